@@ -1,11 +1,55 @@
 #include <algorithm>
+#include <cstdint>
 #include <execution>
+#include <string>
+#include <vector>
 #include <opencv2/opencv.hpp>
 #include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 
+#include <unistd.h>
+
+#include "parallel_bands.h"
+#include "tuning_profile.h"
+
 namespace py = pybind11;
 
+// Tuning profile written by Lesson 6's cache_benchmark.load_tuning_profile().
+// Only the two fields the "tuned" mode needs; the file format, fingerprint
+// and path live in common/tuning_profile.h.
+struct TuningProfile
+{
+    int threads = 1;
+    int64_t parallel_grain_bytes = 256 * 1024;
+};
+
+using ai_cpp::allowed_cpu_count;
+
+static TuningProfile read_tuning_profile()
+{
+    TuningProfile p;
+    p.threads = allowed_cpu_count();
+    long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (l2 > 0)
+        p.parallel_grain_bytes = std::max<int64_t>(p.parallel_grain_bytes, l2);
+
+    TuningProfile cached = p;
+    auto file = ai_cpp::TuningProfileFile::read(ai_cpp::tuning_profile_path());
+    if (file && file->get("threads", cached.threads) &&
+        file->get("parallel_grain_bytes", cached.parallel_grain_bytes))
+    {
+        cached.threads = std::max(1, cached.threads);
+        p = cached;
+    }
+    return p; // missing, stale or malformed: keep the defaults
+}
+
+static const TuningProfile &tuning_profile()
+{
+    static const TuningProfile profile = read_tuning_profile();
+    return profile;
+}
+
 // Helper function for scalar row processing
 void process_row(const uchar *src_row, uchar *dst_row, int src_cols, float x_ratio, int dst_cols)
 {
@@ -57,6 +101,24 @@ cv::Mat crop_and_resize_generic(
             int src_y = static_cast<int>(y * y_ratio);
             process_row(cropped.ptr<uchar>(src_y), resized.ptr<uchar>(y), cropped.cols, x_ratio, target_width); });
     }
+    else if (mode == "tuned")
+    {
+        // Contiguous row bands sized from the tuning profile: at most
+        // profile.threads bands, and none smaller than parallel_grain_bytes of
+        // output, so a small target stays on the calling thread.
+        const TuningProfile &profile = tuning_profile();
+        int64_t total_bytes = static_cast<int64_t>(resized.step[0]) * target_height;
+        int64_t by_grain = std::max<int64_t>(1, total_bytes / std::max<int64_t>(1, profile.parallel_grain_bytes));
+        int bands = static_cast<int>(std::min<int64_t>(profile.threads, by_grain));
+
+        ai_cpp::parallel_bands(target_height, 1, bands, [&](size_t begin, size_t end)
+                               {
+            for (int y = static_cast<int>(begin); y < static_cast<int>(end); ++y)
+            {
+                int src_y = static_cast<int>(y * y_ratio);
+                process_row(cropped.ptr<uchar>(src_y), resized.ptr<uchar>(y), cropped.cols, x_ratio, target_width);
+            } });
+    }
     else
     {
         // Default scalar row processing
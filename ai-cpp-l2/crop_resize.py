@@ -105,5 +105,25 @@ def compare_functions():
 
     print(f"C++ crop_and_resize_par function took {cpp_xsimd_time_ms:.2f} ms")
 
+    # Time the C++ function (bands sized from the Lesson 6 tuning profile)
+    cpp_tuned_start = time.perf_counter()
+    cpp_tuned_result = crop_and_resize(
+        image,
+        crop_start[0],
+        crop_start[1],
+        crop_dim[0],
+        crop_dim[1],
+        target_dim[0],
+        target_dim[1],
+        "tuned"
+    )
+    cpp_tuned_end = time.perf_counter()
+    cpp_tuned_time_ms = (cpp_tuned_end - cpp_tuned_start) * 1000  # Convert to milliseconds
+
+    # write the output image
+    cv2.imwrite("cpp_result_tuned.bmp", cpp_tuned_result)
+
+    print(f"C++ crop_and_resize_tuned function took {cpp_tuned_time_ms:.2f} ms")
+
 if __name__ == "__main__":
     compare_functions()
@@ -1,9 +1,14 @@
 #include <nanobind/nanobind.h>
 #include <nanobind/ndarray.h>
+#include <nanobind/stl/optional.h>
+#include <nanobind/stl/string.h>
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <cstring>
+#include <optional>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
 namespace nb = nanobind;
@@ -19,22 +24,39 @@ namespace nb = nanobind;
 /// The buffer stores `max_entries` rows, each of `row_size` doubles.
 /// Data is stored contiguously so that when the buffer has not wrapped,
 /// latest(n) can return a single view.
+///
+/// Optionally each row carries a monotonic timestamp. Because pushes arrive
+/// in time order, the ring is sorted by timestamp from oldest to newest, so
+/// time queries (at_time, at_times, range) binary-search the ring in place
+/// instead of copying it out to numpy for searchsorted.
 class HistoryView
 {
 public:
+    enum class Interpolation
+    {
+        linear,
+        nearest,
+    };
+
     /// Create a circular buffer for `max_entries` rows of `row_size` doubles each.
-    HistoryView(size_t max_entries, size_t row_size)
-        : max_entries_{max_entries}, row_size_{row_size}
+    /// With `timestamped`, every push() must supply a non-decreasing timestamp.
+    HistoryView(size_t max_entries, size_t row_size, bool timestamped = false)
+        : max_entries_{max_entries}, row_size_{row_size}, timestamped_{timestamped}
     {
         if (max_entries == 0 || row_size == 0)
         {
             throw std::invalid_argument("max_entries and row_size must be > 0");
         }
         storage_.resize(max_entries * row_size, 0.0);
+        if (timestamped_)
+        {
+            timestamps_.resize(max_entries, 0.0);
+        }
     }
 
     /// Push a row of data into the buffer.
-    void push(nb::ndarray<nb::numpy, double, nb::ndim<1>> arr)
+    void push(nb::ndarray<nb::numpy, double, nb::ndim<1>> arr,
+              std::optional<double> timestamp = std::nullopt)
     {
         if (static_cast<size_t>(arr.shape(0)) != row_size_)
         {
@@ -42,6 +64,30 @@ public:
                 "expected row of size " + std::to_string(row_size_) +
                 ", got " + std::to_string(arr.shape(0)));
         }
+        if (timestamped_)
+        {
+            if (!timestamp)
+            {
+                throw std::invalid_argument("timestamp is required for a timestamped HistoryView");
+            }
+            // NaN compares false against everything, so it would pass the
+            // ordering check below and then break every binary search
+            if (!std::isfinite(*timestamp))
+            {
+                throw std::invalid_argument("timestamp must be finite, got " + std::to_string(*timestamp));
+            }
+            if (count_ > 0 && *timestamp < timestamp_at(count_ - 1))
+            {
+                throw std::invalid_argument(
+                    "timestamps must be non-decreasing, got " + std::to_string(*timestamp) +
+                    " after " + std::to_string(timestamp_at(count_ - 1)));
+            }
+            timestamps_[head_] = *timestamp;
+        }
+        else if (timestamp)
+        {
+            throw std::invalid_argument("HistoryView was created without timestamps");
+        }
 
         double* dst = storage_.data() + (head_ * row_size_);
         const double* src = arr.data();
@@ -100,9 +146,107 @@ public:
         return nb::ndarray<nb::numpy, double>(out, 2, shape, owner);
     }
 
+    /// Return the row at time `t` as a 1D array of `row_size` doubles.
+    ///
+    /// "linear" blends the two rows bracketing `t`; "nearest" returns the
+    /// closer one (ties go to the older row). Queries outside the stored
+    /// time span clamp to the oldest/newest row, like np.interp.
+    nb::ndarray<nb::numpy, double> at_time(double t, const std::string& mode)
+    {
+        Interpolation interp = parse_mode(mode);
+        require_timestamped_data();
+        require_query_time(t);
+
+        auto* out = new double[row_size_];
+        nb::capsule owner(out, [](void* p) noexcept { delete[] static_cast<double*>(p); });
+        interpolate_into(t, interp, out);
+
+        size_t shape[] = {row_size_};
+        return nb::ndarray<nb::numpy, double>(out, 1, shape, owner);
+    }
+
+    /// Batched at_time(): one row per query timestamp, shape (len(times), row_size).
+    /// Each query is an independent O(log n) search, so `times` need not be sorted.
+    nb::ndarray<nb::numpy, double> at_times(
+        nb::ndarray<nb::numpy, const double, nb::ndim<1>> times, const std::string& mode)
+    {
+        Interpolation interp = parse_mode(mode);
+        require_timestamped_data();
+
+        size_t n = times.shape(0);
+        const double* src = times.data();
+        int64_t stride = times.stride(0);
+        for (size_t i = 0; i < n; ++i)
+        {
+            require_query_time(src[i * stride]);
+        }
+
+        auto* out = new double[std::max<size_t>(n * row_size_, 1)];
+        nb::capsule owner(out, [](void* p) noexcept { delete[] static_cast<double*>(p); });
+        for (size_t i = 0; i < n; ++i)
+        {
+            interpolate_into(src[i * stride], interp, out + i * row_size_);
+        }
+
+        size_t shape[] = {n, row_size_};
+        return nb::ndarray<nb::numpy, double>(out, 2, shape, owner);
+    }
+
+    /// Return (timestamps, rows) for every entry with t0 <= timestamp <= t1,
+    /// oldest first. Both bounds are located by binary search.
+    nb::tuple range(double t0, double t1)
+    {
+        if (!timestamped_)
+        {
+            throw std::runtime_error("HistoryView was created without timestamps");
+        }
+        require_query_time(t0);
+        require_query_time(t1);
+        if (t1 < t0)
+        {
+            throw std::invalid_argument("range requires t0 <= t1");
+        }
+
+        size_t first = lower_bound_time(t0);
+        size_t last = upper_bound_time(t1);
+        size_t n = last > first ? last - first : 0;
+
+        auto* ts_out = new double[std::max<size_t>(n, 1)];
+        nb::capsule ts_owner(ts_out, [](void* p) noexcept { delete[] static_cast<double*>(p); });
+        auto* rows_out = new double[std::max<size_t>(n * row_size_, 1)];
+        nb::capsule rows_owner(rows_out, [](void* p) noexcept { delete[] static_cast<double*>(p); });
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            ts_out[i] = timestamp_at(first + i);
+            std::memcpy(rows_out + i * row_size_, row_at(first + i), row_size_ * sizeof(double));
+        }
+
+        size_t ts_shape[] = {n};
+        size_t rows_shape[] = {n, row_size_};
+        auto ts_arr = nb::ndarray<nb::numpy, double>(ts_out, 1, ts_shape, ts_owner);
+        auto rows_arr = nb::ndarray<nb::numpy, double>(rows_out, 2, rows_shape, rows_owner);
+        return nb::make_tuple(ts_arr, rows_arr);
+    }
+
+    /// Timestamp of the oldest stored row.
+    [[nodiscard]] double oldest_time() const
+    {
+        require_timestamped_data();
+        return timestamp_at(0);
+    }
+
+    /// Timestamp of the newest stored row.
+    [[nodiscard]] double newest_time() const
+    {
+        require_timestamped_data();
+        return timestamp_at(count_ - 1);
+    }
+
     [[nodiscard]] size_t max_entries() const noexcept { return max_entries_; }
     [[nodiscard]] size_t row_size() const noexcept { return row_size_; }
     [[nodiscard]] size_t count() const noexcept { return count_; }
+    [[nodiscard]] bool timestamped() const noexcept { return timestamped_; }
 
     /// Direct access to internal storage pointer (for testing view semantics).
     [[nodiscard]] uintptr_t data_ptr() const noexcept
@@ -111,11 +255,128 @@ public:
     }
 
 private:
+    static Interpolation parse_mode(const std::string& mode)
+    {
+        if (mode == "linear")
+            return Interpolation::linear;
+        if (mode == "nearest")
+            return Interpolation::nearest;
+        throw std::invalid_argument("mode must be 'linear' or 'nearest', got '" + mode + "'");
+    }
+
+    void require_timestamped_data() const
+    {
+        if (!timestamped_)
+        {
+            throw std::runtime_error("HistoryView was created without timestamps");
+        }
+        if (count_ == 0)
+        {
+            throw std::runtime_error("buffer is empty");
+        }
+    }
+
+    /// Query times may be infinite (they clamp to the ends) but not NaN.
+    static void require_query_time(double t)
+    {
+        if (std::isnan(t))
+        {
+            throw std::invalid_argument("query time must not be NaN");
+        }
+    }
+
+    /// Map a logical index (0 = oldest) to a slot in the ring.
+    [[nodiscard]] size_t slot(size_t logical) const noexcept
+    {
+        return (head_ + max_entries_ - count_ + logical) % max_entries_;
+    }
+
+    [[nodiscard]] double timestamp_at(size_t logical) const noexcept
+    {
+        return timestamps_[slot(logical)];
+    }
+
+    [[nodiscard]] const double* row_at(size_t logical) const noexcept
+    {
+        return storage_.data() + slot(logical) * row_size_;
+    }
+
+    /// First logical index whose timestamp is >= t (count_ if none).
+    [[nodiscard]] size_t lower_bound_time(double t) const noexcept
+    {
+        size_t lo = 0;
+        size_t hi = count_;
+        while (lo < hi)
+        {
+            size_t mid = lo + (hi - lo) / 2;
+            if (timestamp_at(mid) < t)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+    /// First logical index whose timestamp is > t (count_ if none).
+    [[nodiscard]] size_t upper_bound_time(double t) const noexcept
+    {
+        size_t lo = 0;
+        size_t hi = count_;
+        while (lo < hi)
+        {
+            size_t mid = lo + (hi - lo) / 2;
+            if (timestamp_at(mid) <= t)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+    /// Write the row at time `t` into `dst`. Requires count_ > 0.
+    void interpolate_into(double t, Interpolation interp, double* dst) const
+    {
+        size_t hi = lower_bound_time(t);
+        if (hi == 0)
+        {
+            std::memcpy(dst, row_at(0), row_size_ * sizeof(double));
+            return;
+        }
+        if (hi == count_)
+        {
+            std::memcpy(dst, row_at(count_ - 1), row_size_ * sizeof(double));
+            return;
+        }
+
+        size_t lo = hi - 1;
+        double t_lo = timestamp_at(lo);
+        double t_hi = timestamp_at(hi);
+        const double* a = row_at(lo);
+        const double* b = row_at(hi);
+
+        if (interp == Interpolation::nearest)
+        {
+            const double* src = (t - t_lo <= t_hi - t) ? a : b;
+            std::memcpy(dst, src, row_size_ * sizeof(double));
+            return;
+        }
+
+        // t_hi > t_lo here: hi is the first index with timestamp >= t, and
+        // t_lo < t, so duplicate timestamps never produce a zero span.
+        double alpha = (t - t_lo) / (t_hi - t_lo);
+        for (size_t i = 0; i < row_size_; ++i)
+        {
+            dst[i] = a[i] + alpha * (b[i] - a[i]);
+        }
+    }
+
     size_t max_entries_;
     size_t row_size_;
+    bool timestamped_;
     size_t head_{0};
     size_t count_{0};
     std::vector<double> storage_;
+    std::vector<double> timestamps_;
 };
 
 NB_MODULE(history_view_native, m)
@@ -123,14 +384,23 @@ NB_MODULE(history_view_native, m)
     m.doc() = "Zero-copy circular buffer returning numpy array views into C++ memory";
 
     nb::class_<HistoryView>(m, "HistoryView")
-        .def(nb::init<size_t, size_t>(),
-             nb::arg("max_entries"), nb::arg("row_size"))
-        .def("push", &HistoryView::push, nb::arg("row"),
-             "Push a row of data into the circular buffer")
+        .def(nb::init<size_t, size_t, bool>(),
+             nb::arg("max_entries"), nb::arg("row_size"), nb::arg("timestamped") = false)
+        .def("push", &HistoryView::push, nb::arg("row"), nb::arg("timestamp") = nb::none(),
+             "Push a row of data into the circular buffer (timestamp required when timestamped)")
         .def("latest", &HistoryView::latest, nb::arg("n") = 1,
              "Return a view of the latest n entries (zero-copy when contiguous)")
+        .def("at_time", &HistoryView::at_time, nb::arg("t"), nb::arg("mode") = "linear",
+             "Return the row at time t ('linear' or 'nearest'), clamped to the stored span")
+        .def("at_times", &HistoryView::at_times, nb::arg("times"), nb::arg("mode") = "linear",
+             "Batched at_time: returns a (len(times), row_size) array")
+        .def("range", &HistoryView::range, nb::arg("t0"), nb::arg("t1"),
+             "Return (timestamps, rows) for all entries with t0 <= t <= t1")
+        .def_prop_ro("oldest_time", &HistoryView::oldest_time)
+        .def_prop_ro("newest_time", &HistoryView::newest_time)
         .def_prop_ro("max_entries", &HistoryView::max_entries)
         .def_prop_ro("row_size", &HistoryView::row_size)
         .def_prop_ro("count", &HistoryView::count)
+        .def_prop_ro("timestamped", &HistoryView::timestamped)
         .def_prop_ro("data_ptr", &HistoryView::data_ptr);
 }
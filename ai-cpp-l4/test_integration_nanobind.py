@@ -281,3 +281,22 @@ class TestHistoryViewTracking:
         for i in range(10):
             np.testing.assert_almost_equal(result[i, 0], float(i))
             np.testing.assert_almost_equal(result[i, 1], float(i + 100))
+
+    def test_align_detections_to_telemetry(self):
+        """Resample 30 Hz detections onto 100 Hz telemetry timestamps without
+        copying the history out to numpy."""
+        h = HistoryView(max_entries=64, row_size=2, timestamped=True)  # [cx, cy]
+
+        # Object moving at constant velocity, detections every 1/30 s
+        for k in range(120):
+            t = k / 30.0
+            h.push(np.array([10.0 * t, -5.0 * t]), timestamp=t)
+
+        # Only the newest 64 detections are retained
+        telemetry_t = np.arange(h.oldest_time, h.newest_time, 0.01)
+        aligned = np.asarray(h.at_times(telemetry_t))
+        assert aligned.shape == (len(telemetry_t), 2)
+
+        # Linear motion is reproduced exactly by linear interpolation
+        np.testing.assert_array_almost_equal(aligned[:, 0], 10.0 * telemetry_t)
+        np.testing.assert_array_almost_equal(aligned[:, 1], -5.0 * telemetry_t)
@@ -4,7 +4,8 @@ Unit tests for Lesson 4 nanobind modules.
 Tests:
   - BBox: construction, properties, iou, contains_point, edge cases
   - BufferPool: acquire, release, reuse, capacity
-  - HistoryView: push, latest, circular wrap-around, view semantics
+  - HistoryView: push, latest, circular wrap-around, view semantics,
+    timestamp queries (at_time, at_times, range)
 """
 
 import sys
@@ -285,3 +286,124 @@ class TestHistoryView:
         h.push(np.array([1.0, 2.0]))
         with pytest.raises(ValueError):
             h.latest(0)
+
+
+class TestHistoryViewTimestamps:
+    def _filled(self, n=5, max_entries=10):
+        h = HistoryView(max_entries=max_entries, row_size=2, timestamped=True)
+        for i in range(n):
+            h.push(np.array([float(i), float(i * 10)]), timestamp=float(i))
+        return h
+
+    def test_timestamped_flag(self):
+        assert HistoryView(max_entries=4, row_size=2).timestamped is False
+        assert HistoryView(max_entries=4, row_size=2, timestamped=True).timestamped is True
+
+    def test_push_requires_timestamp(self):
+        h = HistoryView(max_entries=4, row_size=1, timestamped=True)
+        with pytest.raises(ValueError):
+            h.push(np.array([1.0]))
+
+    def test_push_rejects_timestamp_without_column(self):
+        h = HistoryView(max_entries=4, row_size=1)
+        with pytest.raises(ValueError):
+            h.push(np.array([1.0]), timestamp=1.0)
+
+    def test_push_rejects_decreasing_timestamp(self):
+        h = HistoryView(max_entries=4, row_size=1, timestamped=True)
+        h.push(np.array([1.0]), timestamp=2.0)
+        with pytest.raises(ValueError, match="non-decreasing"):
+            h.push(np.array([2.0]), timestamp=1.0)
+
+    @pytest.mark.parametrize("bad", [float("nan"), float("inf"), float("-inf")])
+    def test_push_rejects_non_finite_timestamp(self, bad):
+        h = HistoryView(max_entries=4, row_size=1, timestamped=True)
+        h.push(np.array([1.0]), timestamp=1.0)
+        with pytest.raises(ValueError, match="finite"):
+            h.push(np.array([2.0]), timestamp=bad)
+        assert h.count == 1
+        # The rejected push left the ordering intact
+        h.push(np.array([3.0]), timestamp=2.0)
+        np.testing.assert_array_almost_equal(np.asarray(h.at_time(1.5)), [2.0])
+
+    def test_queries_reject_nan(self):
+        h = self._filled()
+        with pytest.raises(ValueError, match="NaN"):
+            h.at_time(float("nan"))
+        with pytest.raises(ValueError, match="NaN"):
+            h.at_times(np.array([1.0, np.nan]))
+        with pytest.raises(ValueError, match="NaN"):
+            h.range(float("nan"), 3.0)
+        # Infinite query times still clamp to the ends
+        np.testing.assert_array_almost_equal(np.asarray(h.at_time(float("inf"))), [4.0, 40.0])
+
+    def test_at_time_linear(self):
+        h = self._filled()
+        row = np.asarray(h.at_time(2.25))
+        np.testing.assert_array_almost_equal(row, [2.25, 22.5])
+
+    def test_at_time_exact_sample(self):
+        h = self._filled()
+        np.testing.assert_array_almost_equal(np.asarray(h.at_time(3.0)), [3.0, 30.0])
+
+    def test_at_time_nearest(self):
+        h = self._filled()
+        np.testing.assert_array_almost_equal(
+            np.asarray(h.at_time(2.6, mode="nearest")), [3.0, 30.0])
+        np.testing.assert_array_almost_equal(
+            np.asarray(h.at_time(2.4, mode="nearest")), [2.0, 20.0])
+
+    def test_at_time_clamps_outside_span(self):
+        h = self._filled()
+        np.testing.assert_array_almost_equal(np.asarray(h.at_time(-5.0)), [0.0, 0.0])
+        np.testing.assert_array_almost_equal(np.asarray(h.at_time(99.0)), [4.0, 40.0])
+
+    def test_at_time_invalid_mode(self):
+        h = self._filled()
+        with pytest.raises(ValueError, match="mode"):
+            h.at_time(1.0, mode="cubic")
+
+    def test_at_time_empty_raises(self):
+        h = HistoryView(max_entries=4, row_size=2, timestamped=True)
+        with pytest.raises(RuntimeError, match="empty"):
+            h.at_time(0.0)
+
+    def test_at_time_without_timestamps_raises(self):
+        h = HistoryView(max_entries=4, row_size=2)
+        h.push(np.array([1.0, 2.0]))
+        with pytest.raises(RuntimeError, match="without timestamps"):
+            h.at_time(0.0)
+
+    def test_at_times_matches_np_interp(self):
+        h = self._filled(n=8)
+        queries = np.array([0.5, 7.0, 3.3, -1.0, 10.0])
+        result = np.asarray(h.at_times(queries))
+        assert result.shape == (5, 2)
+        expected = np.interp(queries, np.arange(8.0), np.arange(8.0))
+        np.testing.assert_array_almost_equal(result[:, 0], expected)
+        np.testing.assert_array_almost_equal(result[:, 1], expected * 10.0)
+
+    def test_range_inclusive(self):
+        h = self._filled(n=6)
+        ts, rows = h.range(1.0, 3.0)
+        np.testing.assert_array_almost_equal(np.asarray(ts), [1.0, 2.0, 3.0])
+        np.testing.assert_array_almost_equal(np.asarray(rows)[:, 0], [1.0, 2.0, 3.0])
+
+    def test_range_empty(self):
+        h = self._filled(n=3)
+        ts, rows = h.range(10.0, 20.0)
+        assert np.asarray(ts).shape == (0,)
+        assert np.asarray(rows).shape == (0, 2)
+
+    def test_range_invalid_bounds(self):
+        h = self._filled(n=3)
+        with pytest.raises(ValueError):
+            h.range(2.0, 1.0)
+
+    def test_queries_after_wraparound(self):
+        h = self._filled(n=13, max_entries=5)
+        assert h.oldest_time == pytest.approx(8.0)
+        assert h.newest_time == pytest.approx(12.0)
+        np.testing.assert_array_almost_equal(np.asarray(h.at_time(9.5)), [9.5, 95.0])
+        ts, _ = h.range(0.0, 100.0)
+        np.testing.assert_array_almost_equal(np.asarray(ts), [8.0, 9.0, 10.0, 11.0, 12.0])
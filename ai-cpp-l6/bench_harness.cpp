@@ -0,0 +1,436 @@
+#include <nanobind/nanobind.h>
+#include <nanobind/stl/string.h>
+#include <nanobind/stl/vector.h>
+#include <nanobind/stl/pair.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sched.h>
+
+namespace nb = nanobind;
+
+// ---------------------------------------------------------------------------
+// Statistical benchmark harness
+//
+// A single mean hides noise: a 3% regression is invisible next to a 10%
+// trial-to-trial spread. This module runs a kernel until its timing settles
+// (warmup detection), then collects repeated trials and reports the median
+// with a bootstrap confidence interval. mann_whitney_u() compares two sets of
+// trials without assuming normality — benchmark timings are skewed and
+// heavy-tailed, so a t-test would be the wrong tool.
+// ---------------------------------------------------------------------------
+
+constexpr size_t kWarmupBatch = 5;  // trials per warmup batch
+constexpr int kStableBatches = 2;   // consecutive settled batches to end warmup
+
+double median_of(std::vector<double> v)
+{
+    if (v.empty())
+    {
+        return 0.0;
+    }
+    size_t mid = v.size() / 2;
+    std::nth_element(v.begin(), v.begin() + mid, v.end());
+    double hi = v[mid];
+    if (v.size() % 2)
+    {
+        return hi;
+    }
+    double lo = *std::max_element(v.begin(), v.begin() + mid);
+    return (lo + hi) / 2.0;
+}
+
+// Percentile-bootstrap confidence interval of the median. Deterministic for a
+// given seed so reruns of the same data report the same interval.
+std::pair<double, double> bootstrap_median_ci(const std::vector<double> &samples, double confidence,
+                                              int resamples, uint64_t seed)
+{
+    if (samples.empty())
+    {
+        throw std::invalid_argument("samples must not be empty");
+    }
+    if (confidence <= 0.0 || confidence >= 1.0)
+    {
+        throw std::invalid_argument("confidence must be in (0, 1)");
+    }
+    if (resamples < 10)
+    {
+        throw std::invalid_argument("resamples must be >= 10");
+    }
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<size_t> pick(0, samples.size() - 1);
+    std::vector<double> medians(static_cast<size_t>(resamples));
+    std::vector<double> resample(samples.size());
+    for (auto &m : medians)
+    {
+        for (auto &x : resample)
+        {
+            x = samples[pick(rng)];
+        }
+        m = median_of(resample);
+    }
+    std::sort(medians.begin(), medians.end());
+    double alpha = (1.0 - confidence) / 2.0;
+    auto at = [&](double q)
+    {
+        auto i = static_cast<size_t>(std::clamp(q * static_cast<double>(medians.size() - 1), 0.0,
+                                                static_cast<double>(medians.size() - 1)));
+        return medians[i];
+    };
+    return {at(alpha), at(1.0 - alpha)};
+}
+
+struct MannWhitneyResult
+{
+    double u;             // U statistic of `current`
+    double z;             // normal approximation, tie- and continuity-corrected
+    double p_greater;     // one-sided p: current is stochastically larger (slower)
+    double p_two_sided;
+    double prob_greater;  // P(current > baseline), ties counted half
+};
+
+// Mann-Whitney U test of `current` against `baseline` using average ranks for
+// ties and the normal approximation (fine from ~8 samples per side).
+MannWhitneyResult mann_whitney_u(const std::vector<double> &baseline, const std::vector<double> &current)
+{
+    const size_t n1 = baseline.size();
+    const size_t n2 = current.size();
+    if (n1 < 2 || n2 < 2)
+    {
+        throw std::invalid_argument("each sample needs at least 2 values");
+    }
+
+    struct Item
+    {
+        double value;
+        bool is_current;
+    };
+    std::vector<Item> all;
+    all.reserve(n1 + n2);
+    for (double v : baseline)
+    {
+        all.push_back({v, false});
+    }
+    for (double v : current)
+    {
+        all.push_back({v, true});
+    }
+    std::sort(all.begin(), all.end(), [](const Item &a, const Item &b) { return a.value < b.value; });
+
+    const double n = static_cast<double>(n1 + n2);
+    double rank_sum_current = 0.0;
+    double tie_term = 0.0;
+    for (size_t i = 0; i < all.size();)
+    {
+        size_t j = i;
+        while (j < all.size() && all[j].value == all[i].value)
+        {
+            ++j;
+        }
+        double avg_rank = (static_cast<double>(i + 1) + static_cast<double>(j)) / 2.0;
+        for (size_t k = i; k < j; ++k)
+        {
+            if (all[k].is_current)
+            {
+                rank_sum_current += avg_rank;
+            }
+        }
+        double t = static_cast<double>(j - i);
+        tie_term += t * t * t - t;
+        i = j;
+    }
+
+    const double dn1 = static_cast<double>(n1);
+    const double dn2 = static_cast<double>(n2);
+    MannWhitneyResult r{};
+    r.u = rank_sum_current - dn2 * (dn2 + 1.0) / 2.0;
+    r.prob_greater = r.u / (dn1 * dn2);
+
+    const double mu = dn1 * dn2 / 2.0;
+    const double sigma = std::sqrt(dn1 * dn2 / 12.0 * ((n + 1.0) - tie_term / (n * (n - 1.0))));
+    if (sigma == 0.0)  // every value identical
+    {
+        r.z = 0.0;
+        r.p_greater = 1.0;
+        r.p_two_sided = 1.0;
+        return r;
+    }
+    double diff = r.u - mu;
+    double corrected = diff > 0 ? diff - 0.5 : (diff < 0 ? diff + 0.5 : 0.0);
+    r.z = corrected / sigma;
+    r.p_greater = 0.5 * std::erfc((r.u - mu - 0.5) / sigma / std::sqrt(2.0));
+    r.p_two_sided = std::min(1.0, std::erfc(std::abs(r.z) / std::sqrt(2.0)));
+    return r;
+}
+
+struct BenchResult
+{
+    std::vector<double> samples_ns;  // per-call time of each measured trial
+    int64_t inner_iterations = 1;    // calls per trial
+    int64_t warmup_trials = 0;
+    bool warmed_up = false;          // false: hit max_warmup_trials before settling
+    double median_ns = 0.0;
+    double mean_ns = 0.0;
+    double stddev_ns = 0.0;
+    double min_ns = 0.0;
+    double ci_low_ns = 0.0;
+    double ci_high_ns = 0.0;
+};
+
+// Time `inner` back-to-back calls, returning ns per call.
+template <typename Fn>
+double time_trial(Fn &fn, int64_t inner)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < inner; ++i)
+    {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) /
+           static_cast<double>(inner);
+}
+
+// Run `fn` until batch medians stop drifting, then record `trials` trials.
+// Each trial repeats the call enough times to last at least min_trial_ns so
+// clock resolution and call overhead stay negligible.
+template <typename Fn>
+BenchResult run_trials(Fn &&fn, int trials, int max_warmup_trials, double warmup_tolerance,
+                       int64_t min_trial_ns)
+{
+    if (trials < 2)
+    {
+        throw std::invalid_argument("trials must be >= 2");
+    }
+    if (max_warmup_trials < 0 || warmup_tolerance <= 0.0 || min_trial_ns < 0)
+    {
+        throw std::invalid_argument("max_warmup_trials, warmup_tolerance and min_trial_ns must be positive");
+    }
+
+    BenchResult result;
+
+    // Calibrate the inner loop (this also serves as the first warmup).
+    int64_t inner = 1;
+    while (true)
+    {
+        double per_call = time_trial(fn, inner);
+        if (per_call * static_cast<double>(inner) >= static_cast<double>(min_trial_ns) || inner >= (int64_t{1} << 30))
+        {
+            break;
+        }
+        inner *= 2;
+    }
+    result.inner_iterations = inner;
+
+    // Warmup: caches, branch predictors, page faults, frequency ramp-up.
+    double previous = 0.0;
+    int stable = 0;
+    std::vector<double> batch(kWarmupBatch);
+    while (result.warmup_trials + static_cast<int64_t>(kWarmupBatch) <= max_warmup_trials)
+    {
+        for (auto &t : batch)
+        {
+            t = time_trial(fn, inner);
+        }
+        result.warmup_trials += kWarmupBatch;
+        double m = median_of(batch);
+        if (previous > 0.0 && std::abs(m - previous) / previous < warmup_tolerance)
+        {
+            if (++stable >= kStableBatches)
+            {
+                result.warmed_up = true;
+                break;
+            }
+        }
+        else
+        {
+            stable = 0;
+        }
+        previous = m;
+    }
+
+    result.samples_ns.resize(static_cast<size_t>(trials));
+    for (auto &t : result.samples_ns)
+    {
+        t = time_trial(fn, inner);
+    }
+
+    const auto &s = result.samples_ns;
+    result.median_ns = median_of(s);
+    result.mean_ns = std::accumulate(s.begin(), s.end(), 0.0) / static_cast<double>(s.size());
+    double sq = 0.0;
+    for (double v : s)
+    {
+        sq += (v - result.mean_ns) * (v - result.mean_ns);
+    }
+    result.stddev_ns = std::sqrt(sq / static_cast<double>(s.size() - 1));
+    result.min_ns = *std::min_element(s.begin(), s.end());
+    std::tie(result.ci_low_ns, result.ci_high_ns) = bootstrap_median_ci(s, 0.95, 2000, 0);
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Environment: CPU pinning and frequency scaling
+// ---------------------------------------------------------------------------
+
+std::vector<int> allowed_cpus()
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0)
+    {
+        throw std::runtime_error(std::string("sched_getaffinity failed: ") + std::strerror(errno));
+    }
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+        if (CPU_ISSET(cpu, &set))
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+// Restrict the calling thread to the given CPUs (one CPU pins it). Migration
+// between cores flushes private caches and changes the clock domain mid-trial.
+void set_affinity(const std::vector<int> &cpus)
+{
+    if (cpus.empty())
+    {
+        throw std::invalid_argument("cpus must not be empty");
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus)
+    {
+        if (cpu < 0 || cpu >= CPU_SETSIZE)
+        {
+            throw std::invalid_argument("cpu index out of range: " + std::to_string(cpu));
+        }
+        CPU_SET(cpu, &set);
+    }
+    if (sched_setaffinity(0, sizeof(set), &set) != 0)
+    {
+        throw std::runtime_error(std::string("sched_setaffinity failed: ") + std::strerror(errno));
+    }
+}
+
+struct FrequencyReport
+{
+    std::vector<std::string> governors;  // distinct scaling governors across CPUs
+    std::string turbo = "unknown";       // "enabled", "disabled" or "unknown"
+    std::vector<std::string> warnings;   // conditions that make timings noisy
+    bool stable = false;                 // no warnings
+};
+
+static std::string read_sysfs(const std::string &path)
+{
+    std::ifstream in(path);
+    std::string value;
+    std::getline(in, value);
+    return value;
+}
+
+FrequencyReport cpu_frequency_report()
+{
+    FrequencyReport report;
+    std::set<std::string> governors;
+    for (int cpu : allowed_cpus())
+    {
+        std::string g = read_sysfs("/sys/devices/system/cpu/cpu" + std::to_string(cpu) +
+                                   "/cpufreq/scaling_governor");
+        if (!g.empty())
+        {
+            governors.insert(g);
+        }
+    }
+    report.governors.assign(governors.begin(), governors.end());
+    if (governors.empty())
+    {
+        report.warnings.push_back("cpufreq not exposed (VM or container): frequency scaling unknown");
+    }
+    else if (governors.size() > 1 || *governors.begin() != "performance")
+    {
+        report.warnings.push_back("scaling governor is not 'performance' on every CPU: "
+                                  "run `cpupower frequency-set -g performance`");
+    }
+
+    // intel_pstate reports no_turbo; acpi-cpufreq and amd-pstate report boost.
+    std::string no_turbo = read_sysfs("/sys/devices/system/cpu/intel_pstate/no_turbo");
+    std::string boost = read_sysfs("/sys/devices/system/cpu/cpufreq/boost");
+    if (!no_turbo.empty())
+    {
+        report.turbo = no_turbo == "1" ? "disabled" : "enabled";
+    }
+    else if (!boost.empty())
+    {
+        report.turbo = boost == "1" ? "enabled" : "disabled";
+    }
+    if (report.turbo == "enabled")
+    {
+        report.warnings.push_back("turbo boost is enabled: clock speed depends on temperature and load");
+    }
+    report.stable = report.warnings.empty();
+    return report;
+}
+
+NB_MODULE(bench_harness, m)
+{
+    m.doc() = "Statistical benchmark harness: warmup detection, bootstrap CIs, Mann-Whitney U";
+
+    nb::class_<BenchResult>(m, "BenchResult")
+        .def_ro("samples_ns", &BenchResult::samples_ns)
+        .def_ro("inner_iterations", &BenchResult::inner_iterations)
+        .def_ro("warmup_trials", &BenchResult::warmup_trials)
+        .def_ro("warmed_up", &BenchResult::warmed_up)
+        .def_ro("median_ns", &BenchResult::median_ns)
+        .def_ro("mean_ns", &BenchResult::mean_ns)
+        .def_ro("stddev_ns", &BenchResult::stddev_ns)
+        .def_ro("min_ns", &BenchResult::min_ns)
+        .def_ro("ci_low_ns", &BenchResult::ci_low_ns)
+        .def_ro("ci_high_ns", &BenchResult::ci_high_ns);
+
+    nb::class_<MannWhitneyResult>(m, "MannWhitneyResult")
+        .def_ro("u", &MannWhitneyResult::u)
+        .def_ro("z", &MannWhitneyResult::z)
+        .def_ro("p_greater", &MannWhitneyResult::p_greater)
+        .def_ro("p_two_sided", &MannWhitneyResult::p_two_sided)
+        .def_ro("prob_greater", &MannWhitneyResult::prob_greater);
+
+    nb::class_<FrequencyReport>(m, "FrequencyReport")
+        .def_ro("governors", &FrequencyReport::governors)
+        .def_ro("turbo", &FrequencyReport::turbo)
+        .def_ro("warnings", &FrequencyReport::warnings)
+        .def_ro("stable", &FrequencyReport::stable);
+
+    m.def("run_case", [](nb::callable fn, int trials, int max_warmup_trials, double warmup_tolerance,
+                         int64_t min_trial_ns)
+          { return run_trials([&fn] { fn(); }, trials, max_warmup_trials, warmup_tolerance, min_trial_ns); },
+          nb::arg("fn"), nb::arg("trials") = 30, nb::arg("max_warmup_trials") = 200,
+          nb::arg("warmup_tolerance") = 0.02, nb::arg("min_trial_ns") = 1'000'000,
+          "Warm up `fn` until batch medians settle, then time `trials` trials");
+
+    m.def("median", &median_of, nb::arg("samples"));
+    m.def("bootstrap_median_ci", &bootstrap_median_ci,
+          nb::arg("samples"), nb::arg("confidence") = 0.95, nb::arg("resamples") = 2000, nb::arg("seed") = 0,
+          "Percentile-bootstrap confidence interval (low, high) of the median");
+    m.def("mann_whitney_u", &mann_whitney_u, nb::arg("baseline"), nb::arg("current"),
+          "Mann-Whitney U test: is `current` stochastically larger than `baseline`?");
+
+    m.def("allowed_cpus", &allowed_cpus, "CPUs the calling thread may run on");
+    m.def("set_affinity", &set_affinity, nb::arg("cpus"),
+          "Restrict the calling thread to the given CPUs");
+    m.def("cpu_frequency_report", &cpu_frequency_report,
+          "Scaling governors and turbo state, with warnings for noisy configurations");
+}
@@ -0,0 +1,420 @@
+"""
+Benchmark regression gate for every C++ kernel in the course.
+
+Each registered case runs through bench_harness.run_case(): warmup until the
+timing settles, then repeated trials with a bootstrap confidence interval of
+the median. With --baseline, every case is compared against a stored JSON
+baseline using a one-sided Mann-Whitney U test, and the script exits with
+status 1 if any case got significantly *and* meaningfully slower.
+
+Trials are also recorded into latency_timer under "bench/<case>", so a run
+can be watched live with metrics_monitor.py.
+
+Cases whose module is not built are skipped. The capstone cases also skip
+until the trainee has bound the class in fast_tracker_utils._native; they use
+the signatures sketched in capstone/src/bindings.cpp. FastKalmanFilter and
+FastPreprocessor have no case because their bound signatures are left to the
+trainee.
+
+Usage:
+    python3 bench_regress.py --save baseline.json         # record a baseline
+    python3 bench_regress.py --baseline baseline.json     # gate: exit 1 on regression
+    python3 bench_regress.py --list
+    python3 bench_regress.py --filter lut --trials 50
+"""
+
+from __future__ import annotations
+
+import argparse
+import importlib
+import json
+import platform
+import sys
+from dataclasses import dataclass
+from typing import Callable
+
+try:
+    import bench_harness
+    _HAS_HARNESS = True
+except ImportError:
+    _HAS_HARNESS = False
+
+try:
+    import latency_timer
+    _HAS_LATENCY_TIMER = True
+except ImportError:
+    _HAS_LATENCY_TIMER = False
+
+BASELINE_VERSION = 1
+
+
+@dataclass
+class BenchCase:
+    name: str
+    module: str  # extension module the kernel lives in
+    setup: Callable  # setup(module) -> zero-argument callable to time, or None if absent
+
+
+def _rng_image(shape, seed=0):
+    import numpy as np
+    return np.random.default_rng(seed).integers(0, 256, shape, dtype=np.uint8)
+
+
+def _bbox_iou(m):
+    a, b = m.BBox(10, 20, 100, 80), m.BBox(50, 40, 100, 80)
+    return lambda: a.iou(b)
+
+
+def _crop_and_resize(mode):
+    def setup(m):
+        image = _rng_image((1365, 2048, 3))
+        return lambda: m.crop_and_resize(image, 50, 50, 1600, 1200, 640, 480, mode)
+    return setup
+
+
+def _history_push_latest(m):
+    import numpy as np
+    view = m.HistoryView(256, 8)
+    row = np.arange(8, dtype=np.float64)
+
+    def run():
+        view.push(row)
+        view.latest(16)
+    return run
+
+
+def _buffer_pool_cycle(m):
+    pool = m.BufferPool(8, 640 * 480 * 3)
+
+    def run():
+        pool.release(pool.acquire_index())
+    return run
+
+
+def _cache_sequential(m):
+    return lambda: m.benchmark_sequential(256 * 1024, 1)
+
+
+def _cache_random(m):
+    return lambda: m.benchmark_random(256 * 1024, 1)
+
+
+def _preprocess(fn_name):
+    def setup(m):
+        image = _rng_image((480, 640, 3))
+        mean, std = [0.485, 0.456, 0.406], [0.229, 0.224, 0.225]
+        fn = getattr(m, fn_name)
+        return lambda: fn(image, mean, std)
+    return setup
+
+
+def _hwc_to_chw(m):
+    image = _rng_image((480, 640, 3))
+    return lambda: m.hwc_to_chw(image)
+
+
+def _pinned_pool_cycle(m):
+    pool = m.PinnedBufferPool(4, 640 * 480 * 3)
+
+    def run():
+        _, index = pool.acquire_with_index()
+        pool.release(index)
+    return run
+
+
+def _state_machine(class_name):
+    def setup(m):
+        sm = getattr(m, class_name)()
+        frame = [0]
+
+        def run():
+            frame[0] += 1
+            # Mostly tracked, with periodic dropouts to exercise every state
+            sm.update(frame[0] % 40 < 30, 10.0, 20.0, 50.0, 60.0)
+        return run
+    return setup
+
+
+def _state_machine_bank(m):
+    import numpy as np
+    n = 1000
+    bank = m.StateMachineBank(n)
+    # Staggered 40-frame detection pattern, so every state is populated
+    period = [(np.arange(n) * 7 + f) % 40 < 25 for f in range(40)]
+    boxes = np.zeros((n, 4), dtype=np.float32)
+    frame = [0]
+
+    def run():
+        frame[0] += 1
+        bank.update(period[frame[0] % 40], boxes)
+    return run
+
+
+def _event_log_replay(m):
+    log = m.EventLog(100_000)
+    sms = [m.VariantStateMachine() for _ in range(100)]
+    for track, sm in enumerate(sms):
+        sm.record_to(log, track)
+    for frame in range(1000):
+        for track, sm in enumerate(sms):
+            sm.update((frame + track * 7) % 40 < 25, 10.0, 20.0, 50.0, 60.0)
+    return lambda: m.replay(log, "table")
+
+
+def _grayscale(fn_name):
+    def setup(m):
+        image = _rng_image((480, 640, 3))
+        fn = getattr(m, fn_name)
+        return lambda: fn(image)
+    return setup
+
+
+def _gamma(fn_name):
+    def setup(m):
+        gray = _rng_image((480, 640))
+        fn = getattr(m, fn_name)
+        return lambda: fn(gray, 2.2)
+    return setup
+
+
+def _apply_lut(m):
+    gray = _rng_image((480, 640))
+    lut = _rng_image((256,), seed=1)
+    return lambda: m.apply_lut(gray, lut)
+
+
+def _lut_chain(m):
+    gray = _rng_image((480, 640))
+    chain = m.LutChain().gamma(0.45).contrast_stretch(16, 235).brightness(10).invert()
+    return lambda: chain.apply(gray)
+
+
+def _equalize_hist(m):
+    gray = _rng_image((480, 640))
+    out = _rng_image((480, 640))
+    return lambda: m.equalize_hist_into(gray, out, threads=1)
+
+
+def _clahe(m):
+    gray = _rng_image((480, 640))
+    out = _rng_image((480, 640))
+    clahe = m.Clahe(2.0, (8, 8), threads=1)
+    return lambda: clahe.apply_into(gray, out)
+
+
+def _serialize_roundtrip(m):
+    box = m.BBox()
+    box.x, box.y, box.w, box.h = 1.0, 2.0, 3.0, 4.0
+    return lambda: m.deserialize_bbox(m.serialize_bbox(box))
+
+
+def _capstone_history(m):
+    import numpy as np
+    if not hasattr(m, "FastHistoryBuffer"):
+        return None
+    history = m.FastHistoryBuffer(100, 4)
+    row = np.arange(4, dtype=np.float64)
+
+    def run():
+        history.push(row)
+        history.latest(10)
+    return run
+
+
+def _capstone_state_machine(m):
+    if not hasattr(m, "FastStateMachine"):
+        return None
+    sm = m.FastStateMachine()
+    events = ["detect", "detect", "miss", "detect", "miss"]
+    frame = [0]
+
+    def run():
+        frame[0] += 1
+        sm.process_event(events[frame[0] % len(events)])
+    return run
+
+
+def _span_sum(fn_name):
+    def setup(m):
+        data = [float(i) for i in range(4096)]
+        fn = getattr(m, fn_name)
+        return lambda: fn(data)
+    return setup
+
+
+CASES = [
+    BenchCase("l2/crop_and_resize_scalar", "cpp_image_processor", _crop_and_resize("scalar")),
+    BenchCase("l2/crop_and_resize_par", "cpp_image_processor", _crop_and_resize("par")),
+    BenchCase("l2/crop_and_resize_tuned", "cpp_image_processor", _crop_and_resize("tuned")),
+    BenchCase("l4/bbox_iou", "bbox_native", _bbox_iou),
+    BenchCase("l4/history_push_latest", "history_view_native", _history_push_latest),
+    BenchCase("l4/buffer_pool_cycle", "buffer_pool_native", _buffer_pool_cycle),
+    BenchCase("l6/cache_sequential_256k", "cache_benchmark", _cache_sequential),
+    BenchCase("l6/cache_random_256k", "cache_benchmark", _cache_random),
+    BenchCase("l7/fused_preprocess", "gpu_preprocess_cpu_ref", _preprocess("fused_preprocess")),
+    BenchCase("l7/fused_preprocess_scalar", "gpu_preprocess_cpu_ref", _preprocess("fused_preprocess_scalar")),
+    BenchCase("l7/hwc_to_chw", "gpu_preprocess_cpu_ref", _hwc_to_chw),
+    BenchCase("l7/numpy_style_preprocess", "gpu_preprocess_cpu_ref", _preprocess("numpy_style_preprocess")),
+    BenchCase("l7/pinned_pool_cycle", "pinned_allocator", _pinned_pool_cycle),
+    BenchCase("l8/string_state_machine", "state_machine", _state_machine("StringStateMachine")),
+    BenchCase("l8/variant_state_machine", "state_machine", _state_machine("VariantStateMachine")),
+    BenchCase("l8/table_state_machine", "state_machine", _state_machine("TableStateMachine")),
+    BenchCase("l8/event_log_replay_100k", "state_machine", _event_log_replay),
+    BenchCase("l8/state_machine_bank_1000", "state_machine", _state_machine_bank),
+    BenchCase("l8/grayscale_lut", "compile_time_lut", _grayscale("apply_grayscale_lut")),
+    BenchCase("l8/grayscale_runtime", "compile_time_lut", _grayscale("apply_grayscale_runtime")),
+    BenchCase("l8/gamma_lut", "compile_time_lut", _gamma("apply_gamma_lut")),
+    BenchCase("l8/gamma_runtime", "compile_time_lut", _gamma("apply_gamma_runtime")),
+    BenchCase("l8/grayscale_simd", "compile_time_lut", _grayscale("apply_grayscale_simd")),
+    BenchCase("l8/gamma_simd", "compile_time_lut", _gamma("apply_gamma_simd")),
+    BenchCase("l8/apply_lut", "compile_time_lut", _apply_lut),
+    BenchCase("l8/lut_chain_4_ops", "compile_time_lut", _lut_chain),
+    BenchCase("l8/equalize_hist", "compile_time_lut", _equalize_hist),
+    BenchCase("l8/clahe_8x8", "compile_time_lut", _clahe),
+    BenchCase("l8/serialize_bbox_roundtrip", "concepts_demo", _serialize_roundtrip),
+    BenchCase("l9/tracker_utils_bbox_iou", "tracker_utils._native", _bbox_iou),
+    BenchCase("l11/span_sum", "safe_views", _span_sum("span_sum")),
+    BenchCase("l11/raw_pointer_sum", "safe_views", _span_sum("raw_pointer_sum")),
+    BenchCase("capstone/history_push_latest", "fast_tracker_utils._native", _capstone_history),
+    BenchCase("capstone/state_machine_event", "fast_tracker_utils._native", _capstone_state_machine),
+]
+
+
+def run_cases(cases, trials: int, max_warmup: int, min_trial_ns: int, log=print) -> dict:
+    """Run every case whose module imports; returns {name: result dict}."""
+    results = {}
+    for case in cases:
+        try:
+            module = importlib.import_module(case.module)
+        except ImportError:
+            log(f"  {case.name:<32} skipped ({case.module} not built)")
+            continue
+        fn = case.setup(module)
+        if fn is None:
+            log(f"  {case.name:<32} skipped (not implemented in {case.module})")
+            continue
+        r = bench_harness.run_case(fn, trials=trials,
+                                   max_warmup_trials=max_warmup, min_trial_ns=min_trial_ns)
+        if _HAS_LATENCY_TIMER:
+            timer = latency_timer.Timer.instance()
+            for ns in r.samples_ns:
+                timer.record(f"bench/{case.name}", int(ns))
+        results[case.name] = {
+            "samples_ns": list(r.samples_ns),
+            "median_ns": r.median_ns,
+            "ci_ns": [r.ci_low_ns, r.ci_high_ns],
+            "inner_iterations": r.inner_iterations,
+            "warmed_up": r.warmed_up,
+        }
+        note = "" if r.warmed_up else "  (did not settle during warmup)"
+        log(f"  {case.name:<32} {r.median_ns:>12.1f} ns  "
+            f"95% CI [{r.ci_low_ns:.1f}, {r.ci_high_ns:.1f}]{note}")
+    return results
+
+
+def compare(baseline: dict, current: dict, alpha: float, threshold: float) -> list[dict]:
+    """Per-case verdicts. A regression must be both significant (one-sided
+    Mann-Whitney p < alpha) and meaningful (median slower by > threshold)."""
+    verdicts = []
+    for name, cur in current.items():
+        base = baseline.get(name)
+        if base is None:
+            verdicts.append({"name": name, "status": "new"})
+            continue
+        test = bench_harness.mann_whitney_u(base["samples_ns"], cur["samples_ns"])
+        ratio = cur["median_ns"] / base["median_ns"] if base["median_ns"] > 0 else 1.0
+        if test.p_greater < alpha and ratio > 1.0 + threshold:
+            status = "REGRESSION"
+        elif bench_harness.mann_whitney_u(cur["samples_ns"], base["samples_ns"]).p_greater < alpha \
+                and ratio < 1.0 - threshold:
+            status = "improved"
+        else:
+            status = "ok"
+        verdicts.append({"name": name, "status": status, "ratio": ratio, "p": test.p_greater})
+    return verdicts
+
+
+def environment(pin: int | None) -> dict:
+    """Pin the process and report conditions that make timings noisy."""
+    cpus = bench_harness.allowed_cpus()
+    if pin is not None:
+        bench_harness.set_affinity([pin if pin >= 0 else cpus[-1]])
+    freq = bench_harness.cpu_frequency_report()
+    return {
+        "machine": platform.machine(),
+        "processor": platform.processor(),
+        "python": platform.python_version(),
+        "pinned_cpus": bench_harness.allowed_cpus(),
+        "governors": list(freq.governors),
+        "turbo": freq.turbo,
+        "warnings": list(freq.warnings),
+    }
+
+
+def main(argv: list[str] | None = None) -> int:
+    parser = argparse.ArgumentParser(description="Statistical benchmark regression gate")
+    parser.add_argument("--baseline", help="JSON baseline to compare against")
+    parser.add_argument("--save", help="write this run as a JSON baseline")
+    parser.add_argument("--filter", default="", help="only run cases containing this substring")
+    parser.add_argument("--list", action="store_true", help="list cases and exit")
+    parser.add_argument("--trials", type=int, default=30)
+    parser.add_argument("--max-warmup", type=int, default=200)
+    parser.add_argument("--min-trial-ms", type=float, default=1.0)
+    parser.add_argument("--alpha", type=float, default=0.01, help="significance level")
+    parser.add_argument("--threshold", type=float, default=0.03,
+                        help="minimum relative slowdown that counts as a regression")
+    parser.add_argument("--pin", type=int, default=-1,
+                        help="CPU to pin to (-1: last allowed CPU; omit pinning with --no-pin)")
+    parser.add_argument("--no-pin", action="store_true")
+    parser.add_argument("--strict", action="store_true",
+                        help="fail if the environment check reports warnings")
+    args = parser.parse_args(argv)
+
+    cases = [c for c in CASES if args.filter in c.name]
+    if args.list:
+        for c in cases:
+            print(f"{c.name:<32} {c.module}")
+        return 0
+    if not _HAS_HARNESS:
+        print("error: bench_harness not built (see Build and Run in README)", file=sys.stderr)
+        return 2
+
+    env = environment(None if args.no_pin else args.pin)
+    print(f"Pinned to CPUs {env['pinned_cpus']}, governors {env['governors'] or 'n/a'}, turbo {env['turbo']}")
+    for w in env["warnings"]:
+        print(f"  WARNING: {w}")
+    if args.strict and env["warnings"]:
+        return 2
+    print()
+
+    current = run_cases(cases, args.trials, args.max_warmup, int(args.min_trial_ms * 1e6))
+
+    if args.save:
+        with open(args.save, "w") as f:
+            json.dump({"version": BASELINE_VERSION, "environment": env, "cases": current}, f, indent=1)
+        print(f"\nSaved {len(current)} cases to {args.save}")
+
+    if not args.baseline:
+        return 0
+
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    if baseline.get("version") != BASELINE_VERSION:
+        print(f"error: baseline version {baseline.get('version')}, expected {BASELINE_VERSION}", file=sys.stderr)
+        return 2
+
+    verdicts = compare(baseline["cases"], current, args.alpha, args.threshold)
+    print(f"\n  {'Case':<32} {'Ratio':>8} {'p':>10}  Verdict")
+    print(f"  {'-' * 32} {'-' * 8} {'-' * 10}  {'-' * 10}")
+    for v in verdicts:
+        if v["status"] == "new":
+            print(f"  {v['name']:<32} {'':>8} {'':>10}  new (not in baseline)")
+        else:
+            print(f"  {v['name']:<32} {v['ratio']:>7.3f}x {v['p']:>10.2e}  {v['status']}")
+    regressions = [v for v in verdicts if v["status"] == "REGRESSION"]
+    print(f"\n{len(regressions)} regression(s) at alpha={args.alpha}, threshold={args.threshold:.0%}")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
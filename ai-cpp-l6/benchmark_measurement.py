@@ -56,6 +56,62 @@ def run_cache_benchmark_demo():
     print()
 
 
+def run_bandwidth_demo():
+    """STREAM bandwidth per thread count and TLB reach — the roofline ceilings."""
+    if not _HAS_CPP_MODULES:
+        print("Skipping bandwidth benchmark (C++ module not available)")
+        return
+
+    print("=" * 72)
+    print("  MEMORY BANDWIDTH (STREAM) AND TLB REACH")
+    print("=" * 72)
+    print()
+
+    results = [cache_benchmark.run_stream_benchmark(iterations=3, non_temporal=nt) for nt in (False, True)]
+    print(f"  Arrays: 3 x {results[0].array_size_bytes / (1024 * 1024):.0f} MB, best of 3, GB/s")
+    print(f"  {'Threads':>7}  {'Stores':<8}{'Copy':>8}{'Scale':>8}{'Add':>8}{'Triad':>8}")
+    print("  " + "-" * 47)
+    for r in results:
+        label = "NT" if r.non_temporal else "regular"
+        for i, t in enumerate(r.threads):
+            print(f"  {t:>7}  {label:<8}{r.copy_gbps[i]:>8.1f}{r.scale_gbps[i]:>8.1f}"
+                  f"{r.add_gbps[i]:>8.1f}{r.triad_gbps[i]:>8.1f}")
+    single_thread_peak = max(r.triad_gbps[0] for r in results)
+    all_thread_peak = max(max(r.triad_gbps) for r in results)
+
+    tlb = cache_benchmark.run_tlb_benchmark(max_size_bytes=128 * 1024 * 1024, iterations=2)
+    print(f"\n  Pointer chase, one line per 4 KB page (hugepage backing: {tlb.huge_backing})")
+    print(f"  {'Size':>8}  {'4K pages':>10}  {'2M pages':>10}")
+    for i, size in enumerate(tlb.sizes_bytes):
+        huge = f"{tlb.ns_per_access_huge[i]:>7.1f} ns" if tlb.ns_per_access_huge else f"{'n/a':>10}"
+        print(f"  {size // (1024 * 1024):>5} MB  {tlb.ns_per_access_4k[i]:>7.1f} ns  {huge}")
+
+    # Roofline check: is fused_preprocess already limited by memory bandwidth?
+    try:
+        import numpy as np
+        import gpu_preprocess_cpu_ref
+    except ImportError:
+        print("\n  (build L7's gpu_preprocess_cpu_ref to compare fused_preprocess against the ceiling)")
+        print()
+        return
+    image = np.random.randint(0, 256, (1080, 1920, 3), dtype=np.uint8)
+    mean, std = [0.485, 0.456, 0.406], [0.229, 0.224, 0.225]
+    gpu_preprocess_cpu_ref.fused_preprocess(image, mean, std)  # warm up
+    best_s = min(_time_once(lambda: gpu_preprocess_cpu_ref.fused_preprocess(image, mean, std)) for _ in range(10))
+    moved = image.nbytes + image.size * 4  # uint8 in, float32 out
+    achieved = moved / best_s / 1e9
+    print(f"\n  fused_preprocess 1080p: {achieved:.1f} GB/s moved "
+          f"= {achieved / single_thread_peak:.0%} of 1-thread triad, "
+          f"{achieved / all_thread_peak:.0%} of all-thread triad")
+    print()
+
+
+def _time_once(fn) -> float:
+    start = time.perf_counter()
+    fn()
+    return time.perf_counter() - start
+
+
 def run_latency_timer_demo():
     """Run latency timer on a simulated tracking pipeline."""
     print("=" * 72)
@@ -121,6 +177,20 @@ def compare_timing_precision():
         if py_median > 0 and cpp_median > 0:
             ratio = py_median / cpp_median if cpp_median > 0 else float('inf')
             print(f"\n  Python/C++ ratio: {ratio:.1f}x")
+
+        cal = latency_timer.tsc_calibration()
+        if cal.reliable:
+            print(f"\n  Invariant TSC at {cal.ghz:.3f} GHz "
+                  f"(calibrated in {cal.calibration_ns / 1e6:.1f} ms)")
+        else:
+            print(f"\n  TSC backends unavailable: {cal.reason}")
+
+        print(f"\n  {'Clock backend':<14}{'min':>8}{'median':>10}{'mean':>10}")
+        for r in latency_timer.compare_clock_backends(iterations=10000):
+            if r.available:
+                print(f"  {r.backend:<14}{r.min_ns:>6} ns{r.median_ns:>7.0f} ns{r.mean_ns:>7.1f} ns")
+            else:
+                print(f"  {r.backend:<14}{'n/a':>8}")
     else:
         print("\n  C++ module not available — skipping C++ comparison")
 
@@ -193,6 +263,7 @@ def main():
     print()
 
     run_cache_benchmark_demo()
+    run_bandwidth_demo()
     run_latency_timer_demo()
     compare_timing_precision()
     show_gpu_vs_cpu_timing()
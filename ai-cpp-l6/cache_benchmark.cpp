@@ -1,14 +1,38 @@
 #include <nanobind/nanobind.h>
 #include <nanobind/ndarray.h>
+#include <nanobind/stl/string.h>
 #include <nanobind/stl/vector.h>
+#include <array>
+#include <atomic>
+#include <barrier>
 #include <chrono>
+#include <cmath>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <limits>
 #include <numeric>
+#include <optional>
 #include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 #include <algorithm>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "tuning_profile.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 namespace nb = nanobind;
 
@@ -34,6 +58,40 @@ struct StrideBenchmarkResult
     std::vector<double> ns_per_access;
 };
 
+// Best-of-iterations bandwidth (GB/s) of each STREAM kernel per thread count
+struct StreamResult
+{
+    int64_t array_size_bytes = 0;  // per array; three arrays are allocated
+    bool non_temporal = false;
+    std::vector<int> threads;
+    std::vector<double> copy_gbps;
+    std::vector<double> scale_gbps;
+    std::vector<double> add_gbps;
+    std::vector<double> triad_gbps;
+};
+
+// Round-trip latency (ns) of bouncing one cache line between each CPU pair
+struct CoreToCoreResult
+{
+    std::vector<int> cpus;
+    std::vector<std::vector<double>> round_trip_ns;  // [i][j], symmetric, 0 on the diagonal
+};
+
+struct FalseSharingResult
+{
+    std::vector<int> threads;
+    std::vector<double> unpadded_ns_per_op;  // counters packed into shared cache lines
+    std::vector<double> padded_ns_per_op;    // one counter per cache line
+};
+
+struct TlbBenchmarkResult
+{
+    std::vector<int64_t> sizes_bytes;
+    std::vector<double> ns_per_access_4k;
+    std::vector<double> ns_per_access_huge;  // empty if no hugepage backing
+    std::string huge_backing;                // "hugetlbfs", "thp" or "none"
+};
+
 // Sequential access benchmark: iterate through array linearly
 double benchmark_sequential(size_t array_size_bytes, int iterations)
 {
@@ -193,6 +251,878 @@ StrideBenchmarkResult run_stride_benchmark(int64_t array_size_bytes = 64 * 1024
     return result;
 }
 
+// ---------------------------------------------------------------------------
+// STREAM bandwidth (McCalpin): copy, scale, add, triad over three arrays
+// much larger than the LLC. Each thread owns a contiguous, cache-line aligned
+// chunk and first-touches it, so pages land on the thread's NUMA node.
+// Non-temporal variants stream stores past the cache: no read-for-ownership
+// of the destination, which is what a large output buffer (e.g. a CHW tensor
+// handed to the GPU) wants.
+// ---------------------------------------------------------------------------
+enum class StreamKernel
+{
+    copy,   // c = a          2 arrays of traffic
+    scale,  // b = s * c      2
+    add,    // c = a + b      3
+    triad,  // a = b + s * c  3
+};
+
+constexpr double kStreamScalar = 3.0;
+
+template <bool NonTemporal>
+void stream_kernel(StreamKernel kernel, double *a, double *b, double *c, size_t begin, size_t end)
+{
+    const double s = kStreamScalar;
+#if defined(__AVX__)
+    if constexpr (NonTemporal)
+    {
+        const __m256d vs = _mm256_set1_pd(s);
+        for (size_t i = begin; i < end; i += 4)  // chunks are 64-byte aligned multiples of 8
+        {
+            switch (kernel)
+            {
+            case StreamKernel::copy:
+                _mm256_stream_pd(c + i, _mm256_load_pd(a + i));
+                break;
+            case StreamKernel::scale:
+                _mm256_stream_pd(b + i, _mm256_mul_pd(vs, _mm256_load_pd(c + i)));
+                break;
+            case StreamKernel::add:
+                _mm256_stream_pd(c + i, _mm256_add_pd(_mm256_load_pd(a + i), _mm256_load_pd(b + i)));
+                break;
+            case StreamKernel::triad:
+                _mm256_stream_pd(a + i, _mm256_add_pd(_mm256_load_pd(b + i),
+                                                      _mm256_mul_pd(vs, _mm256_load_pd(c + i))));
+                break;
+            }
+        }
+        _mm_sfence();  // make streamed stores visible before the barrier
+        return;
+    }
+#elif defined(__SSE2__)
+    if constexpr (NonTemporal)
+    {
+        const __m128d vs = _mm_set1_pd(s);
+        for (size_t i = begin; i < end; i += 2)
+        {
+            switch (kernel)
+            {
+            case StreamKernel::copy:
+                _mm_stream_pd(c + i, _mm_load_pd(a + i));
+                break;
+            case StreamKernel::scale:
+                _mm_stream_pd(b + i, _mm_mul_pd(vs, _mm_load_pd(c + i)));
+                break;
+            case StreamKernel::add:
+                _mm_stream_pd(c + i, _mm_add_pd(_mm_load_pd(a + i), _mm_load_pd(b + i)));
+                break;
+            case StreamKernel::triad:
+                _mm_stream_pd(a + i, _mm_add_pd(_mm_load_pd(b + i), _mm_mul_pd(vs, _mm_load_pd(c + i))));
+                break;
+            }
+        }
+        _mm_sfence();
+        return;
+    }
+#endif
+    // Regular stores (also the fallback when no streaming store is available)
+    switch (kernel)
+    {
+    case StreamKernel::copy:
+        for (size_t i = begin; i < end; ++i)
+            c[i] = a[i];
+        break;
+    case StreamKernel::scale:
+        for (size_t i = begin; i < end; ++i)
+            b[i] = s * c[i];
+        break;
+    case StreamKernel::add:
+        for (size_t i = begin; i < end; ++i)
+            c[i] = a[i] + b[i];
+        break;
+    case StreamKernel::triad:
+        for (size_t i = begin; i < end; ++i)
+            a[i] = b[i] + s * c[i];
+        break;
+    }
+}
+
+static std::vector<int> allowed_cpus()
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    std::vector<int> cpus;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &set))
+                cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+static void pin_this_thread(int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    sched_setaffinity(0, sizeof(set), &set);  // best effort: unpinned still measures
+}
+
+struct AlignedDoubles
+{
+    explicit AlignedDoubles(size_t n)
+        : data(static_cast<double *>(std::aligned_alloc(64, ((n * sizeof(double) + 63) / 64) * 64)))
+    {
+        if (!data)
+            throw std::bad_alloc();
+    }
+    ~AlignedDoubles() { std::free(data); }
+    AlignedDoubles(const AlignedDoubles &) = delete;
+    AlignedDoubles &operator=(const AlignedDoubles &) = delete;
+    double *data;
+};
+
+// Run all four kernels with `n_threads` workers; returns best GB/s per kernel.
+std::array<double, 4> stream_with_threads(double *a, double *b, double *c, size_t n, int n_threads,
+                                          int iterations, bool non_temporal)
+{
+    // Chunk boundaries on 8-double (64-byte) multiples for aligned vector stores
+    size_t per_thread = (n / static_cast<size_t>(n_threads)) & ~size_t{7};
+    std::vector<int> cpus = allowed_cpus();
+
+    std::array<double, 4> best_ns;
+    best_ns.fill(std::numeric_limits<double>::max());
+    std::barrier sync(n_threads + 1);  // workers + the timing thread
+    constexpr StreamKernel kKernels[] = {StreamKernel::copy, StreamKernel::scale, StreamKernel::add,
+                                         StreamKernel::triad};
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < n_threads; ++t)
+    {
+        size_t begin = per_thread * static_cast<size_t>(t);
+        size_t end = t + 1 == n_threads ? n : begin + per_thread;
+        workers.emplace_back([&, t, begin, end]
+                             {
+            if (!cpus.empty())
+                pin_this_thread(cpus[static_cast<size_t>(t) % cpus.size()]);
+            // First touch: this thread's chunk lives on this thread's NUMA node
+            for (size_t i = begin; i < end; ++i)
+            {
+                a[i] = 1.0;
+                b[i] = 2.0;
+                c[i] = 0.0;
+            }
+            sync.arrive_and_wait();
+            for (int iter = 0; iter < iterations; ++iter)
+            {
+                for (StreamKernel k : kKernels)
+                {
+                    sync.arrive_and_wait();  // start together
+                    if (non_temporal)
+                        stream_kernel<true>(k, a, b, c, begin, end);
+                    else
+                        stream_kernel<false>(k, a, b, c, begin, end);
+                    sync.arrive_and_wait();  // all done
+                }
+            } });
+    }
+
+    sync.arrive_and_wait();  // initialisation finished
+    for (int iter = 0; iter < iterations; ++iter)
+    {
+        for (size_t k = 0; k < 4; ++k)
+        {
+            sync.arrive_and_wait();
+            auto start = std::chrono::steady_clock::now();
+            sync.arrive_and_wait();
+            auto stop = std::chrono::steady_clock::now();
+            double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+            best_ns[k] = std::min(best_ns[k], ns);
+        }
+    }
+    for (auto &w : workers)
+        w.join();
+
+    const double arrays_moved[4] = {2.0, 2.0, 3.0, 3.0};
+    std::array<double, 4> gbps;
+    for (size_t k = 0; k < 4; ++k)
+    {
+        gbps[k] = arrays_moved[k] * static_cast<double>(n * sizeof(double)) / best_ns[k];  // bytes/ns == GB/s
+    }
+    return gbps;
+}
+
+// STREAM over 1, 2, 4, ... max_threads (0: all CPUs this process may use).
+StreamResult run_stream_benchmark(int64_t array_size_bytes = 64 * 1024 * 1024, int max_threads = 0,
+                                  int iterations = 5, bool non_temporal = false)
+{
+    if (array_size_bytes < 64 * 1024)
+        throw std::invalid_argument("array_size_bytes must be >= 64 KiB");
+    if (iterations < 1)
+        throw std::invalid_argument("iterations must be >= 1");
+    if (max_threads <= 0)
+        max_threads = std::max<int>(1, static_cast<int>(allowed_cpus().size()));
+
+    size_t n = static_cast<size_t>(array_size_bytes) / sizeof(double) & ~size_t{7};
+    AlignedDoubles a(n), b(n), c(n);
+
+    std::vector<int> counts;
+    for (int t = 1; t < max_threads; t *= 2)
+        counts.push_back(t);
+    counts.push_back(max_threads);
+
+    StreamResult result;
+    result.array_size_bytes = static_cast<int64_t>(n * sizeof(double));
+    result.non_temporal = non_temporal;
+    for (int t : counts)
+    {
+        auto gbps = stream_with_threads(a.data, b.data, c.data, n, t, iterations, non_temporal);
+        result.threads.push_back(t);
+        result.copy_gbps.push_back(gbps[0]);
+        result.scale_gbps.push_back(gbps[1]);
+        result.add_gbps.push_back(gbps[2]);
+        result.triad_gbps.push_back(gbps[3]);
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Core-to-core latency: two threads pinned to CPUs i and j take turns
+// incrementing one atomic, so every step moves the line between their caches.
+// Pairs on the same physical core, the same CCX/LLC, and across sockets or
+// NUMA nodes show up as distinct blocks in the matrix.
+// ---------------------------------------------------------------------------
+static bool try_pin_this_thread(int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+// Best-of-`samples` round trip between two CPUs, or NaN if either pin fails.
+double ping_pong_ns(int cpu_a, int cpu_b, int round_trips, int samples)
+{
+    struct alignas(64) Line
+    {
+        std::atomic<uint64_t> value{0};
+    };
+    Line line;
+    std::atomic<bool> pinned_ok{true};
+    std::barrier sync(2);
+    const uint64_t steps = 2 * static_cast<uint64_t>(round_trips);
+
+    std::thread pong([&]
+                     {
+        if (!try_pin_this_thread(cpu_b))
+            pinned_ok = false;
+        sync.arrive_and_wait();
+        for (int s = 0; s < samples && pinned_ok; ++s)
+        {
+            sync.arrive_and_wait();
+            uint64_t base = static_cast<uint64_t>(s) * steps;
+            // Answer odd values with the next even one
+            for (uint64_t v = base + 1; v < base + steps; v += 2)
+            {
+                while (line.value.load(std::memory_order_acquire) != v)
+                {
+                }
+                line.value.store(v + 1, std::memory_order_release);
+            }
+        } });
+
+    // Not a NaN sentinel: -ffast-math lets the compiler assume isnan() is false
+    double best = std::numeric_limits<double>::max();
+    std::thread ping([&]
+                     {
+        if (!try_pin_this_thread(cpu_a))
+            pinned_ok = false;
+        sync.arrive_and_wait();
+        for (int s = 0; s < samples && pinned_ok; ++s)
+        {
+            sync.arrive_and_wait();
+            uint64_t base = static_cast<uint64_t>(s) * steps;
+            auto start = std::chrono::steady_clock::now();
+            for (uint64_t v = base; v < base + steps; v += 2)
+            {
+                line.value.store(v + 1, std::memory_order_release);
+                while (line.value.load(std::memory_order_acquire) != v + 2)
+                {
+                }
+            }
+            auto end = std::chrono::steady_clock::now();
+            double ns = std::chrono::duration<double, std::nano>(end - start).count() / round_trips;
+            best = std::min(best, ns);
+        } });
+
+    ping.join();
+    pong.join();
+    return pinned_ok ? best : std::numeric_limits<double>::quiet_NaN();
+}
+
+// NxN round-trip matrix over `cpus` (default: every CPU this process may use).
+CoreToCoreResult run_core_to_core_benchmark(std::vector<int> cpus = {}, int round_trips = 10000,
+                                            int samples = 5)
+{
+    if (round_trips < 1 || samples < 1)
+        throw std::invalid_argument("round_trips and samples must be >= 1");
+    if (cpus.empty())
+        cpus = allowed_cpus();
+
+    CoreToCoreResult result;
+    result.cpus = cpus;
+    size_t n = cpus.size();
+    result.round_trip_ns.assign(n, std::vector<double>(n, 0.0));
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t j = i + 1; j < n; ++j)
+        {
+            double ns = ping_pong_ns(cpus[i], cpus[j], round_trips, samples);
+            result.round_trip_ns[i][j] = ns;
+            result.round_trip_ns[j][i] = ns;
+        }
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// False sharing: each thread increments only its own counter, yet packed
+// counters share a cache line and every increment invalidates the other
+// threads' copies. Padding each counter to a full line removes the traffic.
+// ---------------------------------------------------------------------------
+struct PackedCounter
+{
+    std::atomic<uint64_t> value{0};
+};
+
+struct alignas(64) PaddedCounter
+{
+    std::atomic<uint64_t> value{0};
+};
+
+static_assert(sizeof(PackedCounter) == 8, "eight packed counters share one cache line");
+static_assert(sizeof(PaddedCounter) == 64, "one padded counter per cache line");
+
+template <typename Counter>
+double contended_increments(int n_threads, int64_t ops_per_thread, const std::vector<int> &cpus)
+{
+    std::vector<Counter> counters(static_cast<size_t>(n_threads));
+    std::barrier sync(n_threads + 1);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < n_threads; ++t)
+    {
+        workers.emplace_back([&, t]
+                             {
+            if (!cpus.empty())
+                pin_this_thread(cpus[static_cast<size_t>(t) % cpus.size()]);
+            auto &counter = counters[static_cast<size_t>(t)].value;
+            sync.arrive_and_wait();
+            for (int64_t i = 0; i < ops_per_thread; ++i)
+                counter.fetch_add(1, std::memory_order_relaxed);
+            sync.arrive_and_wait(); });
+    }
+    sync.arrive_and_wait();
+    auto start = std::chrono::steady_clock::now();
+    sync.arrive_and_wait();
+    auto end = std::chrono::steady_clock::now();
+    for (auto &w : workers)
+        w.join();
+    return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(ops_per_thread);
+}
+
+// ns per increment for 1, 2, 4, ... max_threads (0: all allowed CPUs)
+FalseSharingResult run_false_sharing_benchmark(int max_threads = 0, int64_t ops_per_thread = 2'000'000)
+{
+    if (ops_per_thread < 1)
+        throw std::invalid_argument("ops_per_thread must be >= 1");
+    std::vector<int> cpus = allowed_cpus();
+    if (max_threads <= 0)
+        max_threads = std::max<int>(1, static_cast<int>(cpus.size()));
+
+    FalseSharingResult result;
+    for (int t = 1;; t = std::min(t * 2, max_threads))
+    {
+        result.threads.push_back(t);
+        result.unpadded_ns_per_op.push_back(contended_increments<PackedCounter>(t, ops_per_thread, cpus));
+        result.padded_ns_per_op.push_back(contended_increments<PaddedCounter>(t, ops_per_thread, cpus));
+        if (t == max_threads)
+            break;
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// TLB reach: pointer chase touching one cache line per 4 KiB page, backed by
+// 4 KiB pages vs 2 MiB hugepages. The cache footprint is identical in both
+// runs, so the gap between them is the cost of TLB misses and page walks.
+// ---------------------------------------------------------------------------
+constexpr size_t kSmallPage = 4096;
+constexpr size_t kHugePage = 2 * 1024 * 1024;
+
+static std::string thp_mode()
+{
+    std::ifstream in("/sys/kernel/mm/transparent_hugepage/enabled");
+    std::string line;
+    std::getline(in, line);
+    auto open = line.find('[');
+    auto close = line.find(']');
+    return open != std::string::npos && close > open ? line.substr(open + 1, close - open - 1) : "";
+}
+
+class PageBackedBuffer
+{
+public:
+    // huge: try hugetlbfs pages first, then transparent hugepages.
+    // Otherwise explicitly opt out of THP so the region really uses 4 KiB pages.
+    PageBackedBuffer(size_t bytes, bool huge)
+    {
+        bytes_ = (bytes + kHugePage - 1) / kHugePage * kHugePage;
+        if (huge)
+        {
+            void *p = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED)
+            {
+                map_ = p;
+                map_bytes_ = bytes_;
+                data_ = static_cast<char *>(p);
+                backing_ = "hugetlbfs";
+                return;
+            }
+        }
+        // Over-allocate so the region can start on a 2 MiB boundary
+        map_bytes_ = bytes_ + kHugePage;
+        map_ = mmap(nullptr, map_bytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (map_ == MAP_FAILED)
+            throw std::bad_alloc();
+        auto addr = reinterpret_cast<uintptr_t>(map_);
+        data_ = reinterpret_cast<char *>((addr + kHugePage - 1) & ~(kHugePage - 1));
+        if (huge)
+        {
+            std::string mode = thp_mode();
+            backing_ = mode == "always" || mode == "madvise" ? "thp" : "none";
+            madvise(data_, bytes_, MADV_HUGEPAGE);
+        }
+        else
+        {
+            backing_ = "4k";
+            madvise(data_, bytes_, MADV_NOHUGEPAGE);
+        }
+    }
+
+    ~PageBackedBuffer() { munmap(map_, map_bytes_); }
+    PageBackedBuffer(const PageBackedBuffer &) = delete;
+    PageBackedBuffer &operator=(const PageBackedBuffer &) = delete;
+
+    char *data() const { return data_; }
+    const std::string &backing() const { return backing_; }
+
+private:
+    void *map_ = nullptr;
+    size_t map_bytes_ = 0;
+    size_t bytes_ = 0;
+    char *data_ = nullptr;
+    std::string backing_;
+};
+
+// ns per dependent load over `size_bytes`, one line per page, random page order
+double chase_pages(const PageBackedBuffer &buffer, size_t size_bytes, int iterations)
+{
+    size_t pages = std::max<size_t>(2, size_bytes / kSmallPage);
+    // Rotate the line within each page so the chase does not hammer one cache set
+    auto slot = [&](size_t page) -> void **
+    {
+        size_t line = (page * 7) % (kSmallPage / 64);
+        return reinterpret_cast<void **>(buffer.data() + page * kSmallPage + line * 64);
+    };
+
+    std::vector<size_t> order(pages);
+    std::iota(order.begin(), order.end(), 0);
+    std::mt19937 rng(42);
+    std::shuffle(order.begin() + 1, order.end(), rng);
+    for (size_t i = 0; i < pages; ++i)
+    {
+        *slot(order[i]) = slot(order[(i + 1) % pages]);
+    }
+
+    void **p = slot(order[0]);
+    for (size_t i = 0; i < pages; ++i)  // warm up
+        p = static_cast<void **>(*p);
+
+    size_t steps = std::max<size_t>(pages * static_cast<size_t>(iterations), size_t{1} << 20);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < steps; ++i)
+        p = static_cast<void **>(*p);
+    auto end = std::chrono::steady_clock::now();
+
+    volatile auto prevent_opt = p;
+    (void)prevent_opt;
+    return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(steps);
+}
+
+// Sizes from min to max bytes (doubling), chased with 4 KiB and 2 MiB pages.
+TlbBenchmarkResult run_tlb_benchmark(int64_t min_size_bytes = 1024 * 1024,
+                                     int64_t max_size_bytes = 256 * 1024 * 1024, int iterations = 4)
+{
+    if (min_size_bytes < static_cast<int64_t>(2 * kSmallPage) || max_size_bytes < min_size_bytes)
+        throw std::invalid_argument("need 8 KiB <= min_size_bytes <= max_size_bytes");
+
+    TlbBenchmarkResult result;
+    PageBackedBuffer small(static_cast<size_t>(max_size_bytes), false);
+    PageBackedBuffer huge(static_cast<size_t>(max_size_bytes), true);
+    result.huge_backing = huge.backing();
+
+    for (int64_t size = min_size_bytes; size <= max_size_bytes; size *= 2)
+    {
+        result.sizes_bytes.push_back(size);
+        result.ns_per_access_4k.push_back(chase_pages(small, static_cast<size_t>(size), iterations));
+        if (result.huge_backing != "none")
+            result.ns_per_access_huge.push_back(chase_pages(huge, static_cast<size_t>(size), iterations));
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Machine topology probe and tuning profile
+//
+// Kernels in other lessons (the L7 preprocess kernels) size their tiles,
+// thread counts and streaming-store cutoffs from a profile derived here. The
+// probe reads sysfs (well under a millisecond), optionally confirms the cache
+// sizes with a short pointer chase, and caches the profile on disk keyed by a
+// machine fingerprint, so deployments pay for probing once. The file format,
+// fingerprint and path are shared with the readers via common/tuning_profile.h.
+// ---------------------------------------------------------------------------
+using ai_cpp::kTuningProfileVersion;
+
+struct CacheLevel
+{
+    int level = 0;
+    std::string type;  // "Data", "Instruction" or "Unified"
+    int64_t size_bytes = 0;
+    int line_bytes = 64;
+    int shared_by_cpus = 1;
+};
+
+struct MachineTopology
+{
+    std::string cpu_model;
+    int logical_cpus = 1;   // CPUs this process may run on
+    int physical_cores = 1; // distinct cores among them (SMT siblings merged)
+    int numa_nodes = 1;
+    std::vector<CacheLevel> caches;
+    std::string source;     // "sysfs", "benchmark" or "default"
+
+    int64_t cache_size(int level) const
+    {
+        for (const auto &c : caches)
+        {
+            if (c.level == level && c.type != "Instruction")
+                return c.size_bytes;
+        }
+        return 0;
+    }
+};
+
+struct TuningProfile
+{
+    int version = kTuningProfileVersion;
+    std::string fingerprint;
+    int threads = 1;                             // worker threads for parallel kernels
+    int64_t l1_tile_bytes = 16 * 1024;           // working set of an L1-blocked tile
+    int64_t l2_tile_bytes = 512 * 1024;          // working set of an L2-blocked tile
+    int64_t parallel_grain_bytes = 256 * 1024;   // smallest chunk worth a thread
+    int64_t streaming_store_threshold_bytes = 8 * 1024 * 1024;  // use NT stores above this output size
+    int line_bytes = 64;
+    int numa_nodes = 1;
+    bool confirmed = false;                      // cache sizes checked by micro-benchmark
+    double probe_ms = 0.0;
+
+    // Rows per tile for a kernel touching `row_bytes` per row
+    int64_t tile_rows(int64_t row_bytes, bool l1 = false) const
+    {
+        int64_t budget = l1 ? l1_tile_bytes : l2_tile_bytes;
+        return std::max<int64_t>(1, budget / std::max<int64_t>(1, row_bytes));
+    }
+};
+
+static std::string read_first_line(const std::string &path)
+{
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+// "48K", "2048K", "32M" -> bytes
+static int64_t parse_cache_size(const std::string &text)
+{
+    if (text.empty())
+        return 0;
+    int64_t value = std::strtoll(text.c_str(), nullptr, 10);
+    switch (text.back())
+    {
+    case 'K':
+        return value * 1024;
+    case 'M':
+        return value * 1024 * 1024;
+    case 'G':
+        return value * 1024 * 1024 * 1024;
+    default:
+        return value;
+    }
+}
+
+// "0-3,8-11" -> 8; 0 if the list is malformed
+static int count_cpu_list(const std::string &list)
+{
+    int count = 0;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ','))
+    {
+        if (range.empty())
+            continue;
+        auto dash = range.find('-');
+        if (dash == std::string::npos)
+        {
+            if (!ai_cpp::parse_number<int>(range))
+                return 0;
+            ++count;
+            continue;
+        }
+        auto first = ai_cpp::parse_number<int>(std::string_view(range).substr(0, dash));
+        auto last = ai_cpp::parse_number<int>(std::string_view(range).substr(dash + 1));
+        if (!first || !last || *last < *first)
+            return 0;
+        count += *last - *first + 1;
+    }
+    return count;
+}
+
+// Dependent-load latency over `size_bytes` with a fixed step count, so small
+// and large sizes cost the same time.
+static double quick_chase_ns(size_t size_bytes, size_t steps)
+{
+    size_t node_count = std::max<size_t>(2, size_bytes / sizeof(Node));
+    std::vector<Node> nodes(node_count);
+    std::vector<size_t> order(node_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::mt19937 rng(42);
+    std::shuffle(order.begin() + 1, order.end(), rng);
+    for (size_t i = 0; i < node_count; ++i)
+        nodes[order[i]].next = &nodes[order[(i + 1) % node_count]];
+
+    Node *p = &nodes[order[0]];
+    for (size_t i = 0; i < std::min(node_count, steps); ++i)  // warm up
+        p = p->next;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < steps; ++i)
+        p = p->next;
+    auto end = std::chrono::steady_clock::now();
+    volatile auto prevent_opt = p;
+    (void)prevent_opt;
+    return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(steps);
+}
+
+MachineTopology probe_topology()
+{
+    MachineTopology topo;
+    topo.cpu_model = ai_cpp::cpu_model_name();
+    std::vector<int> cpus = allowed_cpus();
+    topo.logical_cpus = std::max<int>(1, static_cast<int>(cpus.size()));
+
+    std::set<std::pair<std::string, std::string>> cores;  // (package, core)
+    for (int cpu : cpus)
+    {
+        std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+        cores.emplace(read_first_line(base + "physical_package_id"), read_first_line(base + "core_id"));
+    }
+    topo.physical_cores = std::max<int>(1, static_cast<int>(cores.size()));
+
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    int nodes = 0;
+    for (const auto &entry : fs::directory_iterator("/sys/devices/system/node", ec))
+    {
+        std::string name = entry.path().filename().string();
+        if (name.rfind("node", 0) == 0 && name.size() > 4 && std::isdigit(static_cast<unsigned char>(name[4])))
+            ++nodes;
+    }
+    topo.numa_nodes = std::max(1, nodes);
+
+    int first_cpu = cpus.empty() ? 0 : cpus.front();
+    for (int index = 0;; ++index)
+    {
+        std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(first_cpu) + "/cache/index" +
+                           std::to_string(index) + "/";
+        std::optional<int> level = ai_cpp::parse_number<int>(read_first_line(base + "level"));
+        if (!level)
+            break;
+        CacheLevel c;
+        c.level = *level;
+        c.type = read_first_line(base + "type");
+        c.size_bytes = parse_cache_size(read_first_line(base + "size"));
+        c.line_bytes = ai_cpp::parse_number<int>(read_first_line(base + "coherency_line_size")).value_or(64);
+        c.shared_by_cpus = std::max(1, count_cpu_list(read_first_line(base + "shared_cpu_list")));
+        if (c.size_bytes > 0)
+            topo.caches.push_back(c);
+    }
+    topo.source = topo.caches.empty() ? "default" : "sysfs";
+    return topo;
+}
+
+// Find cache sizes from latency jumps when sysfs does not expose them.
+static std::vector<CacheLevel> caches_from_sweep()
+{
+    std::vector<CacheLevel> found;
+    double previous = 0.0;
+    int64_t previous_size = 0;
+    for (int64_t size = 8 * 1024; size <= 64 * 1024 * 1024 && found.size() < 3; size *= 2)
+    {
+        double ns = quick_chase_ns(static_cast<size_t>(size), 100000);
+        if (previous > 0.0 && ns > 1.4 * previous)
+        {
+            CacheLevel c;
+            c.level = static_cast<int>(found.size()) + 1;
+            c.type = c.level == 1 ? "Data" : "Unified";
+            c.size_bytes = previous_size;
+            found.push_back(c);
+        }
+        previous = ns;
+        previous_size = size;
+    }
+    return found;
+}
+
+TuningProfile derive_tuning_profile(const MachineTopology &topo)
+{
+    TuningProfile p;
+    p.fingerprint = ai_cpp::machine_fingerprint();
+    // Bandwidth-bound kernels gain nothing from SMT siblings
+    p.threads = std::max(1, std::min(topo.physical_cores, topo.logical_cpus));
+    p.numa_nodes = topo.numa_nodes;
+
+    int64_t l1 = topo.cache_size(1);
+    int64_t l2 = topo.cache_size(2);
+    int64_t l3 = topo.cache_size(3);
+    for (const auto &c : topo.caches)
+    {
+        if (c.level == 1 && c.type != "Instruction")
+            p.line_bytes = c.line_bytes;
+    }
+    // Leave half of each level for the output, the stack and the other hyperthread
+    if (l1 > 0)
+        p.l1_tile_bytes = l1 / 2;
+    if (l2 > 0)
+        p.l2_tile_bytes = l2 / 2;
+    // A chunk smaller than L2 finishes before a thread wake-up (~5-10 us) pays off
+    p.parallel_grain_bytes = std::max<int64_t>(256 * 1024, l2 > 0 ? l2 : 0);
+    // An output bigger than half the LLC is evicted before anyone reads it back:
+    // stream it past the cache instead of paying read-for-ownership
+    if (l3 > 0)
+        p.streaming_store_threshold_bytes = l3 / 2;
+    else if (l2 > 0)
+        p.streaming_store_threshold_bytes = l2 * 4;
+    return p;
+}
+
+// Probe topology (and, with confirm, check the L1/L2 sizes by latency) and
+// derive a profile. Completes in well under a second.
+TuningProfile probe_tuning_profile(bool confirm = true)
+{
+    auto start = std::chrono::steady_clock::now();
+    MachineTopology topo = probe_topology();
+    if (topo.caches.empty())
+    {
+        topo.caches = caches_from_sweep();
+        topo.source = topo.caches.empty() ? "default" : "benchmark";
+    }
+    TuningProfile profile = derive_tuning_profile(topo);
+
+    if (confirm && topo.source == "sysfs")
+    {
+        // Inside a level vs four times past it: latency must jump
+        bool ok = true;
+        for (int level : {1, 2})
+        {
+            int64_t size = topo.cache_size(level);
+            if (size <= 0)
+                continue;
+            double inside = quick_chase_ns(static_cast<size_t>(size / 2), 100000);
+            double outside = quick_chase_ns(static_cast<size_t>(size * 4), 100000);
+            ok = ok && outside > 1.2 * inside;
+        }
+        profile.confirmed = ok;
+    }
+    profile.probe_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return profile;
+}
+
+std::string default_tuning_profile_path()
+{
+    return ai_cpp::tuning_profile_path();
+}
+
+// Plain key=value lines so any module can read it without a JSON parser
+void save_tuning_profile(const TuningProfile &p, std::string path = "")
+{
+    if (path.empty())
+        path = default_tuning_profile_path();
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    std::ofstream out(path);
+    if (!out)
+        throw std::runtime_error("cannot write tuning profile to " + path);
+    out << "# ai-cpp-course tuning profile (written by cache_benchmark)\n"
+        << "version=" << p.version << "\n"
+        << "fingerprint=" << p.fingerprint << "\n"
+        << "threads=" << p.threads << "\n"
+        << "l1_tile_bytes=" << p.l1_tile_bytes << "\n"
+        << "l2_tile_bytes=" << p.l2_tile_bytes << "\n"
+        << "parallel_grain_bytes=" << p.parallel_grain_bytes << "\n"
+        << "streaming_store_threshold_bytes=" << p.streaming_store_threshold_bytes << "\n"
+        << "line_bytes=" << p.line_bytes << "\n"
+        << "numa_nodes=" << p.numa_nodes << "\n"
+        << "confirmed=" << (p.confirmed ? 1 : 0) << "\n"
+        << "probe_ms=" << p.probe_ms << "\n";
+}
+
+// Read a cached profile; returns false if missing, another version,
+// written on a different machine, or malformed.
+static bool read_tuning_profile(const std::string &path, TuningProfile &p)
+{
+    auto file = ai_cpp::TuningProfileFile::read(path);
+    TuningProfile cached;
+    int confirmed = 0;
+    if (!file || !file->get("fingerprint", cached.fingerprint) || !file->get("threads", cached.threads) ||
+        !file->get("l1_tile_bytes", cached.l1_tile_bytes) || !file->get("l2_tile_bytes", cached.l2_tile_bytes) ||
+        !file->get("parallel_grain_bytes", cached.parallel_grain_bytes) ||
+        !file->get("streaming_store_threshold_bytes", cached.streaming_store_threshold_bytes) ||
+        !file->get("line_bytes", cached.line_bytes) || !file->get("numa_nodes", cached.numa_nodes) ||
+        !file->get("confirmed", confirmed) || !file->get("probe_ms", cached.probe_ms))
+        return false;  // probe again
+    cached.confirmed = confirmed == 1;
+    p = cached;
+    return true;
+}
+
+// Startup entry point: the cached profile if it matches this machine,
+// otherwise probe and cache the result.
+TuningProfile load_tuning_profile(std::string path = "", bool reprobe = false, bool confirm = true)
+{
+    if (path.empty())
+        path = default_tuning_profile_path();
+    TuningProfile profile;
+    if (!reprobe && read_tuning_profile(path, profile))
+        return profile;
+    profile = probe_tuning_profile(confirm);
+    save_tuning_profile(profile, path);
+    return profile;
+}
+
 NB_MODULE(cache_benchmark, m)
 {
     m.doc() = "Cache hierarchy benchmark — reveals L1/L2/L3/RAM boundaries";
@@ -206,6 +1136,60 @@ NB_MODULE(cache_benchmark, m)
         .def_ro("strides", &StrideBenchmarkResult::strides)
         .def_ro("ns_per_access", &StrideBenchmarkResult::ns_per_access);
 
+    nb::class_<StreamResult>(m, "StreamResult")
+        .def_ro("array_size_bytes", &StreamResult::array_size_bytes)
+        .def_ro("non_temporal", &StreamResult::non_temporal)
+        .def_ro("threads", &StreamResult::threads)
+        .def_ro("copy_gbps", &StreamResult::copy_gbps)
+        .def_ro("scale_gbps", &StreamResult::scale_gbps)
+        .def_ro("add_gbps", &StreamResult::add_gbps)
+        .def_ro("triad_gbps", &StreamResult::triad_gbps);
+
+    nb::class_<CoreToCoreResult>(m, "CoreToCoreResult")
+        .def_ro("cpus", &CoreToCoreResult::cpus)
+        .def_ro("round_trip_ns", &CoreToCoreResult::round_trip_ns);
+
+    nb::class_<FalseSharingResult>(m, "FalseSharingResult")
+        .def_ro("threads", &FalseSharingResult::threads)
+        .def_ro("unpadded_ns_per_op", &FalseSharingResult::unpadded_ns_per_op)
+        .def_ro("padded_ns_per_op", &FalseSharingResult::padded_ns_per_op);
+
+    nb::class_<CacheLevel>(m, "CacheLevel")
+        .def_ro("level", &CacheLevel::level)
+        .def_ro("type", &CacheLevel::type)
+        .def_ro("size_bytes", &CacheLevel::size_bytes)
+        .def_ro("line_bytes", &CacheLevel::line_bytes)
+        .def_ro("shared_by_cpus", &CacheLevel::shared_by_cpus);
+
+    nb::class_<MachineTopology>(m, "MachineTopology")
+        .def_ro("cpu_model", &MachineTopology::cpu_model)
+        .def_ro("logical_cpus", &MachineTopology::logical_cpus)
+        .def_ro("physical_cores", &MachineTopology::physical_cores)
+        .def_ro("numa_nodes", &MachineTopology::numa_nodes)
+        .def_ro("caches", &MachineTopology::caches)
+        .def_ro("source", &MachineTopology::source);
+
+    nb::class_<TuningProfile>(m, "TuningProfile")
+        .def_ro("version", &TuningProfile::version)
+        .def_ro("fingerprint", &TuningProfile::fingerprint)
+        .def_ro("threads", &TuningProfile::threads)
+        .def_ro("l1_tile_bytes", &TuningProfile::l1_tile_bytes)
+        .def_ro("l2_tile_bytes", &TuningProfile::l2_tile_bytes)
+        .def_ro("parallel_grain_bytes", &TuningProfile::parallel_grain_bytes)
+        .def_ro("streaming_store_threshold_bytes", &TuningProfile::streaming_store_threshold_bytes)
+        .def_ro("line_bytes", &TuningProfile::line_bytes)
+        .def_ro("numa_nodes", &TuningProfile::numa_nodes)
+        .def_ro("confirmed", &TuningProfile::confirmed)
+        .def_ro("probe_ms", &TuningProfile::probe_ms)
+        .def("tile_rows", &TuningProfile::tile_rows, nb::arg("row_bytes"), nb::arg("l1") = false,
+             "Rows per cache-blocked tile for a kernel touching row_bytes per row");
+
+    nb::class_<TlbBenchmarkResult>(m, "TlbBenchmarkResult")
+        .def_ro("sizes_bytes", &TlbBenchmarkResult::sizes_bytes)
+        .def_ro("ns_per_access_4k", &TlbBenchmarkResult::ns_per_access_4k)
+        .def_ro("ns_per_access_huge", &TlbBenchmarkResult::ns_per_access_huge)
+        .def_ro("huge_backing", &TlbBenchmarkResult::huge_backing);
+
     m.def("benchmark_sequential", &benchmark_sequential,
           nb::arg("array_size_bytes"), nb::arg("iterations") = 10,
           "Measure sequential access latency (ns/access) for a given array size");
@@ -222,4 +1206,45 @@ NB_MODULE(cache_benchmark, m)
           nb::arg("array_size_bytes") = 64 * 1024 * 1024,
           nb::arg("iterations") = 5,
           "Run stride access benchmark with varying stride sizes");
+
+    m.def("run_stream_benchmark", &run_stream_benchmark,
+          nb::arg("array_size_bytes") = 64 * 1024 * 1024,
+          nb::arg("max_threads") = 0,
+          nb::arg("iterations") = 5,
+          nb::arg("non_temporal") = false,
+          "STREAM copy/scale/add/triad bandwidth (GB/s) for 1, 2, 4, ... threads");
+
+    m.def("run_core_to_core_benchmark", &run_core_to_core_benchmark,
+          nb::arg("cpus") = std::vector<int>{},
+          nb::arg("round_trips") = 10000,
+          nb::arg("samples") = 5,
+          "NxN cache-line ping-pong round-trip latency (ns) between pinned CPUs");
+
+    m.def("run_false_sharing_benchmark", &run_false_sharing_benchmark,
+          nb::arg("max_threads") = 0,
+          nb::arg("ops_per_thread") = 2'000'000,
+          "Per-thread counter increments (ns/op): packed vs cache-line padded");
+
+    m.def("probe_topology", &probe_topology,
+          "Cache levels, cores and NUMA nodes from sysfs");
+
+    m.def("probe_tuning_profile", &probe_tuning_profile,
+          nb::arg("confirm") = true,
+          "Derive a tuning profile, optionally confirming cache sizes by latency");
+
+    m.def("load_tuning_profile", &load_tuning_profile,
+          nb::arg("path") = "", nb::arg("reprobe") = false, nb::arg("confirm") = true,
+          "Cached tuning profile for this machine, probing and saving it if needed");
+
+    m.def("save_tuning_profile", &save_tuning_profile,
+          nb::arg("profile"), nb::arg("path") = "");
+
+    m.def("default_tuning_profile_path", &default_tuning_profile_path,
+          "$AI_CPP_TUNING_PROFILE, else $XDG_CACHE_HOME/ai-cpp-course/tuning_profile.txt");
+
+    m.def("run_tlb_benchmark", &run_tlb_benchmark,
+          nb::arg("min_size_bytes") = 1024 * 1024,
+          nb::arg("max_size_bytes") = 256 * 1024 * 1024,
+          nb::arg("iterations") = 4,
+          "Pointer chase, one line per page, on 4 KiB vs 2 MiB pages (TLB reach)");
 }
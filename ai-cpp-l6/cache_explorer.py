@@ -136,7 +136,79 @@ def text_plot_stride(strides: list[int], ns_per_access: list[float]):
     print()
 
 
+def text_core_matrix(cpus: list[int], matrix: list[list[float]]):
+    """Print the core-to-core round-trip matrix, grouped by latency tier."""
+    print()
+    print("=" * 72)
+    print("  CORE-TO-CORE ROUND-TRIP LATENCY (ns)")
+    print("=" * 72)
+    print()
+    if len(cpus) < 2:
+        print("  Only one CPU available — nothing to compare.")
+        print()
+        return
+
+    print("       " + "".join(f"{c:>6}" for c in cpus))
+    for i, row in enumerate(matrix):
+        cells = "".join(f"{'-':>6}" if i == j else f"{v:>6.0f}" for j, v in enumerate(row))
+        print(f"  {cpus[i]:>4} {cells}")
+
+    pairs = [(matrix[i][j], cpus[i], cpus[j])
+             for i in range(len(cpus)) for j in range(i + 1, len(cpus)) if not math.isnan(matrix[i][j])]
+    if pairs:
+        fastest, slowest = min(pairs), max(pairs)
+        print()
+        print(f"  Fastest pair: CPU {fastest[1]} <-> {fastest[2]} ({fastest[0]:.0f} ns, likely SMT siblings)")
+        print(f"  Slowest pair: CPU {slowest[1]} <-> {slowest[2]} ({slowest[0]:.0f} ns, "
+              f"likely across CCX/NUMA)")
+        print("  Place stages that hand off every frame on a fast pair.")
+    print()
+
+
+def text_false_sharing(threads: list[int], unpadded: list[float], padded: list[float]):
+    """Print packed vs cache-line padded counter cost per thread count."""
+    print("=" * 72)
+    print("  FALSE SHARING: PACKED vs PADDED COUNTERS")
+    print("=" * 72)
+    print()
+    print(f"{'Threads':>10}  {'Packed':>12}  {'Padded':>12}  {'Slowdown':>9}")
+    print(f"{'':>10}  {'(ns/op)':>12}  {'(ns/op)':>12}")
+    print("-" * 50)
+    for t, u, p in zip(threads, unpadded, padded):
+        print(f"{t:>10}  {u:>12.2f}  {p:>12.2f}  {u / p if p > 0 else 0:>8.1f}x")
+    print()
+    print("  Each thread touches only its own counter; the slowdown is pure")
+    print("  cache-line ping-pong. Pad per-thread state to 64 bytes (alignas(64)).")
+    print()
+
+
+def text_tuning_profile(topology, profile, path: str):
+    """Print the probed topology and the kernel parameters derived from it."""
+    print("=" * 72)
+    print("  MACHINE TOPOLOGY AND TUNING PROFILE")
+    print("=" * 72)
+    print()
+    print(f"  {topology.cpu_model}")
+    print(f"  {topology.logical_cpus} CPUs, {topology.physical_cores} cores, "
+          f"{topology.numa_nodes} NUMA node(s)  (source: {topology.source})")
+    for c in topology.caches:
+        print(f"    L{c.level} {c.type:<12} {format_size(c.size_bytes):>8}  "
+              f"line {c.line_bytes} B, shared by {c.shared_by_cpus} CPU(s)")
+    print()
+    print(f"  threads                  {profile.threads}")
+    print(f"  L1 / L2 tile             {format_size(profile.l1_tile_bytes)} / {format_size(profile.l2_tile_bytes)}")
+    print(f"  parallel grain           {format_size(profile.parallel_grain_bytes)}")
+    print(f"  streaming stores above   {format_size(profile.streaming_store_threshold_bytes)}")
+    print(f"  confirmed by benchmark   {'yes' if profile.confirmed else 'no'}")
+    print(f"  cached at {path}")
+    print()
+
+
 def main():
+    topology = cache_benchmark.probe_topology()
+    profile = cache_benchmark.load_tuning_profile()
+    text_tuning_profile(topology, profile, cache_benchmark.default_tuning_profile_path())
+
     print("Running cache hierarchy benchmark...")
     print("This may take a minute for large array sizes.\n")
 
@@ -164,6 +236,14 @@ def main():
 
     text_plot_stride(strides, stride_ns)
 
+    # Inter-core communication
+    print("Running core-to-core and false-sharing benchmarks...")
+    c2c = cache_benchmark.run_core_to_core_benchmark(round_trips=5000, samples=3)
+    text_core_matrix(list(c2c.cpus), [list(row) for row in c2c.round_trip_ns])
+
+    fs = cache_benchmark.run_false_sharing_benchmark()
+    text_false_sharing(list(fs.threads), list(fs.unpadded_ns_per_op), list(fs.padded_ns_per_op))
+
 
 if __name__ == "__main__":
     main()
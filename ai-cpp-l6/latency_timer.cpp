@@ -3,120 +3,2115 @@
 #include <nanobind/stl/string.h>
 #include <nanobind/stl/vector.h>
 #include <nanobind/stl/tuple.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 #include <mutex>
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define LATENCY_TIMER_HAS_TSC 1
+#else
+#define LATENCY_TIMER_HAS_TSC 0
+#endif
 
 namespace nb = nanobind;
 
-struct TimingRecord
-{
-    std::string name;
-    int64_t elapsed_ns;
-};
+// Sections are interned once into a small integer ID. The hot path only ever
+// sees the ID — no string hashing, copying, or allocation per measurement.
+using SectionId = uint32_t;
+
+constexpr size_t kCacheLine = 64;
+constexpr size_t kDefaultThreadCapacity = size_t{1} << 14;  // 16384 samples, 256 KB
+constexpr int64_t kDefaultHighestTrackableNs = 60'000'000'000;  // 60 s
+constexpr int kDefaultSignificantFigures = 2;                    // 1% resolution, ~30 KB
+constexpr size_t kRecentSamplesPerSection = 1024;
+constexpr size_t kRecentRecords = 8192;
+constexpr SectionId kNoSection = UINT32_MAX;
+constexpr int64_t kNoTimestamp = -1;
+constexpr uint32_t kMaxSpanDepth = 64;
+
+// One finished span. Spans from ScopedTimer carry their begin time (steady_clock
+// ns), the recording thread and the enclosing span; plain record() samples
+// have begin_ns == kNoTimestamp and no parent.
+struct TimingRecord
+{
+    SectionId section;
+    SectionId parent;
+    uint32_t thread_id;
+    uint32_t depth;
+    int64_t begin_ns;
+    int64_t elapsed_ns;
+};
+
+static_assert(sizeof(TimingRecord) == 32, "two records per cache line");
+
+// ---------------------------------------------------------------------------
+// Log-linear (HDR) histogram of nanosecond latencies.
+//
+// Values are grouped into power-of-two buckets, each split into a fixed
+// number of linear sub-buckets, so every recorded value keeps
+// `significant_figures` decimal digits of precision across the whole range
+// [1, highest_trackable_ns]. Recording is one index computation and one
+// increment; memory is fixed at construction.
+// ---------------------------------------------------------------------------
+class HdrHistogram
+{
+public:
+    explicit HdrHistogram(int64_t highest_trackable_ns = kDefaultHighestTrackableNs,
+                          int significant_figures = kDefaultSignificantFigures)
+        : highest_trackable_(highest_trackable_ns), significant_figures_(significant_figures)
+    {
+        if (significant_figures < 1 || significant_figures > 5)
+        {
+            throw std::invalid_argument("significant_figures must be in [1, 5]");
+        }
+        if (highest_trackable_ns < 2)
+        {
+            throw std::invalid_argument("highest_trackable_ns must be >= 2");
+        }
+
+        int64_t largest_single_unit = 2;
+        for (int i = 0; i < significant_figures; ++i)
+        {
+            largest_single_unit *= 10;
+        }
+        int sub_bucket_count_magnitude = static_cast<int>(std::ceil(std::log2(static_cast<double>(largest_single_unit))));
+        sub_bucket_half_count_magnitude_ = std::max(sub_bucket_count_magnitude, 1) - 1;
+        sub_bucket_count_ = int64_t{1} << (sub_bucket_half_count_magnitude_ + 1);
+        sub_bucket_half_count_ = sub_bucket_count_ / 2;
+        sub_bucket_mask_ = sub_bucket_count_ - 1;
+
+        // Number of power-of-two buckets needed to cover highest_trackable_ns
+        int64_t smallest_untrackable = sub_bucket_count_;
+        int bucket_count = 1;
+        while (smallest_untrackable <= highest_trackable_ns)
+        {
+            if (smallest_untrackable > INT64_MAX / 2)
+            {
+                ++bucket_count;
+                break;
+            }
+            smallest_untrackable <<= 1;
+            ++bucket_count;
+        }
+        leading_zero_count_base_ = 64 - sub_bucket_half_count_magnitude_ - 1;
+        counts_.assign(static_cast<size_t>((bucket_count + 1) * sub_bucket_half_count_), 0);
+    }
+
+    void record(int64_t value_ns) noexcept { record_n(value_ns, 1); }
+
+    void record_n(int64_t value_ns, uint64_t n) noexcept
+    {
+        int64_t v = std::clamp<int64_t>(value_ns, 0, highest_trackable_);
+        counts_[counts_index_for(v)] += n;
+        total_count_ += n;
+        sum_ += static_cast<double>(v) * static_cast<double>(n);
+        min_ = std::min(min_, v);
+        max_ = std::max(max_, v);
+    }
+
+    // Add every count from `other`. Both histograms must share a configuration.
+    void merge(const HdrHistogram &other)
+    {
+        if (other.highest_trackable_ != highest_trackable_ ||
+            other.significant_figures_ != significant_figures_)
+        {
+            throw std::invalid_argument("cannot merge histograms with different configurations");
+        }
+        for (size_t i = 0; i < counts_.size(); ++i)
+        {
+            counts_[i] += other.counts_[i];
+        }
+        total_count_ += other.total_count_;
+        sum_ += other.sum_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    void reset() noexcept
+    {
+        std::fill(counts_.begin(), counts_.end(), 0);
+        total_count_ = 0;
+        sum_ = 0.0;
+        min_ = INT64_MAX;
+        max_ = 0;
+    }
+
+    // Value (ns) at or below which `percentile` percent of samples fall,
+    // reported as the upper edge of its bucket (never above max()).
+    int64_t value_at_percentile(double percentile) const
+    {
+        if (total_count_ == 0)
+        {
+            return 0;
+        }
+        double p = std::clamp(percentile, 0.0, 100.0);
+        if (p == 0.0)
+        {
+            return min();
+        }
+        auto target = static_cast<uint64_t>(std::ceil(p / 100.0 * static_cast<double>(total_count_)));
+        target = std::max<uint64_t>(target, 1);
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts_.size(); ++i)
+        {
+            seen += counts_[i];
+            if (seen >= target)
+            {
+                return std::min(highest_equivalent_value(value_at_index(i)), max_);
+            }
+        }
+        return max_;
+    }
+
+    // Call f(bucket_lowest_value_ns, count) for every non-empty bucket, in
+    // ascending value order.
+    template <typename F>
+    void for_each_bucket(F &&f) const
+    {
+        for (size_t i = 0; i < counts_.size(); ++i)
+        {
+            if (counts_[i])
+            {
+                f(value_at_index(i), counts_[i]);
+            }
+        }
+    }
+
+    uint64_t count() const noexcept { return total_count_; }
+    int64_t min() const noexcept { return total_count_ ? min_ : 0; }
+    int64_t max() const noexcept { return max_; }
+    double mean() const noexcept { return total_count_ ? sum_ / static_cast<double>(total_count_) : 0.0; }
+
+    int64_t highest_trackable() const noexcept { return highest_trackable_; }
+    int significant_figures() const noexcept { return significant_figures_; }
+    size_t bucket_count() const noexcept { return counts_.size(); }
+    size_t memory_bytes() const noexcept { return sizeof(*this) + counts_.size() * sizeof(uint64_t); }
+
+private:
+    size_t counts_index_for(int64_t v) const noexcept
+    {
+        int bucket = leading_zero_count_base_ - std::countl_zero(static_cast<uint64_t>(v | sub_bucket_mask_));
+        int64_t sub_bucket = v >> bucket;
+        return static_cast<size_t>(((int64_t{bucket} + 1) << sub_bucket_half_count_magnitude_) +
+                                   (sub_bucket - sub_bucket_half_count_));
+    }
+
+    int64_t value_at_index(size_t index) const noexcept
+    {
+        int64_t bucket = (static_cast<int64_t>(index) >> sub_bucket_half_count_magnitude_) - 1;
+        int64_t sub_bucket = (static_cast<int64_t>(index) & (sub_bucket_half_count_ - 1)) + sub_bucket_half_count_;
+        if (bucket < 0)
+        {
+            sub_bucket -= sub_bucket_half_count_;
+            bucket = 0;
+        }
+        return sub_bucket << bucket;
+    }
+
+    int64_t highest_equivalent_value(int64_t v) const noexcept
+    {
+        int bucket = leading_zero_count_base_ - std::countl_zero(static_cast<uint64_t>(v | sub_bucket_mask_));
+        int64_t sub_bucket = v >> bucket;
+        int adjusted = sub_bucket >= sub_bucket_count_ ? bucket + 1 : bucket;
+        int64_t lowest = sub_bucket << bucket;
+        return lowest + (int64_t{1} << adjusted) - 1;
+    }
+
+    int64_t highest_trackable_;
+    int significant_figures_;
+    int sub_bucket_half_count_magnitude_ = 0;
+    int64_t sub_bucket_count_ = 0;
+    int64_t sub_bucket_half_count_ = 0;
+    int64_t sub_bucket_mask_ = 0;
+    int leading_zero_count_base_ = 0;
+    std::vector<uint64_t> counts_;
+    uint64_t total_count_ = 0;
+    double sum_ = 0.0;
+    int64_t min_ = INT64_MAX;
+    int64_t max_ = 0;
+};
+
+struct LatencySummary
+{
+    uint64_t count = 0;
+    int64_t min_ns = 0;
+    int64_t max_ns = 0;
+    double mean_ns = 0.0;
+    int64_t p50_ns = 0;
+    int64_t p90_ns = 0;
+    int64_t p99_ns = 0;
+    int64_t p999_ns = 0;
+
+    static LatencySummary from(const HdrHistogram &h)
+    {
+        return {h.count(), h.min(), h.max(), h.mean(),
+                h.value_at_percentile(50.0), h.value_at_percentile(90.0),
+                h.value_at_percentile(99.0), h.value_at_percentile(99.9)};
+    }
+};
+
+// Fixed-capacity ring keeping the most recent values, oldest first on export.
+template <typename T>
+class RecentRing
+{
+public:
+    explicit RecentRing(size_t capacity) : values_(capacity) {}
+
+    void push(const T &value) noexcept
+    {
+        values_[head_] = value;
+        head_ = (head_ + 1) % values_.size();
+        size_ = std::min(size_ + 1, values_.size());
+    }
+
+    std::vector<T> to_vector() const
+    {
+        std::vector<T> out;
+        out.reserve(size_);
+        size_t start = (head_ + values_.size() - size_) % values_.size();
+        for (size_t i = 0; i < size_; ++i)
+        {
+            out.push_back(values_[(start + i) % values_.size()]);
+        }
+        return out;
+    }
+
+    void clear() noexcept
+    {
+        head_ = 0;
+        size_ = 0;
+    }
+
+    size_t size() const noexcept { return size_; }
+    size_t capacity() const noexcept { return values_.size(); }
+
+private:
+    std::vector<T> values_;
+    size_t head_ = 0;
+    size_t size_ = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Everything kept for one section: an all-time histogram, an optional ring of
+// per-interval histograms for "last N seconds" queries, and the most recent
+// raw samples. Memory is fixed once the section is created.
+// ---------------------------------------------------------------------------
+struct SectionStats
+{
+    SectionStats(int64_t highest_trackable_ns, int significant_figures,
+                 size_t window_slots, int64_t slot_ns, int64_t now_ns)
+        : total(highest_trackable_ns, significant_figures),
+          window(window_slots, HdrHistogram(highest_trackable_ns, significant_figures)),
+          slot_ns(slot_ns),
+          slot_start_ns(now_ns),
+          recent(kRecentSamplesPerSection)
+    {
+    }
+
+    void record(int64_t elapsed_ns) noexcept
+    {
+        total.record(elapsed_ns);
+        if (!window.empty())
+        {
+            window[current_slot].record(elapsed_ns);
+        }
+        recent.push(elapsed_ns);
+    }
+
+    // Retire window slots older than the window; `now_ns` is steady-clock time.
+    void rotate(int64_t now_ns) noexcept
+    {
+        if (window.empty() || now_ns - slot_start_ns < slot_ns)
+        {
+            return;
+        }
+        int64_t elapsed_slots = (now_ns - slot_start_ns) / slot_ns;
+        auto to_clear = static_cast<size_t>(std::min<int64_t>(elapsed_slots, static_cast<int64_t>(window.size())));
+        for (size_t i = 0; i < to_clear; ++i)
+        {
+            current_slot = (current_slot + 1) % window.size();
+            window[current_slot].reset();
+        }
+        slot_start_ns += elapsed_slots * slot_ns;
+    }
+
+    HdrHistogram window_histogram() const
+    {
+        HdrHistogram merged(total.highest_trackable(), total.significant_figures());
+        for (const auto &slot : window)
+        {
+            merged.merge(slot);
+        }
+        return merged;
+    }
+
+    void reset(int64_t now_ns) noexcept
+    {
+        total.reset();
+        for (auto &slot : window)
+        {
+            slot.reset();
+        }
+        current_slot = 0;
+        slot_start_ns = now_ns;
+        recent.clear();
+    }
+
+    size_t memory_bytes() const noexcept
+    {
+        size_t bytes = sizeof(*this) + total.memory_bytes() + recent.capacity() * sizeof(int64_t);
+        for (const auto &slot : window)
+        {
+            bytes += slot.memory_bytes();
+        }
+        return bytes;
+    }
+
+    HdrHistogram total;
+    std::vector<HdrHistogram> window;  // empty when windowing is disabled
+    size_t current_slot = 0;
+    int64_t slot_ns;
+    int64_t slot_start_ns;
+    RecentRing<int64_t> recent;
+};
+
+inline int64_t steady_now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// ---------------------------------------------------------------------------
+// Clock sources
+//
+// steady      std::chrono::steady_clock (CLOCK_MONOTONIC via the vDSO)
+// tsc         raw rdtsc — cheapest, but may be reordered around the timed code
+// tsc_fenced  lfence; rdtsc; lfence — ordered with respect to loads/instructions
+// rdtscp      rdtscp; lfence — waits for prior instructions to retire
+//
+// TSC backends are only used when the CPU reports an invariant TSC and the
+// kernel still trusts it as its clocksource; otherwise selection falls back to
+// steady. Ticks are converted to ns with a ratio calibrated against
+// CLOCK_MONOTONIC_RAW on first use (NTP slews CLOCK_MONOTONIC, which would
+// leak into the ratio), then anchored to one CLOCK_MONOTONIC reading so TSC
+// readings share steady_clock's epoch.
+// ---------------------------------------------------------------------------
+enum class ClockBackend : uint8_t
+{
+    steady,
+    tsc,
+    tsc_fenced,
+    rdtscp,
+};
+
+inline const char *clock_backend_name(ClockBackend backend)
+{
+    switch (backend)
+    {
+    case ClockBackend::steady:
+        return "steady";
+    case ClockBackend::tsc:
+        return "tsc";
+    case ClockBackend::tsc_fenced:
+        return "tsc_fenced";
+    case ClockBackend::rdtscp:
+        return "rdtscp";
+    }
+    return "steady";
+}
+
+inline ClockBackend parse_clock_backend(const std::string &name)
+{
+    if (name == "steady")
+        return ClockBackend::steady;
+    if (name == "tsc")
+        return ClockBackend::tsc;
+    if (name == "tsc_fenced")
+        return ClockBackend::tsc_fenced;
+    if (name == "rdtscp")
+        return ClockBackend::rdtscp;
+    throw std::invalid_argument("unknown clock backend '" + name +
+                                "' (expected steady, tsc, tsc_fenced or rdtscp)");
+}
+
+inline int64_t clock_ns(clockid_t clock)
+{
+    timespec ts{};
+    clock_gettime(clock, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+inline int64_t monotonic_raw_ns() { return clock_ns(CLOCK_MONOTONIC_RAW); }
+
+struct TscCalibration
+{
+    bool supported = false;  // x86 with rdtsc/rdtscp
+    bool invariant = false;  // CPUID 0x80000007:EDX[8]
+    bool reliable = false;   // invariant and the kernel clocksource is tsc
+    double ns_per_tick = 0.0;
+    uint64_t base_ticks = 0;
+    int64_t base_ns = 0;
+    int64_t calibration_ns = 0;  // how long calibration took
+    std::string reason;          // why the TSC is unreliable, if it is
+
+    double ghz() const { return ns_per_tick > 0.0 ? 1.0 / ns_per_tick : 0.0; }
+};
+
+class Clock
+{
+public:
+    static uint64_t read(ClockBackend backend) noexcept
+    {
+#if LATENCY_TIMER_HAS_TSC
+        switch (backend)
+        {
+        case ClockBackend::steady:
+            break;
+        case ClockBackend::tsc:
+            return __rdtsc();
+        case ClockBackend::tsc_fenced:
+        {
+            _mm_lfence();
+            uint64_t t = __rdtsc();
+            _mm_lfence();
+            return t;
+        }
+        case ClockBackend::rdtscp:
+        {
+            unsigned aux;
+            uint64_t t = __rdtscp(&aux);
+            _mm_lfence();
+            return t;
+        }
+        }
+#else
+        (void)backend;
+#endif
+        return static_cast<uint64_t>(steady_now_ns());
+    }
+
+    // Convert a tick delta from `backend` to nanoseconds.
+    static int64_t delta_ns(ClockBackend backend, uint64_t start, uint64_t end) noexcept
+    {
+        int64_t ticks = static_cast<int64_t>(end - start);
+        if (backend == ClockBackend::steady)
+        {
+            return ticks;
+        }
+        return static_cast<int64_t>(static_cast<double>(ticks) * calibration().ns_per_tick);
+    }
+
+    // Convert a reading from `backend` to steady_clock nanoseconds.
+    static int64_t to_ns(ClockBackend backend, uint64_t ticks) noexcept
+    {
+        if (backend == ClockBackend::steady)
+        {
+            return static_cast<int64_t>(ticks);
+        }
+        const TscCalibration &cal = calibration();
+        return cal.base_ns + delta_ns(backend, cal.base_ticks, ticks);
+    }
+
+    static ClockBackend active() noexcept { return active_.load(std::memory_order_relaxed); }
+
+    // Select a backend; TSC backends fall back to steady when the TSC is not
+    // reliable. Returns the backend actually in use.
+    static ClockBackend select(ClockBackend requested)
+    {
+        if (requested != ClockBackend::steady && !calibration().reliable)
+        {
+            requested = ClockBackend::steady;
+        }
+        active_.store(requested, std::memory_order_relaxed);
+        return requested;
+    }
+
+    static const TscCalibration &calibration()
+    {
+        static const TscCalibration cal = calibrate();
+        return cal;
+    }
+
+private:
+    static TscCalibration calibrate()
+    {
+        TscCalibration cal;
+#if LATENCY_TIMER_HAS_TSC
+        cal.supported = true;
+        unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+        if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+        {
+            cal.invariant = (edx & (1u << 8)) != 0;
+        }
+
+        // The kernel demotes the TSC (e.g. to hpet) when it detects drift
+        // between cores or across suspend; respect that verdict.
+        std::string clocksource;
+        std::ifstream f("/sys/devices/system/clocksource/clocksource0/current_clocksource");
+        if (f)
+        {
+            f >> clocksource;
+        }
+
+        if (!cal.invariant)
+        {
+            cal.reason = "CPU does not report an invariant TSC";
+        }
+        else if (!clocksource.empty() && clocksource != "tsc")
+        {
+            cal.reason = "kernel clocksource is " + clocksource + ", not tsc";
+        }
+        else
+        {
+            cal.reliable = true;
+        }
+
+        // Bracket each TSC read between two reads of `clock` and keep the
+        // tightest pair: CLOCK_MONOTONIC_RAW at the start and end of a ~20 ms
+        // interval for the rate, then CLOCK_MONOTONIC once for the epoch.
+        auto sample = [](clockid_t clock, int64_t &ns, uint64_t &ticks)
+        {
+            int64_t best_gap = INT64_MAX;
+            for (int i = 0; i < 16; ++i)
+            {
+                int64_t before = clock_ns(clock);
+                uint64_t t = __rdtsc();
+                int64_t after = clock_ns(clock);
+                if (after - before < best_gap)
+                {
+                    best_gap = after - before;
+                    ns = before + (after - before) / 2;
+                    ticks = t;
+                }
+            }
+        };
+
+        int64_t start_wall = monotonic_raw_ns();
+        int64_t ns0 = 0, ns1 = 0;
+        uint64_t t0 = 0, t1 = 0;
+        sample(CLOCK_MONOTONIC_RAW, ns0, t0);
+        while (monotonic_raw_ns() - ns0 < 20'000'000)
+        {
+        }
+        sample(CLOCK_MONOTONIC_RAW, ns1, t1);
+        int64_t base_ns = 0;
+        uint64_t base_ticks = 0;
+        sample(CLOCK_MONOTONIC, base_ns, base_ticks);
+        cal.calibration_ns = monotonic_raw_ns() - start_wall;
+
+        if (t1 > t0 && ns1 > ns0)
+        {
+            cal.ns_per_tick = static_cast<double>(ns1 - ns0) / static_cast<double>(t1 - t0);
+            cal.base_ticks = base_ticks;
+            cal.base_ns = base_ns;
+        }
+        else
+        {
+            cal.reliable = false;
+            cal.reason = "TSC did not advance during calibration";
+        }
+#else
+        cal.reason = "rdtsc is not available on this architecture";
+#endif
+        return cal;
+    }
+
+    static inline std::atomic<ClockBackend> active_{ClockBackend::steady};
+};
+
+// ---------------------------------------------------------------------------
+// Hardware performance counters (perf_event_open)
+//
+// Each thread lazily opens one counter group, led by cycles, and reads all
+// members with a single read(). ScopedTimer snapshots the group on entry and
+// exit when counters are enabled. Counters the PMU or kernel refuses (VMs,
+// perf_event_paranoid, missing events) are simply left out of the group.
+//
+// When more events are open than the PMU has counters (other perf users, or
+// the NMI watchdog holding one), the kernel time-slices groups and a span's
+// group may only be on the PMU for part of it. Every read therefore also
+// returns time_enabled and time_running; a span that ran for less than its
+// enabled time has its deltas scaled by enabled / running (perf stat's
+// estimate) and is counted as multiplexed.
+// ---------------------------------------------------------------------------
+enum HwCounter : size_t
+{
+    hw_cycles,
+    hw_instructions,
+    hw_l1d_misses,
+    hw_llc_misses,
+    hw_branch_misses,
+    hw_dtlb_misses,
+    kNumHwCounters,
+};
+
+constexpr const char *kHwCounterNames[kNumHwCounters] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "dtlb_misses"};
+
+constexpr size_t kCounterRingCapacity = 4096;
+
+// Counter deltas for one span.
+struct CounterSample
+{
+    SectionId section;
+    uint32_t valid_mask;  // bit i set if deltas[i] was measured
+    bool multiplexed;     // deltas are scaled estimates, not exact counts
+    uint64_t deltas[kNumHwCounters];
+};
+
+// One group read: raw counts plus the group's scheduling times.
+struct CounterReading
+{
+    uint64_t values[kNumHwCounters];
+    uint64_t time_enabled;  // ns the group was enabled
+    uint64_t time_running;  // ns it was actually on the PMU
+};
+
+class PerfCounterGroup
+{
+public:
+    PerfCounterGroup()
+    {
+        fds_.fill(-1);
+        for (size_t c = 0; c < kNumHwCounters; ++c)
+        {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.exclude_kernel = 1;  // allowed at perf_event_paranoid <= 2
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            describe(static_cast<HwCounter>(c), attr);
+
+            int fd = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, leader_fd_, 0));
+            if (fd < 0)
+            {
+                if (c == hw_cycles)
+                {
+                    error_ = std::string("perf_event_open(cycles) failed: ") + std::strerror(errno);
+                    if (errno == EACCES || errno == EPERM)
+                    {
+                        error_ += " (check /proc/sys/kernel/perf_event_paranoid)";
+                    }
+                    return;
+                }
+                continue;  // optional member; the rest of the group still works
+            }
+            if (c == hw_cycles)
+            {
+                leader_fd_ = fd;
+            }
+            fds_[c] = fd;
+            group_index_[c] = members_++;
+            valid_mask_ |= 1u << c;
+        }
+    }
+
+    ~PerfCounterGroup()
+    {
+        for (int fd : fds_)
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+        }
+    }
+
+    PerfCounterGroup(const PerfCounterGroup &) = delete;
+    PerfCounterGroup &operator=(const PerfCounterGroup &) = delete;
+
+    bool ok() const noexcept { return leader_fd_ >= 0; }
+    uint32_t valid_mask() const noexcept { return valid_mask_; }
+    const std::string &error() const noexcept { return error_; }
+
+    // Current value of every counter in the group (one syscall).
+    bool read(CounterReading &out) const noexcept
+    {
+        // Layout for PERF_FORMAT_GROUP | TOTAL_TIME_ENABLED | TOTAL_TIME_RUNNING
+        struct
+        {
+            uint64_t nr;
+            uint64_t time_enabled;
+            uint64_t time_running;
+            uint64_t values[kNumHwCounters];
+        } buf{};
+        if (::read(leader_fd_, &buf, sizeof(buf)) < static_cast<ssize_t>(sizeof(uint64_t) * (3 + members_)))
+        {
+            return false;
+        }
+        for (size_t c = 0; c < kNumHwCounters; ++c)
+        {
+            out.values[c] = (valid_mask_ >> c) & 1u ? buf.values[group_index_[c]] : 0;
+        }
+        out.time_enabled = buf.time_enabled;
+        out.time_running = buf.time_running;
+        return true;
+    }
+
+private:
+    static void describe(HwCounter counter, perf_event_attr &attr)
+    {
+        auto cache = [](uint64_t id)
+        {
+            return id | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        };
+        switch (counter)
+        {
+        case hw_cycles:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case hw_instructions:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case hw_l1d_misses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache(PERF_COUNT_HW_CACHE_L1D);
+            break;
+        case hw_llc_misses:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case hw_branch_misses:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case hw_dtlb_misses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache(PERF_COUNT_HW_CACHE_DTLB);
+            break;
+        case kNumHwCounters:
+            break;
+        }
+    }
+
+    int leader_fd_ = -1;
+    std::array<int, kNumHwCounters> fds_{};
+    std::array<size_t, kNumHwCounters> group_index_{};
+    size_t members_ = 0;
+    uint32_t valid_mask_ = 0;
+    std::string error_;
+};
+
+inline PerfCounterGroup &thread_perf_group()
+{
+    thread_local PerfCounterGroup group;
+    return group;
+}
+
+struct HwCounterStatus
+{
+    bool available = false;
+    std::vector<std::string> counters;  // events that opened on this machine
+    std::string reason;                 // why counters are unavailable, if they are
+};
+
+inline HwCounterStatus hw_counter_status()
+{
+    const PerfCounterGroup &group = thread_perf_group();
+    HwCounterStatus status;
+    status.available = group.ok();
+    status.reason = group.error();
+    for (size_t c = 0; c < kNumHwCounters; ++c)
+    {
+        if ((group.valid_mask() >> c) & 1u)
+        {
+            status.counters.emplace_back(kHwCounterNames[c]);
+        }
+    }
+    return status;
+}
+
+// Per-section totals, aggregated at merge time.
+struct CounterSummary
+{
+    uint64_t samples = 0;
+    uint64_t multiplexed_samples = 0;  // spans whose deltas were scaled
+    std::array<uint64_t, kNumHwCounters> totals{};
+    uint32_t valid_mask = 0;
+
+    bool has(HwCounter c) const { return (valid_mask >> c) & 1u; }
+    uint64_t total(HwCounter c) const { return totals[c]; }
+
+    double ipc() const
+    {
+        return has(hw_cycles) && has(hw_instructions) && totals[hw_cycles] > 0
+                   ? static_cast<double>(totals[hw_instructions]) / static_cast<double>(totals[hw_cycles])
+                   : 0.0;
+    }
+
+    // Misses per thousand instructions
+    double mpki(HwCounter c) const
+    {
+        return has(c) && has(hw_instructions) && totals[hw_instructions] > 0
+                   ? 1000.0 * static_cast<double>(totals[c]) / static_cast<double>(totals[hw_instructions])
+                   : 0.0;
+    }
+
+    void add(const CounterSample &sample)
+    {
+        ++samples;
+        multiplexed_samples += sample.multiplexed ? 1 : 0;
+        valid_mask |= sample.valid_mask;
+        for (size_t c = 0; c < kNumHwCounters; ++c)
+        {
+            totals[c] += sample.deltas[c];
+        }
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Single-producer / single-consumer ring.
+//
+// The owning thread is the only writer of head_; the merger (holding the
+// Timer's merge mutex) is the only writer of tail_. Each index lives on its
+// own cache line so recording never bounces a line between cores.
+// ---------------------------------------------------------------------------
+template <typename T>
+class SpscRing
+{
+public:
+    explicit SpscRing(size_t capacity)
+        : slots_(std::make_unique<T[]>(capacity)), mask_(capacity - 1)
+    {
+    }
+
+    // Producer side. Returns false if the ring is full.
+    bool push(const T &item) noexcept
+    {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head - cached_tail_ > mask_)
+        {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head - cached_tail_ > mask_)
+            {
+                return false;
+            }
+        }
+        slots_[head & mask_] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Caller must hold the Timer's merge mutex.
+    template <typename Sink>
+    void drain(Sink &&sink)
+    {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        uint64_t head = head_.load(std::memory_order_acquire);
+        for (; tail != head; ++tail)
+        {
+            sink(slots_[tail & mask_]);
+        }
+        tail_.store(tail, std::memory_order_release);
+    }
+
+private:
+    // Producer-owned cache line
+    alignas(kCacheLine) std::atomic<uint64_t> head_{0};
+    uint64_t cached_tail_ = 0;
+
+    // Consumer-owned cache line
+    alignas(kCacheLine) std::atomic<uint64_t> tail_{0};
+
+    alignas(kCacheLine) std::unique_ptr<T[]> slots_;
+    size_t mask_;
+};
+
+// Everything one thread records into. Owned by the Timer, leased to a thread.
+struct ThreadBuffer
+{
+    explicit ThreadBuffer(size_t capacity) : spans(capacity) {}
+
+    // Counter ring, allocated by the owning thread the first time it records
+    // counters and published with a release store for the merger.
+    SpscRing<CounterSample> *counter_ring()
+    {
+        SpscRing<CounterSample> *ring = counters.load(std::memory_order_relaxed);
+        if (ring == nullptr) [[unlikely]]
+        {
+            counters_storage = std::make_unique<SpscRing<CounterSample>>(kCounterRingCapacity);
+            ring = counters_storage.get();
+            counters.store(ring, std::memory_order_release);
+        }
+        return ring;
+    }
+
+    SpscRing<TimingRecord> spans;
+    std::atomic<SpscRing<CounterSample> *> counters{nullptr};
+    std::unique_ptr<SpscRing<CounterSample>> counters_storage;
+
+    // Cleared when the owning thread exits so a new thread can reuse the ring.
+    std::atomic<bool> owned{true};
+
+    // OS thread ID of the current owner; set when the buffer is leased.
+    uint32_t thread_id = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Shared-memory metrics export
+//
+// The merger publishes per-section summaries into a POSIX shared-memory
+// segment that other processes map read-only (see metrics_monitor.py). The
+// segment holds two buffers: the writer fills the one readers are *not*
+// pointed at, then flips `generation`. Each buffer carries its own seqlock so
+// a reader that raced with two publishes detects the torn copy and retries.
+// Readers never take a lock, so they cannot stall the measured process.
+//
+// create() refuses a name that already exists (O_CREAT | O_EXCL), so two
+// exporters can never share a segment by accident. A segment left behind by
+// an exporter that died without unlinking it is taken over with attach(),
+// which checks the layout and that the recorded pid is gone.
+//
+// Layout (little-endian, version 1):
+//   header   64 B   magic, version, header_bytes, record_bytes,
+//                   section_capacity, pid, buffer_bytes, generation
+//   buffer0  64 B buffer header (seq, publish_ns, window_ns, section_count,
+//                   dropped_sections) + section_capacity * SharedSectionMetrics
+//   buffer1  same
+// ---------------------------------------------------------------------------
+constexpr uint32_t kMetricsMagic = 0x584D544C;  // "LTMX"
+constexpr uint32_t kMetricsVersion = 1;
+constexpr size_t kMetricsLog2Buckets = 64;
+constexpr size_t kDefaultMetricsSections = 256;
+
+struct SharedSectionMetrics
+{
+    char name[64];  // NUL-padded, truncated to 63 bytes
+    uint64_t count;  // samples in the rolling window (all samples if no window)
+    uint64_t total_count;
+    uint64_t min_ns;
+    uint64_t max_ns;
+    uint64_t mean_ns;
+    uint64_t p50_ns;
+    uint64_t p90_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+    uint64_t log2_buckets[kMetricsLog2Buckets];  // bucket i: [2^i, 2^(i+1)) ns
+};
+static_assert(sizeof(SharedSectionMetrics) == 648, "shared layout is part of the wire format");
+
+struct SharedMetricsHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_bytes;
+    uint32_t record_bytes;
+    uint32_t section_capacity;
+    uint32_t pid;
+    uint64_t buffer_bytes;
+    uint64_t generation;  // number of publishes; readers use buffer generation & 1
+    uint8_t reserved[24];
+};
+static_assert(sizeof(SharedMetricsHeader) == 64);
+
+struct SharedBufferHeader
+{
+    uint64_t seq;  // odd while the buffer is being written
+    int64_t publish_ns;  // CLOCK_MONOTONIC, comparable across processes
+    int64_t window_ns;  // 0: percentiles cover everything since reset()
+    uint32_t section_count;
+    uint32_t dropped_sections;  // sections that did not fit section_capacity
+    uint8_t reserved[32];
+};
+static_assert(sizeof(SharedBufferHeader) == 64);
+
+class MetricsSegment
+{
+public:
+    // Create a new segment; fails if one named `name` already exists.
+    static std::unique_ptr<MetricsSegment> create(const std::string &name, size_t section_capacity)
+    {
+        check_name(name);
+        if (section_capacity == 0)
+        {
+            throw std::invalid_argument("section_capacity must be > 0");
+        }
+        size_t buffer_bytes = sizeof(SharedBufferHeader) + section_capacity * sizeof(SharedSectionMetrics);
+        size_t bytes = sizeof(SharedMetricsHeader) + 2 * buffer_bytes;
+
+        int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0)
+        {
+            if (errno == EEXIST)
+            {
+                throw std::runtime_error("metrics segment " + name +
+                                         " already exists; if its exporter has exited, take it over "
+                                         "with attach_metrics_export()");
+            }
+            throw std::runtime_error("shm_open(" + name + ") failed: " + std::strerror(errno));
+        }
+        if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0)
+        {
+            int err = errno;
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+            throw std::runtime_error("ftruncate(" + name + ") failed: " + std::strerror(err));
+        }
+        void *addr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED)
+        {
+            ::shm_unlink(name.c_str());
+            throw std::runtime_error("mmap(" + name + ") failed: " + std::strerror(errno));
+        }
+        std::unique_ptr<MetricsSegment> segment(
+            new MetricsSegment(name, section_capacity, buffer_bytes, bytes, static_cast<uint8_t *>(addr)));
+        std::memset(segment->base_, 0, bytes);
+
+        SharedMetricsHeader *h = segment->header();
+        h->version = kMetricsVersion;
+        h->header_bytes = sizeof(SharedMetricsHeader);
+        h->record_bytes = sizeof(SharedSectionMetrics);
+        h->section_capacity = static_cast<uint32_t>(section_capacity);
+        h->pid = static_cast<uint32_t>(::getpid());
+        h->buffer_bytes = buffer_bytes;
+        // Magic last: a reader that sees it also sees a complete header.
+        std::atomic_ref<uint32_t>(h->magic).store(kMetricsMagic, std::memory_order_release);
+        return segment;
+    }
+
+    // Take over an existing segment whose exporter has exited. The layout
+    // and capacity are kept, and publishing continues from its generation,
+    // so monitors still watching the name pick up the new process.
+    static std::unique_ptr<MetricsSegment> attach(const std::string &name)
+    {
+        check_name(name);
+        int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0)
+        {
+            throw std::runtime_error("shm_open(" + name + ") failed: " + std::strerror(errno));
+        }
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SharedMetricsHeader))
+        {
+            ::close(fd);
+            throw std::runtime_error(name + " is too small to be a metrics segment");
+        }
+        size_t mapped = static_cast<size_t>(st.st_size);
+        void *addr = ::mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED)
+        {
+            throw std::runtime_error("mmap(" + name + ") failed: " + std::strerror(errno));
+        }
+
+        auto *h = static_cast<SharedMetricsHeader *>(addr);
+        size_t capacity = h->section_capacity;
+        size_t buffer_bytes = sizeof(SharedBufferHeader) + capacity * sizeof(SharedSectionMetrics);
+        size_t bytes = sizeof(SharedMetricsHeader) + 2 * buffer_bytes;
+        std::string problem;
+        if (std::atomic_ref<uint32_t>(h->magic).load(std::memory_order_acquire) != kMetricsMagic)
+        {
+            problem = " is not a latency_timer metrics segment";
+        }
+        else if (h->version != kMetricsVersion || h->header_bytes != sizeof(SharedMetricsHeader) ||
+                 h->record_bytes != sizeof(SharedSectionMetrics) || capacity == 0 ||
+                 h->buffer_bytes != buffer_bytes || bytes > mapped)
+        {
+            problem = " has layout version " + std::to_string(h->version) + ", expected " +
+                      std::to_string(kMetricsVersion);
+        }
+        else if (pid_alive(static_cast<pid_t>(h->pid)))
+        {
+            problem = " is still exported by running process " + std::to_string(h->pid);
+        }
+        if (!problem.empty())
+        {
+            ::munmap(addr, mapped);
+            throw std::runtime_error(name + problem);
+        }
+
+        std::unique_ptr<MetricsSegment> segment(
+            new MetricsSegment(name, capacity, buffer_bytes, mapped, static_cast<uint8_t *>(addr)));
+        std::atomic_ref<uint32_t>(segment->header()->pid).store(static_cast<uint32_t>(::getpid()),
+                                                                std::memory_order_release);
+        return segment;
+    }
+
+    ~MetricsSegment()
+    {
+        ::munmap(base_, bytes_);
+        ::shm_unlink(name_.c_str());  // attached readers keep their mapping
+    }
+
+    MetricsSegment(const MetricsSegment &) = delete;
+    MetricsSegment &operator=(const MetricsSegment &) = delete;
+
+    const std::string &name() const noexcept { return name_; }
+    size_t capacity() const noexcept { return capacity_; }
+
+    // Single writer (the caller holds the Timer's merge mutex). `fill` writes
+    // up to capacity() records and returns how many it wrote.
+    template <typename Fill>
+    void publish(int64_t window_ns, Fill &&fill)
+    {
+        std::atomic_ref<uint64_t> generation(header()->generation);
+        uint64_t next = generation.load(std::memory_order_relaxed) + 1;
+        uint8_t *buffer = base_ + sizeof(SharedMetricsHeader) + (next & 1) * buffer_bytes_;
+        auto *bh = reinterpret_cast<SharedBufferHeader *>(buffer);
+        auto *records = reinterpret_cast<SharedSectionMetrics *>(buffer + sizeof(SharedBufferHeader));
+
+        std::atomic_ref<uint64_t> seq(bh->seq);
+        uint64_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        auto [written, dropped] = fill(records, capacity_);
+        bh->publish_ns = monotonic_ns();
+        bh->window_ns = window_ns;
+        bh->section_count = static_cast<uint32_t>(written);
+        bh->dropped_sections = static_cast<uint32_t>(dropped);
+
+        seq.store(s + 2, std::memory_order_release);
+        generation.store(next, std::memory_order_release);
+    }
+
+    uint64_t generation() const noexcept
+    {
+        return std::atomic_ref<uint64_t>(header()->generation).load(std::memory_order_acquire);
+    }
+
+private:
+    MetricsSegment(const std::string &name, size_t capacity, size_t buffer_bytes, size_t bytes, uint8_t *base)
+        : name_(name), capacity_(capacity), buffer_bytes_(buffer_bytes), bytes_(bytes), base_(base)
+    {
+    }
+
+    static void check_name(const std::string &name)
+    {
+        if (name.size() < 2 || name[0] != '/' || name.find('/', 1) != std::string::npos)
+        {
+            throw std::invalid_argument("segment name must look like /name");
+        }
+    }
+
+    // Our own pid counts as alive: this process already owns the segment.
+    static bool pid_alive(pid_t pid) noexcept
+    {
+        if (pid <= 0)
+        {
+            return false;
+        }
+        return pid == ::getpid() || ::kill(pid, 0) == 0 || errno == EPERM;
+    }
+
+    static int64_t monotonic_ns() noexcept
+    {
+        timespec ts{};
+        ::clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+    }
+
+    SharedMetricsHeader *header() const noexcept { return reinterpret_cast<SharedMetricsHeader *>(base_); }
+
+    std::string name_;
+    size_t capacity_;
+    size_t buffer_bytes_ = 0;
+    size_t bytes_ = 0;
+    uint8_t *base_ = nullptr;
+};
+
+// Fill one shared record from a histogram (the rolling window, if enabled).
+inline void fill_shared_metrics(SharedSectionMetrics &out, const std::string &name,
+                                const HdrHistogram &hist, uint64_t total_count)
+{
+    std::memset(&out, 0, sizeof(out));
+    std::memcpy(out.name, name.data(), std::min(name.size(), sizeof(out.name) - 1));
+    out.count = hist.count();
+    out.total_count = total_count;
+    out.min_ns = static_cast<uint64_t>(hist.min());
+    out.max_ns = static_cast<uint64_t>(hist.max());
+    out.mean_ns = static_cast<uint64_t>(hist.mean());
+    out.p50_ns = static_cast<uint64_t>(hist.value_at_percentile(50.0));
+    out.p90_ns = static_cast<uint64_t>(hist.value_at_percentile(90.0));
+    out.p99_ns = static_cast<uint64_t>(hist.value_at_percentile(99.0));
+    out.p999_ns = static_cast<uint64_t>(hist.value_at_percentile(99.9));
+    hist.for_each_bucket([&out](int64_t value, uint64_t n)
+                         {
+        auto v = static_cast<uint64_t>(value);
+        size_t bucket = v < 2 ? 0 : static_cast<size_t>(std::bit_width(v) - 1);
+        out.log2_buckets[std::min(bucket, kMetricsLog2Buckets - 1)] += n; });
+}
+
+class Timer
+{
+public:
+    static Timer &instance()
+    {
+        static Timer t;
+        return t;
+    }
+
+    ~Timer()
+    {
+        stop_background_merge();
+        if (trace_file_)
+        {
+            stop_trace();
+        }
+        metrics_.reset();
+    }
+
+    // Intern a section name. Idempotent: the same name always maps to the
+    // same ID. Call once at setup and keep the ID for the hot path.
+    SectionId register_section(const std::string &name)
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex_);
+        auto it = ids_.find(name);
+        if (it != ids_.end())
+        {
+            return it->second;
+        }
+        auto id = static_cast<SectionId>(names_.size());
+        names_.push_back(name);
+        ids_.emplace(name, id);
+        section_count_.store(id + 1, std::memory_order_release);
+        return id;
+    }
+
+    // Reject IDs that register_section() never handed out, before they
+    // reach the merger: it indexes per-section tables by ID and looks the
+    // name up with section_name(). Lock-free, so it stays on the hot path.
+    void check_section(SectionId id) const
+    {
+        if (id >= section_count_.load(std::memory_order_acquire))
+        {
+            throw std::invalid_argument("unknown section id " + std::to_string(id) +
+                                        "; get IDs from register_section()");
+        }
+    }
+
+    std::string section_name(SectionId id) const
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex_);
+        if (id >= names_.size())
+        {
+            throw std::out_of_range("unknown section id " + std::to_string(id));
+        }
+        return names_[id];
+    }
+
+    void record(const std::string &name, int64_t elapsed_ns)
+    {
+        record_id(register_section(name), elapsed_ns);
+    }
+
+    void record_id(SectionId id, int64_t elapsed_ns)
+    {
+        check_section(id);
+        record_span({id, kNoSection, 0, 0, kNoTimestamp, elapsed_ns});
+    }
+
+    // Hot path: a thread-local ring write. No locks, no allocation.
+    void record_span(TimingRecord record)
+    {
+        ThreadBuffer &buf = local_buffer();
+        record.thread_id = buf.thread_id;
+        push_or_merge(buf.spans, record);
+    }
+
+    void record_counters(const CounterSample &sample)
+    {
+        push_or_merge(*local_buffer().counter_ring(), sample);
+    }
+
+    // Snapshot hardware counters around every ScopedTimer. Returns whether
+    // counting is on: enabling fails (returns false) when perf_event_open is
+    // unavailable, see hw_counter_status().
+    bool set_hw_counters(bool enabled)
+    {
+        bool on = enabled && thread_perf_group().ok();
+        hw_counters_enabled_.store(on, std::memory_order_relaxed);
+        return on;
+    }
 
-class Timer
-{
-public:
-    static Timer &instance()
+    bool hw_counters_enabled() const noexcept { return hw_counters_enabled_.load(std::memory_order_relaxed); }
+
+    CounterSummary counters_for(const std::string &name)
     {
-        static Timer t;
-        return t;
+        SectionId id = register_section(name);
+        collect();
+        std::lock_guard<std::mutex> lock(merge_mutex_);
+        return id < counter_totals_.size() ? counter_totals_[id] : CounterSummary{};
     }
 
-    void record(const std::string &name, int64_t elapsed_ns)
+    // Slow path when a ring is full because nobody merged recently: merge on
+    // this thread rather than lose the sample. Run a background merge (or call
+    // collect() regularly) to keep recording off this path.
+    template <typename T>
+    void push_or_merge(SpscRing<T> &ring, const T &item)
+    {
+        if (ring.push(item)) [[likely]]
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(merge_mutex_);
+        collect_locked();
+        ring.push(item);
+        overflow_merges_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Merge all per-thread rings into the aggregate. Recording threads are
+    // never blocked by this.
+    void collect()
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        records_.push_back({name, elapsed_ns});
-        by_name_[name].push_back(elapsed_ns);
+        bool trace_pending;
+        {
+            std::lock_guard<std::mutex> lock(merge_mutex_);
+            collect_locked();
+            trace_pending = !trace_pending_.empty();
+        }
+        if (trace_pending)
+        {
+            flush_trace();
+        }
     }
 
-    std::vector<std::string> section_names() const
+    // Merge periodically from a background thread so rings never fill up.
+    void start_background_merge(int64_t interval_ms)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        std::vector<std::string> names;
-        names.reserve(by_name_.size());
-        for (const auto &[name, _] : by_name_)
+        if (interval_ms <= 0)
         {
-            names.push_back(name);
+            throw std::invalid_argument("interval_ms must be > 0");
         }
-        return names;
+        stop_background_merge();
+        {
+            std::lock_guard<std::mutex> lock(merger_mutex_);
+            merger_stop_ = false;
+        }
+        merger_ = std::thread([this, interval_ms]
+                              {
+            std::unique_lock<std::mutex> lock(merger_mutex_);
+            while (!merger_cv_.wait_for(lock, std::chrono::milliseconds(interval_ms),
+                                        [this] { return merger_stop_; }))
+            {
+                lock.unlock();
+                collect();
+                lock.lock();
+            } });
     }
 
-    std::vector<int64_t> timings_for(const std::string &name) const
+    void stop_background_merge()
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = by_name_.find(name);
-        if (it == by_name_.end())
         {
-            return {};
+            std::lock_guard<std::mutex> lock(merger_mutex_);
+            merger_stop_ = true;
+        }
+        merger_cv_.notify_all();
+        if (merger_.joinable())
+        {
+            merger_.join();
+        }
+    }
+
+    bool background_merge_running() const { return merger_.joinable(); }
+
+    std::vector<std::string> section_names()
+    {
+        collect();
+        std::lock_guard<std::mutex> lock(merge_mutex_);
+        std::vector<std::string> names;
+        for (SectionId id = 0; id < sections_.size(); ++id)
+        {
+            if (sections_[id] && sections_[id]->total.count() > 0)
+            {
+                names.push_back(section_name(id));
+            }
         }
-        return it->second;
+        return names;
+    }
+
+    // The most recent raw samples for a section (up to 1024), oldest first.
+    std::vector<int64_t> timings_for(const std::string &name)
+    {
+        SectionId id = register_section(name);
+        collect();
+        std::lock_guard<std::mutex> lock(merge_mutex_);
+        const SectionStats *stats = find_section(id);
+        return stats ? stats->recent.to_vector() : std::vector<int64_t>{};
     }
 
-    std::vector<int64_t> all_timings_ns() const
+    // The most recent raw samples across all sections (up to 8192), in merge order.
+    std::vector<int64_t> all_timings_ns()
     {
-        std::lock_guard<std::mutex> lock(mutex_);
+        collect();
+        std::lock_guard<std::mutex> lock(merge_mutex_);
         std::vector<int64_t> result;
-        result.reserve(records_.size());
-        for (const auto &r : records_)
+        for (const auto &r : recent_.to_vector())
         {
             result.push_back(r.elapsed_ns);
         }
         return result;
     }
 
-    std::vector<std::string> all_names() const
+    std::vector<std::string> all_names()
     {
-        std::lock_guard<std::mutex> lock(mutex_);
+        collect();
+        std::lock_guard<std::mutex> lock(merge_mutex_);
         std::vector<std::string> result;
-        result.reserve(records_.size());
-        for (const auto &r : records_)
+        for (const auto &r : recent_.to_vector())
         {
-            result.push_back(r.name);
+            result.push_back(section_name(r.section));
         }
         return result;
     }
 
-    size_t count() const
+    size_t count()
+    {
+        collect();
+        std::lock_guard<std::mutex> lock(merge_mutex_);
+        return total_count_;
+    }
+
+    size_t count_for(const std::string &name)
+    {
+        SectionId id = register_section(name);
+        collect();
+        std::lock_guard<std::mutex> lock(merge_mutex_);
+        const SectionStats *stats = find_section(id);
+        return stats ? stats->total.count() : 0;
+    }
+
+    // Latency (ns) at the given percentile (0-100) over all samples.
+    int64_t percentile_for(const std::string &name, double percentile)
+    {
+        SectionId id = register_section(name);
+        collect();
+        std::lock_guard<std::mutex> lock(merge_mutex_);
+        const SectionStats *stats = find_section(id);
+        return stats ? stats->total.value_at_percentile(percentile) : 0;
+    }
+
+    LatencySummary summary_for(const std::string &name)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return records_.size();
+        return LatencySummary::from(histogram_for(name));
     }
 
-    size_t count_for(const std::string &name) const
+    // Summary over roughly the last `window_seconds` (see configure_window).
+    LatencySummary window_summary_for(const std::string &name)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = by_name_.find(name);
-        if (it == by_name_.end())
+        SectionId id = register_section(name);
+        collect();
+        std::lock_guard<std::mutex> lock(merge_mutex_);
+        if (window_slots_ == 0)
         {
-            return 0;
+            throw std::runtime_error("windowed histograms are disabled; call configure_window() first");
+        }
+        SectionStats *stats = find_section(id);
+        if (!stats)
+        {
+            return {};
+        }
+        stats->rotate(steady_now_ns());
+        return LatencySummary::from(stats->window_histogram());
+    }
+
+    // Copy of a section's all-time histogram.
+    HdrHistogram histogram_for(const std::string &name)
+    {
+        SectionId id = register_section(name);
+        collect();
+        std::lock_guard<std::mutex> lock(merge_mutex_);
+        const SectionStats *stats = find_section(id);
+        return stats ? stats->total : HdrHistogram(highest_trackable_ns_, significant_figures_);
+    }
+
+    size_t section_memory_bytes(const std::string &name)
+    {
+        SectionId id = register_section(name);
+        collect();
+        std::lock_guard<std::mutex> lock(merge_mutex_);
+        const SectionStats *stats = find_section(id);
+        return stats ? stats->memory_bytes() : 0;
+    }
+
+    // Histogram range/precision for all sections. Clears recorded data.
+    void configure_histograms(int64_t highest_trackable_ns, int significant_figures)
+    {
+        HdrHistogram probe(highest_trackable_ns, significant_figures);  // validates
+        std::lock_guard<std::mutex> lock(merge_mutex_);
+        collect_locked();
+        highest_trackable_ns_ = highest_trackable_ns;
+        significant_figures_ = significant_figures;
+        clear_locked();
+    }
+
+    // Keep per-section histograms for the last `window_seconds`, rotated in
+    // `slots` steps (0 disables). Clears recorded data.
+    void configure_window(double window_seconds, size_t slots)
+    {
+        if (slots > 0 && window_seconds <= 0.0)
+        {
+            throw std::invalid_argument("window_seconds must be > 0");
+        }
+        std::lock_guard<std::mutex> lock(merge_mutex_);
+        collect_locked();
+        window_slots_ = slots;
+        slot_ns_ = slots > 0 ? std::max<int64_t>(1, static_cast<int64_t>(window_seconds * 1e9 / static_cast<double>(slots))) : 0;
+        clear_locked();
+    }
+
+    int64_t highest_trackable_ns() const { return highest_trackable_ns_; }
+    int significant_figures() const { return significant_figures_; }
+
+    // Times a recording thread found its ring full and had to merge itself.
+    uint64_t overflow_merges() const { return overflow_merges_.load(std::memory_order_relaxed); }
+
+    size_t thread_buffer_count() const
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        return buffers_.size();
+    }
+
+    size_t thread_buffer_capacity() const { return thread_capacity_.load(); }
+
+    // Capacity (rounded up to a power of two) for rings created from now on.
+    void set_thread_buffer_capacity(size_t capacity)
+    {
+        if (capacity < 2)
+        {
+            throw std::invalid_argument("capacity must be >= 2");
+        }
+        size_t pow2 = 2;
+        while (pow2 < capacity)
+        {
+            pow2 <<= 1;
         }
-        return it->second.size();
+        thread_capacity_.store(pow2);
     }
 
     void reset()
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        records_.clear();
-        by_name_.clear();
+        std::lock_guard<std::mutex> lock(merge_mutex_);
+        collect_locked();
+        int64_t now = steady_now_ns();
+        for (auto &stats : sections_)
+        {
+            if (stats)
+            {
+                stats->reset(now);
+            }
+        }
+        children_.clear();
+        counter_totals_.clear();
+        recent_.clear();
+        total_count_ = 0;
+    }
+
+    // Start streaming every span merged from now on to a Chrome trace-event
+    // JSON file (open in ui.perfetto.dev or chrome://tracing). A merge only
+    // formats the spans it drains into a buffer; collect(), the background
+    // merger and stop_trace() write it out after releasing the merge lock, so
+    // neither recording threads nor other merges wait on file I/O.
+    void start_trace(const std::string &path)
+    {
+        std::lock_guard<std::mutex> io(trace_io_mutex_);
+        if (trace_file_)
+        {
+            throw std::runtime_error("a trace is already being written");
+        }
+        std::FILE *file = std::fopen(path.c_str(), "w");
+        if (!file)
+        {
+            throw std::runtime_error("cannot open trace file " + path);
+        }
+        std::fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+        std::lock_guard<std::mutex> lock(merge_mutex_);
+        collect_locked();  // earlier spans are not part of this trace
+        trace_file_ = file;
+        trace_events_ = 0;
+        trace_names_.clear();
+        trace_pending_.clear();
+    }
+
+    // Merge outstanding spans, finish the JSON document and close the file.
+    // Returns the number of span events written.
+    uint64_t stop_trace()
+    {
+        std::lock_guard<std::mutex> io(trace_io_mutex_);
+        std::FILE *file = nullptr;
+        std::string pending;
+        uint64_t events = 0;
+        {
+            std::lock_guard<std::mutex> lock(merge_mutex_);
+            if (!trace_file_)
+            {
+                throw std::runtime_error("no trace is being written");
+            }
+            collect_locked();
+            file = std::exchange(trace_file_, nullptr);
+            pending.swap(trace_pending_);
+            events = trace_events_;
+        }
+        std::fwrite(pending.data(), 1, pending.size(), file);
+        std::fprintf(file,
+                     "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+                     "\"args\":{\"name\":\"latency_timer\"}}\n]}\n",
+                     events ? ",\n" : "\n", static_cast<int>(::getpid()));
+        std::fclose(file);
+        return events;
+    }
+
+    bool tracing() const { return trace_file_ != nullptr; }
+
+    // Publish per-section percentiles into a shared-memory segment that
+    // external monitors attach to read-only (metrics_monitor.py). Publishing
+    // happens at merge time, at most once per interval, so recording threads
+    // are unaffected; a background merge is started if none is running.
+    // Returns the segment name (default "/latency_timer.<pid>").
+    // The segment must not exist yet; see attach_metrics_export().
+    std::string start_metrics_export(const std::string &name, int64_t interval_ms, size_t max_sections)
+    {
+        std::string segment = name.empty() ? "/latency_timer." + std::to_string(::getpid()) : name;
+        return begin_metrics_export(interval_ms, [&]
+                                    { return MetricsSegment::create(segment, max_sections); });
+    }
+
+    // Like start_metrics_export, but take over an existing segment left by
+    // an exporter that exited without unlinking it (e.g. a crashed tracker
+    // restarted under the same name). Fails if that exporter is still alive.
+    std::string attach_metrics_export(const std::string &name, int64_t interval_ms)
+    {
+        return begin_metrics_export(interval_ms, [&]
+                                    { return MetricsSegment::attach(name); });
+    }
+
+    // Unlink the segment. Monitors already attached keep the last snapshot.
+    void stop_metrics_export()
+    {
+        {
+            std::lock_guard<std::mutex> lock(merge_mutex_);
+            if (!metrics_)
+            {
+                throw std::runtime_error("no metrics segment is being exported");
+            }
+            metrics_.reset();
+        }
+        if (merger_owned_by_metrics_)
+        {
+            stop_background_merge();
+            merger_owned_by_metrics_ = false;
+        }
+    }
+
+    // Merge and publish now, regardless of the interval. Returns the
+    // segment's generation (number of publishes so far).
+    uint64_t publish_metrics()
+    {
+        std::lock_guard<std::mutex> lock(merge_mutex_);
+        if (!metrics_)
+        {
+            throw std::runtime_error("no metrics segment is being exported");
+        }
+        collect_locked();
+        publish_metrics_locked(steady_now_ns());
+        return metrics_->generation();
+    }
+
+    bool metrics_exporting()
+    {
+        std::lock_guard<std::mutex> lock(merge_mutex_);
+        return metrics_ != nullptr;
+    }
+
+    // Time spent in each direct child of `name`: (child, count, total_ns).
+    std::vector<std::tuple<std::string, uint64_t, int64_t>> children_of(const std::string &name)
+    {
+        SectionId parent = register_section(name);
+        collect();
+        std::lock_guard<std::mutex> lock(merge_mutex_);
+        std::vector<std::tuple<std::string, uint64_t, int64_t>> result;
+        for (const auto &[key, stats] : children_)
+        {
+            if (static_cast<SectionId>(key >> 32) == parent)
+            {
+                result.emplace_back(section_name(static_cast<SectionId>(key & 0xffffffffu)),
+                                    stats.count, stats.total_ns);
+            }
+        }
+        std::sort(result.begin(), result.end(), [](const auto &a, const auto &b)
+                  { return std::get<2>(a) > std::get<2>(b); });
+        return result;
     }
 
 private:
+    struct ChildStats
+    {
+        uint64_t count = 0;
+        int64_t total_ns = 0;
+    };
+
     Timer() = default;
-    mutable std::mutex mutex_;
-    std::vector<TimingRecord> records_;
-    std::unordered_map<std::string, std::vector<int64_t>> by_name_;
+
+    // Ties a ring to the current thread; releases it for reuse at thread exit.
+    struct BufferLease
+    {
+        ThreadBuffer *buffer = nullptr;
+        ~BufferLease()
+        {
+            if (buffer)
+            {
+                buffer->owned.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    ThreadBuffer &local_buffer()
+    {
+        thread_local BufferLease lease;
+        if (lease.buffer == nullptr) [[unlikely]]
+        {
+            lease.buffer = acquire_thread_buffer();
+            lease.buffer->thread_id = static_cast<uint32_t>(::syscall(SYS_gettid));
+        }
+        return *lease.buffer;
+    }
+
+    // Slow path, once per thread: reuse a ring whose thread has exited, or
+    // allocate a new one. Rings are owned by the Timer so samples recorded by
+    // short-lived threads survive until the next merge.
+    ThreadBuffer *acquire_thread_buffer()
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        for (auto &buf : buffers_)
+        {
+            bool expected = false;
+            if (buf->owned.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+            {
+                return buf.get();
+            }
+        }
+        buffers_.push_back(std::make_unique<ThreadBuffer>(thread_capacity_.load()));
+        return buffers_.back().get();
+    }
+
+    void collect_locked()
+    {
+        int64_t now = steady_now_ns();
+        for (auto &stats : sections_)
+        {
+            if (stats)
+            {
+                stats->rotate(now);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        for (auto &buf : buffers_)
+        {
+            if (auto *counters = buf->counters.load(std::memory_order_acquire))
+            {
+                counters->drain([this](const CounterSample &c)
+                                {
+                    if (c.section >= counter_totals_.size())
+                    {
+                        counter_totals_.resize(c.section + 1);
+                    }
+                    counter_totals_[c.section].add(c); });
+            }
+            buf->spans.drain([this, now](const TimingRecord &r)
+                       {
+                section_stats(r.section, now).record(r.elapsed_ns);
+                recent_.push(r);
+                ++total_count_;
+                if (r.parent != kNoSection)
+                {
+                    ChildStats &child = children_[(uint64_t{r.parent} << 32) | r.section];
+                    ++child.count;
+                    child.total_ns += r.elapsed_ns;
+                }
+                if (trace_file_ && r.begin_ns != kNoTimestamp)
+                {
+                    append_trace_event(r);
+                } });
+        }
+        if (metrics_ && now - last_publish_ns_ >= metrics_interval_ns_)
+        {
+            publish_metrics_locked(now);
+        }
+    }
+
+    template <typename Open>
+    std::string begin_metrics_export(int64_t interval_ms, Open &&open)
+    {
+        if (interval_ms <= 0)
+        {
+            throw std::invalid_argument("interval_ms must be > 0");
+        }
+        std::string segment;
+        {
+            std::lock_guard<std::mutex> lock(merge_mutex_);
+            if (metrics_)
+            {
+                throw std::runtime_error("metrics are already being exported to " + metrics_->name());
+            }
+            metrics_ = open();
+            segment = metrics_->name();
+            metrics_interval_ns_ = interval_ms * 1'000'000;
+            publish_metrics_locked(steady_now_ns());
+        }
+        if (!background_merge_running())
+        {
+            start_background_merge(interval_ms);
+            merger_owned_by_metrics_ = true;
+        }
+        return segment;
+    }
+
+    void publish_metrics_locked(int64_t now_ns)
+    {
+        last_publish_ns_ = now_ns;
+        int64_t window_ns = static_cast<int64_t>(window_slots_) * slot_ns_;
+        metrics_->publish(window_ns, [this](SharedSectionMetrics *records, size_t capacity)
+                          {
+            size_t written = 0;
+            size_t dropped = 0;
+            for (SectionId id = 0; id < sections_.size(); ++id)
+            {
+                const SectionStats *stats = sections_[id].get();
+                if (!stats)
+                {
+                    continue;
+                }
+                if (written == capacity)
+                {
+                    ++dropped;
+                    continue;
+                }
+                if (stats->window.empty())
+                {
+                    fill_shared_metrics(records[written], section_name(id), stats->total, stats->total.count());
+                }
+                else
+                {
+                    fill_shared_metrics(records[written], section_name(id), stats->window_histogram(),
+                                        stats->total.count());
+                }
+                ++written;
+            }
+            return std::pair{written, dropped}; });
+    }
+
+    // Write out the events merges have buffered since the last flush. Called
+    // without merge_mutex_; trace_io_mutex_ keeps the chunks in merge order
+    // and the file open while they are written.
+    void flush_trace()
+    {
+        std::lock_guard<std::mutex> io(trace_io_mutex_);
+        std::string pending;
+        {
+            std::lock_guard<std::mutex> lock(merge_mutex_);
+            pending.swap(trace_pending_);
+        }
+        if (trace_file_ && !pending.empty())
+        {
+            std::fwrite(pending.data(), 1, pending.size(), trace_file_);
+            std::fflush(trace_file_);
+        }
+    }
+
+    // Chrome trace-event "complete" event; timestamps are microseconds.
+    // Buffered in trace_pending_ until the next flush_trace().
+    void append_trace_event(const TimingRecord &r)
+    {
+        if (r.section >= trace_names_.size())
+        {
+            trace_names_.resize(r.section + 1);
+        }
+        if (trace_names_[r.section].empty())
+        {
+            trace_names_[r.section] = json_escape(section_name(r.section));
+        }
+        char fields[192];
+        std::snprintf(fields, sizeof(fields),
+                      "\",\"cat\":\"latency_timer\",\"ph\":\"X\","
+                      "\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%u,"
+                      "\"args\":{\"depth\":%u}}",
+                      static_cast<double>(r.begin_ns) / 1e3,
+                      static_cast<double>(r.elapsed_ns) / 1e3,
+                      static_cast<int>(::getpid()), r.thread_id, r.depth);
+        trace_pending_ += trace_events_ ? ",\n{\"name\":\"" : "\n{\"name\":\"";
+        trace_pending_ += trace_names_[r.section];
+        trace_pending_ += fields;
+        ++trace_events_;
+    }
+
+    static std::string json_escape(const std::string &in)
+    {
+        std::string out;
+        for (char c : in)
+        {
+            if (c == '"' || c == '\\')
+            {
+                out += '\\';
+                out += c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            }
+            else
+            {
+                out += c;
+            }
+        }
+        return out;
+    }
+
+    // Created on first sample, so memory is only spent on sections in use.
+    SectionStats &section_stats(SectionId id, int64_t now_ns)
+    {
+        if (id >= sections_.size())
+        {
+            sections_.resize(id + 1);
+        }
+        if (!sections_[id])
+        {
+            sections_[id] = std::make_unique<SectionStats>(
+                highest_trackable_ns_, significant_figures_, window_slots_, slot_ns_, now_ns);
+        }
+        return *sections_[id];
+    }
+
+    SectionStats *find_section(SectionId id)
+    {
+        return id < sections_.size() ? sections_[id].get() : nullptr;
+    }
+
+    void clear_locked()
+    {
+        sections_.clear();
+        children_.clear();
+        counter_totals_.clear();
+        recent_.clear();
+        total_count_ = 0;
+    }
+
+    // Section registry (name <-> ID)
+    mutable std::mutex registry_mutex_;
+    std::deque<std::string> names_;
+    std::unordered_map<std::string, SectionId> ids_;
+    std::atomic<SectionId> section_count_{0};  // names_.size(), readable without the lock
+
+    // Per-thread rings
+    mutable std::mutex buffers_mutex_;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+    std::atomic<size_t> thread_capacity_{kDefaultThreadCapacity};
+    std::atomic<uint64_t> overflow_merges_{0};
+
+    // Merged statistics (guarded by merge_mutex_)
+    std::mutex merge_mutex_;
+    std::vector<std::unique_ptr<SectionStats>> sections_;
+    RecentRing<TimingRecord> recent_{kRecentRecords};
+    uint64_t total_count_ = 0;
+    int64_t highest_trackable_ns_ = kDefaultHighestTrackableNs;
+    int significant_figures_ = kDefaultSignificantFigures;
+    size_t window_slots_ = 0;
+    int64_t slot_ns_ = 0;
+    std::unordered_map<uint64_t, ChildStats> children_;  // key: parent << 32 | child
+    std::vector<CounterSummary> counter_totals_;
+    std::atomic<bool> hw_counters_enabled_{false};
+
+    // Trace export (guarded by merge_mutex_; trace_file_ changes only while
+    // trace_io_mutex_ is held too, so holding either one is enough to read it)
+    std::mutex trace_io_mutex_;  // taken before merge_mutex_, never after
+    std::FILE *trace_file_ = nullptr;
+    uint64_t trace_events_ = 0;
+    std::vector<std::string> trace_names_;
+    std::string trace_pending_;  // formatted events not yet written
+
+    // Shared-memory metrics export (guarded by merge_mutex_)
+    std::unique_ptr<MetricsSegment> metrics_;
+    int64_t metrics_interval_ns_ = 0;
+    int64_t last_publish_ns_ = 0;
+    bool merger_owned_by_metrics_ = false;
+
+    // Background merger
+    std::mutex merger_mutex_;
+    std::condition_variable merger_cv_;
+    bool merger_stop_ = false;
+    std::thread merger_;
 };
 
+// Open spans on the current thread, innermost last. Fixed-size so entering a
+// scope never allocates; spans nested deeper than kMaxSpanDepth still record
+// but report the deepest tracked ancestor as their parent.
+struct SpanStack
+{
+    SectionId sections[kMaxSpanDepth];
+    uint32_t depth = 0;
+};
+
+inline SpanStack &span_stack()
+{
+    thread_local SpanStack stack;
+    return stack;
+}
+
 class ScopedTimer
 {
 public:
-    explicit ScopedTimer(std::string name)
-        : name_(std::move(name)),
-          start_(std::chrono::steady_clock::now())
+    explicit ScopedTimer(SectionId section)
+        : section_(section),
+          backend_(Clock::active())
+    {
+        Timer::instance().check_section(section);
+        SpanStack &stack = span_stack();
+        depth_ = stack.depth;
+        parent_ = depth_ > 0 ? stack.sections[std::min(depth_, kMaxSpanDepth) - 1] : kNoSection;
+        if (depth_ < kMaxSpanDepth)
+        {
+            stack.sections[depth_] = section;
+        }
+        ++stack.depth;
+
+        // Counters first, clock last, so the syscall stays outside the span.
+        if (Timer::instance().hw_counters_enabled())
+        {
+            const PerfCounterGroup &group = thread_perf_group();
+            counting_ = group.ok() && group.read(counters_start_);
+        }
+        start_ = Clock::read(backend_);
+    }
+
+    explicit ScopedTimer(const std::string &name)
+        : ScopedTimer(Timer::instance().register_section(name))
     {
     }
 
@@ -129,27 +2124,74 @@ public:
     {
         if (!stopped_)
         {
-            auto end = std::chrono::steady_clock::now();
-            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start_).count();
-            Timer::instance().record(name_, elapsed);
+            uint64_t end = Clock::read(backend_);
+            if (counting_)
+            {
+                record_counter_deltas();
+            }
+            // Pop this span. Out-of-order stops (possible with manual stop())
+            // only ever shrink the stack, never leave a stale entry above it.
+            SpanStack &stack = span_stack();
+            stack.depth = std::min(stack.depth, depth_);
+            Timer::instance().record_span({section_, parent_, 0, depth_,
+                                           Clock::to_ns(backend_, start_),
+                                           Clock::delta_ns(backend_, start_, end)});
             stopped_ = true;
         }
     }
 
     int64_t elapsed_ns() const
     {
-        auto now = std::chrono::steady_clock::now();
-        return std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_).count();
+        return Clock::delta_ns(backend_, start_, Clock::read(backend_));
     }
 
+    SectionId section() const { return section_; }
+    SectionId parent() const { return parent_; }
+    uint32_t depth() const { return depth_; }
+
     // Context manager support
     ScopedTimer &enter() { return *this; }
     void exit() { stop(); }
 
 private:
-    std::string name_;
-    std::chrono::steady_clock::time_point start_;
+    void record_counter_deltas()
+    {
+        const PerfCounterGroup &group = thread_perf_group();
+        CounterReading now;
+        if (!group.read(now))
+        {
+            return;
+        }
+        uint64_t enabled = now.time_enabled - counters_start_.time_enabled;
+        uint64_t running = now.time_running - counters_start_.time_running;
+        CounterSample sample{section_, group.valid_mask(), running < enabled, {}};
+        if (running == 0)
+        {
+            // Never on the PMU during this span: nothing was measured
+            sample.valid_mask = 0;
+        }
+        else
+        {
+            double scale = sample.multiplexed ? static_cast<double>(enabled) / static_cast<double>(running) : 1.0;
+            for (size_t c = 0; c < kNumHwCounters; ++c)
+            {
+                uint64_t delta = now.values[c] - counters_start_.values[c];
+                sample.deltas[c] = sample.multiplexed
+                                       ? static_cast<uint64_t>(static_cast<double>(delta) * scale + 0.5)
+                                       : delta;
+            }
+        }
+        Timer::instance().record_counters(sample);
+    }
+
+    SectionId section_;
+    SectionId parent_ = kNoSection;
+    uint32_t depth_ = 0;
+    ClockBackend backend_;  // captured so a backend switch mid-scope is harmless
+    uint64_t start_ = 0;
     bool stopped_ = false;
+    bool counting_ = false;
+    CounterReading counters_start_;
 };
 
 int64_t measure_steady_clock_ns()
@@ -160,14 +2202,148 @@ int64_t measure_steady_clock_ns()
     return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
 }
 
+struct ClockOverhead
+{
+    std::string backend;
+    bool available = false;
+    int64_t min_ns = 0;
+    double median_ns = 0.0;
+    double mean_ns = 0.0;
+};
+
+// Cost of back-to-back clock reads for every backend, measured with each
+// backend's own clock. Unavailable TSC backends report available=False.
+std::vector<ClockOverhead> compare_clock_backends(int iterations)
+{
+    if (iterations <= 0)
+    {
+        throw std::invalid_argument("iterations must be > 0");
+    }
+    std::vector<ClockOverhead> results;
+    for (ClockBackend backend : {ClockBackend::steady, ClockBackend::tsc,
+                                 ClockBackend::tsc_fenced, ClockBackend::rdtscp})
+    {
+        ClockOverhead r;
+        r.backend = clock_backend_name(backend);
+        r.available = backend == ClockBackend::steady || Clock::calibration().reliable;
+        if (r.available)
+        {
+            std::vector<int64_t> samples(static_cast<size_t>(iterations));
+            for (auto &sample : samples)
+            {
+                uint64_t a = Clock::read(backend);
+                uint64_t b = Clock::read(backend);
+                sample = Clock::delta_ns(backend, a, b);
+            }
+            std::sort(samples.begin(), samples.end());
+            double sum = 0.0;
+            for (int64_t v : samples)
+            {
+                sum += static_cast<double>(v);
+            }
+            size_t n = samples.size();
+            r.min_ns = samples.front();
+            r.median_ns = n % 2 ? static_cast<double>(samples[n / 2])
+                                : (samples[n / 2 - 1] + samples[n / 2]) / 2.0;
+            r.mean_ns = sum / static_cast<double>(n);
+        }
+        results.push_back(r);
+    }
+    return results;
+}
+
+// Average cost of one Timer::record_id() call, measured over `iterations`
+// calls from the current thread. Samples go to the given section.
+double measure_record_ns(SectionId section, int64_t iterations)
+{
+    Timer &timer = Timer::instance();
+    auto start = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < iterations; ++i)
+    {
+        timer.record_id(section, i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double total_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    return total_ns / static_cast<double>(iterations);
+}
+
 NB_MODULE(latency_timer, m)
 {
     m.doc() = "High-resolution latency timer using std::chrono::steady_clock";
 
+    nb::class_<HdrHistogram>(m, "HdrHistogram")
+        .def(nb::init<int64_t, int>(),
+             nb::arg("highest_trackable_ns") = kDefaultHighestTrackableNs,
+             nb::arg("significant_figures") = kDefaultSignificantFigures)
+        .def("record", &HdrHistogram::record, nb::arg("value_ns"))
+        .def("record_n", &HdrHistogram::record_n, nb::arg("value_ns"), nb::arg("count"))
+        .def("merge", &HdrHistogram::merge, nb::arg("other"),
+             "Add all counts from another histogram with the same configuration")
+        .def("reset", &HdrHistogram::reset)
+        .def("value_at_percentile", &HdrHistogram::value_at_percentile, nb::arg("percentile"))
+        .def_prop_ro("count", &HdrHistogram::count)
+        .def_prop_ro("min", &HdrHistogram::min)
+        .def_prop_ro("max", &HdrHistogram::max)
+        .def_prop_ro("mean", &HdrHistogram::mean)
+        .def_prop_ro("highest_trackable_ns", &HdrHistogram::highest_trackable)
+        .def_prop_ro("significant_figures", &HdrHistogram::significant_figures)
+        .def_prop_ro("bucket_count", &HdrHistogram::bucket_count)
+        .def_prop_ro("memory_bytes", &HdrHistogram::memory_bytes);
+
+    nb::class_<HwCounterStatus>(m, "HwCounterStatus")
+        .def_ro("available", &HwCounterStatus::available)
+        .def_ro("counters", &HwCounterStatus::counters)
+        .def_ro("reason", &HwCounterStatus::reason);
+
+    nb::class_<CounterSummary>(m, "CounterSummary")
+        .def_ro("samples", &CounterSummary::samples)
+        .def_ro("multiplexed_samples", &CounterSummary::multiplexed_samples)
+        .def_prop_ro("available", [](const CounterSummary &self)
+                     {
+            std::vector<std::string> names;
+            for (size_t c = 0; c < kNumHwCounters; ++c)
+            {
+                if (self.has(static_cast<HwCounter>(c)))
+                {
+                    names.emplace_back(kHwCounterNames[c]);
+                }
+            }
+            return names; })
+        .def_prop_ro("cycles", [](const CounterSummary &self) { return self.total(hw_cycles); })
+        .def_prop_ro("instructions", [](const CounterSummary &self) { return self.total(hw_instructions); })
+        .def_prop_ro("l1d_misses", [](const CounterSummary &self) { return self.total(hw_l1d_misses); })
+        .def_prop_ro("llc_misses", [](const CounterSummary &self) { return self.total(hw_llc_misses); })
+        .def_prop_ro("branch_misses", [](const CounterSummary &self) { return self.total(hw_branch_misses); })
+        .def_prop_ro("dtlb_misses", [](const CounterSummary &self) { return self.total(hw_dtlb_misses); })
+        .def_prop_ro("ipc", &CounterSummary::ipc)
+        .def_prop_ro("l1d_mpki", [](const CounterSummary &self) { return self.mpki(hw_l1d_misses); })
+        .def_prop_ro("llc_mpki", [](const CounterSummary &self) { return self.mpki(hw_llc_misses); })
+        .def_prop_ro("branch_mpki", [](const CounterSummary &self) { return self.mpki(hw_branch_misses); })
+        .def_prop_ro("dtlb_mpki", [](const CounterSummary &self) { return self.mpki(hw_dtlb_misses); });
+
+    m.def("hw_counter_status", &hw_counter_status,
+          "Whether perf_event_open counters work for this thread, and which ones");
+
+    nb::class_<LatencySummary>(m, "LatencySummary")
+        .def_ro("count", &LatencySummary::count)
+        .def_ro("min_ns", &LatencySummary::min_ns)
+        .def_ro("max_ns", &LatencySummary::max_ns)
+        .def_ro("mean_ns", &LatencySummary::mean_ns)
+        .def_ro("p50_ns", &LatencySummary::p50_ns)
+        .def_ro("p90_ns", &LatencySummary::p90_ns)
+        .def_ro("p99_ns", &LatencySummary::p99_ns)
+        .def_ro("p999_ns", &LatencySummary::p999_ns);
+
     nb::class_<ScopedTimer>(m, "ScopedTimer")
-        .def(nb::init<std::string>(), nb::arg("name"))
+        .def(nb::init<const std::string &>(), nb::arg("name"))
+        .def(nb::init<SectionId>(), nb::arg("section_id"))
         .def("stop", &ScopedTimer::stop, "Stop the timer and record the measurement")
         .def("elapsed_ns", &ScopedTimer::elapsed_ns, "Get elapsed time without stopping")
+        .def_prop_ro("section_id", &ScopedTimer::section)
+        .def_prop_ro("parent_id",
+                     [](const ScopedTimer &self) -> int64_t
+                     { return self.parent() == kNoSection ? -1 : static_cast<int64_t>(self.parent()); })
+        .def_prop_ro("depth", &ScopedTimer::depth)
         .def("__enter__", &ScopedTimer::enter, nb::rv_policy::reference)
         .def("__exit__",
              [](ScopedTimer &self, const nb::args &)
@@ -177,15 +2353,112 @@ NB_MODULE(latency_timer, m)
 
     nb::class_<Timer>(m, "Timer")
         .def_static("instance", &Timer::instance, nb::rv_policy::reference)
+        .def("register_section", &Timer::register_section, nb::arg("name"),
+             "Intern a section name and return its integer ID")
+        .def("section_name", &Timer::section_name, nb::arg("section_id"))
         .def("record", &Timer::record, nb::arg("name"), nb::arg("elapsed_ns"))
+        .def("record_id", &Timer::record_id, nb::arg("section_id"), nb::arg("elapsed_ns"),
+             "Record a sample by section ID (lock-free, allocation-free)")
+        .def("collect", &Timer::collect, "Merge all per-thread buffers now")
+        .def("start_background_merge", &Timer::start_background_merge,
+             nb::arg("interval_ms") = 100,
+             "Merge per-thread buffers every interval_ms on a background thread")
+        .def("stop_background_merge", &Timer::stop_background_merge)
+        .def_prop_ro("background_merge_running", &Timer::background_merge_running)
         .def("section_names", &Timer::section_names)
-        .def("timings_for", &Timer::timings_for, nb::arg("name"))
-        .def("all_timings_ns", &Timer::all_timings_ns)
+        .def("timings_for", &Timer::timings_for, nb::arg("name"),
+             "Most recent raw samples for a section (up to 1024)")
+        .def("all_timings_ns", &Timer::all_timings_ns,
+             "Most recent raw samples across all sections (up to 8192)")
         .def("all_names", &Timer::all_names)
         .def("count", &Timer::count)
         .def("count_for", &Timer::count_for, nb::arg("name"))
+        .def("percentile_for", &Timer::percentile_for, nb::arg("name"), nb::arg("percentile"),
+             "Latency (ns) at a percentile (0-100), from the section's histogram")
+        .def("summary_for", &Timer::summary_for, nb::arg("name"),
+             "count/min/max/mean/p50/p90/p99/p99.9 over all samples")
+        .def("window_summary_for", &Timer::window_summary_for, nb::arg("name"),
+             "Like summary_for, over the configured rolling window")
+        .def("histogram_for", &Timer::histogram_for, nb::arg("name"),
+             "Copy of the section's all-time HdrHistogram")
+        .def("section_memory_bytes", &Timer::section_memory_bytes, nb::arg("name"))
+        .def("configure_histograms", &Timer::configure_histograms,
+             nb::arg("highest_trackable_ns") = kDefaultHighestTrackableNs,
+             nb::arg("significant_figures") = kDefaultSignificantFigures,
+             "Set histogram range and precision (clears recorded data)")
+        .def("configure_window", &Timer::configure_window,
+             nb::arg("window_seconds"), nb::arg("slots") = 5,
+             "Track the last window_seconds in `slots` rotating histograms; 0 slots disables")
+        .def("set_hw_counters", &Timer::set_hw_counters, nb::arg("enabled"),
+             "Snapshot perf counters around every ScopedTimer; returns False if unavailable")
+        .def_prop_ro("hw_counters_enabled", &Timer::hw_counters_enabled)
+        .def("counters_for", &Timer::counters_for, nb::arg("name"),
+             "Aggregated hardware counter totals, IPC and MPKI for a section")
+        .def("start_metrics_export", &Timer::start_metrics_export,
+             nb::arg("name") = "", nb::arg("interval_ms") = 100,
+             nb::arg("max_sections") = kDefaultMetricsSections,
+             "Publish live per-section percentiles to shared memory; returns the segment name")
+        .def("attach_metrics_export", &Timer::attach_metrics_export,
+             nb::arg("name"), nb::arg("interval_ms") = 100,
+             "Take over a segment left by an exporter that has exited; returns the segment name")
+        .def("stop_metrics_export", &Timer::stop_metrics_export)
+        .def("publish_metrics", &Timer::publish_metrics,
+             "Merge and publish now; returns the segment generation")
+        .def_prop_ro("metrics_exporting", &Timer::metrics_exporting)
+        .def("children_of", &Timer::children_of, nb::arg("name"),
+             "Direct child sections of `name` as (child, count, total_ns), largest first")
+        .def("start_trace", &Timer::start_trace, nb::arg("path"),
+             "Stream spans to a Chrome trace-event JSON file (load in ui.perfetto.dev)")
+        .def("stop_trace", &Timer::stop_trace,
+             "Finish and close the trace file; returns the number of span events")
+        .def_prop_ro("tracing", &Timer::tracing)
+        .def_prop_ro("highest_trackable_ns", &Timer::highest_trackable_ns)
+        .def_prop_ro("significant_figures", &Timer::significant_figures)
+        .def("overflow_merges", &Timer::overflow_merges,
+             "Times a recording thread found its buffer full and merged it itself")
+        .def("thread_buffer_count", &Timer::thread_buffer_count)
+        .def_prop_rw("thread_buffer_capacity", &Timer::thread_buffer_capacity,
+                     &Timer::set_thread_buffer_capacity)
         .def("reset", &Timer::reset);
 
     m.def("measure_steady_clock_ns", &measure_steady_clock_ns,
           "Measure the overhead of reading steady_clock (in nanoseconds)");
+
+    nb::class_<TscCalibration>(m, "TscCalibration")
+        .def_ro("supported", &TscCalibration::supported)
+        .def_ro("invariant", &TscCalibration::invariant)
+        .def_ro("reliable", &TscCalibration::reliable)
+        .def_ro("ns_per_tick", &TscCalibration::ns_per_tick)
+        .def_ro("calibration_ns", &TscCalibration::calibration_ns)
+        .def_ro("reason", &TscCalibration::reason)
+        .def_prop_ro("ghz", &TscCalibration::ghz);
+
+    nb::class_<ClockOverhead>(m, "ClockOverhead")
+        .def_ro("backend", &ClockOverhead::backend)
+        .def_ro("available", &ClockOverhead::available)
+        .def_ro("min_ns", &ClockOverhead::min_ns)
+        .def_ro("median_ns", &ClockOverhead::median_ns)
+        .def_ro("mean_ns", &ClockOverhead::mean_ns);
+
+    m.def("tsc_calibration", &Clock::calibration, nb::rv_policy::reference,
+          "TSC detection and calibration results (calibrates on first call)");
+
+    m.def("set_clock_backend",
+          [](const std::string &name)
+          { return std::string(clock_backend_name(Clock::select(parse_clock_backend(name)))); },
+          nb::arg("backend"),
+          "Select the ScopedTimer clock ('steady', 'tsc', 'tsc_fenced', 'rdtscp').\n"
+          "Falls back to 'steady' if the TSC is unreliable; returns the backend in use.");
+
+    m.def("clock_backend", []
+          { return std::string(clock_backend_name(Clock::active())); },
+          "Name of the clock backend ScopedTimer currently uses");
+
+    m.def("compare_clock_backends", &compare_clock_backends,
+          nb::arg("iterations") = 10000,
+          "Back-to-back read overhead (ns) for every clock backend");
+
+    m.def("measure_record_ns", &measure_record_ns,
+          nb::arg("section_id"), nb::arg("iterations") = 100000,
+          "Average cost of one Timer.record_id() call (in nanoseconds)");
 }
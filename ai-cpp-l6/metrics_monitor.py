@@ -0,0 +1,185 @@
+"""
+Live latency monitor that attaches to a latency_timer shared-memory segment.
+
+The measured process calls ``Timer.instance().start_metrics_export()``; its
+merger then publishes per-section percentiles into ``/dev/shm`` at merge
+time. This script maps that segment read-only and prints p50/p99 per section.
+It never takes a lock and never calls into the measured process, so watching
+a tracker costs it nothing.
+
+The segment is double-buffered and seqlock-protected (see the layout comment
+in latency_timer.cpp): read ``generation``, copy buffer ``generation & 1``,
+and retry if the buffer's sequence number was odd or changed during the copy.
+
+Usage:
+    python3 metrics_monitor.py                      # list segments
+    python3 metrics_monitor.py /latency_timer.1234  # refresh every second
+    python3 metrics_monitor.py /latency_timer.1234 --once
+"""
+
+from __future__ import annotations
+
+import argparse
+import glob
+import mmap
+import os
+import struct
+import sys
+import time
+from dataclasses import dataclass, field
+
+MAGIC = 0x584D544C  # "LTMX"
+VERSION = 1
+LOG2_BUCKETS = 64
+
+# magic, version, header_bytes, record_bytes, section_capacity, pid, buffer_bytes, generation
+_HEADER = struct.Struct("<6I2Q24x")
+# seq, publish_ns, window_ns, section_count, dropped_sections
+_BUFFER_HEADER = struct.Struct("<Q2q2I32x")
+# name, count, total_count, min, max, mean, p50, p90, p99, p999, log2 buckets
+_RECORD = struct.Struct(f"<64s9Q{LOG2_BUCKETS}Q")
+
+_GENERATION_OFFSET = 32
+_SHM_DIR = "/dev/shm"
+
+
+class SegmentError(RuntimeError):
+    """The segment is missing, not a latency_timer segment, or from another version."""
+
+
+@dataclass
+class SectionMetrics:
+    name: str
+    count: int
+    total_count: int
+    min_ns: int
+    max_ns: int
+    mean_ns: int
+    p50_ns: int
+    p90_ns: int
+    p99_ns: int
+    p999_ns: int
+    log2_buckets: list[int] = field(repr=False)
+
+
+@dataclass
+class Snapshot:
+    generation: int
+    publish_ns: int  # CLOCK_MONOTONIC, same clock as time.monotonic_ns()
+    window_ns: int  # 0: percentiles cover everything since reset()
+    dropped_sections: int
+    sections: list[SectionMetrics]
+
+    @property
+    def age_s(self) -> float:
+        return (time.monotonic_ns() - self.publish_ns) / 1e9
+
+
+def segment_path(name: str) -> str:
+    """Map a segment name ("/latency_timer.1234") or a file path to a path."""
+    if os.path.sep in name.lstrip("/"):
+        return name
+    return os.path.join(_SHM_DIR, name.lstrip("/"))
+
+
+def list_segments() -> list[str]:
+    return sorted("/" + os.path.basename(p) for p in glob.glob(os.path.join(_SHM_DIR, "latency_timer.*")))
+
+
+class MetricsReader:
+    """Read-only view of a latency_timer metrics segment."""
+
+    def __init__(self, name: str):
+        path = segment_path(name)
+        try:
+            with open(path, "rb") as f:
+                self._map = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        except (OSError, ValueError) as e:
+            raise SegmentError(f"cannot map {path}: {e}") from e
+
+        if len(self._map) < _HEADER.size:
+            raise SegmentError(f"{path} is too small to be a metrics segment")
+        (magic, version, header_bytes, record_bytes, self.capacity, self.pid,
+         self._buffer_bytes, _) = _HEADER.unpack_from(self._map, 0)
+        if magic != MAGIC:
+            raise SegmentError(f"{path} is not a latency_timer metrics segment")
+        if version != VERSION or header_bytes != _HEADER.size or record_bytes != _RECORD.size:
+            raise SegmentError(f"{path} has layout version {version}, expected {VERSION}")
+        self._header_bytes = header_bytes
+
+    def close(self):
+        self._map.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def snapshot(self, max_retries: int = 1000) -> Snapshot:
+        """Consistent copy of the latest published buffer."""
+        for _ in range(max_retries):
+            (generation,) = struct.unpack_from("<Q", self._map, _GENERATION_OFFSET)
+            offset = self._header_bytes + (generation & 1) * self._buffer_bytes
+            seq_before = struct.unpack_from("<Q", self._map, offset)[0]
+            if seq_before & 1:
+                continue  # writer is inside this buffer
+            raw = self._map[offset:offset + self._buffer_bytes]
+            seq_after = struct.unpack_from("<Q", self._map, offset)[0]
+            if seq_after != seq_before:
+                continue  # overwritten while copying
+            return self._decode(generation, raw)
+        raise SegmentError("segment is being rewritten faster than it can be read")
+
+    @staticmethod
+    def _decode(generation: int, raw: bytes) -> Snapshot:
+        _, publish_ns, window_ns, count, dropped = _BUFFER_HEADER.unpack_from(raw, 0)
+        sections = []
+        for i in range(count):
+            fields = _RECORD.unpack_from(raw, _BUFFER_HEADER.size + i * _RECORD.size)
+            name = fields[0].split(b"\0", 1)[0].decode("utf-8", "replace")
+            sections.append(SectionMetrics(name, *fields[1:10], log2_buckets=list(fields[10:])))
+        return Snapshot(generation, publish_ns, window_ns, dropped, sections)
+
+
+def print_snapshot(snap: Snapshot, pid: int):
+    window = f"last {snap.window_ns / 1e9:.1f}s" if snap.window_ns else "since reset"
+    print(f"pid {pid}  generation {snap.generation}  age {snap.age_s:.2f}s  ({window})")
+    print(f"  {'Section':<24} {'Count':>10} {'p50 (us)':>10} {'p99 (us)':>10} {'max (us)':>10}")
+    print(f"  {'-' * 24} {'-' * 10} {'-' * 10} {'-' * 10} {'-' * 10}")
+    for s in sorted(snap.sections, key=lambda s: s.p99_ns, reverse=True):
+        print(f"  {s.name:<24} {s.count:>10} {s.p50_ns / 1e3:>10.1f} "
+              f"{s.p99_ns / 1e3:>10.1f} {s.max_ns / 1e3:>10.1f}")
+    if snap.dropped_sections:
+        print(f"  ({snap.dropped_sections} sections did not fit the segment)")
+
+
+def main(argv: list[str] | None = None) -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("segment", nargs="?", help="segment name, e.g. /latency_timer.1234")
+    parser.add_argument("--interval", type=float, default=1.0, help="refresh period (s)")
+    parser.add_argument("--once", action="store_true", help="print one snapshot and exit")
+    args = parser.parse_args(argv)
+
+    if args.segment is None:
+        segments = list_segments()
+        print("\n".join(segments) if segments else "no latency_timer segments in /dev/shm")
+        return 0
+
+    try:
+        with MetricsReader(args.segment) as reader:
+            while True:
+                print_snapshot(reader.snapshot(), reader.pid)
+                if args.once:
+                    return 0
+                time.sleep(args.interval)
+                print()
+    except SegmentError as e:
+        print(f"error: {e}", file=sys.stderr)
+        return 1
+    except KeyboardInterrupt:
+        return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
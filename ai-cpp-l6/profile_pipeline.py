@@ -29,6 +29,12 @@ try:
 except ImportError:
     HAS_NUMPY = False
 
+try:
+    import latency_timer
+    HAS_LATENCY_TIMER = True
+except ImportError:
+    HAS_LATENCY_TIMER = False
+
 
 # ============================================================================
 # Simulated pipeline stages
@@ -229,6 +235,57 @@ def amdahl_analysis(tracker: LatencyTracker):
     print()
 
 
+def hardware_counter_report(n_frames: int = 20):
+    """Re-run the pipeline under the C++ ScopedTimer with perf counters on.
+
+    Latency tells you which stage to optimize; IPC and misses per thousand
+    instructions (MPKI) tell you whether it is compute-, memory- or
+    branch-bound.
+    """
+    print("=" * 70)
+    print("  HARDWARE COUNTERS PER STAGE")
+    print("=" * 70)
+    print()
+
+    if not HAS_LATENCY_TIMER:
+        print("  latency_timer not built — skipping (see Build and Run in README)")
+        print()
+        return
+
+    timer = latency_timer.Timer.instance()
+    timer.reset()
+    if not timer.set_hw_counters(True):
+        print(f"  Counters unavailable: {latency_timer.hw_counter_status().reason}")
+        print()
+        return
+
+    image = np.random.randint(0, 256, (640, 480, 3), dtype=np.uint8) if HAS_NUMPY else None
+    stages = ["preprocess", "inference", "postprocess"]
+    try:
+        for _ in range(n_frames):
+            with latency_timer.ScopedTimer("preprocess"):
+                tensor = preprocess(image)
+            with latency_timer.ScopedTimer("inference"):
+                raw = inference(tensor)
+            with latency_timer.ScopedTimer("postprocess"):
+                postprocess(raw)
+    finally:
+        timer.set_hw_counters(False)
+
+    print(f"  {'Stage':<20} {'p50 (ms)':>10} {'IPC':>6} {'L1D MPKI':>9} "
+          f"{'LLC MPKI':>9} {'Br MPKI':>8} {'dTLB MPKI':>10}")
+    print(f"  {'-' * 20} {'-' * 10} {'-' * 6} {'-' * 9} {'-' * 9} {'-' * 8} {'-' * 10}")
+    for stage in stages:
+        c = timer.counters_for(stage)
+        p50_ms = timer.percentile_for(stage, 50) / 1e6
+        estimated = "  (multiplexed: scaled estimates)" if c.multiplexed_samples else ""
+        print(
+            f"  {stage:<20} {p50_ms:>10.3f} {c.ipc:>6.2f} {c.l1d_mpki:>9.2f} "
+            f"{c.llc_mpki:>9.2f} {c.branch_mpki:>8.2f} {c.dtlb_mpki:>10.2f}{estimated}"
+        )
+    print()
+
+
 # ============================================================================
 # Main
 # ============================================================================
@@ -253,6 +310,9 @@ def main():
     # Amdahl's law analysis
     amdahl_analysis(tracker)
 
+    # Why is the bottleneck slow?
+    hardware_counter_report()
+
 
 if __name__ == "__main__":
     main()
@@ -5,6 +5,7 @@ import pytest
 
 from measure_latency import LatencyTracker
 from gpu_timer import GpuTimer, _HAS_CUDA
+import metrics_monitor
 
 # Try importing C++ modules — tests that need them will be skipped if unavailable
 try:
@@ -14,6 +15,13 @@ try:
 except ImportError:
     _HAS_CPP = False
 
+try:
+    import bench_harness
+    import bench_regress
+    _HAS_HARNESS = True
+except ImportError:
+    _HAS_HARNESS = False
+
 
 class TestScopedTimer:
     """Test the C++ ScopedTimer via nanobind."""
@@ -75,6 +83,599 @@ class TestScopedTimer:
         timer.reset()
         assert timer.count() == 0
 
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_section_ids_are_interned(self):
+        """Registering the same name twice returns the same ID."""
+        timer = latency_timer.Timer.instance()
+        a = timer.register_section("interned")
+        b = timer.register_section("interned")
+        assert a == b
+        assert timer.section_name(a) == "interned"
+        assert timer.register_section("other_interned") != a
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_record_by_id(self):
+        """record_id and ScopedTimer(section_id) land in the named section."""
+        timer = latency_timer.Timer.instance()
+        sid = timer.register_section("by_id")
+        timer.record_id(sid, 1234)
+        with latency_timer.ScopedTimer(sid) as t:
+            pass
+        assert t.section_id == sid
+        assert timer.count_for("by_id") == 2
+        assert timer.timings_for("by_id")[0] == 1234
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_unregistered_id_is_rejected(self):
+        """An ID register_section() never returned raises instead of reaching the merger."""
+        timer = latency_timer.Timer.instance()
+        bogus = timer.register_section("last_registered") + 1000
+        with pytest.raises(ValueError, match="unknown section id"):
+            timer.record_id(bogus, 1)
+        with pytest.raises(ValueError, match="unknown section id"):
+            latency_timer.ScopedTimer(2**32 - 2)
+        with latency_timer.ScopedTimer("after_rejection"):
+            pass  # the span stack was left balanced
+        assert timer.count_for("after_rejection") >= 1
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_concurrent_recording(self):
+        """Samples recorded from many threads are all merged, none lost."""
+        import threading
+
+        timer = latency_timer.Timer.instance()
+        sid = timer.register_section("threaded")
+        n_threads, per_thread = 8, 5000
+
+        def worker():
+            for i in range(per_thread):
+                timer.record_id(sid, i)
+
+        threads = [threading.Thread(target=worker) for _ in range(n_threads)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+
+        assert timer.count_for("threaded") == n_threads * per_thread
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_background_merge(self):
+        """The background merger can be started and stopped repeatedly."""
+        timer = latency_timer.Timer.instance()
+        timer.start_background_merge(interval_ms=5)
+        assert timer.background_merge_running
+        with latency_timer.ScopedTimer("merged"):
+            pass
+        time.sleep(0.02)
+        timer.stop_background_merge()
+        assert not timer.background_merge_running
+        assert timer.count_for("merged") == 1
+
+
+class TestHdrHistogram:
+    """Test the fixed-memory HDR histogram behind each Timer section."""
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_percentiles_within_precision(self):
+        """Percentiles of a uniform 1..100000 ns distribution are within 1%."""
+        h = latency_timer.HdrHistogram(significant_figures=2)
+        for v in range(1, 100001):
+            h.record(v)
+        assert h.count == 100000
+        assert h.min == 1
+        assert h.max == 100000
+        assert h.mean == pytest.approx(50000.5)
+        assert h.value_at_percentile(50) == pytest.approx(50000, rel=0.01)
+        assert h.value_at_percentile(99) == pytest.approx(99000, rel=0.01)
+        assert h.value_at_percentile(100) == 100000
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_memory_is_fixed(self):
+        """Recording more samples does not grow the histogram."""
+        h = latency_timer.HdrHistogram()
+        before = h.memory_bytes
+        for v in range(0, 10_000_000, 97):
+            h.record(v)
+        assert h.memory_bytes == before
+        assert before < 64 * 1024
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_merge(self):
+        a = latency_timer.HdrHistogram()
+        b = latency_timer.HdrHistogram()
+        a.record_n(100, 99)
+        b.record(1_000_000)
+        a.merge(b)
+        assert a.count == 100
+        assert a.max == 1_000_000
+        assert a.value_at_percentile(50) == pytest.approx(100, rel=0.01)
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_merge_mismatched_config_raises(self):
+        a = latency_timer.HdrHistogram(significant_figures=2)
+        b = latency_timer.HdrHistogram(significant_figures=3)
+        with pytest.raises(ValueError):
+            a.merge(b)
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_invalid_config_raises(self):
+        with pytest.raises(ValueError):
+            latency_timer.HdrHistogram(significant_figures=0)
+        with pytest.raises(ValueError):
+            latency_timer.HdrHistogram(highest_trackable_ns=1)
+
+
+class TestTimerPercentiles:
+    """Test native percentile queries on Timer sections."""
+
+    @pytest.fixture(autouse=True)
+    def reset_timer(self):
+        if _HAS_CPP:
+            latency_timer.Timer.instance().reset()
+        yield
+        if _HAS_CPP:
+            latency_timer.Timer.instance().configure_window(0.0, 0)
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_summary(self):
+        timer = latency_timer.Timer.instance()
+        for v in range(1, 1001):
+            timer.record("pct", v * 1000)
+        s = timer.summary_for("pct")
+        assert s.count == 1000
+        assert s.min_ns == 1000
+        assert s.max_ns == 1_000_000
+        assert s.p50_ns == pytest.approx(500_000, rel=0.01)
+        assert s.p90_ns == pytest.approx(900_000, rel=0.01)
+        assert s.p99_ns == pytest.approx(990_000, rel=0.01)
+        assert s.p999_ns == pytest.approx(999_000, rel=0.01)
+        assert timer.percentile_for("pct", 50) == s.p50_ns
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_section_memory_is_constant(self):
+        """A section's memory does not grow with the number of samples."""
+        timer = latency_timer.Timer.instance()
+        timer.record("constant", 1)
+        before = timer.section_memory_bytes("constant")
+        for _ in range(20000):
+            timer.record("constant", 12345)
+        assert timer.section_memory_bytes("constant") == before
+        assert timer.count_for("constant") == 20001
+        assert len(timer.timings_for("constant")) <= 1024
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_window_rotation(self):
+        """Samples older than the window drop out of window_summary_for."""
+        timer = latency_timer.Timer.instance()
+        timer.configure_window(0.05, 5)
+        timer.record("windowed", 1_000_000)
+        assert timer.window_summary_for("windowed").count == 1
+        time.sleep(0.08)
+        timer.record("windowed", 2_000)
+        w = timer.window_summary_for("windowed")
+        assert w.count == 1
+        assert w.max_ns == 2_000
+        assert timer.summary_for("windowed").count == 2
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_window_disabled_raises(self):
+        timer = latency_timer.Timer.instance()
+        timer.record("nowindow", 1)
+        with pytest.raises(RuntimeError, match="configure_window"):
+            timer.window_summary_for("nowindow")
+
+
+class TestClockBackends:
+    """Test the selectable TSC / steady_clock backends."""
+
+    @pytest.fixture(autouse=True)
+    def restore_backend(self):
+        if _HAS_CPP:
+            latency_timer.Timer.instance().reset()
+        yield
+        if _HAS_CPP:
+            latency_timer.set_clock_backend("steady")
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_default_is_steady(self):
+        assert latency_timer.clock_backend() == "steady"
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_select_falls_back_when_unreliable(self):
+        cal = latency_timer.tsc_calibration()
+        chosen = latency_timer.set_clock_backend("tsc_fenced")
+        assert chosen == ("tsc_fenced" if cal.reliable else "steady")
+        assert latency_timer.clock_backend() == chosen
+        if cal.reliable:
+            assert cal.ghz > 0.1
+        else:
+            assert cal.reason
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_unknown_backend_raises(self):
+        with pytest.raises(ValueError):
+            latency_timer.set_clock_backend("hpet")
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    @pytest.mark.parametrize("backend", ["tsc", "tsc_fenced", "rdtscp"])
+    def test_tsc_timer_accuracy(self, backend):
+        """A TSC-timed sleep agrees with the requested duration within 20%."""
+        latency_timer.set_clock_backend(backend)
+        with latency_timer.ScopedTimer("tsc_accuracy"):
+            time.sleep(0.05)
+        measured_ms = latency_timer.Timer.instance().timings_for("tsc_accuracy")[0] / 1e6
+        assert 40.0 <= measured_ms <= 60.0
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_tsc_timestamps_share_monotonic_epoch(self, tmp_path):
+        """Rate comes from CLOCK_MONOTONIC_RAW, but begin timestamps stay on CLOCK_MONOTONIC."""
+        import json
+
+        if latency_timer.set_clock_backend("tsc_fenced") != "tsc_fenced":
+            pytest.skip("TSC not reliable here")
+        timer = latency_timer.Timer.instance()
+        path = tmp_path / "trace.json"
+        timer.start_trace(str(path))
+        before = time.monotonic_ns()
+        with latency_timer.ScopedTimer("epoch"):
+            time.sleep(0.001)
+        after = time.monotonic_ns()
+        timer.stop_trace()
+
+        span = next(e for e in json.loads(path.read_text())["traceEvents"] if e.get("name") == "epoch")
+        assert before - 100_000 <= span["ts"] * 1e3 <= after + 100_000
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_compare_clock_backends(self):
+        results = latency_timer.compare_clock_backends(iterations=1000)
+        names = [r.backend for r in results]
+        assert names == ["steady", "tsc", "tsc_fenced", "rdtscp"]
+        steady = results[0]
+        assert steady.available
+        assert steady.min_ns >= 0
+        assert steady.median_ns >= steady.min_ns
+
+
+class TestSpans:
+    """Test span nesting and Chrome trace export."""
+
+    @pytest.fixture(autouse=True)
+    def reset_timer(self):
+        if _HAS_CPP:
+            latency_timer.Timer.instance().reset()
+        yield
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_nesting(self):
+        timer = latency_timer.Timer.instance()
+        with latency_timer.ScopedTimer("outer") as outer:
+            with latency_timer.ScopedTimer("inner") as inner:
+                pass
+        assert outer.depth == 0
+        assert outer.parent_id == -1
+        assert inner.depth == 1
+        assert inner.parent_id == timer.register_section("outer")
+
+        # The stack unwinds: a new top-level span has no parent
+        with latency_timer.ScopedTimer("after") as after:
+            pass
+        assert after.depth == 0
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_children_of(self):
+        timer = latency_timer.Timer.instance()
+        for _ in range(3):
+            with latency_timer.ScopedTimer("frame"):
+                with latency_timer.ScopedTimer("preprocess"):
+                    pass
+                with latency_timer.ScopedTimer("inference"):
+                    time.sleep(0.002)
+        children = timer.children_of("frame")
+        assert [c[0] for c in children] == ["inference", "preprocess"]
+        assert all(c[1] == 3 for c in children)
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_chrome_trace_export(self, tmp_path):
+        import json
+        import threading
+
+        timer = latency_timer.Timer.instance()
+        path = tmp_path / "trace.json"
+        timer.start_trace(str(path))
+        assert timer.tracing
+
+        def worker():
+            with latency_timer.ScopedTimer("frame"):
+                with latency_timer.ScopedTimer("inference"):
+                    time.sleep(0.001)
+
+        threads = [threading.Thread(target=worker) for _ in range(2)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        timer.record("untimed", 100)  # no begin timestamp -> not a trace event
+
+        assert timer.stop_trace() == 4
+        assert not timer.tracing
+
+        trace = json.loads(path.read_text())
+        spans = [e for e in trace["traceEvents"] if e["ph"] == "X"]
+        assert len(spans) == 4
+        assert {e["name"] for e in spans} == {"frame", "inference"}
+        assert len({e["tid"] for e in spans}) == 2
+        for e in spans:
+            if e["name"] == "inference":
+                parent = next(p for p in spans if p["name"] == "frame" and p["tid"] == e["tid"])
+                assert parent["ts"] <= e["ts"]
+                assert e["ts"] + e["dur"] <= parent["ts"] + parent["dur"] + 1e-3
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_stop_trace_without_start_raises(self):
+        with pytest.raises(RuntimeError):
+            latency_timer.Timer.instance().stop_trace()
+
+
+class TestHwCounters:
+    """Test perf_event_open counters per section (skips when unavailable)."""
+
+    @pytest.fixture(autouse=True)
+    def reset_timer(self):
+        if _HAS_CPP:
+            latency_timer.Timer.instance().reset()
+        yield
+        if _HAS_CPP:
+            latency_timer.Timer.instance().set_hw_counters(False)
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_status_explains_unavailability(self):
+        status = latency_timer.hw_counter_status()
+        if status.available:
+            assert "cycles" in status.counters
+        else:
+            assert status.counters == []
+            assert status.reason
+            assert not latency_timer.Timer.instance().set_hw_counters(True)
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_counters_per_section(self):
+        timer = latency_timer.Timer.instance()
+        if not timer.set_hw_counters(True):
+            pytest.skip(latency_timer.hw_counter_status().reason)
+        for _ in range(20):
+            with latency_timer.ScopedTimer("hw_work"):
+                sum(range(10_000))
+        counters = timer.counters_for("hw_work")
+        assert counters.samples == 20
+        assert 0 <= counters.multiplexed_samples <= counters.samples
+        assert counters.cycles > 0
+        if "instructions" in counters.available:
+            assert counters.instructions > 0
+            assert counters.ipc > 0
+        # Timing keeps working alongside counting
+        assert timer.count_for("hw_work") == 20
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_disabled_records_nothing(self):
+        timer = latency_timer.Timer.instance()
+        timer.set_hw_counters(False)
+        with latency_timer.ScopedTimer("hw_off"):
+            pass
+        assert timer.counters_for("hw_off").samples == 0
+
+
+class TestMetricsExport:
+    """Test the shared-memory metrics segment and the out-of-process reader."""
+
+    @pytest.fixture(autouse=True)
+    def reset_timer(self):
+        if _HAS_CPP:
+            latency_timer.Timer.instance().reset()
+        yield
+        if _HAS_CPP and latency_timer.Timer.instance().metrics_exporting:
+            latency_timer.Timer.instance().stop_metrics_export()
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_reader_sees_published_sections(self):
+        import os
+        timer = latency_timer.Timer.instance()
+        name = timer.start_metrics_export(f"/latency_timer.test{os.getpid()}", interval_ms=10)
+        assert timer.metrics_exporting
+        for v in range(1, 101):
+            timer.record("export", v * 1000)
+        generation = timer.publish_metrics()
+
+        with metrics_monitor.MetricsReader(name) as reader:
+            assert reader.pid == os.getpid()
+            snap = reader.snapshot()
+        assert snap.generation >= generation
+        section = next(s for s in snap.sections if s.name == "export")
+        summary = timer.summary_for("export")
+        assert section.count == 100
+        assert section.p50_ns == summary.p50_ns
+        assert section.p99_ns == summary.p99_ns
+        assert sum(section.log2_buckets) == 100
+
+        timer.stop_metrics_export()
+        assert not os.path.exists(metrics_monitor.segment_path(name))
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_cli_attaches_from_another_process(self):
+        import os
+        import subprocess
+        import sys
+        timer = latency_timer.Timer.instance()
+        name = timer.start_metrics_export(f"/latency_timer.cli{os.getpid()}")
+        with latency_timer.ScopedTimer("cli_section"):
+            pass
+        timer.publish_metrics()
+        out = subprocess.run(
+            [sys.executable, metrics_monitor.__file__, name, "--once"],
+            capture_output=True, text=True, timeout=30, check=True,
+        ).stdout
+        assert "cli_section" in out
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_double_start_raises(self):
+        import os
+        timer = latency_timer.Timer.instance()
+        timer.start_metrics_export(f"/latency_timer.dup{os.getpid()}")
+        with pytest.raises(RuntimeError):
+            timer.start_metrics_export(f"/latency_timer.dup{os.getpid()}")
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_start_refuses_existing_segment(self):
+        import os
+        name = f"/latency_timer.excl{os.getpid()}"
+        path = metrics_monitor.segment_path(name)
+        with open(path, "wb") as f:
+            f.write(b"not ours")
+        try:
+            with pytest.raises(RuntimeError, match="already exists"):
+                latency_timer.Timer.instance().start_metrics_export(name)
+            with open(path, "rb") as f:
+                assert f.read() == b"not ours"  # neither truncated nor unlinked
+        finally:
+            os.unlink(path)
+
+    @staticmethod
+    def _exporter_process(name, stay_alive):
+        """Start a child that exports `name`, publishes once and then either
+        waits for stdin to close or exits without unlinking the segment."""
+        import os
+        import subprocess
+        import sys
+        script = (
+            "import os, sys, latency_timer\n"
+            "t = latency_timer.Timer.instance()\n"
+            f"t.start_metrics_export({name!r})\n"
+            "t.record('child', 1000)\n"
+            "t.publish_metrics()\n"
+            "print('ready', flush=True)\n"
+            + ("sys.stdin.read()\n" if stay_alive else "")
+            + "os._exit(0)\n"  # skip the destructor, like a crash
+        )
+        env = dict(os.environ, PYTHONPATH=os.pathsep.join(p for p in sys.path if p))
+        child = subprocess.Popen([sys.executable, "-c", script], stdin=subprocess.PIPE,
+                                 stdout=subprocess.PIPE, text=True, env=env)
+        assert child.stdout.readline().strip() == "ready"
+        return child
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_attach_takes_over_stale_segment(self):
+        import os
+        name = f"/latency_timer.stale{os.getpid()}"
+        child = self._exporter_process(name, stay_alive=False)
+        child.wait(timeout=30)
+        timer = latency_timer.Timer.instance()
+        try:
+            with pytest.raises(RuntimeError, match="already exists"):
+                timer.start_metrics_export(name)
+            with metrics_monitor.MetricsReader(name) as reader:
+                child_generation = reader.snapshot().generation
+            assert timer.attach_metrics_export(name) == name
+            generation = timer.publish_metrics()
+            assert generation > child_generation  # publishing continues, readers keep up
+            with metrics_monitor.MetricsReader(name) as reader:
+                assert reader.pid == os.getpid()
+        finally:
+            if timer.metrics_exporting:
+                timer.stop_metrics_export()
+        assert not os.path.exists(metrics_monitor.segment_path(name))
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_attach_refuses_live_exporter(self):
+        import os
+        name = f"/latency_timer.live{os.getpid()}"
+        child = self._exporter_process(name, stay_alive=True)
+        try:
+            with pytest.raises(RuntimeError, match="still exported"):
+                latency_timer.Timer.instance().attach_metrics_export(name)
+        finally:
+            child.stdin.close()
+            child.wait(timeout=30)
+            os.unlink(metrics_monitor.segment_path(name))
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_attach_missing_segment_raises(self):
+        with pytest.raises(RuntimeError):
+            latency_timer.Timer.instance().attach_metrics_export("/latency_timer.no_such_segment")
+
+    def test_reader_rejects_foreign_file(self, tmp_path):
+        path = tmp_path / "not_a_segment"
+        path.write_bytes(b"\0" * 4096)
+        with pytest.raises(metrics_monitor.SegmentError):
+            metrics_monitor.MetricsReader(str(path))
+
+
+class TestBenchHarness:
+    """Test the statistical benchmark harness and regression gate."""
+
+    @pytest.mark.skipif(not _HAS_HARNESS, reason="bench_harness not built")
+    def test_mann_whitney_known_values(self):
+        r = bench_harness.mann_whitney_u([1, 2, 3, 4, 5], [6, 7, 8, 9, 10])
+        assert r.u == 25
+        assert r.prob_greater == 1.0
+        assert r.p_two_sided == pytest.approx(0.0122, abs=1e-3)
+
+        same = bench_harness.mann_whitney_u([1, 2, 3, 4, 5], [1, 2, 3, 4, 5])
+        assert same.p_greater > 0.4
+
+    @pytest.mark.skipif(not _HAS_HARNESS, reason="bench_harness not built")
+    def test_bootstrap_ci_brackets_median(self):
+        import random
+        rng = random.Random(1)
+        samples = [rng.gauss(100, 5) for _ in range(50)]
+        lo, hi = bench_harness.bootstrap_median_ci(samples)
+        assert lo <= bench_harness.median(samples) <= hi
+        assert (lo, hi) == bench_harness.bootstrap_median_ci(samples)  # seeded
+
+    @pytest.mark.skipif(not _HAS_HARNESS, reason="bench_harness not built")
+    def test_run_case(self):
+        calls = [0]
+
+        def kernel():
+            calls[0] += 1
+
+        r = bench_harness.run_case(kernel, trials=10, min_trial_ns=100_000)
+        assert len(r.samples_ns) == 10
+        assert r.inner_iterations >= 1
+        assert calls[0] >= 10 * r.inner_iterations
+        assert r.ci_low_ns <= r.median_ns <= r.ci_high_ns
+
+    @pytest.mark.skipif(not _HAS_HARNESS, reason="bench_harness not built")
+    def test_compare_flags_only_meaningful_regressions(self):
+        import random
+        rng = random.Random(2)
+
+        def case(scale):
+            samples = [rng.gauss(1000 * scale, 10) for _ in range(30)]
+            return {"samples_ns": samples, "median_ns": bench_harness.median(samples)}
+
+        baseline = {"a": case(1.0), "b": case(1.0), "c": case(1.0)}
+        current = {"a": case(1.10), "b": case(1.01), "c": case(1.0), "d": case(1.0)}
+        verdicts = {v["name"]: v["status"] for v in bench_regress.compare(baseline, current, 0.01, 0.03)}
+        assert verdicts == {"a": "REGRESSION", "b": "ok", "c": "ok", "d": "new"}
+
+    @pytest.mark.skipif(not _HAS_HARNESS, reason="bench_harness not built")
+    def test_run_cases_skips_unbuilt_and_unimplemented(self):
+        cases = [
+            bench_regress.BenchCase("missing", "no_such_module_xyz", lambda m: lambda: None),
+            bench_regress.BenchCase("unbound", "math", lambda m: None),
+        ]
+        lines = []
+        results = bench_regress.run_cases(cases, trials=3, max_warmup=1, min_trial_ns=1000, log=lines.append)
+        assert results == {}
+        assert "not built" in lines[0]
+        assert "not implemented" in lines[1]
+
+    @pytest.mark.skipif(not _HAS_HARNESS, reason="bench_harness not built")
+    def test_frequency_report(self):
+        report = bench_harness.cpu_frequency_report()
+        assert report.turbo in ("enabled", "disabled", "unknown")
+        assert report.stable == (len(report.warnings) == 0)
+
 
 class TestCacheBenchmark:
     """Test the C++ cache benchmark module."""
@@ -111,6 +712,91 @@ class TestCacheBenchmark:
         assert len(result.ns_per_access) == len(result.strides)
         assert all(ns > 0 for ns in result.ns_per_access)
 
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_stream_benchmark_scales_threads(self):
+        """STREAM returns one row per thread count, regular and non-temporal."""
+        for nt in (False, True):
+            result = cache_benchmark.run_stream_benchmark(
+                array_size_bytes=4 * 1024 * 1024, max_threads=2, iterations=1, non_temporal=nt
+            )
+            assert list(result.threads) == [1, 2]
+            assert result.non_temporal == nt
+            for column in (result.copy_gbps, result.scale_gbps, result.add_gbps, result.triad_gbps):
+                assert len(column) == 2
+                assert all(gbps > 0 for gbps in column)
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_core_to_core_matrix(self):
+        """The matrix is square over the requested CPUs and symmetric."""
+        cpus = list(cache_benchmark.run_core_to_core_benchmark(round_trips=1, samples=1).cpus)[:3]
+        result = cache_benchmark.run_core_to_core_benchmark(cpus=cpus, round_trips=1000, samples=2)
+        matrix = [list(row) for row in result.round_trip_ns]
+        assert list(result.cpus) == cpus
+        assert len(matrix) == len(cpus) and all(len(row) == len(cpus) for row in matrix)
+        for i in range(len(cpus)):
+            assert matrix[i][i] == 0
+            for j in range(i + 1, len(cpus)):
+                assert matrix[i][j] == matrix[j][i]
+                assert matrix[i][j] > 0
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_false_sharing_benchmark(self):
+        """Packed and padded counters are measured for each thread count."""
+        result = cache_benchmark.run_false_sharing_benchmark(max_threads=2, ops_per_thread=100_000)
+        assert list(result.threads) == [1, 2]
+        assert all(ns > 0 for ns in result.unpadded_ns_per_op)
+        assert all(ns > 0 for ns in result.padded_ns_per_op)
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_tlb_benchmark_returns_results(self):
+        """The TLB chase covers each size; hugepage column depends on the host."""
+        result = cache_benchmark.run_tlb_benchmark(
+            min_size_bytes=1024 * 1024, max_size_bytes=8 * 1024 * 1024, iterations=1
+        )
+        assert list(result.sizes_bytes) == [1 << 20, 2 << 20, 4 << 20, 8 << 20]
+        assert all(ns > 0 for ns in result.ns_per_access_4k)
+        assert result.huge_backing in ("hugetlbfs", "thp", "none")
+        if result.huge_backing != "none":
+            assert len(result.ns_per_access_huge) == len(result.sizes_bytes)
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_probe_topology(self):
+        """Topology reports at least one CPU and core; caches come from sysfs when present."""
+        topo = cache_benchmark.probe_topology()
+        assert topo.logical_cpus >= topo.physical_cores >= 1
+        assert topo.numa_nodes >= 1
+        assert topo.source in ("sysfs", "default")
+        for c in topo.caches:
+            assert c.level >= 1 and c.size_bytes > 0
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_tuning_profile_is_fast_and_sane(self):
+        """Probing (with confirmation) stays under a second and yields usable sizes."""
+        profile = cache_benchmark.probe_tuning_profile(confirm=True)
+        assert profile.probe_ms < 1000
+        assert profile.threads >= 1
+        assert 0 < profile.l1_tile_bytes <= profile.l2_tile_bytes
+        assert profile.parallel_grain_bytes > 0
+        assert profile.tile_rows(1920 * 3 * 5) >= 1
+
+    @pytest.mark.skipif(not _HAS_CPP, reason="C++ modules not built")
+    def test_tuning_profile_cache_round_trip(self, tmp_path):
+        """The second load reads the cached file instead of probing again."""
+        path = str(tmp_path / "profile.txt")
+        first = cache_benchmark.load_tuning_profile(path=path, confirm=False)
+        second = cache_benchmark.load_tuning_profile(path=path)
+        assert second.fingerprint == first.fingerprint
+        assert second.probe_ms == pytest.approx(first.probe_ms, rel=1e-3)
+        assert second.l2_tile_bytes == first.l2_tile_bytes
+
+        # A profile from another machine is ignored and replaced
+        with open(path) as f:
+            text = f.read().replace(first.fingerprint, "other machine|999")
+        with open(path, "w") as f:
+            f.write(text)
+        reprobed = cache_benchmark.load_tuning_profile(path=path, confirm=False)
+        assert reprobed.fingerprint == first.fingerprint
+
 
 class TestLatencyTracker:
     """Test the Python LatencyTracker."""
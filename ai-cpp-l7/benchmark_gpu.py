@@ -81,11 +81,26 @@ def benchmark_preprocess():
             sys.path.insert(0, str(Path(__file__).parent / "build"))
             import gpu_preprocess_cpu_ref as cpu_ref
 
+        if hasattr(cpu_ref, 'fused_preprocess_scalar'):
+            def cpp_cpu_scalar():
+                return cpu_ref.fused_preprocess_scalar(image, mean, std)
+            m, s = time_fn(cpp_cpu_scalar)
+            rows.append(("C++ CPU fused (scalar loop)", m, s))
+
         def cpp_cpu_preprocess():
             return cpu_ref.fused_preprocess(image, mean, std)
 
         m, s = time_fn(cpp_cpu_preprocess)
-        rows.append(("C++ CPU fused (std::transform)", m, s))
+        level = cpu_ref.simd_level() if hasattr(cpu_ref, 'simd_level') else "scalar"
+        rows.append((f"C++ CPU fused ({level}, threaded)", m, s))
+
+        if hasattr(cpu_ref, 'fused_preprocess_into'):
+            out_f16 = np.empty((3, 480, 640), dtype=np.float16)
+
+            def cpp_cpu_into_f16():
+                cpu_ref.fused_preprocess_into(image, mean, std, out_f16)
+            m, s = time_fn(cpp_cpu_into_f16)
+            rows.append(("C++ CPU fused into float16 buffer", m, s))
 
         # Numpy-style through C++
         if hasattr(cpu_ref, 'numpy_style_preprocess'):
@@ -122,6 +137,45 @@ def benchmark_preprocess():
     print_table(title, rows)
 
 
+# ─── Benchmark 1b: Layout Transpose ──────────────────────────────────────────
+
+def benchmark_transpose():
+    """Compare numpy and naive C++ layout changes against the shuffle-blocked kernels."""
+    try:
+        sys.path.insert(0, str(Path(__file__).parent))
+        sys.path.insert(0, str(Path(__file__).parent / "build"))
+        import gpu_preprocess_cpu_ref as cpu_ref
+    except ImportError:
+        print("  [SKIP] gpu_preprocess_cpu_ref not built")
+        return
+    if not hasattr(cpu_ref, 'hwc_to_chw'):
+        return
+
+    # A 1080p frame: large enough that memory traffic, not call overhead, dominates
+    for dtype in (np.uint8, np.float16, np.float32):
+        image = np.random.randint(0, 256, (1080, 1920, 3)).astype(dtype)
+        rows = []
+
+        m, s = time_fn(lambda: np.ascontiguousarray(image.transpose(2, 0, 1)), n_iters=30)
+        rows.append(("np.ascontiguousarray(transpose)", m, s))
+        m, s = time_fn(lambda: cpu_ref.hwc_to_chw_naive(image), n_iters=30)
+        rows.append(("C++ naive triple loop", m, s))
+        m, s = time_fn(lambda: cpu_ref.hwc_to_chw(image, threads=1), n_iters=30)
+        rows.append(("C++ hwc_to_chw (1 thread)", m, s))
+        m, s = time_fn(lambda: cpu_ref.hwc_to_chw(image), n_iters=30)
+        rows.append(("C++ hwc_to_chw (threaded)", m, s))
+        print_table(f"Benchmark 1b: HWC→CHW transpose — 1920x1080x3 {np.dtype(dtype).name}", rows)
+
+    # The way back, e.g. a CHW uint8 mask or image for display
+    chw = np.random.randint(0, 256, (3, 1080, 1920), dtype=np.uint8)
+    rows = []
+    m, s = time_fn(lambda: np.ascontiguousarray(chw.transpose(1, 2, 0)), n_iters=30)
+    rows.append(("np.ascontiguousarray(transpose)", m, s))
+    m, s = time_fn(lambda: cpu_ref.chw_to_hwc(chw), n_iters=30)
+    rows.append(("C++ chw_to_hwc (threaded)", m, s))
+    print_table("Benchmark 1b: CHW→HWC transpose — 3x1080x1920 uint8", rows)
+
+
 # ─── Benchmark 2: Regular vs Pinned Memory ───────────────────────────────────
 
 def benchmark_pinned_memory():
@@ -159,6 +213,26 @@ def benchmark_pinned_memory():
         rows.append(("Pinned pool acquire/release", m, s))
         print(f"  Pool info: {pool}")
 
+        try:
+            from pinned_allocator import PinnedArena
+        except ImportError:
+            PinnedArena = None
+        if PinnedArena is not None:
+            # Same frame, but carved from one arena that also serves other sizes
+            arena = PinnedArena(arena_size=64 << 20)
+            frame_sizes = [buffer_size, 1280 * 720 * 3, 320 * 240 * 3]
+            resident = [arena.alloc(n) for n in frame_sizes]
+
+            def arena_alloc():
+                buf = np.asarray(arena.alloc(buffer_size))
+                buf[:] = 42  # Simulate filling; freed when buf goes away
+
+            m, s = time_fn(arena_alloc, n_iters=500)
+            rows.append(("Pinned arena alloc/free (buddy)", m, s))
+            stats = arena.stats()
+            print(f"  Arena info: {arena} with {len(resident)} resident frames, "
+                  f"internal fragmentation {stats.internal_fragmentation:.0%}")
+
     except ImportError:
         print("  [SKIP] pinned_allocator not built")
 
@@ -329,6 +403,7 @@ def main():
         print("PyTorch: not installed")
 
     benchmark_preprocess()
+    benchmark_transpose()
     benchmark_pinned_memory()
     benchmark_batching()
     benchmark_torch_compile()
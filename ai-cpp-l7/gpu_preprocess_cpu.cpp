@@ -9,25 +9,155 @@
  */
 
 #include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <new>
 #include <numeric>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include <unistd.h>
+
+#include "parallel_bands.h"
+#include "tuning_profile.h"
+
+#if defined(__AVX2__) || defined(__F16C__)
+#include <immintrin.h>
+#endif
+
 #include <nanobind/nanobind.h>
 #include <nanobind/ndarray.h>
+#include <nanobind/stl/string.h>
 #include <nanobind/stl/vector.h>
 
 namespace nb = nanobind;
 
+// ─── Tuning profile ──────────────────────────────────────────────────────────
+
 /**
- * CPU fused preprocess: uint8 HWC → float32 CHW + normalize.
+ * Tile sizes and thread counts for the CPU kernels.
  *
- * Uses std::transform for the element-wise conversion, mimicking what
- * tracker_engine does with numpy but in C++ for a fair comparison.
+ * Read from the profile cache written by Lesson 6's cache_benchmark
+ * (load_tuning_profile). The file is only trusted if its version and machine
+ * fingerprint match; otherwise we fall back to sysconf cache sizes, so the
+ * kernels still run sensibly on a machine that was never probed.
  */
-nb::ndarray<nb::numpy, float> fused_preprocess(
-    nb::ndarray<nb::numpy, const uint8_t, nb::ndim<3>> input,
+struct TuningProfile {
+    int threads = 1;
+    int64_t l1_tile_bytes = 16 * 1024;
+    int64_t l2_tile_bytes = 512 * 1024;
+    int64_t parallel_grain_bytes = 256 * 1024;
+    int64_t streaming_store_threshold_bytes = 8 * 1024 * 1024;
+    std::string source = "defaults";  // "cache file" or "defaults"
+    std::string path;
+};
+
+using ai_cpp::allowed_cpu_count;
+
+static TuningProfile fallback_tuning_profile() {
+    TuningProfile p;
+    // Physical cores are unknown here; hyperthreads still hide some latency
+    p.threads = allowed_cpu_count();
+    long l1 = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+    long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (l1 > 0) p.l1_tile_bytes = l1 / 2;
+    if (l2 > 0) {
+        p.l2_tile_bytes = l2 / 2;
+        p.parallel_grain_bytes = std::max<int64_t>(p.parallel_grain_bytes, l2);
+    }
+    if (l3 > 0) p.streaming_store_threshold_bytes = l3 / 2;
+    return p;
+}
+
+static TuningProfile read_tuning_profile() {
+    TuningProfile p = fallback_tuning_profile();
+    p.path = ai_cpp::tuning_profile_path();
+    TuningProfile cached = p;
+    auto file = ai_cpp::TuningProfileFile::read(p.path);
+    if (file && file->get("threads", cached.threads) &&
+        file->get("l1_tile_bytes", cached.l1_tile_bytes) &&
+        file->get("l2_tile_bytes", cached.l2_tile_bytes) &&
+        file->get("parallel_grain_bytes", cached.parallel_grain_bytes) &&
+        file->get("streaming_store_threshold_bytes", cached.streaming_store_threshold_bytes)) {
+        cached.threads = std::max(1, cached.threads);
+        cached.source = "cache file";
+        p = cached;
+    }
+    return p;  // missing, stale or malformed: keep the defaults
+}
+
+static TuningProfile& tuning_profile_storage() {
+    static TuningProfile profile = read_tuning_profile();
+    return profile;
+}
+
+/** Profile in effect for this process (read once, on first use). */
+TuningProfile tuning_profile() { return tuning_profile_storage(); }
+
+/** Re-read the cache file, e.g. after cache_benchmark.load_tuning_profile(). */
+TuningProfile reload_tuning_profile() {
+    tuning_profile_storage() = read_tuning_profile();
+    return tuning_profile_storage();
+}
+
+/**
+ * Split [0, rows) into bands and run fn(begin, end) on each, one thread per band.
+ *
+ * The band count comes from the profile: never more than profile.threads, and
+ * never so many that a band moves less than parallel_grain_bytes — below that,
+ * starting a thread costs more than the work it takes over.
+ */
+template <typename Fn>
+static void parallel_rows(int rows, int64_t bytes_per_row, int threads, Fn&& fn) {
+    const TuningProfile& profile = tuning_profile_storage();
+    if (threads <= 0) {
+        int64_t total = static_cast<int64_t>(rows) * bytes_per_row;
+        int64_t by_grain = std::max<int64_t>(1, total / std::max<int64_t>(1, profile.parallel_grain_bytes));
+        threads = static_cast<int>(std::min<int64_t>(profile.threads, by_grain));
+    }
+    ai_cpp::parallel_bands(static_cast<size_t>(std::max(rows, 0)), 1, std::max(threads, 1),
+                           [&fn](size_t begin, size_t end) { fn(static_cast<int>(begin), static_cast<int>(end)); });
+}
+
+/**
+ * Run fn(task) for every task in [0, n_tasks) on up to `threads` workers
+ * (0 = from the tuning profile). Workers pull the next task from a shared
+ * counter, so a large task never leaves the others waiting behind it.
+ */
+template <typename Fn>
+static void parallel_tasks(int n_tasks, int threads, Fn&& fn) {
+    if (threads <= 0) threads = tuning_profile_storage().threads;
+    threads = std::clamp(threads, 1, std::max(1, n_tasks));
+
+    std::atomic<int> next{0};
+    auto worker = [&] {
+        for (int task = next.fetch_add(1, std::memory_order_relaxed); task < n_tasks;
+             task = next.fetch_add(1, std::memory_order_relaxed)) {
+            fn(task);
+        }
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (int t = 1; t < threads; ++t) workers.emplace_back(worker);
+    worker();
+    for (auto& w : workers) w.join();
+}
+
+/**
+ * Scalar fused preprocess: uint8 HWC → float32 CHW + normalize.
+ *
+ * The original single-pass loop, kept single-threaded as the reference the
+ * vectorized fused_preprocess is checked and benchmarked against.
+ */
+nb::ndarray<nb::numpy, float> fused_preprocess_scalar(
+    nb::ndarray<nb::numpy, const uint8_t, nb::ndim<3>, nb::c_contig> input,
     std::vector<float> mean,
     std::vector<float> std_dev)
 {
@@ -64,6 +194,918 @@ nb::ndarray<nb::numpy, float> fused_preprocess(
     return nb::ndarray<nb::numpy, float>(output, 3, shape, owner);
 }
 
+// ─── Vectorized fused preprocess ─────────────────────────────────────────────
+//
+// (x / 255 - mean) / std is folded into a per-channel multiply-add:
+//     x * scale + bias,   scale = 1 / (255 * std),   bias = -mean / std
+// computed once per call in double and split into float hi + lo parts. The
+// lo parts go through a second FMA that corrects for rounding scale and bias
+// to float. On FMA hardware every output y then satisfies
+//     |y - exact| <= 1.5 ULP(exact) + 2^-46 * (x * |scale| + |bias|)
+// Away from zero that is within 1 ULP, except just below a power of two,
+// where the first FMA may round into the next binade (1.25 ULP at worst over
+// all byte values). Near zero, where x * scale and bias cancel, the second
+// term dominates. It is still far below the error of the three-rounding
+// scalar loop, whose x / 255 - mean cancels with float-sized error. The
+// kernel is memory-bound, so the extra FMA costs nothing measurable.
+//
+// Each iteration loads 16 HWC pixels, splits them into one 16-byte vector per
+// channel with byte shuffles, widens to float and writes 16 contiguous values
+// per CHW plane — no divides and no strided scatter.
+//
+// The 16 normalized floats can also be narrowed before the store: float16
+// (F16C), bfloat16, or int8/uint8 with a quantization scale and zero point
+// folded into the same multiply-add. Inference backends that take those
+// inputs then read 2-4x fewer bytes, and no second conversion pass runs.
+
+/** Element formats the fused kernel can write directly. */
+enum class OutFormat { F32, F16, BF16, I8, U8 };
+
+/** float16 element, so nb::ndarray accepts numpy float16 buffers. */
+struct Half {
+    uint16_t bits;
+};
+
+namespace nanobind::detail {
+template <> struct dtype_traits<Half> {
+    static constexpr dlpack::dtype value{static_cast<uint8_t>(dlpack::dtype_code::Float), 16, 1};
+    static constexpr auto name = const_name("float16");
+};
+}  // namespace nanobind::detail
+
+template <OutFormat F> struct OutElement;
+template <> struct OutElement<OutFormat::F32> { using type = float; };
+template <> struct OutElement<OutFormat::F16> { using type = uint16_t; };
+template <> struct OutElement<OutFormat::BF16> { using type = uint16_t; };
+template <> struct OutElement<OutFormat::I8> { using type = int8_t; };
+template <> struct OutElement<OutFormat::U8> { using type = uint8_t; };
+template <OutFormat F> using out_t = typename OutElement<F>::type;
+
+constexpr bool is_quantized(OutFormat f) { return f == OutFormat::I8 || f == OutFormat::U8; }
+template <OutFormat F> constexpr float kQuantMin = F == OutFormat::I8 ? -128.0f : 0.0f;
+template <OutFormat F> constexpr float kQuantMax = F == OutFormat::I8 ? 127.0f : 255.0f;
+
+/** Per-channel scale/bias for the folded normalization, as hi + lo pairs. */
+struct ChannelAffine {
+    std::vector<float> scale, scale_lo;
+    std::vector<float> bias, bias_lo;
+};
+
+/**
+ * Fold normalization, and optionally quantization q = y / qscale + zero_point,
+ * into one scale/bias per channel. qscale/zero_point hold 1 (per-tensor) or
+ * `channels` (per-channel) entries; empty means no quantization.
+ */
+static ChannelAffine fold_normalization(const std::vector<float>& mean, const std::vector<float>& std_dev,
+                                        const std::vector<float>& qscale = {},
+                                        const std::vector<int>& zero_point = {}) {
+    ChannelAffine a;
+    for (size_t c = 0; c < mean.size(); ++c) {
+        if (std_dev[c] == 0.0f) throw std::invalid_argument("std must be non-zero");
+        double scale = 1.0 / (255.0 * static_cast<double>(std_dev[c]));
+        double bias = -static_cast<double>(mean[c]) / static_cast<double>(std_dev[c]);
+        if (!qscale.empty()) {
+            double qs = qscale[qscale.size() == 1 ? 0 : c];
+            double zp = zero_point.empty() ? 0.0 : zero_point[zero_point.size() == 1 ? 0 : c];
+            scale /= qs;
+            bias = bias / qs + zp;
+        }
+        a.scale.push_back(static_cast<float>(scale));
+        a.scale_lo.push_back(static_cast<float>(scale - a.scale.back()));
+        a.bias.push_back(static_cast<float>(bias));
+        a.bias_lo.push_back(static_cast<float>(bias - a.bias.back()));
+    }
+    return a;
+}
+
+/** Same rounding as the vector body, so tails match it bit for bit. */
+static inline float affine(float x, const ChannelAffine& a, int c) {
+#if defined(__FMA__)
+    return std::fma(x, a.scale[c], a.bias[c]) + std::fma(x, a.scale_lo[c], a.bias_lo[c]);
+#else
+    return (x * a.scale[c] + a.bias[c]) + (x * a.scale_lo[c] + a.bias_lo[c]);
+#endif
+}
+
+/** float → IEEE half, round to nearest even (subnormals included). */
+static inline uint16_t float_to_half(float f) {
+#if defined(__F16C__)
+    return static_cast<uint16_t>(_cvtss_sh(f, _MM_FROUND_TO_NEAREST_INT));
+#else
+    // Without F16C: F. Giesen's float_to_half_fast3_rtne
+    uint32_t x = std::bit_cast<uint32_t>(f);
+    uint32_t sign = x & 0x80000000u;
+    x ^= sign;
+    uint16_t h;
+    if (x >= (127u + 16u) << 23) {
+        h = x > (255u << 23) ? 0x7E00 : 0x7C00;  // NaN or overflow to inf
+    } else if (x < (113u << 23)) {
+        // Subnormal half: let the FPU round by adding a magic power of two
+        const float magic = std::bit_cast<float>(((127u - 15u) + (23u - 10u) + 1u) << 23);
+        h = static_cast<uint16_t>(std::bit_cast<uint32_t>(std::bit_cast<float>(x) + magic) -
+                                  std::bit_cast<uint32_t>(magic));
+    } else {
+        uint32_t mant_odd = (x >> 13) & 1;
+        x += (static_cast<uint32_t>(15 - 127) << 23) + 0xFFF + mant_odd;
+        h = static_cast<uint16_t>(x >> 13);
+    }
+    return static_cast<uint16_t>(h | (sign >> 16));
+#endif
+}
+
+/** float → bfloat16 (upper 16 bits), round to nearest even. */
+static inline uint16_t float_to_bfloat16(float f) {
+    uint32_t x = std::bit_cast<uint32_t>(f);
+    x += 0x7FFF + ((x >> 16) & 1);
+    return static_cast<uint16_t>(x >> 16);
+}
+
+template <OutFormat F>
+static inline out_t<F> convert(float y) {
+    if constexpr (F == OutFormat::F32) {
+        return y;
+    } else if constexpr (F == OutFormat::F16) {
+        return float_to_half(y);
+    } else if constexpr (F == OutFormat::BF16) {
+        return float_to_bfloat16(y);
+    } else {
+        // Clamp first, then round half to even like cvtps2dq in the vector path
+        return static_cast<out_t<F>>(std::nearbyint(std::clamp(y, kQuantMin<F>, kQuantMax<F>)));
+    }
+}
+
+static float* allocate_output(size_t count) {
+    // 64-byte aligned so full vector stores (and streaming stores) never split a line
+    return static_cast<float*>(::operator new[](count * sizeof(float), std::align_val_t(64)));
+}
+
+static nb::capsule aligned_owner(float* p) {
+    return nb::capsule(p, [](void* q) noexcept { ::operator delete[](q, std::align_val_t(64)); });
+}
+
+#if defined(__AVX2__) && defined(__FMA__) && defined(__F16C__)
+constexpr bool kHaveSimdPreprocess = true;
+
+#if defined(__AVX512F__)
+using Vec16 = __m512;
+
+/** Widen 16 bytes to floats and apply channel c's scale/bias. */
+static inline Vec16 normalize16(__m128i bytes, const ChannelAffine& a, int c) {
+    __m512 x = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(bytes));
+    return _mm512_add_ps(_mm512_fmadd_ps(x, _mm512_set1_ps(a.scale[c]), _mm512_set1_ps(a.bias[c])),
+                         _mm512_fmadd_ps(x, _mm512_set1_ps(a.scale_lo[c]), _mm512_set1_ps(a.bias_lo[c])));
+}
+
+/** Convert 16 normalized floats to the output format and store them at dst. */
+template <OutFormat F, bool Stream>
+static inline void store16(out_t<F>* dst, Vec16 y) {
+    if constexpr (F == OutFormat::F32) {
+        if constexpr (Stream) _mm512_stream_ps(dst, y);
+        else _mm512_storeu_ps(dst, y);
+    } else if constexpr (F == OutFormat::F16) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm512_cvtps_ph(y, _MM_FROUND_TO_NEAREST_INT));
+    } else if constexpr (F == OutFormat::BF16) {
+        __m512i x = _mm512_castps_si512(y);
+        __m512i round = _mm512_add_epi32(_mm512_set1_epi32(0x7FFF),
+                                         _mm512_and_si512(_mm512_srli_epi32(x, 16), _mm512_set1_epi32(1)));
+        x = _mm512_srli_epi32(_mm512_add_epi32(x, round), 16);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm512_cvtepi32_epi16(x));
+    } else {
+        __m512 q = _mm512_min_ps(_mm512_max_ps(y, _mm512_set1_ps(kQuantMin<F>)), _mm512_set1_ps(kQuantMax<F>));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm512_cvtepi32_epi8(_mm512_cvtps_epi32(q)));
+    }
+}
+#else
+struct Vec16 {
+    __m256 lo, hi;
+};
+
+static inline Vec16 normalize16(__m128i bytes, const ChannelAffine& a, int c) {
+    const __m256 vs = _mm256_set1_ps(a.scale[c]), vs_lo = _mm256_set1_ps(a.scale_lo[c]);
+    const __m256 vb = _mm256_set1_ps(a.bias[c]), vb_lo = _mm256_set1_ps(a.bias_lo[c]);
+    auto apply = [&](__m128i eight) {
+        __m256 x = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(eight));
+        return _mm256_add_ps(_mm256_fmadd_ps(x, vs, vb), _mm256_fmadd_ps(x, vs_lo, vb_lo));
+    };
+    return {apply(bytes), apply(_mm_srli_si128(bytes, 8))};
+}
+
+template <OutFormat F, bool Stream>
+static inline void store16(out_t<F>* dst, Vec16 y) {
+    if constexpr (F == OutFormat::F32) {
+        if constexpr (Stream) {
+            _mm256_stream_ps(dst, y.lo);
+            _mm256_stream_ps(dst + 8, y.hi);
+        } else {
+            _mm256_storeu_ps(dst, y.lo);
+            _mm256_storeu_ps(dst + 8, y.hi);
+        }
+    } else if constexpr (F == OutFormat::F16) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm256_cvtps_ph(y.lo, _MM_FROUND_TO_NEAREST_INT));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 8), _mm256_cvtps_ph(y.hi, _MM_FROUND_TO_NEAREST_INT));
+    } else if constexpr (F == OutFormat::BF16) {
+        auto round = [](__m256 v) {
+            __m256i x = _mm256_castps_si256(v);
+            __m256i r = _mm256_add_epi32(_mm256_set1_epi32(0x7FFF),
+                                         _mm256_and_si256(_mm256_srli_epi32(x, 16), _mm256_set1_epi32(1)));
+            return _mm256_srli_epi32(_mm256_add_epi32(x, r), 16);
+        };
+        // packus works per 128-bit lane; the permute restores element order
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(round(y.lo), round(y.hi)), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), packed);
+    } else {
+        auto quantize = [](__m256 v) {
+            return _mm256_cvtps_epi32(
+                _mm256_min_ps(_mm256_max_ps(v, _mm256_set1_ps(kQuantMin<F>)), _mm256_set1_ps(kQuantMax<F>)));
+        };
+        __m256i words = _mm256_permute4x64_epi64(_mm256_packs_epi32(quantize(y.lo), quantize(y.hi)), 0xD8);
+        __m128i lo = _mm256_castsi256_si128(words), hi = _mm256_extracti128_si256(words, 1);
+        __m128i bytes = F == OutFormat::I8 ? _mm_packs_epi16(lo, hi) : _mm_packus_epi16(lo, hi);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), bytes);
+    }
+}
+#endif
+
+/**
+ * Deinterleave 16 pixels starting at src into one vector per channel.
+ * C = 1, 3 or 4; channel k lands in out[k].
+ */
+template <int C>
+static inline void deinterleave16(const uint8_t* src, __m128i* out) {
+    if constexpr (C == 1) {
+        out[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    } else if constexpr (C == 3) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+        // Byte i of a/b/c holds channel (i, i+16, i+32) % 3; gather each channel's 16 bytes
+        auto pick = [&](__m128i ma, __m128i mb, __m128i mc) {
+            return _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, ma), _mm_shuffle_epi8(b, mb)),
+                                _mm_shuffle_epi8(c, mc));
+        };
+        out[0] = pick(_mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1),
+                      _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1),
+                      _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13));
+        out[1] = pick(_mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1),
+                      _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1),
+                      _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14));
+        out[2] = pick(_mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1),
+                      _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1),
+                      _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15));
+    } else {
+        static_assert(C == 4);
+        // Group each 4-pixel load by channel, then transpose the 4x4 grid of 32-bit lanes
+        const __m128i group = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+        __m128i q[4];
+        for (int i = 0; i < 4; ++i)
+            q[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16 * i)), group);
+        __m128i t0 = _mm_unpacklo_epi32(q[0], q[1]);
+        __m128i t1 = _mm_unpacklo_epi32(q[2], q[3]);
+        __m128i t2 = _mm_unpackhi_epi32(q[0], q[1]);
+        __m128i t3 = _mm_unpackhi_epi32(q[2], q[3]);
+        out[0] = _mm_unpacklo_epi64(t0, t1);
+        out[1] = _mm_unpackhi_epi64(t0, t1);
+        out[2] = _mm_unpacklo_epi64(t2, t3);
+        out[3] = _mm_unpackhi_epi64(t2, t3);
+    }
+}
+
+template <int C, OutFormat F, bool Stream>
+static void preprocess_rows_simd(const uint8_t* src, out_t<F>* dst, int width, size_t plane,
+                                 int row_begin, int row_end, const ChannelAffine& a) {
+    for (int h = row_begin; h < row_end; ++h) {
+        const uint8_t* row = src + static_cast<size_t>(h) * width * C;
+        out_t<F>* out = dst + static_cast<size_t>(h) * width;
+        int w = 0;
+        for (; w + 16 <= width; w += 16) {
+            __m128i channel[C];
+            deinterleave16<C>(row + w * C, channel);
+            for (int c = 0; c < C; ++c)
+                store16<F, Stream>(out + c * plane + w, normalize16(channel[c], a, c));
+        }
+        for (; w < width; ++w) {
+            for (int c = 0; c < C; ++c)
+                out[c * plane + w] = convert<F>(affine(static_cast<float>(row[w * C + c]), a, c));
+        }
+    }
+    if constexpr (Stream) _mm_sfence();  // streamed rows visible before the join
+}
+#else
+constexpr bool kHaveSimdPreprocess = false;
+#endif
+
+/** Any channel count; also the path on CPUs without AVX2/FMA/F16C. */
+template <OutFormat F>
+static void preprocess_rows_generic(const uint8_t* src, out_t<F>* dst, int width, int channels, size_t plane,
+                                    int row_begin, int row_end, const ChannelAffine& a) {
+    for (int h = row_begin; h < row_end; ++h) {
+        const uint8_t* row = src + static_cast<size_t>(h) * width * channels;
+        out_t<F>* out = dst + static_cast<size_t>(h) * width;
+        for (int c = 0; c < channels; ++c) {
+            out_t<F>* out_plane = out + c * plane;
+            for (int w = 0; w < width; ++w)
+                out_plane[w] = convert<F>(affine(static_cast<float>(row[w * channels + c]), a, c));
+        }
+    }
+}
+
+/** Rows [row_begin, row_end) of one image: the vector path when there is one, else generic. */
+template <OutFormat F>
+static void preprocess_band(const uint8_t* src, out_t<F>* dst, int width, int channels, size_t plane,
+                            int row_begin, int row_end, const ChannelAffine& a, [[maybe_unused]] bool stream) {
+#if defined(__AVX2__) && defined(__FMA__) && defined(__F16C__)
+    auto run = [&]<int C>() {
+        if (F == OutFormat::F32 && stream)
+            preprocess_rows_simd<C, F, F == OutFormat::F32>(src, dst, width, plane, row_begin, row_end, a);
+        else
+            preprocess_rows_simd<C, F, false>(src, dst, width, plane, row_begin, row_end, a);
+    };
+    switch (channels) {
+        case 1: run.template operator()<1>(); return;
+        case 3: run.template operator()<3>(); return;
+        case 4: run.template operator()<4>(); return;
+        default: break;
+    }
+#endif
+    preprocess_rows_generic<F>(src, dst, width, channels, plane, row_begin, row_end, a);
+}
+
+/** Run the fused kernel over an HWC image into a CHW buffer of format F. */
+template <OutFormat F>
+static void preprocess_into(const uint8_t* src, out_t<F>* dst, int height, int width, int channels,
+                            const ChannelAffine& affine_params, int threads) {
+    size_t plane = static_cast<size_t>(height) * width;
+    size_t out_bytes = plane * channels * sizeof(out_t<F>);
+
+    // Streaming stores (float32 only) need every 16-float group aligned: the
+    // buffer, rows and planes must start on a 64-byte boundary
+    const TuningProfile& profile = tuning_profile_storage();
+    bool stream = kHaveSimdPreprocess && F == OutFormat::F32 &&
+                  static_cast<int64_t>(out_bytes) >= profile.streaming_store_threshold_bytes &&
+                  width % 16 == 0 && plane % 16 == 0 && reinterpret_cast<uintptr_t>(dst) % 64 == 0;
+
+    // 1 byte read + sizeof(out_t<F>) bytes written per element
+    int64_t bytes_per_row = static_cast<int64_t>(width) * channels * (1 + sizeof(out_t<F>));
+    parallel_rows(height, bytes_per_row, threads, [&](int row_begin, int row_end) {
+        preprocess_band<F>(src, dst, width, channels, plane, row_begin, row_end, affine_params, stream);
+    });
+}
+
+/**
+ * CPU fused preprocess: uint8 HWC → float32 CHW + normalize.
+ *
+ * Vectorized (AVX-512 or AVX2 + FMA, chosen at compile time by -march=native)
+ * for 1, 3 and 4 channels, with rows split across `threads` workers
+ * (0 = from the tuning profile). Outputs larger than the profile's streaming
+ * threshold are written with non-temporal stores. With FMA, outputs are
+ * within 1.5 ULP of the exact (x / 255 - mean) / std, plus a tiny absolute
+ * term for outputs near zero (bound above fold_normalization).
+ */
+nb::ndarray<nb::numpy, float> fused_preprocess(
+    nb::ndarray<nb::numpy, const uint8_t, nb::ndim<3>, nb::c_contig> input,
+    std::vector<float> mean,
+    std::vector<float> std_dev,
+    int threads)
+{
+    int height = static_cast<int>(input.shape(0));
+    int width = static_cast<int>(input.shape(1));
+    int channels = static_cast<int>(input.shape(2));
+    size_t total = static_cast<size_t>(height) * width * channels;
+
+    if (mean.size() != static_cast<size_t>(channels) ||
+        std_dev.size() != static_cast<size_t>(channels)) {
+        throw std::invalid_argument("mean and std must have length == channels");
+    }
+
+    ChannelAffine affine_params = fold_normalization(mean, std_dev);
+    float* output = allocate_output(total);
+    preprocess_into<OutFormat::F32>(input.data(), output, height, width, channels, affine_params, threads);
+
+    size_t shape[3] = {
+        static_cast<size_t>(channels),
+        static_cast<size_t>(height),
+        static_cast<size_t>(width)
+    };
+    return nb::ndarray<nb::numpy, float>(output, 3, shape, aligned_owner(output));
+}
+
+/**
+ * Fused preprocess into a caller-provided CHW buffer.
+ *
+ * The output format follows the buffer's dtype: float32, float16, uint16
+ * (bfloat16 bit patterns — numpy has no bfloat16; view the result with
+ * ml_dtypes or torch), int8 or uint8. Integer outputs are quantized as
+ * round(y / scale + zero_point), saturated to the type's range, with `scale`
+ * and `zero_point` given per tensor (one value) or per channel.
+ */
+template <OutFormat F, typename T>
+void fused_preprocess_into(
+    nb::ndarray<nb::numpy, const uint8_t, nb::ndim<3>, nb::c_contig> input,
+    std::vector<float> mean,
+    std::vector<float> std_dev,
+    nb::ndarray<nb::numpy, T, nb::ndim<3>, nb::c_contig> out,
+    std::vector<float> scale,
+    std::vector<int> zero_point,
+    int threads)
+{
+    int height = static_cast<int>(input.shape(0));
+    int width = static_cast<int>(input.shape(1));
+    int channels = static_cast<int>(input.shape(2));
+    size_t n_channels = static_cast<size_t>(channels);
+
+    if (mean.size() != n_channels || std_dev.size() != n_channels) {
+        throw std::invalid_argument("mean and std must have length == channels");
+    }
+    if (out.shape(0) != n_channels || out.shape(1) != static_cast<size_t>(height) ||
+        out.shape(2) != static_cast<size_t>(width)) {
+        throw std::invalid_argument("out must have shape (channels, height, width)");
+    }
+    if constexpr (is_quantized(F)) {
+        if (scale.size() != 1 && scale.size() != n_channels) {
+            throw std::invalid_argument("int8/uint8 output needs scale with 1 or channels entries");
+        }
+        if (!zero_point.empty() && zero_point.size() != 1 && zero_point.size() != n_channels) {
+            throw std::invalid_argument("zero_point must have 1 or channels entries");
+        }
+        for (float s : scale) {
+            if (!(s > 0.0f)) throw std::invalid_argument("scale must be positive");
+        }
+    } else if (!scale.empty() || !zero_point.empty()) {
+        throw std::invalid_argument("scale and zero_point apply only to int8/uint8 output");
+    }
+
+    ChannelAffine affine_params = fold_normalization(mean, std_dev, scale, zero_point);
+    auto* dst = static_cast<out_t<F>*>(static_cast<void*>(out.data()));
+    preprocess_into<F>(input.data(), dst, height, width, channels, affine_params, threads);
+}
+
+// ─── Batched preprocess ──────────────────────────────────────────────────────
+//
+// N frames of any size go straight into one preallocated NCHW tensor: no
+// per-frame arrays and no np.stack copy. A frame whose size differs from the
+// target is resized (bilinear, half-pixel centres like cv2.INTER_LINEAR) and,
+// with letterbox, centred with its aspect ratio kept and the border filled
+// with `pad_value`. Work is split into (frame, row band) tasks pulled by
+// every worker, so small frames never wait for a large one to finish.
+
+/** Where a frame landed in its batch slot; maps detections back to the source. */
+struct LetterboxInfo {
+    float scale_x = 1.0f;  // target pixels per source pixel
+    float scale_y = 1.0f;
+    int pad_x = 0;         // left/top border in target pixels
+    int pad_y = 0;
+    int width = 0;         // size of the resized frame inside the slot
+    int height = 0;
+};
+
+static LetterboxInfo letterbox_info(int src_h, int src_w, int dst_h, int dst_w, bool letterbox) {
+    LetterboxInfo info;
+    if (letterbox) {
+        float scale = std::min(static_cast<float>(dst_w) / src_w, static_cast<float>(dst_h) / src_h);
+        info.width = std::clamp(static_cast<int>(std::lround(src_w * scale)), 1, dst_w);
+        info.height = std::clamp(static_cast<int>(std::lround(src_h * scale)), 1, dst_h);
+        info.pad_x = (dst_w - info.width) / 2;
+        info.pad_y = (dst_h - info.height) / 2;
+    } else {
+        info.width = dst_w;
+        info.height = dst_h;
+    }
+    info.scale_x = static_cast<float>(info.width) / src_w;
+    info.scale_y = static_cast<float>(info.height) / src_h;
+    return info;
+}
+
+/** Bilinear source taps for each resized column, computed once per frame. */
+struct ResizeTaps {
+    std::vector<int> x0, x1;
+    std::vector<float> fx;
+};
+
+static ResizeTaps resize_taps(int src_w, const LetterboxInfo& info) {
+    ResizeTaps t;
+    for (int x = 0; x < info.width; ++x) {
+        float sx = std::clamp((x + 0.5f) * src_w / info.width - 0.5f, 0.0f, static_cast<float>(src_w - 1));
+        int x0 = static_cast<int>(sx);
+        t.x0.push_back(x0);
+        t.x1.push_back(std::min(x0 + 1, src_w - 1));
+        t.fx.push_back(sx - x0);
+    }
+    return t;
+}
+
+/** Output rows [row_begin, row_end) of one letterboxed, resized frame. */
+static void preprocess_resized_band(const uint8_t* src, int src_h, int src_w, int channels,
+                                    float* dst, int dst_h, int dst_w, const LetterboxInfo& info,
+                                    const ResizeTaps& taps, const ChannelAffine& a, uint8_t pad_value,
+                                    int row_begin, int row_end) {
+    size_t plane = static_cast<size_t>(dst_h) * dst_w;
+    std::vector<float> pad(channels);
+    for (int c = 0; c < channels; ++c) pad[c] = affine(static_cast<float>(pad_value), a, c);
+
+    // Horizontally interpolated source rows, channel-major; two slots so
+    // consecutive output rows reuse the rows they share
+    std::vector<float> cache[2] = {std::vector<float>(static_cast<size_t>(channels) * info.width),
+                                   std::vector<float>(static_cast<size_t>(channels) * info.width)};
+    int cached_row[2] = {-1, -1};
+    auto source_row = [&](int y) -> const float* {
+        for (int slot = 0; slot < 2; ++slot) {
+            if (cached_row[slot] == y) return cache[slot].data();
+        }
+        int slot = cached_row[0] < cached_row[1] ? 0 : 1;  // rows only move down: evict the older
+        const uint8_t* row = src + static_cast<size_t>(y) * src_w * channels;
+        float* out = cache[slot].data();
+        for (int c = 0; c < channels; ++c) {
+            for (int x = 0; x < info.width; ++x) {
+                float p0 = row[taps.x0[x] * channels + c];
+                float p1 = row[taps.x1[x] * channels + c];
+                out[c * info.width + x] = p0 + (p1 - p0) * taps.fx[x];
+            }
+        }
+        cached_row[slot] = y;
+        return out;
+    };
+
+    for (int y = row_begin; y < row_end; ++y) {
+        float* out_row = dst + static_cast<size_t>(y) * dst_w;
+        int ry = y - info.pad_y;
+        if (ry < 0 || ry >= info.height) {
+            for (int c = 0; c < channels; ++c) std::fill_n(out_row + c * plane, dst_w, pad[c]);
+            continue;
+        }
+        float sy = std::clamp((ry + 0.5f) * src_h / info.height - 0.5f, 0.0f, static_cast<float>(src_h - 1));
+        int y0 = static_cast<int>(sy);
+        int y1 = std::min(y0 + 1, src_h - 1);
+        float fy = sy - y0;
+        const float* r0 = source_row(y0);
+        const float* r1 = source_row(y1);
+        for (int c = 0; c < channels; ++c) {
+            float* out = out_row + c * plane;
+            std::fill_n(out, info.pad_x, pad[c]);
+            std::fill(out + info.pad_x + info.width, out + dst_w, pad[c]);
+            const float* a0 = r0 + c * info.width;
+            const float* a1 = r1 + c * info.width;
+            for (int x = 0; x < info.width; ++x)
+                out[info.pad_x + x] = affine(a0[x] + (a1[x] - a0[x]) * fy, a, c);
+        }
+    }
+}
+
+/**
+ * Preprocess N uint8 HWC frames into one float32 NCHW tensor.
+ *
+ * `out` has shape (N, C, H, W) and is reused across calls. mean/std hold one
+ * per-channel list shared by all frames, or one list per frame. Frames of a
+ * different size are resized into the H x W slot (letterboxed unless
+ * letterbox=False); the returned LetterboxInfo per frame maps coordinates back.
+ */
+std::vector<LetterboxInfo> fused_preprocess_batch(
+    std::vector<nb::ndarray<nb::numpy, const uint8_t, nb::ndim<3>, nb::c_contig>> frames,
+    std::vector<std::vector<float>> mean,
+    std::vector<std::vector<float>> std_dev,
+    nb::ndarray<nb::numpy, float, nb::ndim<4>, nb::c_contig> out,
+    bool letterbox,
+    int pad_value,
+    int threads)
+{
+    const size_t n = frames.size();
+    if (n == 0 || out.shape(0) != n) {
+        throw std::invalid_argument("out must have shape (len(frames), channels, height, width)");
+    }
+    const int channels = static_cast<int>(out.shape(1));
+    const int dst_h = static_cast<int>(out.shape(2));
+    const int dst_w = static_cast<int>(out.shape(3));
+    if ((mean.size() != 1 && mean.size() != n) || std_dev.size() != mean.size()) {
+        throw std::invalid_argument("mean and std need one entry, or one per frame");
+    }
+    if (pad_value < 0 || pad_value > 255) throw std::invalid_argument("pad_value must be in [0, 255]");
+
+    struct Item {
+        const uint8_t* src;
+        int h, w;
+        ChannelAffine affine;
+        LetterboxInfo info;
+        ResizeTaps taps;
+        bool resize;
+    };
+    std::vector<Item> items(n);
+    for (size_t i = 0; i < n; ++i) {
+        const auto& f = frames[i];
+        if (f.shape(2) != static_cast<size_t>(channels) || f.shape(0) == 0 || f.shape(1) == 0) {
+            throw std::invalid_argument("frame " + std::to_string(i) + " must be non-empty with " +
+                                        std::to_string(channels) + " channels");
+        }
+        const auto& m = mean[mean.size() == 1 ? 0 : i];
+        const auto& s = std_dev[std_dev.size() == 1 ? 0 : i];
+        if (m.size() != static_cast<size_t>(channels) || s.size() != static_cast<size_t>(channels)) {
+            throw std::invalid_argument("mean and std must have length == channels");
+        }
+        Item& it = items[i];
+        it.src = f.data();
+        it.h = static_cast<int>(f.shape(0));
+        it.w = static_cast<int>(f.shape(1));
+        it.affine = fold_normalization(m, s);
+        it.resize = it.h != dst_h || it.w != dst_w;
+        it.info = letterbox_info(it.h, it.w, dst_h, dst_w, letterbox && it.resize);
+        if (it.resize) it.taps = resize_taps(it.w, it.info);
+    }
+
+    // Row bands of about one parallel grain each, across all frames
+    const TuningProfile& profile = tuning_profile_storage();
+    int64_t bytes_per_row = static_cast<int64_t>(dst_w) * channels * 5;
+    int band_rows = static_cast<int>(std::clamp<int64_t>(profile.parallel_grain_bytes / bytes_per_row, 1, dst_h));
+    int bands_per_frame = (dst_h + band_rows - 1) / band_rows;
+    size_t frame_floats = static_cast<size_t>(channels) * dst_h * dst_w;
+    size_t plane = static_cast<size_t>(dst_h) * dst_w;
+
+    parallel_tasks(static_cast<int>(n) * bands_per_frame, threads, [&](int task) {
+        const Item& it = items[task / bands_per_frame];
+        float* dst = out.data() + (task / bands_per_frame) * frame_floats;
+        int row_begin = (task % bands_per_frame) * band_rows;
+        int row_end = std::min(dst_h, row_begin + band_rows);
+        if (it.resize) {
+            preprocess_resized_band(it.src, it.h, it.w, channels, dst, dst_h, dst_w, it.info, it.taps,
+                                    it.affine, static_cast<uint8_t>(pad_value), row_begin, row_end);
+        } else {
+            preprocess_band<OutFormat::F32>(it.src, dst, dst_w, channels, plane, row_begin, row_end,
+                                            it.affine, false);
+        }
+    });
+
+    std::vector<LetterboxInfo> infos;
+    for (const auto& it : items) infos.push_back(it.info);
+    return infos;
+}
+
+// ─── Layout transpose ────────────────────────────────────────────────────────
+//
+// HWC ↔ CHW (and NHWC ↔ NCHW, image by image) as a plain layout change with
+// no normalization, e.g. CHW model output back to HWC for display. For
+// P = H * W pixels this is a P x C matrix transpose. Only the element size
+// matters, so uint8, float16 and float32 share one kernel per size S.
+//
+// For C <= 4 a block of 16 / S pixels fills exactly C 16-byte registers in
+// either layout, and byte shuffles with compile-time masks move the block
+// from one layout to the other entirely in registers. Wider C uses a scalar
+// transpose over square tiles sized from the profile's l1_tile_bytes. Both
+// the source and the destination lines of a tile then stay in L1 while it
+// is written out.
+
+/** Square tile edge (in elements) whose source and destination fit in L1 together. */
+static size_t transpose_tile(size_t elem_bytes) {
+    int64_t l1 = tuning_profile_storage().l1_tile_bytes;
+    return std::max<size_t>(8, static_cast<size_t>(std::sqrt(static_cast<double>(l1) / (2.0 * elem_bytes))));
+}
+
+/** dst[c * dst_stride + r] = src[r * src_stride + c] for an rows x cols block, in tiles. */
+template <typename T>
+static void transpose_tiled(const T* src, size_t src_stride, T* dst, size_t dst_stride,
+                            size_t rows, size_t cols, size_t tile) {
+    for (size_t r0 = 0; r0 < rows; r0 += tile) {
+        size_t r1 = std::min(rows, r0 + tile);
+        for (size_t c0 = 0; c0 < cols; c0 += tile) {
+            size_t c1 = std::min(cols, c0 + tile);
+            for (size_t r = r0; r < r1; ++r)
+                for (size_t c = c0; c < c1; ++c) dst[c * dst_stride + r] = src[r * src_stride + c];
+        }
+    }
+}
+
+#if defined(__AVX2__)
+/**
+ * pshufb masks for one block of C registers of S-byte elements.
+ * m[o][i] picks the bytes of output register o that live in input register i
+ * (-1 elsewhere); used[o][i] is false when register i contributes nothing.
+ */
+template <int S, int C, bool ToPlanar>
+struct TransposeMasks {
+    alignas(16) int8_t m[C][C][16] = {};
+    bool used[C][C] = {};
+
+    constexpr TransposeMasks() {
+        for (int o = 0; o < C; ++o) {
+            for (int b = 0; b < 16; ++b) {
+                int from;  // byte offset in the C * 16-byte source block
+                if constexpr (ToPlanar) {
+                    // Output register o is channel o; byte b is pixel b / S
+                    from = ((b / S) * C + o) * S + b % S;
+                } else {
+                    int pixel = (o * 16 + b) / (S * C), rem = (o * 16 + b) % (S * C);
+                    from = (rem / S) * 16 + pixel * S + rem % S;
+                }
+                for (int i = 0; i < C; ++i) {
+                    m[o][i][b] = static_cast<int8_t>(from / 16 == i ? from % 16 : -1);
+                    used[o][i] = used[o][i] || from / 16 == i;
+                }
+            }
+        }
+    }
+};
+
+template <int S, int C, bool ToPlanar>
+inline constexpr TransposeMasks<S, C, ToPlanar> kTransposeMasks{};
+
+/** Output register O of a block: OR of the shuffles of every input register that feeds it. */
+template <int S, int C, bool ToPlanar, int O, int... I>
+static inline __m128i gather_register(const __m128i* in, std::integer_sequence<int, I...>) {
+    __m128i acc = _mm_setzero_si128();
+    auto add = [&]<int In>() {
+        // Resolved at compile time, so registers that contribute nothing cost nothing
+        if constexpr (kTransposeMasks<S, C, ToPlanar>.used[O][In]) {
+            const int8_t* mask = kTransposeMasks<S, C, ToPlanar>.m[O][In];
+            acc = _mm_or_si128(acc, _mm_shuffle_epi8(in[In], _mm_load_si128(reinterpret_cast<const __m128i*>(mask))));
+        }
+    };
+    (add.template operator()<I>(), ...);
+    return acc;
+}
+
+template <int S, int C, bool ToPlanar>
+static inline void shuffle_block(const __m128i* in, __m128i* out) {
+    [&]<int... O>(std::integer_sequence<int, O...> seq) {
+        ((out[O] = gather_register<S, C, ToPlanar, O>(in, seq)), ...);
+    }(std::make_integer_sequence<int, C>{});
+}
+
+/** Pixels [p_begin, p_end) of one image whose channel planes are plane_bytes apart. */
+template <int S, int C, bool ToPlanar, bool Stream>
+static void transpose_pixels_simd(const uint8_t* src, uint8_t* dst, size_t plane_bytes,
+                                  size_t p_begin, size_t p_end) {
+    constexpr size_t kBlock = 16 / S;  // pixels per register block
+    size_t p = p_begin;
+    for (; p + kBlock <= p_end; p += kBlock) {
+        __m128i in[C], out[C];
+        for (int i = 0; i < C; ++i) {
+            const uint8_t* from = ToPlanar ? src + p * C * S + i * 16 : src + i * plane_bytes + p * S;
+            in[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from));
+        }
+        shuffle_block<S, C, ToPlanar>(in, out);
+        for (int o = 0; o < C; ++o) {
+            uint8_t* to = ToPlanar ? dst + o * plane_bytes + p * S : dst + p * C * S + o * 16;
+            if constexpr (Stream) _mm_stream_si128(reinterpret_cast<__m128i*>(to), out[o]);
+            else _mm_storeu_si128(reinterpret_cast<__m128i*>(to), out[o]);
+        }
+    }
+    for (; p < p_end; ++p) {
+        for (int c = 0; c < C; ++c) {
+            size_t interleaved = (p * C + c) * S, planar = c * plane_bytes + p * S;
+            if constexpr (ToPlanar) std::memcpy(dst + planar, src + interleaved, S);
+            else std::memcpy(dst + interleaved, src + planar, S);
+        }
+    }
+    if constexpr (Stream) _mm_sfence();
+}
+#endif
+
+/** Pixels [p_begin, p_end) of one image with `plane` pixels: interleaved ↔ planar. */
+template <typename T>
+static void transpose_pixels(const T* src, T* dst, size_t plane, int channels,
+                             size_t p_begin, size_t p_end, bool to_planar, size_t tile,
+                             [[maybe_unused]] bool stream) {
+    if (channels == 1) {
+        std::memcpy(dst + p_begin, src + p_begin, (p_end - p_begin) * sizeof(T));
+        return;
+    }
+#if defined(__AVX2__)
+    constexpr int S = sizeof(T);
+    auto run = [&]<int C>() {
+        const auto* s = reinterpret_cast<const uint8_t*>(src);
+        auto* d = reinterpret_cast<uint8_t*>(dst);
+        if (to_planar && stream) transpose_pixels_simd<S, C, true, true>(s, d, plane * S, p_begin, p_end);
+        else if (to_planar) transpose_pixels_simd<S, C, true, false>(s, d, plane * S, p_begin, p_end);
+        else if (stream) transpose_pixels_simd<S, C, false, true>(s, d, plane * S, p_begin, p_end);
+        else transpose_pixels_simd<S, C, false, false>(s, d, plane * S, p_begin, p_end);
+    };
+    switch (channels) {
+        case 2: run.template operator()<2>(); return;
+        case 3: run.template operator()<3>(); return;
+        case 4: run.template operator()<4>(); return;
+        default: break;
+    }
+#endif
+    size_t n = p_end - p_begin, c = static_cast<size_t>(channels);
+    if (to_planar)
+        transpose_tiled(src + p_begin * c, c, dst + p_begin, plane, n, c, tile);
+    else
+        transpose_tiled(src + p_begin, plane, dst + p_begin * c, c, c, n, tile);
+}
+
+/**
+ * Interleaved (HWC / NHWC) ↔ planar (CHW / NCHW) copy of a 3-D or 4-D array.
+ *
+ * Each image is split into pixel chunks of about one parallel grain, and the
+ * (image, chunk) tasks are spread over `threads` workers (0 = from the tuning
+ * profile).
+ */
+template <typename T>
+static nb::ndarray<nb::numpy, T> transpose_layout(nb::ndarray<nb::numpy, const T, nb::c_contig> input,
+                                                  bool to_planar, int threads) {
+    if (input.ndim() != 3 && input.ndim() != 4) {
+        throw std::invalid_argument(to_planar ? "input must be HWC (3-D) or NHWC (4-D)"
+                                              : "input must be CHW (3-D) or NCHW (4-D)");
+    }
+    const bool batched = input.ndim() == 4;
+    const size_t n = batched ? input.shape(0) : 1;
+    size_t a = input.shape(batched ? 1 : 0), b = input.shape(batched ? 2 : 1), c = input.shape(batched ? 3 : 2);
+    // to_planar: (h, w, channels) = (a, b, c); otherwise (channels, h, w) = (a, b, c)
+    const size_t channels = to_planar ? c : a;
+    const size_t plane = to_planar ? a * b : b * c;
+    if (channels == 0) throw std::invalid_argument("input must have at least one channel");
+
+    size_t image = plane * channels;
+    T* output = static_cast<T*>(::operator new[](std::max<size_t>(1, n * image) * sizeof(T), std::align_val_t(64)));
+
+    const TuningProfile& profile = tuning_profile_storage();
+    size_t chunk = static_cast<size_t>(profile.parallel_grain_bytes) / (2 * channels * sizeof(T));
+    chunk = std::max<size_t>(64, chunk / 64 * 64);
+    size_t chunks_per_image = std::max<size_t>(1, (plane + chunk - 1) / chunk);
+    size_t tile = transpose_tile(sizeof(T));
+    // Streaming stores need every 16-byte store aligned: the buffer is, and
+    // chunks start on a 64-pixel boundary, so only the plane size can break it
+    bool stream = n * image * sizeof(T) >= static_cast<size_t>(profile.streaming_store_threshold_bytes) &&
+                  plane * sizeof(T) % 16 == 0;
+    const T* src = input.data();
+
+    parallel_tasks(static_cast<int>(n * chunks_per_image), threads, [&](int task) {
+        size_t i = static_cast<size_t>(task) / chunks_per_image;
+        size_t p_begin = static_cast<size_t>(task) % chunks_per_image * chunk;
+        size_t p_end = std::min(plane, p_begin + chunk);
+        if (p_begin < p_end) {
+            transpose_pixels(src + i * image, output + i * image, plane, static_cast<int>(channels),
+                             p_begin, p_end, to_planar, tile, stream);
+        }
+    });
+
+    size_t shape[4];
+    size_t* dst_shape = shape;
+    if (batched) *dst_shape++ = n;
+    if (to_planar) {
+        dst_shape[0] = c; dst_shape[1] = a; dst_shape[2] = b;
+    } else {
+        dst_shape[0] = b; dst_shape[1] = c; dst_shape[2] = a;
+    }
+    nb::capsule owner(output, [](void* p) noexcept { ::operator delete[](p, std::align_val_t(64)); });
+    return nb::ndarray<nb::numpy, T>(output, input.ndim(), shape, owner);
+}
+
+/** HWC → CHW, or NHWC → NCHW for a 4-D batch. */
+template <typename T>
+nb::ndarray<nb::numpy, T> hwc_to_chw(nb::ndarray<nb::numpy, const T, nb::c_contig> input, int threads) {
+    return transpose_layout<T>(input, true, threads);
+}
+
+/** CHW → HWC, or NCHW → NHWC for a 4-D batch. */
+template <typename T>
+nb::ndarray<nb::numpy, T> chw_to_hwc(nb::ndarray<nb::numpy, const T, nb::c_contig> input, int threads) {
+    return transpose_layout<T>(input, false, threads);
+}
+
+/** Textbook triple loop over an HWC image, the baseline hwc_to_chw is benchmarked against. */
+template <typename T>
+nb::ndarray<nb::numpy, T> hwc_to_chw_naive(nb::ndarray<nb::numpy, const T, nb::ndim<3>, nb::c_contig> input) {
+    size_t height = input.shape(0), width = input.shape(1), channels = input.shape(2);
+    T* output = new T[height * width * channels];
+    const T* src = input.data();
+    for (size_t h = 0; h < height; ++h)
+        for (size_t w = 0; w < width; ++w)
+            for (size_t c = 0; c < channels; ++c)
+                output[c * height * width + h * width + w] = src[(h * width + w) * channels + c];
+
+    size_t shape[3] = {channels, height, width};
+    nb::capsule owner(output, [](void* p) noexcept { delete[] static_cast<T*>(p); });
+    return nb::ndarray<nb::numpy, T>(output, 3, shape, owner);
+}
+
+template <typename T>
+static void def_transpose(nb::module_& m) {
+    m.def("hwc_to_chw", &hwc_to_chw<T>, nb::arg("input").noconvert(), nb::arg("threads") = 0,
+          "HWC → CHW (or NHWC → NCHW) layout change for uint8, float16 or float32.");
+    m.def("chw_to_hwc", &chw_to_hwc<T>, nb::arg("input").noconvert(), nb::arg("threads") = 0,
+          "CHW → HWC (or NCHW → NHWC) layout change for uint8, float16 or float32.");
+    m.def("hwc_to_chw_naive", &hwc_to_chw_naive<T>, nb::arg("input").noconvert(),
+          "Naive triple-loop HWC → CHW, for benchmarking.");
+}
+
+template <OutFormat F, typename T>
+static void def_preprocess_into(nb::module_& m) {
+    // noconvert: a dtype mismatch must pick another overload, never fill a temporary copy
+    m.def("fused_preprocess_into", &fused_preprocess_into<F, T>,
+          nb::arg("input"), nb::arg("mean"), nb::arg("std"), nb::arg("out").noconvert(),
+          nb::arg("scale") = std::vector<float>{}, nb::arg("zero_point") = std::vector<int>{},
+          nb::arg("threads") = 0,
+          "Fused preprocess into a CHW buffer of float32, float16, uint16 (bfloat16 bits), int8 or uint8.");
+}
+
+/** Which vector path fused_preprocess was compiled with. */
+std::string simd_level() {
+#if defined(__AVX512F__) && defined(__FMA__) && defined(__F16C__)
+    return "avx512";
+#elif defined(__AVX2__) && defined(__FMA__) && defined(__F16C__)
+    return "avx2";
+#else
+    return "scalar";
+#endif
+}
+
 /**
  * CPU numpy-style preprocess (mimics tracker_engine's TRT_Preprocessor.process).
  *
@@ -73,7 +1115,7 @@ nb::ndarray<nb::numpy, float> fused_preprocess(
  *   3. Transpose HWC → CHW
  */
 nb::ndarray<nb::numpy, float> numpy_style_preprocess(
-    nb::ndarray<nb::numpy, const uint8_t, nb::ndim<3>> input,
+    nb::ndarray<nb::numpy, const uint8_t, nb::ndim<3>, nb::c_contig> input,
     std::vector<float> mean,
     std::vector<float> std_dev)
 {
@@ -135,9 +1177,54 @@ bool cuda_available() { return false; }
 NB_MODULE(MODULE_NAME, m) {
     m.doc() = "CPU reference implementation of fused preprocessing";
 
+    nb::class_<TuningProfile>(m, "TuningProfile")
+        .def_ro("threads", &TuningProfile::threads)
+        .def_ro("l1_tile_bytes", &TuningProfile::l1_tile_bytes)
+        .def_ro("l2_tile_bytes", &TuningProfile::l2_tile_bytes)
+        .def_ro("parallel_grain_bytes", &TuningProfile::parallel_grain_bytes)
+        .def_ro("streaming_store_threshold_bytes", &TuningProfile::streaming_store_threshold_bytes)
+        .def_ro("source", &TuningProfile::source)
+        .def_ro("path", &TuningProfile::path);
+
+    m.def("tuning_profile", &tuning_profile,
+          "Tile sizes and thread count the CPU kernels use (from the L6 profile cache).");
+
+    m.def("reload_tuning_profile", &reload_tuning_profile,
+          "Re-read the profile cache written by cache_benchmark.load_tuning_profile().");
+
     m.def("fused_preprocess", &fused_preprocess,
+          nb::arg("input"), nb::arg("mean"), nb::arg("std"), nb::arg("threads") = 0,
+          "CPU fused preprocess: uint8 HWC → float32 CHW normalized (SIMD, multithreaded).");
+
+    m.def("fused_preprocess_scalar", &fused_preprocess_scalar,
           nb::arg("input"), nb::arg("mean"), nb::arg("std"),
-          "CPU fused preprocess: uint8 HWC → float32 CHW normalized.");
+          "Single-threaded scalar reference for fused_preprocess.");
+
+    nb::class_<LetterboxInfo>(m, "LetterboxInfo")
+        .def_ro("scale_x", &LetterboxInfo::scale_x)
+        .def_ro("scale_y", &LetterboxInfo::scale_y)
+        .def_ro("pad_x", &LetterboxInfo::pad_x)
+        .def_ro("pad_y", &LetterboxInfo::pad_y)
+        .def_ro("width", &LetterboxInfo::width)
+        .def_ro("height", &LetterboxInfo::height);
+
+    m.def("fused_preprocess_batch", &fused_preprocess_batch,
+          nb::arg("frames"), nb::arg("mean"), nb::arg("std"), nb::arg("out").noconvert(),
+          nb::arg("letterbox") = true, nb::arg("pad_value") = 114, nb::arg("threads") = 0,
+          "Preprocess uint8 HWC frames of any size into one float32 NCHW tensor (resize + letterbox).");
+
+    def_preprocess_into<OutFormat::F32, float>(m);
+    def_preprocess_into<OutFormat::F16, Half>(m);
+    def_preprocess_into<OutFormat::BF16, uint16_t>(m);
+    def_preprocess_into<OutFormat::I8, int8_t>(m);
+    def_preprocess_into<OutFormat::U8, uint8_t>(m);
+
+    def_transpose<uint8_t>(m);
+    def_transpose<Half>(m);
+    def_transpose<float>(m);
+
+    m.def("simd_level", &simd_level,
+          "Vector path compiled into fused_preprocess: 'avx512', 'avx2' or 'scalar'.");
 
     m.def("numpy_style_preprocess", &numpy_style_preprocess,
           nb::arg("input"), nb::arg("mean"), nb::arg("std"),
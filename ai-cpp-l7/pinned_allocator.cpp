@@ -10,15 +10,38 @@
  *   buf = pool.acquire()    # O(1) — no allocation
  *   # ... fill buf, transfer to GPU ...
  *   pool.release(buf)       # O(1) — no deallocation
+ *
+ * Between pipeline stages the pool is also the backpressure mechanism: the
+ * producer blocks in acquire(timeout) while every buffer is in flight, hands
+ * filled buffers over with submit(), and the consumer take()s them in order.
+ *
+ * For frames of varying size, PinnedArena sub-allocates arbitrary sizes out
+ * of one pinned region with a buddy allocator:
+ *   arena = PinnedArena(arena_size=256 << 20)
+ *   buf = arena.alloc(h * w * 3)   # O(log n); freed when buf is garbage-collected
+ *
+ * To overlap pipeline stages, StagedRing passes a ring of pinned buffers from
+ * stage to stage, one thread per stage:
+ *   ring = StagedRing(n_stages=3, n_slots=4, buffer_size=640*480*3)
+ *   buf, slot = ring.begin(stage)   # next slot in ring order, once upstream is done
+ *   ring.commit(stage, slot)        # hand it to stage + 1
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <queue>
 #include <stdexcept>
+#include <string>
+#include <thread>
 #include <vector>
 
 #if HAVE_CUDA
@@ -27,6 +50,7 @@
 
 #include <nanobind/nanobind.h>
 #include <nanobind/ndarray.h>
+#include <nanobind/stl/optional.h>
 #include <nanobind/stl/string.h>
 #include <nanobind/stl/vector.h>
 
@@ -34,20 +58,26 @@ namespace nb = nanobind;
 
 // ─── Pinned memory helpers ───────────────────────────────────────────────────
 
+constexpr size_t kPageBytes = 4096;
+
+/** Page-aligned host memory, so the fallback lines up like cudaMallocHost's. */
+static void* host_alloc(size_t size) {
+    void* ptr = std::aligned_alloc(kPageBytes, (size + kPageBytes - 1) / kPageBytes * kPageBytes);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
 static void* pinned_alloc(size_t size) {
 #if HAVE_CUDA
     void* ptr = nullptr;
     cudaError_t err = cudaMallocHost(&ptr, size);
     if (err != cudaSuccess) {
         // Fall back to regular malloc if CUDA runtime fails
-        ptr = std::malloc(size);
-        if (!ptr) throw std::bad_alloc();
+        ptr = host_alloc(size);
     }
     return ptr;
 #else
-    void* ptr = std::malloc(size);
-    if (!ptr) throw std::bad_alloc();
-    return ptr;
+    return host_alloc(size);
 #endif
 }
 
@@ -65,6 +95,19 @@ static void pinned_free(void* ptr) {
 
 // ─── PinnedBufferPool ────────────────────────────────────────────────────────
 
+/** Counters since construction or the last reset_stats(). Wait times are in nanoseconds. */
+struct PoolStats {
+    uint64_t acquires = 0;           // buffers handed out by acquire / try_acquire
+    uint64_t waits = 0;              // acquires that found the pool empty and blocked
+    uint64_t timeouts = 0;           // acquires that gave up without a buffer
+    uint64_t dropped = 0;            // ready buffers reclaimed by drop_oldest
+    int64_t wait_ns_total = 0;       // time spent blocked in acquire
+    int64_t wait_ns_max = 0;
+    uint64_t takes = 0;              // buffers handed to the consumer by take
+    int64_t take_wait_ns_total = 0;  // time spent blocked in take
+    int64_t take_wait_ns_max = 0;
+};
+
 class PinnedBufferPool {
 public:
     /**
@@ -86,6 +129,7 @@ public:
             buffers_.push_back(ptr);
             available_.push(i);
         }
+        state_.assign(n_buffers, State::Free);
     }
 
     ~PinnedBufferPool() {
@@ -103,63 +147,95 @@ public:
      * Returns a numpy array (uint8) backed by pinned memory.
      * The array shape is (buffer_size,) — reshape as needed.
      *
-     * Throws if no buffers are available.
+     * With timeout > 0, waits up to that many seconds for a release (< 0:
+     * wait forever) with the GIL released. With drop_oldest, an empty pool
+     * reclaims the oldest submitted-but-not-taken buffer instead of waiting.
+     * Throws if no buffer becomes available.
      */
-    nb::ndarray<nb::numpy, uint8_t, nb::ndim<1>> acquire() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (available_.empty()) {
-            throw std::runtime_error(
-                "PinnedBufferPool: no buffers available. "
-                "Increase pool size or release buffers sooner.");
-        }
-
-        size_t idx = available_.front();
-        available_.pop();
-
-        uint8_t* ptr = static_cast<uint8_t*>(buffers_[idx]);
-        size_t shape[1] = { buffer_size_ };
-
-        // Create a capsule that captures the pool index for release tracking.
-        // The capsule does NOT free the memory — the pool owns it.
-        // We store the index in the capsule so release() can validate.
-        size_t* idx_copy = new size_t(idx);
-        nb::capsule owner(idx_copy, [](void* p) noexcept { delete static_cast<size_t*>(p); });
-
-        return nb::ndarray<nb::numpy, uint8_t, nb::ndim<1>>(ptr, 1, shape, owner);
+    nb::ndarray<nb::numpy, uint8_t, nb::ndim<1>> acquire(double timeout, bool drop_oldest) {
+        return make_array(acquire_or_throw(timeout, drop_oldest));
     }
 
     /**
      * Release buffer at the given index back to the pool.
+     * Throws if the buffer is not currently held (double release).
      */
     void release(size_t index) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (index >= total_buffers_) {
-            throw std::out_of_range("PinnedBufferPool: invalid buffer index");
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            check_index(index);
+            if (state_[index] == State::Free) {
+                throw std::runtime_error("PinnedBufferPool: buffer " + std::to_string(index) + " already released");
+            }
+            if (state_[index] == State::Ready) {
+                throw std::runtime_error("PinnedBufferPool: buffer " + std::to_string(index) +
+                                         " is submitted; take() it before releasing");
+            }
+            state_[index] = State::Free;
+            available_.push(index);
         }
-        available_.push(index);
+        cv_.notify_all();
     }
 
     /**
      * Acquire a buffer and return (numpy_array, index) tuple.
      * The index is needed to release the buffer later.
      */
-    nb::tuple acquire_with_index() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (available_.empty()) {
-            throw std::runtime_error("PinnedBufferPool: no buffers available.");
-        }
+    nb::tuple acquire_with_index(double timeout, bool drop_oldest) {
+        size_t idx = acquire_or_throw(timeout, drop_oldest);
+        return nb::make_tuple(make_array(idx), idx);
+    }
 
-        size_t idx = available_.front();
-        available_.pop();
+    /** (numpy_array, index), or None right away if the pool is empty. */
+    std::optional<nb::tuple> try_acquire(bool drop_oldest) {
+        std::optional<size_t> idx = acquire_index(0.0, drop_oldest);
+        if (!idx) return std::nullopt;
+        return nb::make_tuple(make_array(*idx), *idx);
+    }
 
-        uint8_t* ptr = static_cast<uint8_t*>(buffers_[idx]);
-        size_t shape[1] = { buffer_size_ };
+    /** Hand a filled buffer to the consumer side; take() returns buffers in submit order. */
+    void submit(size_t index) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            check_index(index);
+            if (state_[index] != State::Held) {
+                throw std::runtime_error("PinnedBufferPool: buffer " + std::to_string(index) + " is not acquired");
+            }
+            state_[index] = State::Ready;
+            ready_.push_back(index);
+        }
+        cv_.notify_all();
+    }
 
-        size_t* idx_copy = new size_t(idx);
-        nb::capsule owner(idx_copy, [](void* p) noexcept { delete static_cast<size_t*>(p); });
+    /**
+     * Oldest submitted buffer as (numpy_array, index), waiting up to `timeout`
+     * seconds (< 0: forever) with the GIL released. None on timeout, or once
+     * the pool is closed and drained. The consumer release()s it when done.
+     */
+    std::optional<nb::tuple> take(double timeout) {
+        std::optional<size_t> idx;
+        bool wait;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            idx = pop_ready_locked();
+            wait = !idx && timeout != 0.0 && !closed_;
+        }
+        if (wait) {
+            nb::gil_scoped_release release;
+            idx = wait_for(timeout, [&] { return pop_ready_locked(); },
+                           stats_.take_wait_ns_total, stats_.take_wait_ns_max);
+        }
+        if (!idx) return std::nullopt;
+        return nb::make_tuple(make_array(*idx), *idx);
+    }
 
-        auto arr = nb::ndarray<nb::numpy, uint8_t, nb::ndim<1>>(ptr, 1, shape, owner);
-        return nb::make_tuple(arr, idx);
+    /** Wake every waiter: pending and later acquires raise, take() drains then returns None. */
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        cv_.notify_all();
     }
 
     size_t available_count() const {
@@ -167,9 +243,24 @@ public:
         return available_.size();
     }
 
+    size_t ready_count() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return ready_.size();
+    }
+
     size_t total_count() const { return total_buffers_; }
     size_t buffer_size() const { return buffer_size_; }
 
+    PoolStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+    void reset_stats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_ = PoolStats{};
+    }
+
     bool is_pinned() const {
 #if HAVE_CUDA
         return true;
@@ -182,23 +273,702 @@ public:
         std::lock_guard<std::mutex> lock(mutex_);
         return "PinnedBufferPool(total=" + std::to_string(total_buffers_) +
                ", available=" + std::to_string(available_.size()) +
+               ", ready=" + std::to_string(ready_.size()) +
                ", buffer_size=" + std::to_string(buffer_size_) +
                ", pinned=" + (is_pinned() ? "true" : "false") + ")";
     }
 
 private:
+    enum class State : uint8_t { Free, Held, Ready };
+
+    void check_index(size_t index) const {
+        if (index >= total_buffers_) {
+            throw std::out_of_range("PinnedBufferPool: invalid buffer index");
+        }
+    }
+
+    nb::ndarray<nb::numpy, uint8_t, nb::ndim<1>> make_array(size_t idx) {
+        uint8_t* ptr = static_cast<uint8_t*>(buffers_[idx]);
+        size_t shape[1] = { buffer_size_ };
+
+        // Create a capsule that captures the pool index for release tracking.
+        // The capsule does NOT free the memory — the pool owns it.
+        size_t* idx_copy = new size_t(idx);
+        nb::capsule owner(idx_copy, [](void* p) noexcept { delete static_cast<size_t*>(p); });
+
+        return nb::ndarray<nb::numpy, uint8_t, nb::ndim<1>>(ptr, 1, shape, owner);
+    }
+
+    /** A free buffer, or with drop_oldest the oldest ready one. Caller holds mutex_. */
+    std::optional<size_t> pop_free_locked(bool drop_oldest) {
+        size_t idx;
+        if (!available_.empty()) {
+            idx = available_.front();
+            available_.pop();
+        } else if (drop_oldest && !ready_.empty()) {
+            idx = ready_.front();
+            ready_.pop_front();
+            ++stats_.dropped;
+        } else {
+            return std::nullopt;
+        }
+        state_[idx] = State::Held;
+        ++stats_.acquires;
+        return idx;
+    }
+
+    std::optional<size_t> pop_ready_locked() {
+        if (ready_.empty()) return std::nullopt;
+        size_t idx = ready_.front();
+        ready_.pop_front();
+        state_[idx] = State::Held;
+        ++stats_.takes;
+        return idx;
+    }
+
+    /**
+     * Block on cv_ until pop() yields a buffer, the pool closes, or `timeout`
+     * seconds pass (< 0: no limit). The time spent goes into the given stats
+     * counters. Takes mutex_ itself; call it with the GIL released.
+     */
+    template <typename Pop>
+    std::optional<size_t> wait_for(double timeout, Pop&& pop, int64_t& wait_ns_total, int64_t& wait_ns_max) {
+        auto start = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(mutex_);
+        std::optional<size_t> idx;
+        auto done = [&] {
+            idx = pop();
+            return idx.has_value() || closed_;
+        };
+        if (timeout < 0) {
+            cv_.wait(lock, done);
+        } else {
+            cv_.wait_for(lock, std::chrono::duration<double>(timeout), done);
+        }
+        int64_t waited = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        wait_ns_total += waited;
+        wait_ns_max = std::max(wait_ns_max, waited);
+        return idx;
+    }
+
+    /** Index of an acquired buffer, or nullopt after `timeout`. Throws once closed. */
+    std::optional<size_t> acquire_index(double timeout, bool drop_oldest) {
+        {
+            // Fast path with the GIL held: releasing it costs more than an uncontended pop
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (closed_) throw std::runtime_error("PinnedBufferPool: pool is closed");
+            if (auto idx = pop_free_locked(drop_oldest)) return idx;
+            if (timeout == 0.0) {
+                ++stats_.timeouts;
+                return std::nullopt;
+            }
+            ++stats_.waits;
+        }
+        std::optional<size_t> idx;
+        {
+            nb::gil_scoped_release release;
+            idx = wait_for(timeout, [&] { return pop_free_locked(drop_oldest); },
+                           stats_.wait_ns_total, stats_.wait_ns_max);
+        }
+        if (!idx) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (closed_) throw std::runtime_error("PinnedBufferPool: pool is closed");
+            ++stats_.timeouts;
+        }
+        return idx;
+    }
+
+    size_t acquire_or_throw(double timeout, bool drop_oldest) {
+        std::optional<size_t> idx = acquire_index(timeout, drop_oldest);
+        if (!idx) {
+            throw std::runtime_error(
+                timeout == 0.0 ? "PinnedBufferPool: no buffers available. "
+                                 "Increase pool size or release buffers sooner."
+                               : "PinnedBufferPool: no buffers available within the timeout.");
+        }
+        return *idx;
+    }
+
     size_t buffer_size_;
     size_t total_buffers_;
     std::vector<void*> buffers_;
     std::queue<size_t> available_;
+    std::deque<size_t> ready_;   // submitted, oldest first
+    std::vector<State> state_;
+    PoolStats stats_;
+    bool closed_ = false;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;  // any buffer freed or submitted, or the pool closed
+};
+
+// ─── PinnedArena: buddy sub-allocator ────────────────────────────────────────
+//
+// One pinned region carved into power-of-two blocks of min_block << k bytes.
+// An allocation takes the smallest free block that fits, splitting larger
+// ones in half as needed. A freed block merges with its buddy (the other half
+// of the block it was split from, at offset ^ size) for as long as that buddy
+// is free too. Both are O(log n) in the number of orders. Blocks sit at a
+// multiple of their own size, so every block is aligned to its size, up to
+// the arena's page alignment.
+//
+// The bookkeeping lives outside the arena: one entry per min_block unit, with
+// free-list links stored at block heads. A stray write past the end of a
+// buffer can corrupt a neighbour's pixels, but never the allocator.
+
+/** Snapshot of an arena's occupancy. Fragmentation values are in [0, 1]. */
+struct ArenaStats {
+    size_t capacity_bytes = 0;
+    size_t used_bytes = 0;                // sum of allocated block sizes
+    size_t requested_bytes = 0;           // sum of the sizes asked for
+    size_t free_bytes = 0;
+    size_t largest_free_block = 0;        // biggest allocation that can still succeed
+    size_t free_blocks = 0;
+    size_t live_allocations = 0;
+    size_t peak_used_bytes = 0;
+    uint64_t failed_allocations = 0;
+    double internal_fragmentation = 0.0;  // 1 - requested / used: rounding to powers of two
+    double external_fragmentation = 0.0;  // 1 - largest_free_block / free_bytes: scattered holes
+};
+
+class BuddyArena {
+public:
+    BuddyArena(size_t arena_size, size_t min_block) : min_block_(min_block) {
+        if (min_block < 64 || (min_block & (min_block - 1)) != 0) {
+            throw std::invalid_argument("min_block must be a power of two >= 64");
+        }
+        if (arena_size == 0 || arena_size / min_block >= kNone) {
+            throw std::invalid_argument("arena_size must be > 0 and < 2^32 blocks");
+        }
+        units_ = (arena_size + min_block - 1) / min_block;
+
+        while ((size_t{2} << max_order_) <= units_) ++max_order_;
+        base_ = static_cast<uint8_t*>(pinned_alloc(units_ * min_block_));
+        auto address = reinterpret_cast<uintptr_t>(base_);
+        base_alignment_ = std::min<size_t>(address & (~address + 1), kPageBytes);
+
+        head_.assign(max_order_ + 1, kNone);
+        next_.assign(units_, kNone);
+        prev_.assign(units_, kNone);
+        free_order_.assign(units_, -1);
+        // Cover [0, units) with the largest blocks that are aligned to their size
+        for (size_t off = 0; off < units_;) {
+            int k = max_order_;
+            while ((off & ((size_t{1} << k) - 1)) != 0 || off + (size_t{1} << k) > units_) --k;
+            push(static_cast<uint32_t>(off), k);
+            off += size_t{1} << k;
+        }
+    }
+
+    ~BuddyArena() { pinned_free(base_); }
+
+    BuddyArena(const BuddyArena&) = delete;
+    BuddyArena& operator=(const BuddyArena&) = delete;
+
+    struct Block {
+        size_t offset;  // bytes from base()
+        int order;
+    };
+
+    /** A block of at least nbytes aligned to `alignment`, or nullopt if none is free. */
+    std::optional<Block> allocate(size_t nbytes, size_t alignment) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t need = std::max(nbytes, alignment);
+        if (need > (min_block_ << max_order_)) {
+            ++failed_;
+            return std::nullopt;
+        }
+        size_t units = (need + min_block_ - 1) / min_block_;
+        int order = 0;
+        while ((size_t{1} << order) < units) ++order;
+
+        int j = order;
+        while (j <= max_order_ && head_[j] == kNone) ++j;
+        if (j > max_order_) {
+            ++failed_;
+            return std::nullopt;
+        }
+        uint32_t off = head_[j];
+        remove(off, j);
+        while (j > order) {  // split, keeping the lower half
+            --j;
+            push(off + (uint32_t{1} << j), j);
+        }
+        used_ += min_block_ << order;
+        requested_ += nbytes;
+        ++live_;
+        peak_used_ = std::max(peak_used_, used_);
+        return Block{static_cast<size_t>(off) * min_block_, order};
+    }
+
+    void deallocate(Block block, size_t nbytes) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto off = static_cast<uint32_t>(block.offset / min_block_);
+        int k = block.order;
+        used_ -= min_block_ << k;
+        requested_ -= nbytes;
+        --live_;
+        while (k < max_order_) {
+            uint32_t buddy = off ^ (uint32_t{1} << k);
+            if (buddy + (size_t{1} << k) > units_ || free_order_[buddy] != k) break;
+            remove(buddy, k);
+            off = std::min(off, buddy);
+            ++k;
+        }
+        push(off, k);
+    }
+
+    ArenaStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ArenaStats s;
+        s.capacity_bytes = units_ * min_block_;
+        s.used_bytes = used_;
+        s.requested_bytes = requested_;
+        s.free_bytes = s.capacity_bytes - used_;
+        for (int k = max_order_; k >= 0; --k) {
+            if (head_[k] != kNone) {
+                s.largest_free_block = min_block_ << k;
+                break;
+            }
+        }
+        s.free_blocks = free_blocks_;
+        s.live_allocations = live_;
+        s.peak_used_bytes = peak_used_;
+        s.failed_allocations = failed_;
+        if (used_ > 0) s.internal_fragmentation = 1.0 - static_cast<double>(requested_) / used_;
+        if (s.free_bytes > 0) {
+            s.external_fragmentation = 1.0 - static_cast<double>(s.largest_free_block) / s.free_bytes;
+        }
+        return s;
+    }
+
+    uint8_t* base() const { return base_; }
+    size_t capacity() const { return units_ * min_block_; }
+    size_t min_block() const { return min_block_; }
+    size_t base_alignment() const { return base_alignment_; }
+
+private:
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    void push(uint32_t off, int k) {
+        next_[off] = head_[k];
+        prev_[off] = kNone;
+        if (head_[k] != kNone) prev_[head_[k]] = off;
+        head_[k] = off;
+        free_order_[off] = static_cast<int8_t>(k);
+        ++free_blocks_;
+    }
+
+    void remove(uint32_t off, int k) {
+        if (prev_[off] != kNone) next_[prev_[off]] = next_[off];
+        else head_[k] = next_[off];
+        if (next_[off] != kNone) prev_[next_[off]] = prev_[off];
+        free_order_[off] = -1;
+        --free_blocks_;
+    }
+
+    size_t min_block_;
+    size_t units_ = 0;                // arena size in min_block units
+    int max_order_ = 0;
+    uint8_t* base_ = nullptr;
+    size_t base_alignment_ = 0;
+    std::vector<uint32_t> head_;      // per order: first free block, kNone if empty
+    std::vector<uint32_t> next_;      // per unit: free-list links, valid at free block heads
+    std::vector<uint32_t> prev_;
+    std::vector<int8_t> free_order_;  // per unit: order of the free block starting here, or -1
+    size_t free_blocks_ = 0;
+    size_t used_ = 0;
+    size_t requested_ = 0;
+    size_t live_ = 0;
+    size_t peak_used_ = 0;
+    uint64_t failed_ = 0;
     mutable std::mutex mutex_;
 };
 
+class PinnedArena {
+public:
+    /**
+     * Reserve one pinned region of arena_size bytes (rounded up to min_block).
+     *
+     * @param arena_size  Total bytes to pin
+     * @param min_block   Smallest block handed out; a power of two >= 64
+     */
+    PinnedArena(size_t arena_size, size_t min_block)
+        : arena_(std::make_shared<BuddyArena>(arena_size, min_block)) {}
+
+    /**
+     * Allocate nbytes aligned to `alignment` as a numpy uint8 array.
+     *
+     * The block returns to the arena when the array (and every view of it)
+     * is garbage-collected. The arena itself stays alive until then, even if
+     * the PinnedArena object goes away first. Raises MemoryError when no free
+     * block is large enough.
+     */
+    nb::ndarray<nb::numpy, uint8_t, nb::ndim<1>> alloc(size_t nbytes, size_t alignment) {
+        if (nbytes == 0) throw std::invalid_argument("nbytes must be > 0");
+        if (alignment == 0 || (alignment & (alignment - 1)) != 0 || alignment > arena_->base_alignment()) {
+            throw std::invalid_argument("alignment must be a power of two <= " +
+                                        std::to_string(arena_->base_alignment()));
+        }
+        std::optional<BuddyArena::Block> block = arena_->allocate(nbytes, alignment);
+        if (!block) throw std::bad_alloc();
+
+        struct Allocation {
+            std::shared_ptr<BuddyArena> arena;
+            BuddyArena::Block block;
+            size_t nbytes;
+        };
+        auto* allocation = new Allocation{arena_, *block, nbytes};
+        nb::capsule owner(allocation, [](void* p) noexcept {
+            auto* a = static_cast<Allocation*>(p);
+            a->arena->deallocate(a->block, a->nbytes);
+            delete a;
+        });
+        size_t shape[1] = { nbytes };
+        return nb::ndarray<nb::numpy, uint8_t, nb::ndim<1>>(arena_->base() + block->offset, 1, shape, owner);
+    }
+
+    ArenaStats stats() const { return arena_->stats(); }
+    size_t capacity() const { return arena_->capacity(); }
+    size_t min_block() const { return arena_->min_block(); }
+
+    bool is_pinned() const {
+#if HAVE_CUDA
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    std::string info() const {
+        ArenaStats s = arena_->stats();
+        return "PinnedArena(capacity=" + std::to_string(s.capacity_bytes) +
+               ", used=" + std::to_string(s.used_bytes) +
+               ", live=" + std::to_string(s.live_allocations) +
+               ", largest_free=" + std::to_string(s.largest_free_block) +
+               ", pinned=" + (is_pinned() ? "true" : "false") + ")";
+    }
+
+private:
+    std::shared_ptr<BuddyArena> arena_;
+};
+
+// ─── StagedRing: overlapping pipeline stages ─────────────────────────────────
+//
+// n_slots pinned buffers visited in ring order by n_stages stages, each
+// driven by one thread. Slot i is handed to stage k+1 when stage k commits
+// it, so capture can fill slot i+1 while preprocess works on slot i and
+// inference on slot i-1.
+//
+// A slot's state is one atomic word: 2k means "ready for stage k", 2k+1
+// means "stage k is working on it". Stage 0's ready state is "free", and the
+// last stage's commit wraps the slot back to free. Every transition is a CAS
+// or a store on that word, so the hand-off itself never takes a lock. The
+// mutex and condition variable are used only by a stage that has to sleep,
+// and a commit touches them only when someone is asleep.
+
+/** Per-stage counters since construction or the last reset_stats(). Times in nanoseconds. */
+struct StageStats {
+    uint64_t processed = 0;     // slots committed by this stage
+    uint64_t stalls = 0;        // begin() calls that found the next slot not ready and waited for it
+    int64_t stall_ns_total = 0; // time spent waiting in begin(), yielding or asleep
+    int64_t stall_ns_max = 0;
+    int64_t busy_ns_total = 0;  // time between begin() and commit()
+};
+
+class StagedRing {
+public:
+    /**
+     * Allocate n_slots pinned buffers shared by n_stages pipeline stages.
+     *
+     * @param n_stages     Pipeline stages, e.g. 3 for capture → preprocess → infer
+     * @param n_slots      Buffers in the ring; n_stages lets every stage work at once
+     * @param buffer_size  Size of each buffer in bytes
+     */
+    StagedRing(size_t n_stages, size_t n_slots, size_t buffer_size)
+        : buffer_size_(buffer_size), buffers_(std::make_shared<Buffers>()), slots_(n_slots), stages_(n_stages)
+    {
+        if (n_stages < 2) throw std::invalid_argument("n_stages must be >= 2");
+        if (n_slots == 0) throw std::invalid_argument("n_slots must be > 0");
+        if (buffer_size == 0) throw std::invalid_argument("buffer_size must be > 0");
+        buffers_->data.reserve(n_slots);
+        for (Slot& s : slots_) {
+            s.data = buffers_->data.emplace_back(pinned_alloc(buffer_size));
+            std::memset(s.data, 0, buffer_size);
+        }
+    }
+
+    StagedRing(const StagedRing&) = delete;
+    StagedRing& operator=(const StagedRing&) = delete;
+
+    /**
+     * Claim the next slot for `stage` as (numpy_array, slot).
+     *
+     * Slots come in ring order. If the next one is still upstream, waits up
+     * to `timeout` seconds (< 0: forever) with the GIL released; the time
+     * counts as a stall of this stage. Returns None on timeout, or once the
+     * ring is closed and everything upstream has drained.
+     */
+    std::optional<nb::tuple> begin(size_t stage, double timeout) {
+        Stage& st = stage_at(stage);
+        int64_t held = st.held.load(std::memory_order_relaxed);
+        if (held >= 0) {
+            throw std::runtime_error("StagedRing: stage " + std::to_string(stage) + " still holds slot " +
+                                     std::to_string(held) + "; commit it first");
+        }
+        size_t slot = st.cursor % slots_.size();
+        bool taken = try_take(stage, slot, false);
+        if (!taken && timeout != 0.0 && !finished(stage)) {
+            nb::gil_scoped_release release;
+            auto start = std::chrono::steady_clock::now();
+            // The upstream commit is often microseconds away: yield a few
+            // times before paying for a sleep and a wake-up
+            for (int i = 0; i < kSpinYields && !taken && !finished(stage); ++i) {
+                std::this_thread::yield();
+                taken = try_take(stage, slot, false);
+            }
+            if (!taken && !finished(stage)) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                waiters_.fetch_add(1, std::memory_order_seq_cst);
+                auto done = [&] {
+                    taken = try_take(stage, slot, true);
+                    return taken || finished(stage);
+                };
+                if (timeout < 0) {
+                    cv_.wait(lock, done);
+                } else {
+                    cv_.wait_for(lock, std::chrono::duration<double>(timeout), done);
+                }
+                waiters_.fetch_sub(1, std::memory_order_seq_cst);
+            }
+            int64_t waited = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            st.stalls.fetch_add(1, std::memory_order_relaxed);
+            st.stall_ns_total.fetch_add(waited, std::memory_order_relaxed);
+            atomic_max(st.stall_ns_max, waited);
+        }
+        if (!taken) return std::nullopt;
+
+        st.begin_ns = now_ns();
+        return nb::make_tuple(make_array(slot), slot);
+    }
+
+    /** Pass the slot this stage holds on to the next stage (the last stage frees it). */
+    void commit(size_t stage, size_t slot) {
+        Stage& st = stage_at(stage);
+        if (st.held.load(std::memory_order_relaxed) != static_cast<int64_t>(slot)) {
+            throw std::runtime_error("StagedRing: stage " + std::to_string(stage) +
+                                     " does not hold slot " + std::to_string(slot));
+        }
+        st.busy_ns_total.fetch_add(now_ns() - st.begin_ns, std::memory_order_relaxed);
+        st.processed.fetch_add(1, std::memory_order_relaxed);
+        ++st.cursor;
+        // commits before held: finished() of the next stage must never see
+        // this stage idle with the count not yet raised
+        st.commits.fetch_add(1, std::memory_order_seq_cst);
+        st.held.store(-1, std::memory_order_seq_cst);
+        uint32_t next = stage + 1 == stages_.size() ? 0 : static_cast<uint32_t>(2 * (stage + 1));
+        slots_[slot].state.store(next, std::memory_order_seq_cst);
+        notify();
+    }
+
+    /**
+     * End the stream: stage 0 gets None from now on, and each later stage
+     * gets None once it has processed everything committed upstream.
+     */
+    void close() {
+        closed_.store(true, std::memory_order_seq_cst);
+        notify();
+    }
+
+    /** State of every slot: "free", "filling", "ready:k" or "consuming:k" (k = stage). */
+    std::vector<std::string> slot_states() const {
+        std::vector<std::string> out;
+        out.reserve(slots_.size());
+        for (const Slot& s : slots_) {
+            uint32_t state = s.state.load(std::memory_order_relaxed);
+            uint32_t stage = state / 2;
+            bool busy = state % 2 != 0;
+            if (stage == 0) {
+                out.emplace_back(busy ? "filling" : "free");
+            } else {
+                out.push_back((busy ? "consuming:" : "ready:") + std::to_string(stage));
+            }
+        }
+        return out;
+    }
+
+    std::vector<StageStats> stats() const {
+        std::vector<StageStats> out(stages_.size());
+        for (size_t k = 0; k < stages_.size(); ++k) {
+            const Stage& st = stages_[k];
+            out[k].processed = st.processed.load(std::memory_order_relaxed);
+            out[k].stalls = st.stalls.load(std::memory_order_relaxed);
+            out[k].stall_ns_total = st.stall_ns_total.load(std::memory_order_relaxed);
+            out[k].stall_ns_max = st.stall_ns_max.load(std::memory_order_relaxed);
+            out[k].busy_ns_total = st.busy_ns_total.load(std::memory_order_relaxed);
+        }
+        return out;
+    }
+
+    void reset_stats() {
+        for (Stage& st : stages_) {
+            st.processed.store(0, std::memory_order_relaxed);
+            st.stalls.store(0, std::memory_order_relaxed);
+            st.stall_ns_total.store(0, std::memory_order_relaxed);
+            st.stall_ns_max.store(0, std::memory_order_relaxed);
+            st.busy_ns_total.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    size_t n_stages() const { return stages_.size(); }
+    size_t n_slots() const { return slots_.size(); }
+    size_t buffer_size() const { return buffer_size_; }
+
+    bool is_pinned() const {
+#if HAVE_CUDA
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    std::string info() const {
+        return "StagedRing(n_stages=" + std::to_string(stages_.size()) +
+               ", n_slots=" + std::to_string(slots_.size()) +
+               ", buffer_size=" + std::to_string(buffer_size_) +
+               ", pinned=" + (is_pinned() ? "true" : "false") + ")";
+    }
+
+private:
+    static constexpr int kSpinYields = 64;
+
+    /** The pinned buffers. Every array handed out keeps them alive, so a view can outlive the ring. */
+    struct Buffers {
+        std::vector<void*> data;
+        ~Buffers() { for (void* p : data) pinned_free(p); }
+    };
+
+    struct alignas(64) Slot {
+        std::atomic<uint32_t> state{0};  // 2k: ready for stage k, 2k + 1: stage k busy
+        void* data = nullptr;
+    };
+
+    // One cache line per stage: each is written by its own thread
+    struct alignas(64) Stage {
+        uint64_t cursor = 0;                // slots begun so far; only this stage's thread touches it
+        int64_t begin_ns = 0;
+        std::atomic<int64_t> held{-1};      // slot currently claimed, -1 if none
+        std::atomic<uint64_t> commits{0};   // read by the next stage to tell when it has drained
+        std::atomic<uint64_t> processed{0};
+        std::atomic<uint64_t> stalls{0};
+        std::atomic<int64_t> stall_ns_total{0};
+        std::atomic<int64_t> stall_ns_max{0};
+        std::atomic<int64_t> busy_ns_total{0};
+    };
+
+    static int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static void atomic_max(std::atomic<int64_t>& target, int64_t value) {
+        int64_t cur = target.load(std::memory_order_relaxed);
+        while (value > cur && !target.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {}
+    }
+
+    Stage& stage_at(size_t stage) {
+        if (stage >= stages_.size()) throw std::out_of_range("StagedRing: invalid stage");
+        return stages_[stage];
+    }
+
+    /**
+     * CAS `slot` from ready to busy for `stage` and mark it held. `locked`:
+     * the caller holds mutex_ (begin()'s wait predicate).
+     *
+     * Stage 0 re-checks closed_ after marking the slot held. Either that
+     * check sees close(), and the slot is given back, or close() came later
+     * and every finished(1) that follows sees the slot held. Without it, a
+     * close() landing between the first check and the CAS would let stage 1
+     * return None while stage 0 goes on to commit a frame nobody consumes.
+     */
+    bool try_take(size_t stage, size_t slot, bool locked) {
+        if (stage == 0 && closed_.load(std::memory_order_seq_cst)) return false;
+        uint32_t expected = static_cast<uint32_t>(2 * stage);
+        if (!slots_[slot].state.compare_exchange_strong(expected, expected + 1, std::memory_order_seq_cst)) {
+            return false;
+        }
+        Stage& st = stages_[stage];
+        st.held.store(static_cast<int64_t>(slot), std::memory_order_seq_cst);
+        if (stage == 0 && closed_.load(std::memory_order_seq_cst)) {
+            st.held.store(-1, std::memory_order_seq_cst);
+            slots_[slot].state.store(0, std::memory_order_seq_cst);
+            // A downstream stage may have gone to sleep on seeing the slot held
+            if (locked) {
+                cv_.notify_all();
+            } else {
+                notify();
+            }
+            return false;
+        }
+        return true;
+    }
+
+    /** Closed, and nothing more can reach `stage`: every upstream commit has been consumed. */
+    bool finished(size_t stage) const {
+        if (!closed_.load(std::memory_order_seq_cst)) return false;
+        if (stage == 0) return stages_[0].held.load(std::memory_order_seq_cst) < 0;
+        return finished(stage - 1) &&
+               stages_[stage].commits.load(std::memory_order_seq_cst) ==
+               stages_[stage - 1].commits.load(std::memory_order_seq_cst);
+    }
+
+    /**
+     * Wake sleepers after a state change. The change is a seq_cst store made
+     * before waiters_ is read, and a sleeper bumps waiters_ before it checks,
+     * so either it sees the change or this sees it and takes the lock.
+     */
+    void notify() {
+        if (waiters_.load(std::memory_order_seq_cst) == 0) return;
+        { std::lock_guard<std::mutex> lock(mutex_); }
+        cv_.notify_all();
+    }
+
+    nb::ndarray<nb::numpy, uint8_t, nb::ndim<1>> make_array(size_t slot) {
+        size_t shape[1] = { buffer_size_ };
+        // Like PinnedArena: the array shares ownership of the buffers, so a
+        // view that outlives the ring never points at freed memory
+        auto* keep = new std::shared_ptr<Buffers>(buffers_);
+        nb::capsule owner(keep, [](void* p) noexcept { delete static_cast<std::shared_ptr<Buffers>*>(p); });
+        return nb::ndarray<nb::numpy, uint8_t, nb::ndim<1>>(static_cast<uint8_t*>(slots_[slot].data), 1, shape, owner);
+    }
+
+    size_t buffer_size_;
+    std::shared_ptr<Buffers> buffers_;
+    std::vector<Slot> slots_;
+    std::vector<Stage> stages_;
+    std::atomic<bool> closed_{false};
+    std::atomic<uint32_t> waiters_{0};  // stages asleep in begin()
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
 // ─── Nanobind module ─────────────────────────────────────────────────────────
 
 NB_MODULE(pinned_allocator, m) {
     m.doc() = "Pinned memory pool allocator for zero-overhead GPU transfers";
 
+    nb::class_<PoolStats>(m, "PoolStats")
+        .def_ro("acquires", &PoolStats::acquires)
+        .def_ro("waits", &PoolStats::waits)
+        .def_ro("timeouts", &PoolStats::timeouts)
+        .def_ro("dropped", &PoolStats::dropped)
+        .def_ro("wait_ns_total", &PoolStats::wait_ns_total)
+        .def_ro("wait_ns_max", &PoolStats::wait_ns_max)
+        .def_ro("takes", &PoolStats::takes)
+        .def_ro("take_wait_ns_total", &PoolStats::take_wait_ns_total)
+        .def_ro("take_wait_ns_max", &PoolStats::take_wait_ns_max);
+
     nb::class_<PinnedBufferPool>(m, "PinnedBufferPool")
         .def(nb::init<size_t, size_t>(),
              nb::arg("n_buffers"), nb::arg("buffer_size"),
@@ -207,19 +977,110 @@ NB_MODULE(pinned_allocator, m) {
              "    n_buffers: Number of buffers to pre-allocate\n"
              "    buffer_size: Size of each buffer in bytes")
         .def("acquire", &PinnedBufferPool::acquire,
-             "Acquire a buffer as a numpy uint8 array backed by pinned memory.")
+             nb::arg("timeout") = 0.0, nb::arg("drop_oldest") = false,
+             "Acquire a buffer as a numpy uint8 array backed by pinned memory.\n\n"
+             "Args:\n"
+             "    timeout: Seconds to wait for a release when empty (0: raise at once, < 0: forever)\n"
+             "    drop_oldest: Reclaim the oldest submitted buffer instead of waiting")
         .def("acquire_with_index", &PinnedBufferPool::acquire_with_index,
+             nb::arg("timeout") = 0.0, nb::arg("drop_oldest") = false,
              "Acquire a buffer, returning (numpy_array, index) tuple.")
+        .def("try_acquire", &PinnedBufferPool::try_acquire,
+             nb::arg("drop_oldest") = false,
+             "Acquire without waiting: (numpy_array, index), or None if the pool is empty.")
         .def("release", &PinnedBufferPool::release,
              nb::arg("index"),
              "Release the buffer at the given index back to the pool.")
+        .def("submit", &PinnedBufferPool::submit,
+             nb::arg("index"),
+             "Hand a filled buffer to the consumer; take() returns buffers in submit order.")
+        .def("take", &PinnedBufferPool::take,
+             nb::arg("timeout") = -1.0,
+             "Oldest submitted buffer as (numpy_array, index), or None on timeout / after close().")
+        .def("close", &PinnedBufferPool::close,
+             "Wake all waiters; further acquires raise and take() drains, then returns None.")
         .def("available_count", &PinnedBufferPool::available_count,
              "Number of buffers currently available.")
+        .def("ready_count", &PinnedBufferPool::ready_count,
+             "Number of submitted buffers waiting for take().")
         .def("total_count", &PinnedBufferPool::total_count,
              "Total number of buffers in the pool.")
         .def("buffer_size", &PinnedBufferPool::buffer_size,
              "Size of each buffer in bytes.")
+        .def("stats", &PinnedBufferPool::stats,
+             "Acquire/take counters and wait times (PoolStats).")
+        .def("reset_stats", &PinnedBufferPool::reset_stats,
+             "Zero the counters returned by stats().")
         .def("is_pinned", &PinnedBufferPool::is_pinned,
              "True if buffers use CUDA pinned memory (vs regular malloc).")
         .def("__repr__", &PinnedBufferPool::info);
+
+    nb::class_<ArenaStats>(m, "ArenaStats")
+        .def_ro("capacity_bytes", &ArenaStats::capacity_bytes)
+        .def_ro("used_bytes", &ArenaStats::used_bytes)
+        .def_ro("requested_bytes", &ArenaStats::requested_bytes)
+        .def_ro("free_bytes", &ArenaStats::free_bytes)
+        .def_ro("largest_free_block", &ArenaStats::largest_free_block)
+        .def_ro("free_blocks", &ArenaStats::free_blocks)
+        .def_ro("live_allocations", &ArenaStats::live_allocations)
+        .def_ro("peak_used_bytes", &ArenaStats::peak_used_bytes)
+        .def_ro("failed_allocations", &ArenaStats::failed_allocations)
+        .def_ro("internal_fragmentation", &ArenaStats::internal_fragmentation)
+        .def_ro("external_fragmentation", &ArenaStats::external_fragmentation);
+
+    nb::class_<PinnedArena>(m, "PinnedArena")
+        .def(nb::init<size_t, size_t>(),
+             nb::arg("arena_size"), nb::arg("min_block") = 4096,
+             "Reserve one pinned region and sub-allocate variable-size buffers from it.\n\n"
+             "Args:\n"
+             "    arena_size: Total bytes to pin\n"
+             "    min_block: Smallest block (power of two >= 64); smaller requests round up to it")
+        .def("alloc", &PinnedArena::alloc,
+             nb::arg("nbytes"), nb::arg("alignment") = 64,
+             "Allocate a numpy uint8 array of nbytes; the block is freed when the array is collected.")
+        .def("stats", &PinnedArena::stats,
+             "Occupancy and fragmentation (ArenaStats).")
+        .def("capacity", &PinnedArena::capacity,
+             "Arena size in bytes.")
+        .def("min_block", &PinnedArena::min_block,
+             "Smallest block size in bytes.")
+        .def("is_pinned", &PinnedArena::is_pinned,
+             "True if the arena uses CUDA pinned memory (vs regular malloc).")
+        .def("__repr__", &PinnedArena::info);
+
+    nb::class_<StageStats>(m, "StageStats")
+        .def_ro("processed", &StageStats::processed)
+        .def_ro("stalls", &StageStats::stalls)
+        .def_ro("stall_ns_total", &StageStats::stall_ns_total)
+        .def_ro("stall_ns_max", &StageStats::stall_ns_max)
+        .def_ro("busy_ns_total", &StageStats::busy_ns_total);
+
+    nb::class_<StagedRing>(m, "StagedRing")
+        .def(nb::init<size_t, size_t, size_t>(),
+             nb::arg("n_stages"), nb::arg("n_slots"), nb::arg("buffer_size"),
+             "Ring of pinned buffers handed from pipeline stage to stage.\n\n"
+             "Args:\n"
+             "    n_stages: Number of stages (>= 2), each driven by one thread\n"
+             "    n_slots: Buffers in the ring\n"
+             "    buffer_size: Size of each buffer in bytes")
+        .def("begin", &StagedRing::begin,
+             nb::arg("stage"), nb::arg("timeout") = -1.0,
+             "Next slot for `stage` as (numpy_array, slot), or None on timeout / once drained after close().")
+        .def("commit", &StagedRing::commit,
+             nb::arg("stage"), nb::arg("slot"),
+             "Hand the slot to the next stage; the last stage's commit frees it.")
+        .def("close", &StagedRing::close,
+             "End the stream: stage 0 gets None, later stages drain, then get None.")
+        .def("slot_states", &StagedRing::slot_states,
+             "State of every slot: free, filling, ready:k or consuming:k.")
+        .def("stats", &StagedRing::stats,
+             "Per-stage counters and stall times (list of StageStats).")
+        .def("reset_stats", &StagedRing::reset_stats,
+             "Zero the counters returned by stats().")
+        .def("n_stages", &StagedRing::n_stages)
+        .def("n_slots", &StagedRing::n_slots)
+        .def("buffer_size", &StagedRing::buffer_size)
+        .def("is_pinned", &StagedRing::is_pinned,
+             "True if buffers use CUDA pinned memory (vs regular malloc).")
+        .def("__repr__", &StagedRing::info);
 }
@@ -0,0 +1,152 @@
+"""
+Capture process → N tracker processes over one SharedFramePool segment.
+
+The producer publishes 1080p frames at a fixed rate; each tracker maps the
+segment, reads every frame as a read-only numpy view (no copy, no socket) and
+records the publish → receive latency from the CLOCK_MONOTONIC timestamp in
+the frame descriptor. Compare with pickling the same frames through a
+multiprocessing.Queue, which copies each frame twice.
+
+Usage:
+    python3 shared_frame_demo.py
+    python3 shared_frame_demo.py --trackers 4 --fps 120 --seconds 5
+"""
+
+from __future__ import annotations
+
+import argparse
+import multiprocessing
+import os
+import sys
+import time
+from pathlib import Path
+
+import numpy as np
+
+sys.path.insert(0, str(Path(__file__).parent))
+sys.path.insert(0, str(Path(__file__).parent / "build"))
+
+try:
+    from shared_frame_pool import SharedFramePool, SharedFrameReader
+    _HAS_POOL = True
+except ImportError:
+    _HAS_POOL = False
+
+SHAPE = (1080, 1920, 3)
+
+
+def _percentiles_us(latencies_ns):
+    if not latencies_ns:
+        return 0.0, 0.0
+    p50, p99 = np.percentile(np.asarray(latencies_ns, dtype=np.float64), [50, 99])
+    return p50 / 1e3, p99 / 1e3
+
+
+def shm_tracker(name, ready, results):
+    reader = SharedFrameReader(name)
+    ready.set()
+    latencies = []
+    checksum = 0
+    while (item := reader.wait(timeout=5.0)) is not None:
+        frame, desc = item
+        latencies.append(time.monotonic_ns() - desc.timestamp_ns)
+        checksum += int(frame[desc.height // 2, desc.width // 2, 0])  # touch the pixels
+        del frame, item
+    results.put((os.getpid(), latencies, reader.dropped_count()))
+
+
+def queue_tracker(queue, results):
+    latencies = []
+    while (item := queue.get()) is not None:
+        timestamp_ns, _frame = item  # unpickling the frame is the copy being measured
+        latencies.append(time.monotonic_ns() - timestamp_ns)
+    results.put((os.getpid(), latencies, 0))
+
+
+def run_shared(n_trackers: int, fps: float, seconds: float):
+    ctx = multiprocessing.get_context("fork")
+    name = f"/shared_frame_demo.{os.getpid()}"
+    pool = SharedFramePool(name, n_slots=8, slot_bytes=int(np.prod(SHAPE)))
+    results = ctx.Queue()
+    readies = [ctx.Event() for _ in range(n_trackers)]
+    procs = [ctx.Process(target=shm_tracker, args=(name, e, results)) for e in readies]
+    for p in procs:
+        p.start()
+    for e in readies:
+        e.wait(10.0)
+
+    n_frames = int(fps * seconds)
+    period = 1.0 / fps
+    next_t = time.perf_counter()
+    for i in range(n_frames):
+        buf, slot = pool.acquire(timeout=1.0)
+        np.asarray(buf)[:1024] = i % 256  # "capture" straight into shared memory
+        pool.publish(slot, SHAPE)
+        next_t += period
+        time.sleep(max(0.0, next_t - time.perf_counter()))
+    pool.close()
+
+    outcomes = [results.get(timeout=30.0) for _ in procs]
+    for p in procs:
+        p.join()
+    return n_frames, outcomes
+
+
+def run_queue(n_trackers: int, fps: float, seconds: float):
+    ctx = multiprocessing.get_context("fork")
+    results = ctx.Queue()
+    queues = [ctx.Queue(maxsize=8) for _ in range(n_trackers)]
+    procs = [ctx.Process(target=queue_tracker, args=(q, results)) for q in queues]
+    for p in procs:
+        p.start()
+
+    frame = np.zeros(SHAPE, dtype=np.uint8)
+    n_frames = int(fps * seconds)
+    period = 1.0 / fps
+    next_t = time.perf_counter()
+    for i in range(n_frames):
+        frame.reshape(-1)[:1024] = i % 256
+        for q in queues:
+            q.put((time.monotonic_ns(), frame))
+        next_t += period
+        time.sleep(max(0.0, next_t - time.perf_counter()))
+    for q in queues:
+        q.put(None)
+
+    outcomes = [results.get(timeout=30.0) for _ in procs]
+    for p in procs:
+        p.join()
+    return n_frames, outcomes
+
+
+def report(title: str, n_frames: int, outcomes):
+    print(f"\n{title}")
+    print(f"  {'Tracker pid':<12} {'Frames':>8} {'Dropped':>8} {'p50 (us)':>10} {'p99 (us)':>10}")
+    print(f"  {'-' * 12} {'-' * 8} {'-' * 8} {'-' * 10} {'-' * 10}")
+    for pid, latencies, dropped in outcomes:
+        p50, p99 = _percentiles_us(latencies)
+        print(f"  {pid:<12} {len(latencies):>8} {dropped:>8} {p50:>10.1f} {p99:>10.1f}")
+    print(f"  ({n_frames} frames published)")
+
+
+def main(argv: list[str] | None = None) -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("--trackers", type=int, default=2)
+    parser.add_argument("--fps", type=float, default=60.0)
+    parser.add_argument("--seconds", type=float, default=3.0)
+    parser.add_argument("--skip-queue", action="store_true", help="skip the multiprocessing.Queue baseline")
+    args = parser.parse_args(argv)
+
+    if not _HAS_POOL:
+        print("error: shared_frame_pool not built (see Build and Run in README)", file=sys.stderr)
+        return 2
+
+    print(f"{args.trackers} trackers, {SHAPE[1]}x{SHAPE[0]} uint8 frames at {args.fps:.0f} fps")
+    report("SharedFramePool (zero-copy views)", *run_shared(args.trackers, args.fps, args.seconds))
+    if not args.skip_queue:
+        report("multiprocessing.Queue (pickled copies)", *run_queue(args.trackers, args.fps, args.seconds))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,760 @@
+/**
+ * Cross-process zero-copy frame pool over POSIX shared memory.
+ *
+ * The CPU counterpart of cuda_ipc_producer.cu / cuda_ipc_consumer.cu: one
+ * capture process writes frames into slots of a shared segment, and any
+ * number of tracker processes map the same segment and read those frames as
+ * read-only numpy views. Frames are never copied between processes and no
+ * socket is involved. Readers find new frames through a lock-free ring of
+ * descriptors inside the segment and sleep on a futex until one arrives.
+ *
+ * Usage pattern:
+ *   # capture process
+ *   pool = SharedFramePool("/cam0", n_slots=8, slot_bytes=1920 * 1080 * 3)
+ *   buf, slot = pool.acquire()           # writable view of a free slot
+ *   camera.read_into(buf)
+ *   pool.publish(slot, (1080, 1920, 3))
+ *
+ *   # each tracker process
+ *   reader = SharedFrameReader("/cam0")
+ *   frame, desc = reader.wait()          # read-only HWC view, no copy
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <nanobind/nanobind.h>
+#include <nanobind/ndarray.h>
+#include <nanobind/stl/optional.h>
+#include <nanobind/stl/string.h>
+#include <nanobind/stl/tuple.h>
+#include <nanobind/stl/vector.h>
+
+namespace nb = nanobind;
+
+// ─── Segment layout ──────────────────────────────────────────────────────────
+//
+// One shm_open segment, little-endian, version 1:
+//   header      128 B   magic, version, sizes and offsets, producer pid,
+//                       closed flag, futex word, waiter count, head
+//   slots       n_slots * 64 B    per slot: pin count, generation, last seq
+//   ring        ring_capacity * 64 B   frame descriptors, indexed seq % capacity
+//   (padding to a page)
+//   data        n_slots * slot_stride   frame pixels, every slot page-aligned
+//
+// Readers map the control part (header, slots, ring) read-write, because
+// pinning a slot and registering as a futex waiter are writes. They map the
+// data part read-only, so a tracker cannot scribble over a frame that other
+// trackers are reading.
+//
+// A slot's pin count is the only lock. The producer claims a slot by CAS from
+// 0 to kWriterPinned and bumps its generation. A reader pins with fetch_add
+// and backs off if the writer bit is set or the generation no longer matches
+// the descriptor: that frame was overwritten and counts as dropped. Once a
+// reader holds a pin, the producer cannot claim the slot, so a numpy view
+// stays valid for as long as it lives.
+//
+// Limitation: a reader process that dies while holding views leaves its
+// pins behind. Those slots stay unavailable until the producer recreates
+// the segment.
+
+constexpr uint32_t kFramePoolMagic = 0x4C4F5046;  // "FPOL"
+constexpr uint32_t kFramePoolVersion = 1;
+constexpr uint32_t kWriterPinned = 0x80000000u;
+constexpr uint64_t kDescriptorWriting = UINT64_MAX;
+constexpr size_t kSegmentPage = 4096;
+constexpr uint32_t kMaxSlots = 1024;
+
+struct SegmentHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_bytes;
+    uint32_t n_slots;
+    uint64_t slot_bytes;
+    uint64_t slot_stride;
+    uint64_t data_offset;
+    uint64_t segment_bytes;
+    uint32_t ring_capacity;
+    uint32_t producer_pid;
+    uint32_t closed;      // set once the producer is gone; readers drain, then stop
+    uint32_t futex_word;  // low 32 bits of head; readers FUTEX_WAIT on it
+    uint32_t waiters;     // readers inside FUTEX_WAIT; the producer skips the wake at 0
+    uint32_t reserved0;
+    uint64_t head;        // frames published so far
+    uint8_t reserved[48];
+};
+static_assert(sizeof(SegmentHeader) == 128, "shared layout is part of the wire format");
+
+struct SlotState {
+    uint32_t pins;        // readers holding a view, | kWriterPinned while the producer owns it
+    uint32_t reserved0;
+    uint64_t generation;  // bumped on every claim; descriptors carry the value they saw
+    uint64_t last_seq;    // seq + 1 of the frame last published here (LRU reuse)
+    uint8_t reserved[40];
+};
+static_assert(sizeof(SlotState) == 64);
+
+struct SharedDescriptor {
+    uint64_t seq;         // seq + 1 once published, kDescriptorWriting while rewritten
+    uint32_t slot;
+    uint32_t channels;
+    uint64_t generation;
+    int64_t timestamp_ns; // CLOCK_MONOTONIC, comparable across processes
+    uint32_t height;
+    uint32_t width;
+    uint8_t reserved[24];
+};
+static_assert(sizeof(SharedDescriptor) == 64);
+
+/** What a reader gets with every frame. */
+struct FrameDescriptor {
+    uint64_t seq = 0;
+    uint32_t slot = 0;
+    uint64_t generation = 0;
+    int64_t timestamp_ns = 0;
+    uint32_t height = 0;
+    uint32_t width = 0;
+    uint32_t channels = 0;
+};
+
+static int64_t monotonic_ns() {
+    timespec ts{};
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+static size_t round_up(size_t n, size_t to) { return (n + to - 1) / to * to; }
+
+static void validate_segment_name(const std::string& name) {
+    if (name.size() < 2 || name[0] != '/' || name.find('/', 1) != std::string::npos) {
+        throw std::invalid_argument("segment name must look like /name");
+    }
+}
+
+/** Both mappings of one segment; shared by the pool/reader and every numpy view. */
+struct SegmentMapping {
+    uint8_t* control = nullptr;
+    size_t control_bytes = 0;
+    uint8_t* data = nullptr;
+    size_t data_bytes = 0;
+
+    ~SegmentMapping() {
+        if (data) ::munmap(data, data_bytes);
+        if (control) ::munmap(control, control_bytes);
+    }
+
+    SegmentHeader* header() const { return reinterpret_cast<SegmentHeader*>(control); }
+    SlotState* slots() const { return reinterpret_cast<SlotState*>(control + sizeof(SegmentHeader)); }
+    SharedDescriptor* ring() const {
+        return reinterpret_cast<SharedDescriptor*>(control + sizeof(SegmentHeader) +
+                                                   header()->n_slots * sizeof(SlotState));
+    }
+    uint8_t* slot_data(uint32_t slot) const { return data + slot * header()->slot_stride; }
+
+    /** Map [0, control_bytes) read-write and the rest with data_prot. Takes no ownership of fd. */
+    void map(int fd, const std::string& name, size_t control_len, size_t data_len, int data_prot) {
+        void* c = ::mmap(nullptr, control_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (c == MAP_FAILED) throw std::runtime_error("mmap(" + name + ") failed: " + std::strerror(errno));
+        control = static_cast<uint8_t*>(c);
+        control_bytes = control_len;
+        void* d = ::mmap(nullptr, data_len, data_prot, MAP_SHARED, fd, static_cast<off_t>(control_len));
+        if (d == MAP_FAILED) throw std::runtime_error("mmap(" + name + ") failed: " + std::strerror(errno));
+        data = static_cast<uint8_t*>(d);
+        data_bytes = data_len;
+    }
+};
+
+static long futex(uint32_t* addr, int op, uint32_t value, const timespec* timeout) {
+    // Not FUTEX_PRIVATE_FLAG: waiter and waker live in different processes
+    return ::syscall(SYS_futex, addr, op, value, timeout, nullptr, 0);
+}
+
+static void wake_readers(SegmentHeader* h) {
+    std::atomic_ref<uint32_t>(h->futex_word).fetch_add(1, std::memory_order_seq_cst);
+    if (std::atomic_ref<uint32_t>(h->waiters).load(std::memory_order_seq_cst) > 0) {
+        futex(&h->futex_word, FUTEX_WAKE, INT_MAX, nullptr);
+    }
+}
+
+// ─── SharedFramePool (producer) ──────────────────────────────────────────────
+
+class SharedFramePool {
+public:
+    /**
+     * Create the segment `name` with n_slots frame slots.
+     *
+     * The name must be free. With `takeover`, a segment left behind by a
+     * producer that has exited is replaced instead: its readers are told the
+     * stream closed, and the name is re-created with this pool's layout. A
+     * segment whose producer is still running is never replaced.
+     *
+     * @param name        POSIX shm name, e.g. "/cam0"
+     * @param n_slots     Frames that can be in flight at once
+     * @param slot_bytes  Capacity of one slot; frames up to this size fit
+     * @param takeover    Replace a stale segment of a dead producer
+     */
+    SharedFramePool(const std::string& name, size_t n_slots, size_t slot_bytes, bool takeover)
+        : name_(name), mapping_(std::make_shared<SegmentMapping>())
+    {
+        validate_segment_name(name);
+        if (n_slots == 0 || n_slots > kMaxSlots) {
+            throw std::invalid_argument("n_slots must be in [1, " + std::to_string(kMaxSlots) + "]");
+        }
+        if (slot_bytes == 0) throw std::invalid_argument("slot_bytes must be > 0");
+
+        uint32_t ring_capacity = 64;
+        while (ring_capacity < 4 * n_slots) ring_capacity *= 2;
+        size_t control_bytes = round_up(sizeof(SegmentHeader) + n_slots * sizeof(SlotState) +
+                                        ring_capacity * sizeof(SharedDescriptor), kSegmentPage);
+        size_t slot_stride = round_up(slot_bytes, kSegmentPage);
+        size_t segment_bytes = control_bytes + n_slots * slot_stride;
+
+        int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0 && errno == EEXIST && takeover) {
+            retire_stale_segment(name);
+            fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        }
+        if (fd < 0) {
+            if (errno == EEXIST) {
+                throw std::runtime_error("frame pool " + name + " already exists; if its producer has exited, "
+                                         "take it over with SharedFramePool(..., takeover=True)");
+            }
+            throw std::runtime_error("shm_open(" + name + ") failed: " + std::strerror(errno));
+        }
+        try {
+            struct stat st{};
+            if (::fstat(fd, &st) != 0) {
+                throw std::runtime_error("fstat(" + name + ") failed: " + std::strerror(errno));
+            }
+            segment_dev_ = st.st_dev;
+            segment_ino_ = st.st_ino;
+            if (::ftruncate(fd, static_cast<off_t>(segment_bytes)) != 0) {
+                throw std::runtime_error("ftruncate(" + name + ") failed: " + std::strerror(errno));
+            }
+            mapping_->map(fd, name, control_bytes, segment_bytes - control_bytes, PROT_READ | PROT_WRITE);
+        } catch (...) {
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+            throw;
+        }
+        ::close(fd);
+
+        SegmentHeader* h = mapping_->header();
+        h->version = kFramePoolVersion;
+        h->header_bytes = sizeof(SegmentHeader);
+        h->n_slots = static_cast<uint32_t>(n_slots);
+        h->slot_bytes = slot_bytes;
+        h->slot_stride = slot_stride;
+        h->data_offset = control_bytes;
+        h->segment_bytes = segment_bytes;
+        h->ring_capacity = ring_capacity;
+        h->producer_pid = static_cast<uint32_t>(::getpid());
+        claimed_.assign(n_slots, false);
+        // Magic last: a reader that sees it also sees a complete header
+        std::atomic_ref<uint32_t>(h->magic).store(kFramePoolMagic, std::memory_order_release);
+    }
+
+    ~SharedFramePool() {
+        close();
+        // Attached readers keep their mapping. If the name was unlinked and
+        // re-created behind our back, it belongs to another pool now.
+        if (names_segment(name_, segment_dev_, segment_ino_)) ::shm_unlink(name_.c_str());
+    }
+
+    SharedFramePool(const SharedFramePool&) = delete;
+    SharedFramePool& operator=(const SharedFramePool&) = delete;
+
+    /**
+     * Claim a free slot as (writable uint8 array of slot_bytes, slot).
+     *
+     * Slots pinned by readers are skipped; of the rest, the one published
+     * longest ago is reused. If every slot is pinned, waits up to `timeout`
+     * seconds (< 0: forever) with the GIL released, then raises.
+     */
+    std::tuple<nb::ndarray<nb::numpy, uint8_t, nb::ndim<1>>, uint32_t> acquire(double timeout) {
+        std::optional<uint32_t> slot = try_claim();
+        if (!slot && timeout != 0.0) {
+            nb::gil_scoped_release release;
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout);
+            while (!slot && (timeout < 0 || std::chrono::steady_clock::now() < deadline)) {
+                // Readers unpin from their own processes without a wake-up, so poll
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+                slot = try_claim();
+            }
+        }
+        if (!slot) throw std::runtime_error("SharedFramePool: every slot is pinned by readers");
+
+        auto* keep = new std::shared_ptr<SegmentMapping>(mapping_);
+        nb::capsule owner(keep, [](void* p) noexcept { delete static_cast<std::shared_ptr<SegmentMapping>*>(p); });
+        size_t shape[1] = { mapping_->header()->slot_bytes };
+        return { nb::ndarray<nb::numpy, uint8_t, nb::ndim<1>>(mapping_->slot_data(*slot), 1, shape, owner), *slot };
+    }
+
+    /**
+     * Publish the frame in a claimed slot as a (height, width, channels) uint8
+     * image and wake waiting readers. Returns its sequence number.
+     * timestamp_ns = 0 stamps it with CLOCK_MONOTONIC now.
+     */
+    uint64_t publish(uint32_t slot, std::tuple<uint32_t, uint32_t, uint32_t> shape, int64_t timestamp_ns) {
+        auto [height, width, channels] = shape;
+        std::lock_guard lock(mutex_);
+        check_claimed(slot);
+        SegmentHeader* h = mapping_->header();
+        if (static_cast<uint64_t>(height) * width * channels > h->slot_bytes || channels == 0) {
+            throw std::invalid_argument("frame shape does not fit slot_bytes");
+        }
+        SlotState& st = mapping_->slots()[slot];
+        uint64_t seq = h->head;  // only written here, under mutex_
+
+        // Unpin before the descriptor goes out, so a fast reader never sees
+        // the writer bit on a frame it was just told about
+        st.last_seq = seq + 1;
+        std::atomic_ref<uint32_t>(st.pins).fetch_sub(kWriterPinned, std::memory_order_release);
+        claimed_[slot] = false;
+
+        SharedDescriptor& d = mapping_->ring()[seq & (h->ring_capacity - 1)];
+        std::atomic_ref<uint64_t> d_seq(d.seq);
+        d_seq.store(kDescriptorWriting, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        d.slot = slot;
+        d.channels = channels;
+        d.generation = std::atomic_ref<uint64_t>(st.generation).load(std::memory_order_relaxed);
+        d.timestamp_ns = timestamp_ns != 0 ? timestamp_ns : monotonic_ns();
+        d.height = height;
+        d.width = width;
+        d_seq.store(seq + 1, std::memory_order_release);
+
+        std::atomic_ref<uint64_t>(h->head).store(seq + 1, std::memory_order_seq_cst);
+        wake_readers(h);
+        return seq;
+    }
+
+    /** Give a claimed slot back without publishing it. */
+    void discard(uint32_t slot) {
+        std::lock_guard lock(mutex_);
+        check_claimed(slot);
+        std::atomic_ref<uint32_t>(mapping_->slots()[slot].pins).fetch_sub(kWriterPinned, std::memory_order_release);
+        claimed_[slot] = false;
+    }
+
+    /** Copy a uint8 HWC (or HW) frame into a free slot and publish it: one copy, in this process. */
+    uint64_t write(nb::ndarray<const uint8_t, nb::c_contig, nb::device::cpu> frame, double timeout, int64_t timestamp_ns) {
+        if (frame.ndim() != 2 && frame.ndim() != 3) throw std::invalid_argument("frame must be HW or HWC");
+        auto height = static_cast<uint32_t>(frame.shape(0));
+        auto width = static_cast<uint32_t>(frame.shape(1));
+        uint32_t channels = frame.ndim() == 3 ? static_cast<uint32_t>(frame.shape(2)) : 1;
+        if (frame.size() > mapping_->header()->slot_bytes) {
+            throw std::invalid_argument("frame does not fit slot_bytes");
+        }
+        auto [view, slot] = acquire(timeout);
+        {
+            nb::gil_scoped_release release;
+            std::memcpy(mapping_->slot_data(slot), frame.data(), frame.size());
+        }
+        return publish(slot, {height, width, channels}, timestamp_ns);
+    }
+
+    /** Mark the stream finished: waiting readers wake, drain what is left, then get None. */
+    void close() {
+        SegmentHeader* h = mapping_->header();
+        std::atomic_ref<uint32_t>(h->closed).store(1, std::memory_order_seq_cst);
+        wake_readers(h);
+    }
+
+    uint64_t published_count() const {
+        return std::atomic_ref<uint64_t>(mapping_->header()->head).load(std::memory_order_relaxed);
+    }
+
+    /** Slots that at least one reader currently holds a view of. */
+    size_t pinned_count() const {
+        size_t n = 0;
+        for (uint32_t i = 0; i < mapping_->header()->n_slots; ++i) {
+            uint32_t pins = std::atomic_ref<uint32_t>(mapping_->slots()[i].pins).load(std::memory_order_relaxed);
+            n += (pins & ~kWriterPinned) != 0;
+        }
+        return n;
+    }
+
+    const std::string& name() const { return name_; }
+    size_t n_slots() const { return mapping_->header()->n_slots; }
+    size_t slot_bytes() const { return mapping_->header()->slot_bytes; }
+
+    std::string info() const {
+        return "SharedFramePool(name=" + name_ + ", n_slots=" + std::to_string(n_slots()) +
+               ", slot_bytes=" + std::to_string(slot_bytes()) +
+               ", published=" + std::to_string(published_count()) + ")";
+    }
+
+private:
+    /** True if `name` currently refers to the shm object (dev, ino). */
+    static bool names_segment(const std::string& name, dev_t dev, ino_t ino) {
+        int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) return false;
+        struct stat st{};
+        bool same = ::fstat(fd, &st) == 0 && st.st_dev == dev && st.st_ino == ino;
+        ::close(fd);
+        return same;
+    }
+
+    /** Our own pid counts as alive: this process already produces into the segment. */
+    static bool pid_alive(pid_t pid) {
+        if (pid <= 0) return false;
+        return pid == ::getpid() || ::kill(pid, 0) == 0 || errno == EPERM;
+    }
+
+    /**
+     * Unlink the existing segment `name` so it can be re-created, provided it
+     * is a frame pool whose producer has exited. Readers still attached to it
+     * see the stream close, drain what is left and can then re-attach.
+     */
+    static void retire_stale_segment(const std::string& name) {
+        int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0) {
+            if (errno == ENOENT) return;  // already gone
+            throw std::runtime_error("shm_open(" + name + ") failed: " + std::strerror(errno));
+        }
+        struct stat st{};
+        SegmentHeader h{};
+        std::string problem;
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SegmentHeader) ||
+            ::pread(fd, &h, sizeof(h), 0) != static_cast<ssize_t>(sizeof(h)) ||
+            h.magic != kFramePoolMagic || h.header_bytes != sizeof(SegmentHeader)) {
+            problem = " is not a SharedFramePool segment";
+        } else if (pid_alive(static_cast<pid_t>(h.producer_pid))) {
+            problem = " is still produced by running process " + std::to_string(h.producer_pid);
+        }
+        if (!problem.empty()) {
+            ::close(fd);
+            throw std::runtime_error(name + problem);
+        }
+        void* c = ::mmap(nullptr, sizeof(SegmentHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (c != MAP_FAILED) {
+            SegmentHeader* old = static_cast<SegmentHeader*>(c);
+            std::atomic_ref<uint32_t>(old->closed).store(1, std::memory_order_seq_cst);
+            wake_readers(old);
+            ::munmap(c, sizeof(SegmentHeader));
+        }
+        ::close(fd);
+        // Another process may have taken the name over in the meantime
+        if (names_segment(name, st.st_dev, st.st_ino)) ::shm_unlink(name.c_str());
+    }
+
+    /** CAS the least recently published unpinned slot to writer-owned. */
+    std::optional<uint32_t> try_claim() {
+        std::lock_guard lock(mutex_);
+        SegmentHeader* h = mapping_->header();
+        for (;;) {
+            std::optional<uint32_t> best;
+            for (uint32_t i = 0; i < h->n_slots; ++i) {
+                if (claimed_[i]) continue;
+                SlotState& st = mapping_->slots()[i];
+                if (std::atomic_ref<uint32_t>(st.pins).load(std::memory_order_relaxed) != 0) continue;
+                if (!best || st.last_seq < mapping_->slots()[*best].last_seq) best = i;
+            }
+            if (!best) return std::nullopt;
+            SlotState& st = mapping_->slots()[*best];
+            uint32_t expected = 0;
+            if (std::atomic_ref<uint32_t>(st.pins).compare_exchange_strong(expected, kWriterPinned,
+                                                                          std::memory_order_seq_cst)) {
+                // Invalidates every descriptor still pointing at the old frame
+                std::atomic_ref<uint64_t>(st.generation).fetch_add(1, std::memory_order_seq_cst);
+                claimed_[*best] = true;
+                return best;
+            }
+            // A reader pinned it between the scan and the CAS; rescan
+        }
+    }
+
+    /** Caller holds mutex_. */
+    void check_claimed(uint32_t slot) const {
+        if (slot >= claimed_.size()) throw std::out_of_range("SharedFramePool: invalid slot");
+        if (!claimed_[slot]) throw std::runtime_error("SharedFramePool: slot " + std::to_string(slot) + " is not acquired");
+    }
+
+    std::string name_;
+    std::shared_ptr<SegmentMapping> mapping_;
+    dev_t segment_dev_ = 0;  // identity of the shm object we created, so the
+    ino_t segment_ino_ = 0;  // destructor never unlinks a successor's segment
+    // acquire() polls try_claim() with the GIL released, so producer threads
+    // in this process can claim, publish and discard concurrently. mutex_
+    // guards claimed_ and keeps publishes (the head update) one at a time.
+    std::mutex mutex_;
+    std::vector<bool> claimed_;  // slots this producer holds between acquire and publish
+};
+
+// ─── SharedFrameReader (consumer) ────────────────────────────────────────────
+
+using FrameView = nb::ndarray<nb::numpy, const uint8_t, nb::ndim<3>>;
+
+class SharedFrameReader {
+public:
+    /** Attach to the segment `name`. Only frames published from now on are delivered by wait(). */
+    explicit SharedFrameReader(const std::string& name)
+        : name_(name), mapping_(std::make_shared<SegmentMapping>())
+    {
+        validate_segment_name(name);
+        int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0) throw std::runtime_error("shm_open(" + name + ") failed: " + std::strerror(errno));
+        try {
+            struct stat st{};
+            SegmentHeader h{};
+            if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SegmentHeader) ||
+                ::pread(fd, &h, sizeof(h), 0) != static_cast<ssize_t>(sizeof(h)) ||
+                h.magic != kFramePoolMagic) {
+                throw std::runtime_error(name + " is not a SharedFramePool segment");
+            }
+            if (h.version != kFramePoolVersion || h.header_bytes != sizeof(SegmentHeader) ||
+                h.segment_bytes != static_cast<uint64_t>(st.st_size)) {
+                throw std::runtime_error(name + " has layout version " + std::to_string(h.version) +
+                                         ", expected " + std::to_string(kFramePoolVersion));
+            }
+            mapping_->map(fd, name, h.data_offset, h.segment_bytes - h.data_offset, PROT_READ);
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+        ::close(fd);
+        next_ = std::atomic_ref<uint64_t>(mapping_->header()->head).load(std::memory_order_acquire);
+    }
+
+    SharedFrameReader(const SharedFrameReader&) = delete;
+    SharedFrameReader& operator=(const SharedFrameReader&) = delete;
+
+    /**
+     * Next frame in publish order as (read-only HWC view, descriptor).
+     *
+     * Waits up to `timeout` seconds (< 0: forever) with the GIL released.
+     * Returns None on timeout, or once the producer has closed and every
+     * frame has been read. Frames overwritten before this reader got to
+     * them are skipped and counted in dropped_count().
+     */
+    std::optional<std::tuple<FrameView, FrameDescriptor>> wait(double timeout) {
+        SegmentHeader* h = mapping_->header();
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                            std::chrono::duration<double>(std::max(timeout, 0.0)));
+        for (;;) {
+            uint64_t head = std::atomic_ref<uint64_t>(h->head).load(std::memory_order_acquire);
+            while (next_ < head) {
+                if (head - next_ > h->ring_capacity) {  // lapped: those descriptors are gone
+                    dropped_ += head - h->ring_capacity - next_;
+                    next_ = head - h->ring_capacity;
+                }
+                std::optional<FrameDescriptor> desc = read_descriptor(next_++);
+                if (desc && pin(*desc)) {
+                    ++received_;
+                    return std::make_tuple(make_view(*desc), *desc);
+                }
+                ++dropped_;
+            }
+            if (std::atomic_ref<uint32_t>(h->closed).load(std::memory_order_acquire)) return std::nullopt;
+            if (timeout == 0.0) return std::nullopt;
+
+            auto remaining = deadline - std::chrono::steady_clock::now();
+            if (timeout > 0 && remaining <= std::chrono::nanoseconds::zero()) return std::nullopt;
+            nb::gil_scoped_release release;
+            sleep_until_published(head, timeout < 0 ? nullptr : &remaining);
+        }
+    }
+
+    /**
+     * The newest published frame, skipping anything older, or None if nothing
+     * new has arrived since the last call. Never blocks. For trackers that
+     * only care about the freshest frame.
+     */
+    std::optional<std::tuple<FrameView, FrameDescriptor>> latest() {
+        SegmentHeader* h = mapping_->header();
+        const uint64_t head = std::atomic_ref<uint64_t>(h->head).load(std::memory_order_acquire);
+        if (head <= next_) return std::nullopt;
+        // A slot can be re-claimed (generation bumped, writer bit set) long
+        // before a newer frame is published, or claimed and then discarded,
+        // so a failed pin says nothing about head moving. Step back through
+        // older descriptors instead, and give up once they are exhausted.
+        const uint64_t oldest = std::max(next_, head > h->ring_capacity ? head - h->ring_capacity : 0);
+        next_ = head;
+        for (uint64_t seq = head; seq-- > oldest;) {
+            std::optional<FrameDescriptor> desc = read_descriptor(seq);
+            if (desc && pin(*desc)) {
+                ++received_;
+                return std::make_tuple(make_view(*desc), *desc);
+            }
+        }
+        return std::nullopt;
+    }
+
+    uint64_t received_count() const { return received_; }
+    uint64_t dropped_count() const { return dropped_; }
+    bool closed() const {
+        return std::atomic_ref<uint32_t>(mapping_->header()->closed).load(std::memory_order_acquire) != 0;
+    }
+    const std::string& name() const { return name_; }
+    uint32_t producer_pid() const { return mapping_->header()->producer_pid; }
+
+    std::string info() const {
+        return "SharedFrameReader(name=" + name_ + ", received=" + std::to_string(received_) +
+               ", dropped=" + std::to_string(dropped_) + ")";
+    }
+
+private:
+    /** Seqlock read of descriptor `seq`; nullopt if it was already overwritten. */
+    std::optional<FrameDescriptor> read_descriptor(uint64_t seq) const {
+        SegmentHeader* h = mapping_->header();
+        SharedDescriptor& d = mapping_->ring()[seq & (h->ring_capacity - 1)];
+        std::atomic_ref<uint64_t> d_seq(d.seq);
+        if (d_seq.load(std::memory_order_acquire) != seq + 1) return std::nullopt;
+        FrameDescriptor out;
+        out.seq = seq;
+        out.slot = d.slot;
+        out.generation = d.generation;
+        out.timestamp_ns = d.timestamp_ns;
+        out.height = d.height;
+        out.width = d.width;
+        out.channels = d.channels;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (d_seq.load(std::memory_order_relaxed) != seq + 1) return std::nullopt;
+        if (out.slot >= h->n_slots ||
+            static_cast<uint64_t>(out.height) * out.width * out.channels > h->slot_bytes) {
+            return std::nullopt;
+        }
+        return out;
+    }
+
+    /** Pin the descriptor's slot if it still holds that frame. */
+    bool pin(const FrameDescriptor& desc) {
+        SlotState& st = mapping_->slots()[desc.slot];
+        std::atomic_ref<uint32_t> pins(st.pins);
+        uint32_t before = pins.fetch_add(1, std::memory_order_seq_cst);
+        if ((before & kWriterPinned) == 0 &&
+            std::atomic_ref<uint64_t>(st.generation).load(std::memory_order_seq_cst) == desc.generation) {
+            return true;
+        }
+        pins.fetch_sub(1, std::memory_order_release);
+        return false;
+    }
+
+    FrameView make_view(const FrameDescriptor& desc) {
+        struct Pin {
+            std::shared_ptr<SegmentMapping> mapping;
+            uint32_t slot;
+        };
+        auto* p = new Pin{mapping_, desc.slot};
+        nb::capsule owner(p, [](void* q) noexcept {
+            auto* pin = static_cast<Pin*>(q);
+            std::atomic_ref<uint32_t>(pin->mapping->slots()[pin->slot].pins).fetch_sub(1, std::memory_order_release);
+            delete pin;
+        });
+        size_t shape[3] = { desc.height, desc.width, desc.channels };
+        return FrameView(mapping_->slot_data(desc.slot), 3, shape, owner);
+    }
+
+    /** FUTEX_WAIT until head moves past `seen`, the pool closes, or `remaining` passes. */
+    void sleep_until_published(uint64_t seen, const std::chrono::steady_clock::duration* remaining) {
+        SegmentHeader* h = mapping_->header();
+        std::atomic_ref<uint32_t> waiters(h->waiters);
+        waiters.fetch_add(1, std::memory_order_seq_cst);
+        // Read the futex word before re-checking head: a publish in between
+        // changes the word, so FUTEX_WAIT returns at once instead of sleeping
+        uint32_t word = std::atomic_ref<uint32_t>(h->futex_word).load(std::memory_order_seq_cst);
+        if (std::atomic_ref<uint64_t>(h->head).load(std::memory_order_seq_cst) == seen &&
+            !std::atomic_ref<uint32_t>(h->closed).load(std::memory_order_seq_cst)) {
+            timespec ts{};
+            if (remaining) {
+                auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(*remaining).count();
+                ts.tv_sec = ns / 1'000'000'000;
+                ts.tv_nsec = ns % 1'000'000'000;
+            }
+            futex(&h->futex_word, FUTEX_WAIT, word, remaining ? &ts : nullptr);
+        }
+        waiters.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    std::string name_;
+    std::shared_ptr<SegmentMapping> mapping_;
+    uint64_t next_ = 0;  // next sequence number wait() delivers
+    uint64_t received_ = 0;
+    uint64_t dropped_ = 0;
+};
+
+// ─── Nanobind module ─────────────────────────────────────────────────────────
+
+NB_MODULE(shared_frame_pool, m) {
+    m.doc() = "Cross-process zero-copy frame pool over POSIX shared memory";
+
+    nb::class_<FrameDescriptor>(m, "FrameDescriptor")
+        .def_ro("seq", &FrameDescriptor::seq)
+        .def_ro("slot", &FrameDescriptor::slot)
+        .def_ro("generation", &FrameDescriptor::generation)
+        .def_ro("timestamp_ns", &FrameDescriptor::timestamp_ns)
+        .def_ro("height", &FrameDescriptor::height)
+        .def_ro("width", &FrameDescriptor::width)
+        .def_ro("channels", &FrameDescriptor::channels);
+
+    nb::class_<SharedFramePool>(m, "SharedFramePool")
+        .def(nb::init<const std::string&, size_t, size_t, bool>(),
+             nb::arg("name"), nb::arg("n_slots"), nb::arg("slot_bytes"), nb::arg("takeover") = false,
+             "Create the shared segment `name` (e.g. \"/cam0\") with n_slots frame slots.\n\n"
+             "Args:\n"
+             "    name: POSIX shm name; RuntimeError if it already exists\n"
+             "    n_slots: Frames that can be in flight at once\n"
+             "    slot_bytes: Capacity of one slot in bytes\n"
+             "    takeover: Replace a segment whose producer has exited (never a live one)")
+        .def("acquire", &SharedFramePool::acquire, nb::arg("timeout") = 0.1,
+             "Claim a free slot as (writable uint8 array, slot); waits while readers pin every slot.")
+        .def("publish", &SharedFramePool::publish,
+             nb::arg("slot"), nb::arg("shape"), nb::arg("timestamp_ns") = 0,
+             "Publish a claimed slot as a (height, width, channels) uint8 frame; returns its seq.")
+        .def("discard", &SharedFramePool::discard, nb::arg("slot"),
+             "Give a claimed slot back without publishing it.")
+        .def("write", &SharedFramePool::write,
+             nb::arg("frame"), nb::arg("timeout") = 0.1, nb::arg("timestamp_ns") = 0,
+             "Copy a uint8 HW/HWC frame into a free slot and publish it; returns its seq.")
+        .def("close", &SharedFramePool::close,
+             "End the stream: readers drain the remaining frames, then wait() returns None.")
+        .def("published_count", &SharedFramePool::published_count,
+             "Frames published so far.")
+        .def("pinned_count", &SharedFramePool::pinned_count,
+             "Slots currently held by at least one reader view.")
+        .def("name", &SharedFramePool::name)
+        .def("n_slots", &SharedFramePool::n_slots)
+        .def("slot_bytes", &SharedFramePool::slot_bytes)
+        .def("__repr__", &SharedFramePool::info);
+
+    nb::class_<SharedFrameReader>(m, "SharedFrameReader")
+        .def(nb::init<const std::string&>(), nb::arg("name"),
+             "Attach to a SharedFramePool segment by name.")
+        .def("wait", &SharedFrameReader::wait, nb::arg("timeout") = -1.0,
+             "Next frame as (read-only HWC uint8 view, FrameDescriptor), or None on timeout/close.")
+        .def("latest", &SharedFrameReader::latest,
+             "Newest frame as (view, FrameDescriptor), skipping older ones; None if nothing new.")
+        .def("received_count", &SharedFrameReader::received_count,
+             "Frames delivered to this reader.")
+        .def("dropped_count", &SharedFrameReader::dropped_count,
+             "Frames overwritten before this reader got to them.")
+        .def("closed", &SharedFrameReader::closed,
+             "True once the producer has closed the stream.")
+        .def("producer_pid", &SharedFrameReader::producer_pid)
+        .def("name", &SharedFrameReader::name)
+        .def("__repr__", &SharedFrameReader::info);
+}
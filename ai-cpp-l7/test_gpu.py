@@ -3,14 +3,20 @@ Unit tests for Lesson 7 GPU programming modules.
 
 Tests:
   - gpu_preprocess: fused kernel output matches CPU reference
-  - pinned_allocator: acquire, release, reuse cycle
+  - pinned_allocator: acquire, release, reuse cycle, staged ring
+  - shared_frame_pool: cross-process zero-copy frame hand-off
   - Graceful skip when GPU/modules not available
 
 Run:
     pytest test_gpu.py -v
 """
 
+import itertools
+import multiprocessing
+import os
 import sys
+import threading
+import time
 from pathlib import Path
 
 import numpy as np
@@ -47,6 +53,41 @@ def cpu_reference_preprocess(image, mean, std):
     return np.ascontiguousarray(img)
 
 
+def _exact_preprocess(image, mean, std):
+    """(x / 255 - mean) / std in float64, CHW, with mean and std rounded to float32 like the kernels."""
+    m = np.float32(mean).astype(np.float64)
+    s = np.float32(std).astype(np.float64)
+    return ((image.astype(np.float64) / 255.0 - m) / s).transpose(2, 0, 1)
+
+
+def _fused_error_bound(image, mean, std, fma=True):
+    """Per-element bound on |fused_preprocess - exact|, from the comment above fold_normalization.
+
+    1.5 ULP of the exact result, plus a term relative to x * |scale| + |bias| that only
+    matters near zero. Without FMA each product is rounded too, so that term is larger.
+    """
+    exact = _exact_preprocess(image, mean, std)
+    m = np.abs(np.float32(mean).astype(np.float64))
+    s = np.float32(std).astype(np.float64)
+    magnitude = ((image.astype(np.float64) / 255.0 + m) / s).transpose(2, 0, 1)
+    ulp = np.spacing(np.abs(exact).astype(np.float32)).astype(np.float64)
+    return 1.5 * ulp + (2.0 ** -46 if fma else 2.0 ** -22) * magnitude
+
+
+def _scalar_error_bound(image, mean, std):
+    """Per-element bound on |fused_preprocess_scalar - exact|: half a ULP per rounding of
+    q = x / 255, d = q - mean and d / std, the first two scaled by 1 / std."""
+    q = image.astype(np.float32) / np.float32(255.0)
+    d = q - np.float32(mean)
+    y = d / np.float32(std)
+    s = np.float32(std).astype(np.float64)
+    return ((_half_ulp(q) + _half_ulp(d)) / s + _half_ulp(y)).transpose(2, 0, 1)
+
+
+def _half_ulp(values):
+    return np.spacing(np.abs(values)).astype(np.float64) / 2
+
+
 # ─── GPU Preprocess Tests ─────────────────────────────────────────────────────
 
 class TestGpuPreprocess:
@@ -166,6 +207,215 @@ class TestCpuReference:
         """CPU reference should report no CUDA."""
         assert self.mod.cuda_available() is False
 
+    def test_within_error_bound_of_exact(self, imagenet_params):
+        """Per element: 1.5 ULP of the exact result plus the near-zero term (see fold_normalization)."""
+        if self.mod.simd_level() == "scalar":
+            pytest.skip("the bound needs the FMA path")
+        mean, std = imagenet_params["mean"], imagenet_params["std"]
+        # Every byte value in every channel, with a width that leaves a scalar tail
+        image = np.stack([np.arange(256, dtype=np.uint8)] * 3, axis=-1).reshape(8, 32, 3)
+        image = np.concatenate([image, image[:, :7]], axis=1)
+        exact = _exact_preprocess(image, mean, std)
+        result = np.asarray(self.mod.fused_preprocess(image, mean, std))
+        error = np.abs(result - exact)
+        assert (error <= _fused_error_bound(image, mean, std)).all()
+        # and the 1.5 ULP only happens at binade edges: nearly everything is within 1 ULP
+        assert (error <= np.spacing(np.abs(exact).astype(np.float32))).mean() > 0.99
+
+    @pytest.mark.parametrize("channels", [1, 2, 3, 4])
+    @pytest.mark.parametrize("width", [1, 15, 16, 17, 50])
+    def test_matches_scalar_reference(self, channels, width):
+        """Vector bodies, scalar tails and the generic path all agree with the scalar loop."""
+        image = np.random.RandomState(channels).randint(0, 256, (5, width, channels), dtype=np.uint8)
+        mean = [0.3 + 0.05 * c for c in range(channels)]
+        std = [0.2 + 0.01 * c for c in range(channels)]
+        expected = np.asarray(self.mod.fused_preprocess_scalar(image, mean, std))
+        result = np.asarray(self.mod.fused_preprocess(image, mean, std))
+        assert result.shape == (channels, 5, width)
+        # Each is within its own error bound of the exact value, so of each other
+        fma = self.mod.simd_level() != "scalar"
+        tolerance = _fused_error_bound(image, mean, std, fma) + _scalar_error_bound(image, mean, std)
+        assert (np.abs(result.astype(np.float64) - expected) <= tolerance).all()
+
+    def test_zero_std_raises(self, sample_image):
+        with pytest.raises(ValueError):
+            self.mod.fused_preprocess(sample_image, [0.5] * 3, [0.2, 0.0, 0.2])
+
+    def test_into_float32_buffer(self, sample_image, imagenet_params):
+        """Writing into a caller buffer gives the same floats as the allocating call."""
+        mean, std = imagenet_params["mean"], imagenet_params["std"]
+        out = np.empty((3, 64, 80), dtype=np.float32)
+        self.mod.fused_preprocess_into(sample_image, mean, std, out)
+        np.testing.assert_array_equal(out, np.asarray(self.mod.fused_preprocess(sample_image, mean, std)))
+
+    def test_non_contiguous_input(self, sample_image, imagenet_params):
+        """A cropped view is read through its strides, not as if it were packed."""
+        mean, std = imagenet_params["mean"], imagenet_params["std"]
+        crop = sample_image[:, 10:]
+        assert not crop.flags.c_contiguous
+        expected = np.asarray(self.mod.fused_preprocess(np.ascontiguousarray(crop), mean, std))
+        np.testing.assert_array_equal(np.asarray(self.mod.fused_preprocess(crop, mean, std)), expected)
+        np.testing.assert_array_equal(np.asarray(self.mod.fused_preprocess_scalar(crop, mean, std)),
+                                      np.asarray(self.mod.fused_preprocess_scalar(np.ascontiguousarray(crop), mean, std)))
+        out = np.empty((3, 64, 70), dtype=np.float32)
+        self.mod.fused_preprocess_into(crop, mean, std, out)
+        np.testing.assert_array_equal(out, expected)
+
+    def test_into_float16(self, sample_image, imagenet_params):
+        """float16 output is the float32 result rounded to nearest even."""
+        mean, std = imagenet_params["mean"], imagenet_params["std"]
+        out = np.empty((3, 64, 80), dtype=np.float16)
+        self.mod.fused_preprocess_into(sample_image, mean, std, out)
+        expected = np.asarray(self.mod.fused_preprocess(sample_image, mean, std)).astype(np.float16)
+        np.testing.assert_array_equal(out, expected)
+
+    def test_into_bfloat16_bits(self, sample_image, imagenet_params):
+        """uint16 buffers receive bfloat16 bit patterns (round to nearest even)."""
+        mean, std = imagenet_params["mean"], imagenet_params["std"]
+        out = np.empty((3, 64, 80), dtype=np.uint16)
+        self.mod.fused_preprocess_into(sample_image, mean, std, out)
+        bits = np.asarray(self.mod.fused_preprocess(sample_image, mean, std)).view(np.uint32)
+        expected = ((bits + 0x7FFF + ((bits >> 16) & 1)) >> 16).astype(np.uint16)
+        np.testing.assert_array_equal(out, expected)
+        # Widening the bits back gives floats within bfloat16 precision (8 bits)
+        widened = (out.astype(np.uint32) << 16).view(np.float32)
+        np.testing.assert_allclose(widened, bits.view(np.float32), rtol=2 ** -8, atol=0)
+
+    def test_into_int8_per_tensor(self, sample_image, imagenet_params):
+        """int8: round(y / scale + zero_point), saturated to [-128, 127]."""
+        mean, std = imagenet_params["mean"], imagenet_params["std"]
+        y = np.asarray(self.mod.fused_preprocess(sample_image, mean, std)).astype(np.float64)
+        for scale, zero_point in ((0.02, 3), (0.005, 0)):  # the second one saturates
+            out = np.empty((3, 64, 80), dtype=np.int8)
+            self.mod.fused_preprocess_into(sample_image, mean, std, out, scale=[scale], zero_point=[zero_point])
+            expected = np.clip(np.rint(y / scale + zero_point), -128, 127)
+            assert np.abs(out.astype(np.int32) - expected).max() <= 1
+            assert (out == expected.astype(np.int8)).mean() > 0.99
+
+    def test_into_uint8_per_channel(self, sample_image, imagenet_params):
+        mean, std = imagenet_params["mean"], imagenet_params["std"]
+        scale, zero_point = [0.018, 0.02, 0.022], [120, 128, 136]
+        out = np.empty((3, 64, 80), dtype=np.uint8)
+        self.mod.fused_preprocess_into(sample_image, mean, std, out, scale=scale, zero_point=zero_point)
+        y = np.asarray(self.mod.fused_preprocess(sample_image, mean, std)).astype(np.float64)
+        expected = np.clip(np.rint(y / np.array(scale)[:, None, None] + np.array(zero_point)[:, None, None]), 0, 255)
+        assert np.abs(out.astype(np.int32) - expected).max() <= 1
+
+    def test_into_rejects_bad_arguments(self, sample_image, imagenet_params):
+        mean, std = imagenet_params["mean"], imagenet_params["std"]
+        with pytest.raises(ValueError):  # HWC instead of CHW
+            self.mod.fused_preprocess_into(sample_image, mean, std, np.empty((64, 80, 3), dtype=np.float32))
+        with pytest.raises(ValueError):  # quantization parameters on a float output
+            self.mod.fused_preprocess_into(sample_image, mean, std, np.empty((3, 64, 80), dtype=np.float16),
+                                           scale=[0.02])
+        with pytest.raises(ValueError):  # int8 needs a scale
+            self.mod.fused_preprocess_into(sample_image, mean, std, np.empty((3, 64, 80), dtype=np.int8))
+        with pytest.raises(TypeError):  # no float64 output, and never a silent converted copy
+            self.mod.fused_preprocess_into(sample_image, mean, std, np.empty((3, 64, 80), dtype=np.float64))
+
+    def test_batch_same_size_matches_single(self, imagenet_params):
+        """Frames already at the target size go through the single-frame kernel unchanged."""
+        mean, std = imagenet_params["mean"], imagenet_params["std"]
+        rng = np.random.RandomState(3)
+        frames = [rng.randint(0, 256, (64, 80, 3), dtype=np.uint8) for _ in range(5)]
+        out = np.empty((5, 3, 64, 80), dtype=np.float32)
+        infos = self.mod.fused_preprocess_batch(frames, [mean], [std], out)
+        for frame, item, info in zip(frames, out, infos):
+            np.testing.assert_array_equal(item, np.asarray(self.mod.fused_preprocess(frame, mean, std)))
+            assert (info.pad_x, info.pad_y, info.width, info.height) == (0, 0, 80, 64)
+
+    def test_batch_letterbox_mixed_sizes(self, imagenet_params):
+        """Other sizes are resized with aspect kept and the border filled with pad_value."""
+        mean, std = imagenet_params["mean"], imagenet_params["std"]
+        wide = np.full((32, 128, 3), 200, dtype=np.uint8)  # 4:1 -> 64x16 inside a 64x64 slot
+        small = np.full((16, 16, 3), 50, dtype=np.uint8)   # upscaled 4x, fills the slot
+        out = np.empty((2, 3, 64, 64), dtype=np.float32)
+        wide_info, small_info = self.mod.fused_preprocess_batch(
+            [wide, small], [mean], [std], out, pad_value=114)
+
+        assert (wide_info.width, wide_info.height, wide_info.pad_x, wide_info.pad_y) == (64, 16, 0, 24)
+        assert wide_info.scale_x == pytest.approx(0.5)
+        assert (small_info.width, small_info.height) == (64, 64)
+
+        def norm(v):
+            return (v / 255.0 - np.array(mean)[:, None, None]) / np.array(std)[:, None, None]
+
+        np.testing.assert_allclose(out[0][:, 24:40], np.broadcast_to(norm(200.0), (3, 16, 64)), atol=1e-5)
+        np.testing.assert_allclose(out[0][:, :24], np.broadcast_to(norm(114.0), (3, 24, 64)), atol=1e-5)
+        np.testing.assert_allclose(out[0][:, 40:], np.broadcast_to(norm(114.0), (3, 24, 64)), atol=1e-5)
+        np.testing.assert_allclose(out[1], np.broadcast_to(norm(50.0), (3, 64, 64)), atol=1e-5)
+
+    def test_batch_per_frame_parameters(self, imagenet_params):
+        """mean/std can differ per frame; letterbox=False stretches to the slot."""
+        frames = [np.full((10, 20, 3), 255, dtype=np.uint8), np.full((30, 30, 3), 255, dtype=np.uint8)]
+        out = np.empty((2, 3, 8, 8), dtype=np.float32)
+        infos = self.mod.fused_preprocess_batch(
+            frames, [[0.0] * 3, [0.5] * 3], [[1.0] * 3, [0.25] * 3], out, letterbox=False, threads=2)
+        np.testing.assert_allclose(out[0], 1.0, atol=1e-6)
+        np.testing.assert_allclose(out[1], 2.0, atol=1e-6)
+        assert all((i.pad_x, i.pad_y, i.width, i.height) == (0, 0, 8, 8) for i in infos)
+
+    def test_batch_rejects_bad_arguments(self, sample_image, imagenet_params):
+        mean, std = [imagenet_params["mean"]], [imagenet_params["std"]]
+        with pytest.raises(ValueError):  # batch dimension does not match
+            self.mod.fused_preprocess_batch([sample_image] * 2, mean, std, np.empty((3, 3, 64, 80), np.float32))
+        with pytest.raises(ValueError):  # channel count does not match
+            self.mod.fused_preprocess_batch([sample_image], mean, std, np.empty((1, 1, 64, 80), np.float32))
+        with pytest.raises(ValueError):  # two parameter sets for three frames
+            self.mod.fused_preprocess_batch([sample_image] * 3, mean * 2, std * 2,
+                                            np.empty((3, 3, 64, 80), np.float32))
+
+    @pytest.mark.parametrize("dtype", [np.uint8, np.float16, np.float32])
+    @pytest.mark.parametrize("channels", [1, 2, 3, 4, 5])
+    @pytest.mark.parametrize("width", [1, 17, 33])
+    def test_transpose_matches_numpy(self, dtype, channels, width):
+        """Shuffle blocks, scalar tails and the tiled path all match numpy's transpose."""
+        rng = np.random.RandomState(channels)
+        image = rng.randint(0, 256, (7, width, channels)).astype(dtype)
+        chw = np.asarray(self.mod.hwc_to_chw(image))
+        assert chw.dtype == dtype
+        np.testing.assert_array_equal(chw, np.ascontiguousarray(image.transpose(2, 0, 1)))
+        np.testing.assert_array_equal(np.asarray(self.mod.chw_to_hwc(chw)), image)
+
+    def test_transpose_batch(self):
+        """4-D input is NHWC ↔ NCHW, and splitting across threads changes nothing."""
+        batch = np.random.RandomState(2).rand(3, 45, 70, 3).astype(np.float32)
+        nchw = np.asarray(self.mod.hwc_to_chw(batch, threads=4))
+        np.testing.assert_array_equal(nchw, np.ascontiguousarray(batch.transpose(0, 3, 1, 2)))
+        np.testing.assert_array_equal(np.asarray(self.mod.chw_to_hwc(nchw, threads=1)), batch)
+
+    def test_transpose_naive_matches(self, sample_image):
+        np.testing.assert_array_equal(np.asarray(self.mod.hwc_to_chw_naive(sample_image)),
+                                      np.asarray(self.mod.hwc_to_chw(sample_image)))
+
+    def test_transpose_rejects_bad_arguments(self, sample_image):
+        with pytest.raises(ValueError):  # neither 3-D nor 4-D
+            self.mod.hwc_to_chw(sample_image[0])
+        with pytest.raises(TypeError):  # unsupported dtype is not silently converted
+            self.mod.hwc_to_chw(sample_image.astype(np.float64))
+        with pytest.raises(TypeError):  # non-contiguous view
+            self.mod.hwc_to_chw(sample_image[:, ::2])
+
+    def test_threads_do_not_change_output(self, imagenet_params):
+        """Row bands split across threads must produce the single-thread result."""
+        image = np.random.RandomState(1).randint(0, 256, (257, 96, 3), dtype=np.uint8)
+        args = (image, imagenet_params["mean"], imagenet_params["std"])
+        single = np.asarray(self.mod.fused_preprocess(*args, threads=1))
+        for threads in (0, 3, 8):
+            np.testing.assert_array_equal(
+                np.asarray(self.mod.fused_preprocess(*args, threads=threads)), single)
+
+    def test_tuning_profile(self, tmp_path, monkeypatch):
+        """Without a matching cache file the kernels fall back to defaults."""
+        monkeypatch.setenv("AI_CPP_TUNING_PROFILE", str(tmp_path / "missing.txt"))
+        profile = self.mod.reload_tuning_profile()
+        assert profile.source == "defaults"
+        assert profile.threads >= 1
+        assert 0 < profile.l1_tile_bytes <= profile.l2_tile_bytes
+        assert self.mod.tuning_profile().path == str(tmp_path / "missing.txt")
+        monkeypatch.delenv("AI_CPP_TUNING_PROFILE")
+        self.mod.reload_tuning_profile()
+
 
 # ─── Pinned Allocator Tests ──────────────────────────────────────────────────
 
@@ -250,6 +500,97 @@ class TestPinnedAllocator:
         assert np.asarray(arr2)[0] == 99
         pool.release(idx2)
 
+    def test_double_release_raises(self):
+        pool = self.Pool(n_buffers=2, buffer_size=64)
+        _, idx = pool.acquire_with_index()
+        pool.release(idx)
+        with pytest.raises(RuntimeError, match="already released"):
+            pool.release(idx)
+        assert pool.available_count() == 2
+
+    def test_acquire_timeout(self):
+        """An empty pool waits for the timeout, then raises and counts it."""
+        pool = self.Pool(n_buffers=1, buffer_size=64)
+        pool.acquire()
+        assert pool.try_acquire() is None
+        t0 = time.perf_counter()
+        with pytest.raises(RuntimeError, match="no buffers available"):
+            pool.acquire(timeout=0.05)
+        assert time.perf_counter() - t0 >= 0.04
+        stats = pool.stats()
+        assert (stats.acquires, stats.waits, stats.timeouts) == (1, 1, 2)
+        assert stats.wait_ns_max >= 40_000_000
+
+    def test_acquire_blocks_until_release(self):
+        """A blocked acquire wakes on release. The release comes from another
+        Python thread, so this also shows the wait does not hold the GIL."""
+        pool = self.Pool(n_buffers=1, buffer_size=64)
+        _, idx = pool.acquire_with_index()
+        releaser = threading.Timer(0.05, pool.release, args=(idx,))
+        releaser.start()
+        _, idx2 = pool.acquire_with_index(timeout=5.0)
+        releaser.join()
+        assert idx2 == idx
+        assert pool.stats().waits == 1
+
+    def test_submit_take_fifo(self):
+        pool = self.Pool(n_buffers=3, buffer_size=16)
+        order = []
+        for value in (1, 2, 3):
+            arr, idx = pool.acquire_with_index()
+            np.asarray(arr)[0] = value
+            pool.submit(idx)
+            order.append(idx)
+        assert pool.ready_count() == 3
+        for value, expected_idx in zip((1, 2, 3), order):
+            arr, idx = pool.take(timeout=0)
+            assert idx == expected_idx and np.asarray(arr)[0] == value
+            pool.release(idx)
+        assert pool.take(timeout=0.01) is None
+
+    def test_drop_oldest_reclaims_stale_frame(self):
+        """With drop_oldest, a full pool recycles the oldest unconsumed frame."""
+        pool = self.Pool(n_buffers=2, buffer_size=16)
+        _, first = pool.acquire_with_index()
+        _, second = pool.acquire_with_index()
+        pool.submit(first)
+        pool.submit(second)
+        _, idx = pool.acquire_with_index(drop_oldest=True)
+        assert idx == first
+        assert pool.stats().dropped == 1
+        assert pool.take(timeout=0)[1] == second
+
+    def test_close_wakes_waiters(self):
+        pool = self.Pool(n_buffers=1, buffer_size=16)
+        pool.acquire()
+        threading.Timer(0.05, pool.close).start()
+        with pytest.raises(RuntimeError, match="closed"):
+            pool.acquire(timeout=-1)
+        assert pool.take() is None
+
+    def test_producer_consumer_backpressure(self):
+        """A fast producer is throttled by a slow consumer instead of failing."""
+        pool = self.Pool(n_buffers=2, buffer_size=16)
+        n_frames, received = 40, []
+
+        def consumer():
+            while (item := pool.take()) is not None:
+                arr, idx = item
+                received.append(int(np.asarray(arr)[0]))
+                time.sleep(0.001)
+                pool.release(idx)
+
+        worker = threading.Thread(target=consumer)
+        worker.start()
+        for frame in range(n_frames):
+            arr, idx = pool.acquire_with_index(timeout=5.0)
+            np.asarray(arr)[0] = frame
+            pool.submit(idx)
+        pool.close()
+        worker.join()
+        assert received == list(range(n_frames))
+        assert pool.stats().waits > 0
+
     def test_invalid_index_raises(self):
         """Releasing an invalid index should raise."""
         pool = self.Pool(n_buffers=2, buffer_size=64)
@@ -277,3 +618,439 @@ class TestPinnedAllocator:
         """is_pinned() should return a bool."""
         pool = self.Pool(n_buffers=1, buffer_size=64)
         assert isinstance(pool.is_pinned(), bool)
+
+
+class TestPinnedArena:
+    """Tests for the variable-size buddy sub-allocator."""
+
+    @pytest.fixture(autouse=True)
+    def _load_module(self):
+        try:
+            from pinned_allocator import PinnedArena
+            self.Arena = PinnedArena
+        except ImportError:
+            pytest.skip("pinned_allocator module not built")
+
+    def test_alloc_returns_aligned_writable_array(self):
+        arena = self.Arena(arena_size=1 << 20)
+        arr = np.asarray(arena.alloc(1000, alignment=256))
+        assert arr.shape == (1000,) and arr.dtype == np.uint8
+        assert arr.ctypes.data % 256 == 0
+        arr[:] = 7
+        assert arr.sum() == 7000
+
+    def test_block_freed_when_array_collected(self):
+        arena = self.Arena(arena_size=1 << 20)
+        arr = arena.alloc(5000)
+        assert arena.stats().live_allocations == 1
+        assert arena.stats().used_bytes == 8192  # 5000 rounds up to two 4 KiB units
+        del arr
+        stats = arena.stats()
+        assert (stats.live_allocations, stats.used_bytes) == (0, 0)
+
+    def test_variable_sizes_do_not_overlap(self):
+        arena = self.Arena(arena_size=8 << 20)
+        sizes = [640 * 480 * 3, 100, 320 * 240 * 3, 4096, 70000, 1]
+        bufs = [np.asarray(arena.alloc(n)) for n in sizes]
+        for i, buf in enumerate(bufs):
+            buf[:] = i
+        for i, buf in enumerate(bufs):
+            assert (buf == i).all()
+
+    def test_free_blocks_coalesce(self):
+        """Freeing every quarter lets the whole arena be allocated again."""
+        arena = self.Arena(arena_size=1 << 20)
+        quarters = [arena.alloc(256 * 1024) for _ in range(4)]
+        with pytest.raises(MemoryError):
+            arena.alloc(1)
+        assert arena.stats().failed_allocations == 1
+        del quarters
+        assert arena.stats().largest_free_block == 1 << 20
+        assert np.asarray(arena.alloc(1 << 20)).size == 1 << 20
+
+    def test_fragmentation_stats(self):
+        arena = self.Arena(arena_size=1 << 20)
+        keep = [arena.alloc(3000) for _ in range(2)]
+        stats = arena.stats()
+        assert stats.requested_bytes == 6000
+        assert stats.internal_fragmentation == pytest.approx(1 - 6000 / 8192)
+        assert 0.0 <= stats.external_fragmentation < 1.0
+        assert stats.peak_used_bytes == 8192
+        del keep
+
+    def test_arena_outlives_python_object(self):
+        """Live arrays keep the pinned region alive after the arena object is gone."""
+        arena = self.Arena(arena_size=1 << 16, min_block=1024)
+        arr = np.asarray(arena.alloc(2048))
+        del arena
+        arr[:] = 3
+        assert arr[-1] == 3
+
+    def test_invalid_arguments(self):
+        with pytest.raises(ValueError):
+            self.Arena(arena_size=1 << 20, min_block=100)
+        arena = self.Arena(arena_size=1 << 20)
+        with pytest.raises(ValueError):
+            arena.alloc(0)
+        with pytest.raises(ValueError):
+            arena.alloc(64, alignment=3)
+
+
+class TestStagedRing:
+    """Tests for the ring of buffers handed between pipeline stages."""
+
+    @pytest.fixture(autouse=True)
+    def _load_module(self):
+        try:
+            from pinned_allocator import StagedRing
+            self.Ring = StagedRing
+        except ImportError:
+            pytest.skip("pinned_allocator module not built")
+
+    def test_slot_moves_through_stages_in_order(self):
+        ring = self.Ring(n_stages=3, n_slots=2, buffer_size=16)
+        buf, slot = ring.begin(0)
+        assert slot == 0 and ring.slot_states() == ["filling", "free"]
+        np.asarray(buf)[:] = 5
+        assert ring.begin(1, timeout=0.0) is None  # nothing committed yet
+        ring.commit(0, slot)
+        assert ring.slot_states() == ["ready:1", "free"]
+        buf1, slot1 = ring.begin(1, timeout=0.0)
+        assert slot1 == 0 and (np.asarray(buf1) == 5).all()
+        assert ring.slot_states() == ["consuming:1", "free"]
+        ring.commit(1, slot1)
+        _, slot2 = ring.begin(2, timeout=0.0)
+        ring.commit(2, slot2)
+        assert ring.slot_states() == ["free", "free"]
+        assert [s.processed for s in ring.stats()] == [1, 1, 1]
+
+    def test_producer_fills_next_slot_while_consumer_holds_previous(self):
+        ring = self.Ring(n_stages=2, n_slots=2, buffer_size=16)
+        _, a = ring.begin(0)
+        ring.commit(0, a)
+        _, consumed = ring.begin(1)
+        _, b = ring.begin(0, timeout=0.0)
+        assert (consumed, b) == (0, 1)
+        ring.commit(0, b)
+        assert ring.begin(0, timeout=0.0) is None  # slot 0 is still being consumed
+        ring.commit(1, consumed)
+        assert ring.begin(0, timeout=0.0)[1] == 0
+
+    def test_misuse_raises(self):
+        ring = self.Ring(n_stages=2, n_slots=2, buffer_size=16)
+        _, slot = ring.begin(0)
+        with pytest.raises(RuntimeError):
+            ring.begin(0)  # one slot per stage at a time
+        with pytest.raises(RuntimeError):
+            ring.commit(1, slot)
+        with pytest.raises(IndexError):
+            ring.begin(2)
+        with pytest.raises(ValueError):
+            self.Ring(n_stages=1, n_slots=2, buffer_size=16)
+
+    def test_stall_time_recorded(self):
+        ring = self.Ring(n_stages=2, n_slots=2, buffer_size=16)
+        t0 = time.perf_counter()
+        assert ring.begin(1, timeout=0.05) is None
+        assert time.perf_counter() - t0 >= 0.04
+        stats = ring.stats()[1]
+        assert stats.stalls == 1 and stats.stall_ns_total >= 40_000_000
+        ring.reset_stats()
+        assert ring.stats()[1].stalls == 0
+
+    def test_close_drains_downstream(self):
+        ring = self.Ring(n_stages=2, n_slots=4, buffer_size=16)
+        for _ in range(3):
+            _, slot = ring.begin(0)
+            ring.commit(0, slot)
+        ring.close()
+        assert ring.begin(0) is None
+        seen = []
+        while (item := ring.begin(1)) is not None:
+            seen.append(item[1])
+            ring.commit(1, item[1])
+        assert seen == [0, 1, 2]
+
+    def test_view_outlives_ring(self):
+        """A slot's array keeps the ring's buffers alive after the ring is gone."""
+        ring = self.Ring(n_stages=2, n_slots=2, buffer_size=16)
+        view = np.asarray(ring.begin(0)[0])
+        del ring
+        view[:] = 9
+        assert (view == 9).all()
+
+    def test_three_stage_pipeline_threads(self):
+        """Each stage runs on its own thread; every frame passes every stage in order."""
+        ring = self.Ring(n_stages=3, n_slots=3, buffer_size=8)
+        n_frames = 300
+        outputs = []
+
+        def stage(k):
+            frame_no = 0
+            while (item := ring.begin(k, timeout=5.0)) is not None:
+                buf, slot = item
+                view = np.asarray(buf).view(np.int64)
+                if k == 0:
+                    view[0] = frame_no
+                elif k == 1:
+                    view[0] *= 2
+                else:
+                    outputs.append(int(view[0]))
+                ring.commit(k, slot)
+                frame_no += 1
+                if k == 0 and frame_no == n_frames:
+                    ring.close()
+
+        threads = [threading.Thread(target=stage, args=(k,)) for k in range(3)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join(10.0)
+        assert outputs == [2 * i for i in range(n_frames)]
+        assert [s.processed for s in ring.stats()] == [n_frames] * 3
+
+
+_segment_ids = itertools.count()
+
+
+def _tracker_process(name, ready, results):
+    """Child process: read frames until the producer closes, check their pixels."""
+    from shared_frame_pool import SharedFrameReader
+    reader = SharedFrameReader(name)
+    ready.set()
+    seqs, bad = [], 0
+    while (item := reader.wait(timeout=5.0)) is not None:
+        frame, desc = item
+        bad += int(not (frame == desc.seq % 251).all())
+        seqs.append(desc.seq)
+        del frame, item
+    results.put((seqs, bad, reader.dropped_count()))
+
+
+class TestSharedFramePool:
+    """Tests for the cross-process shared-memory frame pool."""
+
+    @pytest.fixture(autouse=True)
+    def _load_module(self):
+        try:
+            import shared_frame_pool
+            self.m = shared_frame_pool
+        except ImportError:
+            pytest.skip("shared_frame_pool module not built")
+        self.name = f"/sfp_test_{os.getpid()}_{next(_segment_ids)}"
+
+    def test_publish_then_read_is_zero_copy_and_read_only(self):
+        pool = self.m.SharedFramePool(self.name, n_slots=4, slot_bytes=48 * 64 * 3)
+        reader = self.m.SharedFrameReader(self.name)
+        buf, slot = pool.acquire()
+        frame_in = np.arange(48 * 64 * 3, dtype=np.uint32).astype(np.uint8)
+        np.asarray(buf)[:frame_in.size] = frame_in
+        seq = pool.publish(slot, (48, 64, 3))
+
+        frame, desc = reader.wait(timeout=1.0)
+        frame = np.asarray(frame)
+        assert (desc.seq, desc.slot, desc.height, desc.width, desc.channels) == (seq, slot, 48, 64, 3)
+        assert desc.timestamp_ns > 0
+        np.testing.assert_array_equal(frame.ravel(), frame_in)
+        assert not frame.flags.writeable
+        with pytest.raises(ValueError):
+            frame[0, 0, 0] = 1
+
+    def test_write_copies_frame_in(self, sample_image):
+        pool = self.m.SharedFramePool(self.name, n_slots=2, slot_bytes=sample_image.nbytes)
+        reader = self.m.SharedFrameReader(self.name)
+        pool.write(sample_image, timestamp_ns=1234)
+        frame, desc = reader.wait(timeout=1.0)
+        np.testing.assert_array_equal(np.asarray(frame), sample_image)
+        assert desc.timestamp_ns == 1234
+        with pytest.raises(ValueError):
+            pool.write(np.zeros((100, 100, 3), dtype=np.uint8))
+
+    def test_wait_times_out_and_returns_none_after_close(self):
+        pool = self.m.SharedFramePool(self.name, n_slots=2, slot_bytes=64)
+        reader = self.m.SharedFrameReader(self.name)
+        t0 = time.perf_counter()
+        assert reader.wait(timeout=0.05) is None
+        assert time.perf_counter() - t0 >= 0.04
+        pool.write(np.ones((8, 8), dtype=np.uint8))
+        pool.close()
+        assert reader.wait(timeout=1.0) is not None  # drained before the close is reported
+        assert reader.wait() is None
+        assert reader.closed()
+
+    def test_wait_wakes_on_publish_from_other_thread(self):
+        pool = self.m.SharedFramePool(self.name, n_slots=2, slot_bytes=64)
+        reader = self.m.SharedFrameReader(self.name)
+        timer = threading.Timer(0.05, lambda: pool.write(np.zeros((8, 8), dtype=np.uint8)))
+        timer.start()
+        item = reader.wait(timeout=5.0)
+        timer.join()
+        assert item is not None and item[1].seq == 0
+
+    def test_latest_skips_to_newest(self):
+        pool = self.m.SharedFramePool(self.name, n_slots=4, slot_bytes=64)
+        reader = self.m.SharedFrameReader(self.name)
+        for i in range(3):
+            pool.write(np.full((8, 8), i, dtype=np.uint8))
+        frame, desc = reader.latest()
+        assert desc.seq == 2 and np.asarray(frame)[0, 0, 0] == 2
+        assert reader.latest() is None
+
+    def test_latest_returns_when_slot_is_reclaimed_then_discarded(self):
+        """A claimed-then-discarded slot never gets a newer frame: latest() must not spin on it."""
+        pool = self.m.SharedFramePool(self.name, n_slots=1, slot_bytes=64)
+        reader = self.m.SharedFrameReader(self.name)
+        _, slot = pool.acquire()
+        pool.publish(slot, (8, 8, 1))
+        _, slot = pool.acquire()  # bumps the generation of the only slot
+        pool.discard(slot)
+        t0 = time.perf_counter()
+        assert reader.latest() is None
+        assert time.perf_counter() - t0 < 1.0
+        pool.write(np.full((8, 8), 5, dtype=np.uint8))
+        frame, desc = reader.latest()
+        assert desc.seq == 1 and np.asarray(frame)[0, 0, 0] == 5
+
+    def test_latest_falls_back_to_older_frame(self):
+        pool = self.m.SharedFramePool(self.name, n_slots=2, slot_bytes=64)
+        early = self.m.SharedFrameReader(self.name)
+        reader = self.m.SharedFrameReader(self.name)
+        pool.write(np.full((8, 8), 1, dtype=np.uint8))
+        pool.write(np.full((8, 8), 2, dtype=np.uint8))
+        held, _ = early.wait(timeout=1.0)  # pins frame 0's slot
+        _, slot = pool.acquire(timeout=0.0)  # so this re-claims frame 1's slot
+        pool.discard(slot)
+        frame, desc = reader.latest()
+        assert desc.seq == 0 and np.asarray(frame)[0, 0, 0] == 1
+        assert reader.latest() is None
+        del held, frame
+
+    def test_pinned_slot_is_not_overwritten(self):
+        pool = self.m.SharedFramePool(self.name, n_slots=2, slot_bytes=64)
+        reader = self.m.SharedFrameReader(self.name)
+        pool.write(np.full((8, 8), 7, dtype=np.uint8))
+        frame, desc = reader.wait(timeout=1.0)
+        assert pool.pinned_count() == 1
+        for i in range(5):
+            pool.write(np.full((8, 8), i, dtype=np.uint8))
+        assert (np.asarray(frame) == 7).all()
+        _, other = pool.acquire(timeout=0.0)
+        with pytest.raises(RuntimeError):
+            pool.acquire(timeout=0.0)  # one slot pinned, the other claimed
+        pool.discard(other)
+        del frame
+        assert pool.pinned_count() == 0
+
+    def test_producer_threads_share_one_pool(self):
+        """acquire() polls with the GIL released, so claims from several threads must not race."""
+        pool = self.m.SharedFramePool(self.name, n_slots=4, slot_bytes=64)
+        errors = []
+
+        def produce(value):
+            try:
+                for _ in range(100):
+                    pool.write(np.full((8, 8), value, dtype=np.uint8), timeout=5.0)
+            except Exception as e:  # noqa: BLE001 - surfaced by the assert below
+                errors.append(e)
+
+        threads = [threading.Thread(target=produce, args=(v,)) for v in range(4)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        assert errors == []
+        assert pool.published_count() == 400
+        assert pool.pinned_count() == 0
+
+    def test_lagging_reader_counts_dropped_frames(self):
+        pool = self.m.SharedFramePool(self.name, n_slots=4, slot_bytes=64)
+        reader = self.m.SharedFrameReader(self.name)
+        for i in range(10):
+            pool.write(np.full((8, 8), i, dtype=np.uint8))
+        seqs = []
+        while (item := reader.wait(timeout=0.0)) is not None:
+            seqs.append(item[1].seq)
+        assert seqs == [6, 7, 8, 9]
+        assert reader.dropped_count() == 6 and reader.received_count() == 4
+
+    def test_attach_errors(self):
+        with pytest.raises(RuntimeError):
+            self.m.SharedFrameReader(self.name)
+        with pytest.raises(ValueError):
+            self.m.SharedFramePool("no_slash", n_slots=2, slot_bytes=64)
+        with pytest.raises(ValueError):
+            self.m.SharedFramePool(self.name, n_slots=0, slot_bytes=64)
+        pool = self.m.SharedFramePool(self.name, n_slots=2, slot_bytes=64)
+        _, slot = pool.acquire()
+        with pytest.raises(ValueError):
+            pool.publish(slot, (100, 100, 3))
+        pool.discard(slot)
+        with pytest.raises(RuntimeError):
+            pool.publish(slot, (8, 8, 1))
+
+    def test_existing_name_is_not_replaced(self):
+        pool = self.m.SharedFramePool(self.name, n_slots=2, slot_bytes=64)
+        reader = self.m.SharedFrameReader(self.name)
+        with pytest.raises(RuntimeError, match="already exists"):
+            self.m.SharedFramePool(self.name, n_slots=2, slot_bytes=64)
+        with pytest.raises(RuntimeError, match="still produced"):
+            self.m.SharedFramePool(self.name, n_slots=2, slot_bytes=64, takeover=True)
+        pool.write(np.full((8, 8), 7, dtype=np.uint8))
+        frame, _ = reader.wait(timeout=1.0)
+        assert np.asarray(frame).max() == 7
+
+    def test_reused_name_survives_old_pool(self):
+        """A pool whose name was re-created by someone else must not unlink the successor."""
+        old = self.m.SharedFramePool(self.name, n_slots=2, slot_bytes=64)
+        os.unlink("/dev/shm" + self.name)
+        pool = self.m.SharedFramePool(self.name, n_slots=2, slot_bytes=64)
+        del old
+        reader = self.m.SharedFrameReader(self.name)
+        pool.write(np.full((8, 8), 3, dtype=np.uint8))
+        frame, _ = reader.wait(timeout=1.0)
+        assert np.asarray(frame).max() == 3
+        del frame, reader, pool
+        assert not os.path.exists("/dev/shm" + self.name)
+
+    def test_takeover_replaces_stale_segment(self):
+        import subprocess
+        script = (
+            "import os, shared_frame_pool\n"
+            f"pool = shared_frame_pool.SharedFramePool({self.name!r}, n_slots=2, slot_bytes=64)\n"
+            "os._exit(0)\n"  # skip the destructor, like a crash
+        )
+        env = dict(os.environ, PYTHONPATH=os.pathsep.join(p for p in sys.path if p))
+        subprocess.run([sys.executable, "-c", script], env=env, check=True, timeout=30)
+        stale = self.m.SharedFrameReader(self.name)
+        with pytest.raises(RuntimeError, match="already exists"):
+            self.m.SharedFramePool(self.name, n_slots=4, slot_bytes=128)
+        pool = self.m.SharedFramePool(self.name, n_slots=4, slot_bytes=128, takeover=True)
+        assert stale.closed() and stale.wait(timeout=1.0) is None
+        reader = self.m.SharedFrameReader(self.name)
+        assert reader.producer_pid() == os.getpid()
+        pool.write(np.full((8, 16), 5, dtype=np.uint8))
+        frame, _ = reader.wait(timeout=1.0)
+        assert np.asarray(frame).shape == (8, 16, 1)
+
+    def test_frames_reach_several_processes(self):
+        """Two tracker processes each see every frame, in order, with correct pixels."""
+        ctx = multiprocessing.get_context("fork")
+        pool = self.m.SharedFramePool(self.name, n_slots=8, slot_bytes=32 * 32 * 3)
+        results = ctx.Queue()
+        readies = [ctx.Event() for _ in range(2)]
+        procs = [ctx.Process(target=_tracker_process, args=(self.name, e, results)) for e in readies]
+        for p in procs:
+            p.start()
+        for e in readies:
+            assert e.wait(10.0)
+        for i in range(50):
+            pool.write(np.full((32, 32, 3), i % 251, dtype=np.uint8), timeout=5.0)
+            time.sleep(0.002)
+        pool.close()
+        outcomes = [results.get(timeout=10.0) for _ in procs]
+        for p in procs:
+            p.join(10.0)
+            assert p.exitcode == 0
+        for seqs, bad, dropped in outcomes:
+            assert bad == 0
+            assert seqs == sorted(seqs) and len(seqs) + dropped == 50
@@ -2,9 +2,11 @@
 Benchmarks for Lesson 8: Compile-Time Concepts for Performance.
 
 Compares:
-  1. State machine: Python string vs C++ string vs C++ variant
+  1. State machine: Python string vs C++ string vs C++ variant vs C++ table
   2. Grayscale conversion: runtime computation vs compile-time LUT
   3. Gamma correction: runtime pow() vs compile-time LUT
+  4. Many tracks: one VariantStateMachine per track vs one StateMachineBank
+  5. Event log: recording cost per update and replay throughput
 """
 
 import sys
@@ -46,6 +48,9 @@ def benchmark_state_machines(iterations: int = 100_000):
     # --- C++ variant-based ---
     cpp_var_time_us = state_machine.benchmark_variant_sm(iterations)
 
+    # --- C++ compile-time transition table (runtime threshold) ---
+    cpp_table_time_us = state_machine.benchmark_table_sm(iterations, 30)
+
     print(f"\n{'Method':<35} {'Time (us)':>12} {'Speedup':>10}")
     print(f"{'-' * 57}")
     print(f"{'Python string state machine':<35} {py_time_us:>12,.0f} {'1.0x':>10}")
@@ -57,11 +62,19 @@ def benchmark_state_machines(iterations: int = 100_000):
         f"{'C++ variant state machine':<35} {cpp_var_time_us:>12,.0f} "
         f"{py_time_us / cpp_var_time_us:>9.1f}x"
     )
+    print(
+        f"{'C++ table state machine':<35} {cpp_table_time_us:>12,.0f} "
+        f"{py_time_us / cpp_table_time_us:>9.1f}x"
+    )
     if cpp_str_time_us > 0:
         print(
             f"\n  variant vs string (C++ only): "
             f"{cpp_str_time_us / cpp_var_time_us:.1f}x faster"
         )
+        print(
+            f"  table vs variant (C++ only):  "
+            f"{cpp_var_time_us / cpp_table_time_us:.2f}x"
+        )
 
 
 def benchmark_grayscale(iterations: int = 1_000):
@@ -124,6 +137,206 @@ def benchmark_gamma(iterations: int = 1_000):
     )
 
 
+def benchmark_many_tracks(n_tracks: int = 1_000, frames: int = 200):
+    """Benchmark 4: Per-frame cost of n_tracks state machines."""
+    print(f"\n{'=' * 70}")
+    print(f"BENCHMARK 4: {n_tracks:,} Tracks ({frames:,} frames)")
+    print(f"{'=' * 70}")
+
+    rng = np.random.default_rng(0)
+    detections = rng.random((frames, n_tracks)) < 0.6
+    boxes = rng.random((frames, n_tracks, 4), dtype=np.float32) * 100
+
+    # --- One VariantStateMachine per track, one Python call per track ---
+    sms = [state_machine.VariantStateMachine() for _ in range(n_tracks)]
+    det_lists = detections.tolist()
+    start = time.perf_counter()
+    for f in range(frames):
+        for sm, det in zip(sms, det_lists[f]):
+            if det:
+                sm.update(True, 100.0, 200.0, 50.0, 50.0)
+            else:
+                sm.update(False)
+    per_track_us = (time.perf_counter() - start) * 1e6 / frames
+
+    # --- One StateMachineBank, one Python call per frame ---
+    bank = state_machine.StateMachineBank(n_tracks)
+    start = time.perf_counter()
+    for f in range(frames):
+        bank.update(detections[f], boxes[f])
+    bank_us = (time.perf_counter() - start) * 1e6 / frames
+
+    # --- Both in C++ only (no Python calls) ---
+    cpp_frames = 10_000
+    cpp_variant_us = state_machine.benchmark_variant_tracks(n_tracks, cpp_frames) / cpp_frames
+    cpp_bank_us = state_machine.benchmark_bank_tracks(n_tracks, cpp_frames) / cpp_frames
+
+    print(f"\n{'Method':<35} {'us/frame':>12} {'Speedup':>10}")
+    print(f"{'-' * 57}")
+    rows = [
+        ("Python loop of VariantStateMachine", per_track_us),
+        ("StateMachineBank.update", bank_us),
+        ("C++ loop of VariantStateMachine", cpp_variant_us),
+        ("C++ StateMachineBank step", cpp_bank_us),
+    ]
+    for name, us in rows:
+        print(f"{name:<35} {us:>12,.1f} {per_track_us / us:>9.1f}x")
+
+
+def benchmark_event_log(iterations: int = 100_000, n_tracks: int = 1_000, frames: int = 200):
+    """Benchmark 5: Recording every update, and replaying a recorded trace."""
+    print(f"\n{'=' * 70}")
+    print(f"BENCHMARK 5: Event Log ({iterations:,} iterations; replay of {n_tracks:,} tracks x {frames} frames)")
+    print(f"{'=' * 70}")
+
+    updates = iterations * 38  # updates per benchmark_variant_sm iteration
+    plain_us = state_machine.benchmark_variant_sm(iterations)
+    logged_us = state_machine.benchmark_variant_sm_logged(iterations)
+    print(f"\n{'Variant update':<35} {'ns/update':>12}")
+    print(f"{'-' * 47}")
+    print(f"{'Not recording':<35} {plain_us * 1e3 / updates:>12.2f}")
+    print(f"{'Recording to an EventLog':<35} {logged_us * 1e3 / updates:>12.2f}")
+
+    # Record a trace from the batched bank, then replay it per track
+    log = state_machine.EventLog(n_tracks * frames)
+    bank = state_machine.StateMachineBank(n_tracks)
+    bank.record_to(log)
+    rng = np.random.default_rng(0)
+    boxes = rng.random((n_tracks, 4), dtype=np.float32)
+    for _ in range(frames):
+        bank.update(rng.random(n_tracks) < 0.6, boxes)
+
+    print(f"\n{'Replay through':<35} {'ns/record':>12} {'Mismatches':>12}")
+    print(f"{'-' * 59}")
+    for machine in ("string", "variant", "table"):
+        result = state_machine.replay(log, machine)
+        print(f"{machine:<35} {result['ns_per_record']:>12.2f} {result['mismatches']:>12,}")
+
+
+def _best_us(fn, iterations):
+    best = float("inf")
+    for _ in range(iterations):
+        start = time.perf_counter()
+        fn()
+        best = min(best, (time.perf_counter() - start) * 1e6)
+    return best
+
+
+def benchmark_simd_kernels(iterations: int = 20):
+    """Benchmark 6: SIMD grayscale and LUT kernels vs the scalar LUT loops."""
+    print(f"\n{'=' * 70}")
+    print(f"BENCHMARK 6: SIMD Kernels ({compile_time_lut.simd_level()}, best of {iterations})")
+    print(f"{'=' * 70}")
+
+    print(f"\n{'Kernel (C++ only)':<24} {'Size':>10} {'Scalar (us)':>12} {'SIMD (us)':>12} {'Speedup':>9}")
+    print(f"{'-' * 71}")
+    for width, height in ((1920, 1080), (3840, 2160)):
+        t = compile_time_lut.benchmark_lut_kernels(width, height, iterations)
+        size = f"{width}x{height}"
+        for name, scalar, simd in (("BGR -> gray", "grayscale_lut", "grayscale_simd"),
+                                   ("256-entry LUT", "gamma_lut", "lut_simd")):
+            print(
+                f"{name:<24} {size:>10} {t[scalar]:>12,.0f} {t[simd]:>12,.0f} "
+                f"{t[scalar] / t[simd]:>8.1f}x"
+            )
+
+    # From Python, gamma 1.8 is not precomputed: apply_gamma_lut rebuilds its
+    # table on every call, apply_gamma_simd reuses the cached one.
+    gray = np.random.randint(0, 256, (2160, 3840), dtype=np.uint8)
+    out = np.empty_like(gray)
+    calls = (
+        ("apply_gamma_runtime", lambda: compile_time_lut.apply_gamma_runtime(gray, 1.8)),
+        ("apply_gamma_lut", lambda: compile_time_lut.apply_gamma_lut(gray, 1.8)),
+        ("apply_gamma_simd", lambda: compile_time_lut.apply_gamma_simd(gray, 1.8)),
+        ("apply_gamma_simd_into", lambda: compile_time_lut.apply_gamma_simd_into(gray, 1.8, out)),
+    )
+    print(f"\n{'Python call (4K, gamma 1.8)':<35} {'Best (us)':>12}")
+    print(f"{'-' * 48}")
+    for name, fn in calls:
+        print(f"{name:<35} {_best_us(fn, iterations):>12,.0f}")
+
+
+def benchmark_lut_chain(iterations: int = 20):
+    """Benchmark 7: four point-op passes vs one composed table."""
+    print(f"\n{'=' * 70}")
+    print(f"BENCHMARK 7: LUT Composition (4K, best of {iterations})")
+    print(f"{'=' * 70}")
+
+    gray = np.random.randint(0, 256, (2160, 3840), dtype=np.uint8)
+    out = np.empty_like(gray)
+    contrast = compile_time_lut.LutChain().contrast_stretch(16, 235).table
+    brightness = compile_time_lut.LutChain().brightness(10).table
+    invert = compile_time_lut.LutChain().invert().table
+
+    def four_passes():
+        compile_time_lut.apply_gamma_simd_into(gray, 0.45, out)
+        compile_time_lut.apply_lut_into(out, contrast, out)
+        compile_time_lut.apply_lut_into(out, brightness, out)
+        compile_time_lut.apply_lut_into(out, invert, out)
+
+    chain = compile_time_lut.LutChain().gamma(0.45).contrast_stretch(16, 235).brightness(10).invert()
+    bgr = np.random.randint(0, 256, (2160, 3840, 3), dtype=np.uint8)
+    bgr_out = np.empty_like(bgr)
+    per_channel = compile_time_lut.LutChain(channels=3).gamma(0.45).brightness(20, channel=2).invert(channel=0)
+    tables = per_channel.table
+
+    rows = (
+        ("Gray: 4 separate SIMD passes", four_passes),
+        ("Gray: LutChain, 1 pass", lambda: chain.apply_into(gray, out)),
+        ("Gray: compile-time chain, 1 pass", lambda: compile_time_lut.apply_photometric_into(gray, out)),
+        ("BGR: numpy, 1 index per channel", lambda: [tables[c][bgr[..., c]] for c in range(3)]),
+        ("BGR: LutChain(channels=3), 1 pass", lambda: per_channel.apply_into(bgr, bgr_out)),
+    )
+    print(f"\n{'Method':<40} {'Best (us)':>12}")
+    print(f"{'-' * 53}")
+    for name, fn in rows:
+        print(f"{name:<40} {_best_us(fn, iterations):>12,.0f}")
+
+
+def benchmark_clahe(iterations: int = 10):
+    """Benchmark 8: histogram, equalization and CLAHE vs OpenCV."""
+    print(f"\n{'=' * 70}")
+    print(f"BENCHMARK 8: Histogram / Equalization / CLAHE (best of {iterations})")
+    print(f"{'=' * 70}")
+
+    try:
+        import cv2
+    except ImportError:
+        cv2 = None
+        print("\n(opencv-python not installed: OpenCV rows skipped)")
+
+    ours_1 = compile_time_lut.Clahe(2.0, (8, 8), threads=1)
+    ours_n = compile_time_lut.Clahe(2.0, (8, 8))
+    for width, height in ((1920, 1080), (3840, 2160)):
+        rng = np.random.default_rng(0)
+        y, x = np.indices((height, width))
+        gray = np.clip(90 + 30 * np.sin(x * 0.01) + 20 * np.cos(y * 0.013) + rng.integers(0, 20, (height, width)),
+                       0, 255).astype(np.uint8)
+        out = np.empty_like(gray)
+
+        rows = [
+            ("histogram: np.bincount", lambda: np.bincount(gray.ravel(), minlength=256)),
+            ("histogram: ours, 1 thread", lambda: compile_time_lut.histogram(gray, threads=1)),
+            ("histogram: ours, all threads", lambda: compile_time_lut.histogram(gray)),
+            ("equalize: ours, 1 thread", lambda: compile_time_lut.equalize_hist_into(gray, out, threads=1)),
+            ("equalize: ours, all threads", lambda: compile_time_lut.equalize_hist_into(gray, out)),
+            ("CLAHE: ours, 1 thread", lambda: ours_1.apply_into(gray, out)),
+            ("CLAHE: ours, all threads", lambda: ours_n.apply_into(gray, out)),
+        ]
+        if cv2 is not None:
+            cv_clahe = cv2.createCLAHE(clipLimit=2.0, tileGridSize=(8, 8))
+            rows += [
+                ("equalize: cv2.equalizeHist", lambda: cv2.equalizeHist(gray, out)),
+                ("CLAHE: cv2.createCLAHE", lambda: cv_clahe.apply(gray, out)),
+            ]
+
+        title = f"Method ({width}x{height})"
+        print(f"\n{title:<40} {'Best (us)':>12}")
+        print(f"{'-' * 53}")
+        for name, fn in rows:
+            print(f"{name:<40} {_best_us(fn, iterations):>12,.0f}")
+
+
 def main():
     print("Lesson 8: Compile-Time Concepts for Performance — Benchmarks")
     print("=" * 70)
@@ -131,6 +344,11 @@ def main():
     benchmark_state_machines(iterations=100_000)
     benchmark_grayscale(iterations=1_000)
     benchmark_gamma(iterations=1_000)
+    benchmark_many_tracks(n_tracks=1_000, frames=200)
+    benchmark_event_log(iterations=100_000)
+    benchmark_simd_kernels(iterations=20)
+    benchmark_lut_chain(iterations=20)
+    benchmark_clahe(iterations=10)
 
     print(f"\n{'=' * 70}")
     print("Done.")
@@ -1,10 +1,31 @@
 #include <nanobind/nanobind.h>
 #include <nanobind/ndarray.h>
+#include <nanobind/stl/pair.h>
+#include <nanobind/stl/string.h>
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <bit>
 #include <chrono>
 #include <cmath>
 #include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "parallel_bands.h"
 
 namespace nb = nanobind;
 
@@ -148,11 +169,764 @@ void gamma_lut(const uint8_t* src, uint8_t* dst, size_t num_pixels,
     }
 }
 
+// ---------------------------------------------------------------------------
+// SIMD kernels
+//
+// The loops above handle one byte at a time. These do 32 (AVX2) or 64
+// (AVX-512 VBMI) pixels per step. The vector path is picked at compile
+// time (CMakeLists.txt builds with -march=native); every path produces
+// exactly the same bytes as the scalar tail loop.
+// ---------------------------------------------------------------------------
+
+// BT.601 weights in Q16, summing to 65536. Each channel term is computed as
+// (x * w) >> 8, which is one _mm256_mulhi_epu16 on (x << 8); the sum is
+// then rounded back to 8 bits. Unlike GRAY_LUT (three truncated terms) this
+// rounds once, so white maps to 255.
+constexpr uint16_t kGrayWeightB = 7471;
+constexpr uint16_t kGrayWeightG = 38470;
+constexpr uint16_t kGrayWeightR = 19595;
+static_assert(kGrayWeightB + kGrayWeightG + kGrayWeightR == 65536);
+
+constexpr uint8_t gray_fixed(uint8_t b, uint8_t g, uint8_t r) {
+    return static_cast<uint8_t>(((b * kGrayWeightB >> 8) + (g * kGrayWeightG >> 8) +
+                                 (r * kGrayWeightR >> 8) + 128) >> 8);
+}
+static_assert(gray_fixed(255, 255, 255) == 255 && gray_fixed(0, 0, 0) == 0);
+
+#if defined(__AVX2__)
+// pshufb control that gathers channel `channel` of 16 pixels from slice
+// `slice` (bytes 16*slice .. 16*slice+15) of their 48-byte BGR run. Lanes
+// whose byte lives in another slice get 0x80, which pshufb turns into 0.
+static __m128i deinterleave_mask(int channel, int slice) {
+    alignas(16) int8_t m[16];
+    for (int k = 0; k < 16; ++k) {
+        int src = 3 * k + channel - 16 * slice;
+        m[k] = (src >= 0 && src < 16) ? static_cast<int8_t>(src) : static_cast<int8_t>(-128);
+    }
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(m));
+}
+#endif
+
+void grayscale_simd(const uint8_t* bgr, uint8_t* gray, size_t num_pixels) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    // pshufb only shuffles within a 128-bit lane, so each ymm holds the same
+    // 16-byte slice of two 16-pixel runs: pixels i..i+15 in the low lane and
+    // i+16..i+31 in the high lane. Three shuffles + ORs give one channel.
+    __m256i masks[3][3];
+    for (int c = 0; c < 3; ++c) {
+        for (int s = 0; s < 3; ++s) masks[c][s] = _mm256_broadcastsi128_si256(deinterleave_mask(c, s));
+    }
+    const __m256i wb = _mm256_set1_epi16(static_cast<short>(kGrayWeightB));
+    const __m256i wg = _mm256_set1_epi16(static_cast<short>(kGrayWeightG));
+    const __m256i wr = _mm256_set1_epi16(static_cast<short>(kGrayWeightR));
+    const __m256i round = _mm256_set1_epi16(128);
+    const __m256i zero = _mm256_setzero_si256();
+
+    for (; i + 32 <= num_pixels; i += 32) {
+        const uint8_t* p = bgr + 3 * i;
+        __m256i slices[3];
+        for (int s = 0; s < 3; ++s) {
+            __m128i run0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * s));
+            __m128i run1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 48 + 16 * s));
+            slices[s] = _mm256_inserti128_si256(_mm256_castsi128_si256(run0), run1, 1);
+        }
+        __m256i ch[3];
+        for (int c = 0; c < 3; ++c) {
+            ch[c] = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(slices[0], masks[c][0]),
+                                                    _mm256_shuffle_epi8(slices[1], masks[c][1])),
+                                    _mm256_shuffle_epi8(slices[2], masks[c][2]));
+        }
+        // Unpacking with zero as the low byte widens to 16 bits and shifts
+        // left by 8 in one step, ready for mulhi
+        auto weigh = [&](__m256i b, __m256i g, __m256i r) {
+            __m256i acc = _mm256_add_epi16(_mm256_mulhi_epu16(b, wb), _mm256_mulhi_epu16(g, wg));
+            acc = _mm256_add_epi16(acc, _mm256_mulhi_epu16(r, wr));
+            return _mm256_srli_epi16(_mm256_add_epi16(acc, round), 8);
+        };
+        __m256i lo = weigh(_mm256_unpacklo_epi8(zero, ch[0]), _mm256_unpacklo_epi8(zero, ch[1]),
+                           _mm256_unpacklo_epi8(zero, ch[2]));
+        __m256i hi = weigh(_mm256_unpackhi_epi8(zero, ch[0]), _mm256_unpackhi_epi8(zero, ch[1]),
+                           _mm256_unpackhi_epi8(zero, ch[2]));
+        // packus is per lane too, which puts every pixel back in order
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(gray + i), _mm256_packus_epi16(lo, hi));
+    }
+#endif
+    for (; i < num_pixels; ++i) {
+        gray[i] = gray_fixed(bgr[i * 3 + 0], bgr[i * 3 + 1], bgr[i * 3 + 2]);
+    }
+}
+
+#if defined(__AVX512VBMI__)
+// A 256-entry table in four registers, for lookup256
+struct LutRegisters {
+    __m512i part[4];
+
+    explicit LutRegisters(const uint8_t* lut) {
+        for (int q = 0; q < 4; ++q) part[q] = _mm512_loadu_si512(lut + 64 * q);
+    }
+};
+
+// vpermi2b looks up 64 bytes in a 128-byte table: two lookups cover the
+// 256 entries and bit 7 of the index picks between them
+static inline __m512i lookup256(const LutRegisters& t, __m512i v) {
+    const __m512i lo = _mm512_permutex2var_epi8(t.part[0], v, t.part[1]);
+    const __m512i hi = _mm512_permutex2var_epi8(t.part[2], v, t.part[3]);
+    return _mm512_mask_blend_epi8(_mm512_movepi8_mask(v), lo, hi);
+}
+#endif
+
+void apply_lut_simd(const uint8_t* src, uint8_t* dst, size_t num_pixels, const std::array<uint8_t, 256>& lut) {
+    size_t i = 0;
+#if defined(__AVX512VBMI__)
+    const LutRegisters table(lut.data());
+    for (; i + 64 <= num_pixels; i += 64) {
+        _mm512_storeu_si512(dst + i, lookup256(table, _mm512_loadu_si512(src + i)));
+    }
+#elif defined(__AVX2__)
+    // pshufb looks up 16-entry tables: split the LUT into 16 of them by the
+    // high nibble, look every pixel up in each by its low nibble, and keep
+    // the result from the table its high nibble selects
+    __m256i tables[16];
+    for (int k = 0; k < 16; ++k) {
+        tables[k] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lut.data() + 16 * k)));
+    }
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    for (; i + 32 <= num_pixels; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        const __m256i lo = _mm256_and_si256(v, nibble);
+        const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+        __m256i out = _mm256_setzero_si256();
+        for (int k = 0; k < 16; ++k) {
+            const __m256i hit = _mm256_cmpeq_epi8(hi, _mm256_set1_epi8(static_cast<char>(k)));
+            out = _mm256_blendv_epi8(out, _mm256_shuffle_epi8(tables[k], lo), hit);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), out);
+    }
+#endif
+    for (; i < num_pixels; ++i) {
+        dst[i] = lut[src[i]];
+    }
+}
+
+/** Which vector paths the kernels above were compiled with. */
+std::string simd_level() {
+#if defined(__AVX512VBMI__)
+    return "avx512vbmi";
+#elif defined(__AVX2__)
+    return "avx2";
+#else
+    return "scalar";
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// Runtime LUT cache
+//
+// GAMMA_LUT_* only exist for 0.45, 2.2 and 1.0. Any other gamma gets its
+// table built once with std::pow (the same formula as gamma_runtime, so
+// results match it exactly) and kept here. Lookups share a reader lock;
+// only a miss takes the writer lock. Tables are handed out as shared_ptr,
+// so clear() never frees a table another thread is still applying.
+// ---------------------------------------------------------------------------
+using Lut = std::array<uint8_t, 256>;
+
+Lut make_gamma_lut_runtime(double gamma) {
+    Lut lut{};
+    for (int i = 0; i < 256; ++i) {
+        int val = static_cast<int>(std::pow(i / 255.0, gamma) * 255.0 + 0.5);
+        lut[i] = static_cast<uint8_t>(std::clamp(val, 0, 255));
+    }
+    return lut;
+}
+
+class GammaLutCache {
+public:
+    static GammaLutCache& instance() {
+        static GammaLutCache cache;
+        return cache;
+    }
+
+    std::shared_ptr<const Lut> get(double gamma) {
+        if (!(gamma > 0.0) || !std::isfinite(gamma)) {
+            throw std::invalid_argument("gamma must be a positive finite number");
+        }
+        const uint64_t key = std::bit_cast<uint64_t>(gamma);
+        {
+            std::shared_lock lock(mutex_);
+            if (auto it = luts_.find(key); it != luts_.end()) {
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return it->second;
+            }
+        }
+        auto lut = std::make_shared<const Lut>(make_gamma_lut_runtime(gamma));  // outside the lock
+        std::unique_lock lock(mutex_);
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        // A sweep over thousands of gammas must not grow the cache forever
+        if (luts_.size() >= kMaxEntries) luts_.clear();
+        return luts_.try_emplace(key, std::move(lut)).first->second;  // another thread may have won
+    }
+
+    void clear() {
+        std::unique_lock lock(mutex_);
+        luts_.clear();
+        hits_ = 0;
+        misses_ = 0;
+    }
+
+    std::tuple<size_t, uint64_t, uint64_t> info() {
+        std::shared_lock lock(mutex_);
+        return {luts_.size(), hits_.load(), misses_.load()};
+    }
+
+    static constexpr size_t kMaxEntries = 1024;
+
+private:
+    GammaLutCache() = default;
+
+    std::shared_mutex mutex_;
+    std::unordered_map<uint64_t, std::shared_ptr<const Lut>> luts_;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+};
+
+// ---------------------------------------------------------------------------
+// LUT composition
+//
+// Gamma, contrast stretch, brightness and inversion are all uint8 -> uint8
+// point ops, so any chain of them is itself one 256-entry table:
+// compose(a, b)[i] = b[a[i]]. Building the chain costs 256 lookups per op;
+// applying it is one apply_lut_simd pass however long the chain is.
+// ---------------------------------------------------------------------------
+constexpr Lut identity_lut() {
+    Lut lut{};
+    for (int i = 0; i < 256; ++i) lut[i] = static_cast<uint8_t>(i);
+    return lut;
+}
+
+// Stretch [lo, hi] to the full [0, 255] range, clamping outside it
+constexpr Lut contrast_stretch_lut(int lo, int hi) {
+    if (lo < 0 || hi > 255 || lo >= hi) {
+        throw std::invalid_argument("contrast stretch needs 0 <= lo < hi <= 255");
+    }
+    Lut lut{};
+    for (int i = 0; i < 256; ++i) {
+        int x = std::clamp(i, lo, hi) - lo;
+        lut[i] = static_cast<uint8_t>((x * 255 + (hi - lo) / 2) / (hi - lo));
+    }
+    return lut;
+}
+
+constexpr Lut brightness_lut(int delta) {
+    if (delta < -255 || delta > 255) throw std::invalid_argument("brightness delta must be in [-255, 255]");
+    Lut lut{};
+    for (int i = 0; i < 256; ++i) lut[i] = static_cast<uint8_t>(std::clamp(i + delta, 0, 255));
+    return lut;
+}
+
+constexpr Lut invert_lut() {
+    Lut lut{};
+    for (int i = 0; i < 256; ++i) lut[i] = static_cast<uint8_t>(255 - i);
+    return lut;
+}
+
+// The table for "apply `first`, then `second`"
+constexpr Lut compose(const Lut& first, const Lut& second) {
+    Lut lut{};
+    for (int i = 0; i < 256; ++i) lut[i] = second[first[i]];
+    return lut;
+}
+
+template <typename... Rest>
+constexpr Lut compose_chain(const Lut& first, const Rest&... rest) {
+    Lut lut = first;
+    ((lut = compose(lut, rest)), ...);
+    return lut;
+}
+
+// A static chain folds entirely at compile time: the photometric
+// preprocessing below is one table in .rodata, not four passes. An invalid
+// op (say contrast_stretch_lut(200, 100)) throws during constant evaluation,
+// which is a compile error.
+constexpr Lut PHOTOMETRIC_LUT = compose_chain(GAMMA_LUT_0_45,               // sRGB encode
+                                              contrast_stretch_lut(16, 235), // video -> full range
+                                              brightness_lut(10),
+                                              invert_lut());
+
+static_assert(compose(invert_lut(), invert_lut()) == identity_lut());
+static_assert(compose_chain(brightness_lut(20), brightness_lut(-20))[100] == 100);
+static_assert(PHOTOMETRIC_LUT[0] == 255 - 10 && PHOTOMETRIC_LUT[255] == 0);
+
+// Per-channel version of apply_lut_simd for interleaved 3-channel pixels:
+// byte 3*i + c goes through luts[c]
+void apply_lut3_simd(const uint8_t* src, uint8_t* dst, size_t num_pixels, const std::array<Lut, 3>& luts) {
+    size_t i = 0;
+#if defined(__AVX512VBMI__)
+    // 64 bytes is not a whole number of pixels but 192 (64 pixels) is, and
+    // vector j of those three starts at channel j. Every byte is looked up
+    // in all three tables; a per-vector mask keeps the right channel's value.
+    const LutRegisters tables[3] = {LutRegisters(luts[0].data()), LutRegisters(luts[1].data()),
+                                    LutRegisters(luts[2].data())};
+    __mmask64 keep[3][3] = {};
+    for (int j = 0; j < 3; ++j) {
+        for (int b = 0; b < 64; ++b) keep[j][(64 * j + b) % 3] |= __mmask64{1} << b;
+    }
+    for (; i + 64 <= num_pixels; i += 64) {
+        for (int j = 0; j < 3; ++j) {
+            const __m512i v = _mm512_loadu_si512(src + 3 * i + 64 * j);
+            __m512i out = _mm512_setzero_si512();
+            for (int c = 0; c < 3; ++c) out = _mm512_mask_mov_epi8(out, keep[j][c], lookup256(tables[c], v));
+            _mm512_storeu_si512(dst + 3 * i + 64 * j, out);
+        }
+    }
+#endif
+    // Three tables of 16 nibble tables each would make AVX2 slower than this
+    // loop, so below VBMI the per-channel path stays scalar
+    for (; i < num_pixels; ++i) {
+        dst[3 * i + 0] = luts[0][src[3 * i + 0]];
+        dst[3 * i + 1] = luts[1][src[3 * i + 1]];
+        dst[3 * i + 2] = luts[2][src[3 * i + 2]];
+    }
+}
+
+// A chain of point ops built at runtime, composed as each op is added.
+// With channels=3 every channel has its own table and ops can target one
+// channel (channel=-1 means all). Adding ops is not thread-safe; applying
+// a finished chain from several threads is.
+class LutChain {
+public:
+    explicit LutChain(int channels = 1) : channels_(channels) {
+        if (channels != 1 && channels != 3) throw std::invalid_argument("channels must be 1 or 3");
+        luts_.fill(identity_lut());
+    }
+
+    LutChain& gamma(double gamma, int channel) { return append(*GammaLutCache::instance().get(gamma), channel); }
+    LutChain& contrast_stretch(int lo, int hi, int channel) { return append(contrast_stretch_lut(lo, hi), channel); }
+    LutChain& brightness(int delta, int channel) { return append(brightness_lut(delta), channel); }
+    LutChain& invert(int channel) { return append(invert_lut(), channel); }
+    LutChain& lut(const Lut& table, int channel) { return append(table, channel); }
+
+    // Append every op of `other`; a 1-channel chain applies to all channels
+    LutChain& then(const LutChain& other) {
+        if (other.channels_ != 1 && other.channels_ != channels_) {
+            throw std::invalid_argument("cannot append a 3-channel chain to a 1-channel chain");
+        }
+        for (int c = 0; c < channels_; ++c) luts_[c] = compose(luts_[c], other.luts_[other.channels_ == 1 ? 0 : c]);
+        length_ += other.length_;
+        return *this;
+    }
+
+    void apply(const uint8_t* src, uint8_t* dst, size_t num_bytes) const {
+        if (channels_ == 1) {
+            apply_lut_simd(src, dst, num_bytes, luts_[0]);
+        } else {
+            apply_lut3_simd(src, dst, num_bytes / 3, luts_);
+        }
+    }
+
+    [[nodiscard]] int channels() const noexcept { return channels_; }
+    [[nodiscard]] size_t length() const noexcept { return length_; }
+    [[nodiscard]] const Lut& table(int channel) const { return luts_[channel]; }
+
+private:
+    LutChain& append(const Lut& op, int channel) {
+        if (channel < -1 || channel >= channels_) throw std::invalid_argument("channel out of range for this chain");
+        for (int c = 0; c < channels_; ++c) {
+            if (channel == -1 || channel == c) luts_[c] = compose(luts_[c], op);
+        }
+        ++length_;
+        return *this;
+    }
+
+    int channels_;
+    std::array<Lut, 3> luts_{};
+    size_t length_ = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Histograms, equalization and CLAHE
+//
+// Equalization is a point op like the ones above: histogram -> 256-entry
+// table -> apply_lut_simd. CLAHE builds one clipped, equalized table per
+// tile and blends the four nearest tables per pixel. The formulas follow
+// OpenCV's equalizeHist and createCLAHE so results can be compared directly.
+// ---------------------------------------------------------------------------
+using ai_cpp::allowed_cpu_count;
+using ai_cpp::parallel_bands;
+
+using Histogram = std::array<uint64_t, 256>;
+
+// Counts bytes into four interleaved sub-histograms: a run of equal pixels
+// (black borders, flat sky) then increments four different counters
+// instead of serializing on one counter's load -> add -> store chain.
+// Counters are 32-bit, so callers keep n below 2^32 per call.
+struct SubHistograms {
+    alignas(64) uint32_t bins[4][256] = {};
+
+    void count(const uint8_t* src, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            ++bins[0][src[i]];
+            ++bins[1][src[i + 1]];
+            ++bins[2][src[i + 2]];
+            ++bins[3][src[i + 3]];
+        }
+        for (; i < n; ++i) ++bins[0][src[i]];
+    }
+
+    void merge_into(Histogram& hist) {
+        for (int v = 0; v < 256; ++v) hist[v] += uint64_t{bins[0][v]} + bins[1][v] + bins[2][v] + bins[3][v];
+        *this = {};
+    }
+};
+
+// Each thread fills its own sub-histograms (no shared counters, no atomics);
+// the per-thread results are summed once at the end
+Histogram histogram_parallel(const uint8_t* src, size_t n, int threads) {
+    constexpr size_t kChunk = size_t{1} << 30;  // keeps every 32-bit counter below 2^30
+    std::vector<Histogram> partial(threads <= 0 ? allowed_cpu_count() : threads, Histogram{});
+    std::atomic<size_t> next_slot{0};
+    parallel_bands(n, 256 * 1024, static_cast<int>(partial.size()), [&](size_t begin, size_t end) {
+        Histogram& out = partial[next_slot.fetch_add(1, std::memory_order_relaxed)];
+        SubHistograms sub;
+        for (size_t chunk = begin; chunk < end; chunk += kChunk) {
+            sub.count(src + chunk, std::min(kChunk, end - chunk));
+            sub.merge_into(out);
+        }
+    });
+    Histogram hist{};
+    for (const Histogram& p : partial) {
+        for (int v = 0; v < 256; ++v) hist[v] += p[v];
+    }
+    return hist;
+}
+
+// cv::equalizeHist's table: the cumulative histogram rescaled so the
+// darkest occupied level maps to 0 and the brightest to 255
+Lut equalization_lut(const Histogram& hist) {
+    uint64_t total = 0;
+    for (uint64_t count : hist) total += count;
+    int first = 0;
+    while (first < 255 && hist[first] == 0) ++first;
+    Lut lut{};
+    if (total == 0 || hist[first] == total) {
+        lut.fill(static_cast<uint8_t>(first));  // a flat image stays flat
+        return lut;
+    }
+    const float scale = 255.0f / static_cast<float>(total - hist[first]);
+    uint64_t sum = 0;
+    for (int v = first + 1; v < 256; ++v) {
+        sum += hist[v];
+        lut[v] = static_cast<uint8_t>(std::clamp(std::lrint(sum * scale), 0L, 255L));
+    }
+    return lut;
+}
+
+void equalize_parallel(const uint8_t* src, uint8_t* dst, size_t n, int threads) {
+    const Lut lut = equalization_lut(histogram_parallel(src, n, threads));
+    parallel_bands(n, 256 * 1024, threads, [&](size_t begin, size_t end) {
+        apply_lut_simd(src + begin, dst + begin, end - begin, lut);
+    });
+}
+
+// Mirror index i into [0, n) without repeating the edge (OpenCV's
+// BORDER_REFLECT_101), for the padding CLAHE adds when the image does not
+// divide into whole tiles
+static size_t reflect101(size_t i, size_t n) {
+    if (n == 1) return 0;
+    const size_t period = 2 * (n - 1);
+    i %= period;
+    return i < n ? i : period - i;
+}
+
+/**
+ * Contrast-limited adaptive histogram equalization on a 2-D uint8 image.
+ *
+ * Same parameters and algorithm as cv::createCLAHE(clip_limit, (tiles_x,
+ * tiles_y)): per-tile histograms clipped at clip_limit * tile_area / 256
+ * with the excess spread evenly, a table per tile, and bilinear blending of
+ * the four nearest tile tables per pixel. clip_limit <= 0 disables clipping.
+ */
+class Clahe {
+public:
+    // tile_grid is (tiles_x, tiles_y), the order of OpenCV's tileGridSize
+    Clahe(double clip_limit, std::pair<int, int> tile_grid, int threads)
+        : clip_limit_(clip_limit), tiles_x_(tile_grid.first), tiles_y_(tile_grid.second), threads_(threads) {
+        if (tiles_x_ < 1 || tiles_y_ < 1 || tiles_x_ > 256 || tiles_y_ > 256) {
+            throw std::invalid_argument("tile_grid must be between (1, 1) and (256, 256)");
+        }
+        if (!std::isfinite(clip_limit)) throw std::invalid_argument("clip_limit must be finite");
+    }
+
+    void apply(const uint8_t* src, uint8_t* dst, size_t height, size_t width) const {
+        if (width < static_cast<size_t>(tiles_x_) || height < static_cast<size_t>(tiles_y_)) {
+            throw std::invalid_argument("image is smaller than the tile grid");
+        }
+        // OpenCV's tile geometry: an image that divides evenly in both
+        // dimensions is used as-is; otherwise BOTH dimensions are padded
+        // (reflect-101) by tiles - size % tiles, which adds a whole extra tile
+        // to a dimension that already divided (1920x1080 on 16x16 tiles gives
+        // 121x68 tiles, not 120x68)
+        const bool whole_tiles = width % tiles_x_ == 0 && height % tiles_y_ == 0;
+        const size_t tile_w = width / tiles_x_ + (whole_tiles ? 0 : 1);
+        const size_t tile_h = height / tiles_y_ + (whole_tiles ? 0 : 1);
+        const std::vector<uint8_t> luts = tile_luts(src, height, width, tile_w, tile_h);
+        blend(src, dst, height, width, tile_w, tile_h, luts);
+    }
+
+    [[nodiscard]] double clip_limit() const noexcept { return clip_limit_; }
+    [[nodiscard]] std::pair<int, int> tile_grid() const noexcept { return {tiles_x_, tiles_y_}; }
+    [[nodiscard]] int threads() const noexcept { return threads_; }
+
+private:
+    // One 256-entry table per tile, row-major over the tile grid
+    std::vector<uint8_t> tile_luts(const uint8_t* src, size_t height, size_t width, size_t tile_w,
+                                   size_t tile_h) const {
+        const size_t n_tiles = static_cast<size_t>(tiles_x_) * tiles_y_;
+        const size_t area = tile_w * tile_h;
+        const int64_t limit = clip_limit_ > 0.0
+            ? std::max<int64_t>(static_cast<int64_t>(clip_limit_ * static_cast<double>(area) / 256), 1)
+            : 0;
+        const float scale = 255.0f / static_cast<float>(area);
+        std::vector<uint8_t> luts(n_tiles * 256);
+
+        parallel_bands(n_tiles, 1, threads_, [&](size_t begin, size_t end) {
+            SubHistograms sub;
+            for (size_t t = begin; t < end; ++t) {
+                const size_t x0 = (t % tiles_x_) * tile_w;
+                const size_t y0 = (t / tiles_x_) * tile_h;
+                const size_t inside = x0 < width ? std::min(tile_w, width - x0) : 0;
+                for (size_t y = y0; y < y0 + tile_h; ++y) {
+                    const uint8_t* row = src + reflect101(y, height) * width;
+                    sub.count(row + x0, inside);
+                    for (size_t x = x0 + inside; x < x0 + tile_w; ++x) ++sub.bins[0][row[reflect101(x, width)]];
+                }
+                Histogram hist{};
+                sub.merge_into(hist);
+                if (limit > 0) clip(hist, static_cast<uint64_t>(limit));
+
+                uint64_t sum = 0;
+                uint8_t* lut = luts.data() + 256 * t;
+                for (int v = 0; v < 256; ++v) {
+                    sum += hist[v];
+                    lut[v] = static_cast<uint8_t>(std::clamp(std::lrint(sum * scale), 0L, 255L));
+                }
+            }
+        });
+        return luts;
+    }
+
+    // Cap every bin at `limit` and hand the excess back evenly; the
+    // remainder goes one count each to bins spread across the range
+    static void clip(Histogram& hist, uint64_t limit) {
+        uint64_t clipped = 0;
+        for (uint64_t& count : hist) {
+            if (count > limit) {
+                clipped += count - limit;
+                count = limit;
+            }
+        }
+        const uint64_t batch = clipped / 256;
+        uint64_t residual = clipped - batch * 256;
+        for (uint64_t& count : hist) count += batch;
+        if (residual != 0) {
+            const uint64_t step = std::max<uint64_t>(256 / residual, 1);
+            for (uint64_t v = 0; v < 256 && residual > 0; v += step, --residual) ++hist[v];
+        }
+    }
+
+    // Columns [begin, end) whose pixels all blend the same four tile tables
+    struct BlendSpan {
+        size_t begin;
+        size_t end;
+        int left;
+        int right;
+    };
+
+    // Each pixel blends the tables of the four tile centres around it, with
+    // OpenCV's weights and operation order. Between two tile centres the four
+    // tables are fixed, so the row is walked in spans of constant tables.
+    void blend(const uint8_t* src, uint8_t* dst, size_t height, size_t width, size_t tile_w, size_t tile_h,
+               const std::vector<uint8_t>& luts) const {
+        const float inv_tw = 1.0f / static_cast<float>(tile_w);
+        const float inv_th = 1.0f / static_cast<float>(tile_h);
+        std::vector<float> wx(width);
+        std::vector<BlendSpan> spans;
+        for (size_t x = 0; x < width; ++x) {
+            const float txf = static_cast<float>(x) * inv_tw - 0.5f;
+            const int tx1 = static_cast<int>(std::floor(txf));
+            wx[x] = txf - static_cast<float>(tx1);
+            const int left = std::max(tx1, 0);
+            const int right = std::min(tx1 + 1, tiles_x_ - 1);
+            if (spans.empty() || spans.back().left != left || spans.back().right != right) {
+                spans.push_back({x, x, left, right});
+            }
+            spans.back().end = x + 1;
+        }
+
+        parallel_bands(height, 16, threads_, [&](size_t begin, size_t end) {
+            for (size_t y = begin; y < end; ++y) {
+                const float tyf = static_cast<float>(y) * inv_th - 0.5f;
+                const int ty1 = static_cast<int>(std::floor(tyf));
+                const float wy = tyf - static_cast<float>(ty1);
+                const uint8_t* top = luts.data() + 256 * tiles_x_ * std::max(ty1, 0);
+                const uint8_t* bottom = luts.data() + 256 * tiles_x_ * std::min(ty1 + 1, tiles_y_ - 1);
+                for (const BlendSpan& span : spans) {
+                    blend_span(src + y * width, dst + y * width, wx.data(), span, wy,
+                               {top + 256 * span.left, top + 256 * span.right,
+                                bottom + 256 * span.left, bottom + 256 * span.right});
+                }
+            }
+        });
+    }
+
+    // corners: top-left, top-right, bottom-left, bottom-right tile tables
+    static void blend_span(const uint8_t* in, uint8_t* out, const float* wx, const BlendSpan& span, float wy,
+                           const std::array<const uint8_t*, 4>& corners) {
+        const float wy1 = 1.0f - wy;
+        size_t x = span.begin;
+#if defined(__AVX512VBMI__)
+        // The four lookups are vpermi2b on 64 pixels, then the scalar loop's
+        // float math 16 lanes at a time; a masked final step covers the rest
+        // of the span. Products and sums are rounded separately in both paths
+        // (the target builds with -ffp-contract=off), so they agree exactly.
+        const LutRegisters tables[4] = {LutRegisters(corners[0]), LutRegisters(corners[1]),
+                                        LutRegisters(corners[2]), LutRegisters(corners[3])};
+        const __m512 one = _mm512_set1_ps(1.0f);
+        const __m512 wy_v = _mm512_set1_ps(wy);
+        const __m512 wy1_v = _mm512_set1_ps(wy1);
+        for (; x < span.end; x += 64) {
+            const __mmask64 live = span.end - x >= 64 ? ~__mmask64{0} : (__mmask64{1} << (span.end - x)) - 1;
+            const __m512i v = _mm512_maskz_loadu_epi8(live, in + x);
+            __m512i corner[4];
+            for (int k = 0; k < 4; ++k) corner[k] = lookup256(tables[k], v);
+
+            // Pixels 16*G .. 16*G+15 of the 64 (G must be a constant for extracti32x4)
+            __m512i result = _mm512_setzero_si512();
+            auto quarter = [&]<int G>(std::integral_constant<int, G>) {
+                auto lanes = [](__m512i bytes) {
+                    return _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(bytes, G)));
+                };
+                const __m512 w = _mm512_maskz_loadu_ps(static_cast<__mmask16>(live >> (16 * G)), wx + x + 16 * G);
+                const __m512 w1 = _mm512_sub_ps(one, w);
+                const __m512 top =
+                    _mm512_add_ps(_mm512_mul_ps(lanes(corner[0]), w1), _mm512_mul_ps(lanes(corner[1]), w));
+                const __m512 bottom =
+                    _mm512_add_ps(_mm512_mul_ps(lanes(corner[2]), w1), _mm512_mul_ps(lanes(corner[3]), w));
+                const __m512 value = _mm512_add_ps(_mm512_mul_ps(top, wy1_v), _mm512_mul_ps(bottom, wy_v));
+                // cvtps rounds half to even, like std::rint below
+                result = _mm512_inserti32x4(result, _mm512_cvtusepi32_epi8(_mm512_cvtps_epi32(value)), G);
+            };
+            quarter(std::integral_constant<int, 0>{});
+            quarter(std::integral_constant<int, 1>{});
+            quarter(std::integral_constant<int, 2>{});
+            quarter(std::integral_constant<int, 3>{});
+            _mm512_mask_storeu_epi8(out + x, live, result);
+        }
+#endif
+        for (; x < span.end; ++x) {
+            const uint8_t v = in[x];
+            const float w = wx[x];
+            const float w1 = 1.0f - w;
+            const float value =
+                (corners[0][v] * w1 + corners[1][v] * w) * wy1 + (corners[2][v] * w1 + corners[3][v] * w) * wy;
+            out[x] = static_cast<uint8_t>(std::rint(value));  // value is in [0, 255]
+        }
+    }
+
+    double clip_limit_;
+    int tiles_x_;
+    int tiles_y_;
+    int threads_;
+};
+
+// Per-kernel time for one width x height frame, in microseconds (best of
+// `iterations`), with buffers allocated once: the kernels alone
+nb::dict benchmark_lut_kernels(size_t width, size_t height, int iterations) {
+    if (width == 0 || height == 0 || iterations < 1) {
+        throw std::invalid_argument("width, height and iterations must be positive");
+    }
+    const size_t n = width * height;
+    std::vector<uint8_t> bgr(n * 3), gray(n), out(n);
+    uint32_t state = 12345;
+    for (auto& v : bgr) v = static_cast<uint8_t>((state = state * 1664525u + 1013904223u) >> 24);
+    grayscale_simd(bgr.data(), gray.data(), n);
+    const Lut custom = make_gamma_lut_runtime(1.8);
+
+    auto best_us = [&](auto&& kernel) {
+        double best = 1e300;
+        for (int it = 0; it < iterations; ++it) {
+            auto start = std::chrono::high_resolution_clock::now();
+            kernel();
+            auto end = std::chrono::high_resolution_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::micro>(end - start).count());
+        }
+        return best;
+    };
+    double timings[4];
+    {
+        nb::gil_scoped_release release;
+        timings[0] = best_us([&] { grayscale_lut(bgr.data(), out.data(), n); });
+        timings[1] = best_us([&] { grayscale_simd(bgr.data(), out.data(), n); });
+        timings[2] = best_us([&] { gamma_lut(gray.data(), out.data(), n, custom); });
+        timings[3] = best_us([&] { apply_lut_simd(gray.data(), out.data(), n, custom); });
+    }
+    nb::dict r;
+    r["grayscale_lut"] = timings[0];
+    r["grayscale_simd"] = timings[1];
+    r["gamma_lut"] = timings[2];
+    r["lut_simd"] = timings[3];
+    return r;
+}
+
+// ---------------------------------------------------------------------------
+// Array helpers for the SIMD bindings
+// ---------------------------------------------------------------------------
+using ByteInput = nb::ndarray<const uint8_t, nb::c_contig, nb::device::cpu>;
+using ByteOutput = nb::ndarray<uint8_t, nb::c_contig, nb::device::cpu>;
+using GrayInput = nb::ndarray<const uint8_t, nb::shape<-1, -1, 3>, nb::c_contig, nb::device::cpu>;
+using LutInput = nb::ndarray<const uint8_t, nb::shape<256>, nb::c_contig, nb::device::cpu>;
+using PlaneInput = nb::ndarray<const uint8_t, nb::ndim<2>, nb::c_contig, nb::device::cpu>;
+
+static std::vector<size_t> shape_of(const ByteInput& a) {
+    std::vector<size_t> shape(a.ndim());
+    for (size_t d = 0; d < a.ndim(); ++d) shape[d] = a.shape(d);
+    return shape;
+}
+
+static void require_same_shape(const ByteInput& in, const ByteOutput& out) {
+    bool same = in.ndim() == out.ndim();
+    for (size_t d = 0; same && d < in.ndim(); ++d) same = in.shape(d) == out.shape(d);
+    if (!same) throw std::invalid_argument("out must be a C-contiguous uint8 array with the input's shape");
+}
+
+static Lut copy_lut(const LutInput& lut) {
+    Lut table;
+    std::copy(lut.data(), lut.data() + 256, table.begin());
+    return table;
+}
+
+// A 3-channel chain needs interleaved pixels: the last axis must be 3
+static void require_chain_layout(const LutChain& chain, const ByteInput& image) {
+    if (chain.channels() == 3 && (image.ndim() == 0 || image.shape(image.ndim() - 1) != 3)) {
+        throw std::invalid_argument("a 3-channel LutChain needs an image whose last axis is 3");
+    }
+}
+
+// A new numpy uint8 array of `shape`, and a pointer to fill it through
+static std::pair<nb::ndarray<nb::numpy, uint8_t>, uint8_t*> new_image(const std::vector<size_t>& shape) {
+    size_t n = 1;
+    for (size_t s : shape) n *= s;
+    auto* data = new uint8_t[n];
+    nb::capsule owner(data, [](void* p) noexcept { delete[] static_cast<uint8_t*>(p); });
+    return {nb::ndarray<nb::numpy, uint8_t>(data, shape.size(), shape.data(), owner), data};
+}
+
 // ---------------------------------------------------------------------------
 // Nanobind bindings
 // ---------------------------------------------------------------------------
 NB_MODULE(compile_time_lut, m) {
-    m.doc() = "Compile-time LUT generation for grayscale and gamma correction";
+    m.doc() = "Compile-time LUT generation for grayscale and gamma correction, with SIMD kernels";
 
     // --- Apply grayscale LUT to a BGR numpy array, return grayscale array ---
     m.def("apply_grayscale_lut", [](nb::ndarray<uint8_t, nb::ndim<3>> bgr_arr)
@@ -259,4 +1033,209 @@ NB_MODULE(compile_time_lut, m) {
         throw std::invalid_argument("Only precomputed gamma values (0.45, 2.2, 1.0) available");
     }, nb::arg("intensity"), nb::arg("gamma"),
     "Get a single value from a compile-time gamma LUT");
+
+    // --- SIMD kernels ---
+    m.def("apply_grayscale_simd", [](GrayInput bgr) -> nb::ndarray<nb::numpy, uint8_t> {
+        auto [out, dst] = new_image({bgr.shape(0), bgr.shape(1)});
+        {
+            nb::gil_scoped_release release;
+            grayscale_simd(bgr.data(), dst, bgr.shape(0) * bgr.shape(1));
+        }
+        return out;
+    }, nb::arg("bgr"), "BGR -> grayscale with fixed-point BT.601 weights, 32 pixels per AVX2 step");
+
+    m.def("apply_grayscale_simd_into", [](GrayInput bgr, ByteOutput out) {
+        if (out.ndim() != 2 || out.shape(0) != bgr.shape(0) || out.shape(1) != bgr.shape(1)) {
+            throw std::invalid_argument("out must be a C-contiguous uint8 array of shape (H, W)");
+        }
+        nb::gil_scoped_release release;
+        grayscale_simd(bgr.data(), out.data(), bgr.shape(0) * bgr.shape(1));
+    }, nb::arg("bgr"), nb::arg("out").noconvert(), "apply_grayscale_simd into a preallocated (H, W) array");
+
+    m.def("apply_lut", [](ByteInput image, LutInput lut) -> nb::ndarray<nb::numpy, uint8_t> {
+        const Lut table = copy_lut(lut);
+        auto [out, dst] = new_image(shape_of(image));
+        {
+            nb::gil_scoped_release release;
+            apply_lut_simd(image.data(), dst, image.size(), table);
+        }
+        return out;
+    }, nb::arg("image"), nb::arg("lut"), "Map every byte of a uint8 array through a 256-entry uint8 table (SIMD)");
+
+    m.def("apply_lut_into", [](ByteInput image, LutInput lut, ByteOutput out) {
+        require_same_shape(image, out);
+        const Lut table = copy_lut(lut);
+        nb::gil_scoped_release release;
+        apply_lut_simd(image.data(), out.data(), image.size(), table);
+    }, nb::arg("image"), nb::arg("lut"), nb::arg("out").noconvert(), "apply_lut into a preallocated array");
+
+    m.def("apply_gamma_simd", [](ByteInput image, double gamma) -> nb::ndarray<nb::numpy, uint8_t> {
+        std::shared_ptr<const Lut> lut = GammaLutCache::instance().get(gamma);
+        auto [out, dst] = new_image(shape_of(image));
+        {
+            nb::gil_scoped_release release;
+            apply_lut_simd(image.data(), dst, image.size(), *lut);
+        }
+        return out;
+    }, nb::arg("image"), nb::arg("gamma"),
+    "Gamma correction for any gamma: cached runtime LUT + SIMD lookup (matches apply_gamma_runtime)");
+
+    m.def("apply_gamma_simd_into", [](ByteInput image, double gamma, ByteOutput out) {
+        require_same_shape(image, out);
+        std::shared_ptr<const Lut> lut = GammaLutCache::instance().get(gamma);
+        nb::gil_scoped_release release;
+        apply_lut_simd(image.data(), out.data(), image.size(), *lut);
+    }, nb::arg("image"), nb::arg("gamma"), nb::arg("out").noconvert(), "apply_gamma_simd into a preallocated array");
+
+    m.def("gamma_lut", [](double gamma) -> nb::ndarray<nb::numpy, uint8_t> {
+        std::shared_ptr<const Lut> lut = GammaLutCache::instance().get(gamma);
+        auto [out, dst] = new_image({256});
+        std::copy(lut->begin(), lut->end(), dst);
+        return out;
+    }, nb::arg("gamma"), "The cached 256-entry gamma table for `gamma` (built on first use)");
+
+    m.def("lut_cache_info", [] {
+        auto [size, hits, misses] = GammaLutCache::instance().info();
+        nb::dict d;
+        d["size"] = size;
+        d["hits"] = hits;
+        d["misses"] = misses;
+        d["max_size"] = GammaLutCache::kMaxEntries;
+        return d;
+    }, "Runtime gamma LUT cache: tables held, hits, misses");
+    m.def("clear_lut_cache", [] { GammaLutCache::instance().clear(); });
+
+    // --- LUT composition ---
+    m.def("photometric_lut", [] {
+        auto [out, dst] = new_image({256});
+        std::copy(PHOTOMETRIC_LUT.begin(), PHOTOMETRIC_LUT.end(), dst);
+        return out;
+    }, "The compile-time composed gamma(0.45) -> contrast(16, 235) -> brightness(+10) -> invert table");
+
+    m.def("apply_photometric", [](ByteInput image) -> nb::ndarray<nb::numpy, uint8_t> {
+        auto [out, dst] = new_image(shape_of(image));
+        {
+            nb::gil_scoped_release release;
+            apply_lut_simd(image.data(), dst, image.size(), PHOTOMETRIC_LUT);
+        }
+        return out;
+    }, nb::arg("image"), "Apply the static photometric chain in one SIMD pass");
+
+    m.def("apply_photometric_into", [](ByteInput image, ByteOutput out) {
+        require_same_shape(image, out);
+        nb::gil_scoped_release release;
+        apply_lut_simd(image.data(), out.data(), image.size(), PHOTOMETRIC_LUT);
+    }, nb::arg("image"), nb::arg("out").noconvert(), "apply_photometric into a preallocated array");
+
+    nb::class_<LutChain>(m, "LutChain",
+        "Chain of uint8 point ops composed into one table (or one per channel) as they are added")
+        .def(nb::init<int>(), nb::arg("channels") = 1)
+        .def("gamma", &LutChain::gamma, nb::arg("gamma"), nb::arg("channel") = -1, nb::rv_policy::reference)
+        .def("contrast_stretch", &LutChain::contrast_stretch, nb::arg("lo"), nb::arg("hi"), nb::arg("channel") = -1,
+             nb::rv_policy::reference)
+        .def("brightness", &LutChain::brightness, nb::arg("delta"), nb::arg("channel") = -1, nb::rv_policy::reference)
+        .def("invert", &LutChain::invert, nb::arg("channel") = -1, nb::rv_policy::reference)
+        .def("lut", [](LutChain& chain, LutInput table, int channel) -> LutChain& {
+            return chain.lut(copy_lut(table), channel);
+        }, nb::arg("table"), nb::arg("channel") = -1, nb::rv_policy::reference)
+        .def("then", &LutChain::then, nb::arg("other"), nb::rv_policy::reference)
+        .def_prop_ro("channels", &LutChain::channels)
+        .def("__len__", &LutChain::length)
+        .def_prop_ro("table", [](const LutChain& chain) {
+            // (256,) for one channel, (3, 256) with one row per channel
+            std::vector<size_t> shape = chain.channels() == 1 ? std::vector<size_t>{256}
+                                                              : std::vector<size_t>{3, 256};
+            auto [out, dst] = new_image(shape);
+            for (int c = 0; c < chain.channels(); ++c) std::copy_n(chain.table(c).begin(), 256, dst + 256 * c);
+            return out;
+        })
+        .def("apply", [](const LutChain& chain, ByteInput image) -> nb::ndarray<nb::numpy, uint8_t> {
+            require_chain_layout(chain, image);
+            auto [out, dst] = new_image(shape_of(image));
+            {
+                nb::gil_scoped_release release;
+                chain.apply(image.data(), dst, image.size());
+            }
+            return out;
+        }, nb::arg("image"), "Apply the whole chain in one pass")
+        .def("apply_into", [](const LutChain& chain, ByteInput image, ByteOutput out) {
+            require_chain_layout(chain, image);
+            require_same_shape(image, out);
+            nb::gil_scoped_release release;
+            chain.apply(image.data(), out.data(), image.size());
+        }, nb::arg("image"), nb::arg("out").noconvert(), "apply into a preallocated array")
+        .def("__repr__", [](const LutChain& chain) {
+            return "LutChain(channels=" + std::to_string(chain.channels()) + ", ops=" +
+                   std::to_string(chain.length()) + ")";
+        });
+
+    // --- Histograms, equalization, CLAHE ---
+    m.def("histogram", [](ByteInput image, int threads) {
+        Histogram hist;
+        {
+            nb::gil_scoped_release release;
+            hist = histogram_parallel(image.data(), image.size(), threads);
+        }
+        auto* data = new uint64_t[256];
+        std::copy(hist.begin(), hist.end(), data);
+        nb::capsule owner(data, [](void* p) noexcept { delete[] static_cast<uint64_t*>(p); });
+        size_t shape[1] = {256};
+        return nb::ndarray<nb::numpy, uint64_t>(data, 1, shape, owner);
+    }, nb::arg("image"), nb::arg("threads") = 0,
+    "256-bin histogram of a uint8 array using per-thread sub-histograms (threads=0: all allowed CPUs)");
+
+    m.def("equalization_lut", [](ByteInput image, int threads) {
+        Lut lut;
+        {
+            nb::gil_scoped_release release;
+            lut = equalization_lut(histogram_parallel(image.data(), image.size(), threads));
+        }
+        auto [out, dst] = new_image({256});
+        std::copy(lut.begin(), lut.end(), dst);
+        return out;
+    }, nb::arg("image"), nb::arg("threads") = 0,
+    "The histogram-equalization table for `image`, e.g. to append to a LutChain");
+
+    m.def("equalize_hist", [](ByteInput image, int threads) -> nb::ndarray<nb::numpy, uint8_t> {
+        auto [out, dst] = new_image(shape_of(image));
+        {
+            nb::gil_scoped_release release;
+            equalize_parallel(image.data(), dst, image.size(), threads);
+        }
+        return out;
+    }, nb::arg("image"), nb::arg("threads") = 0, "Global histogram equalization (same table as cv2.equalizeHist)");
+
+    m.def("equalize_hist_into", [](ByteInput image, ByteOutput out, int threads) {
+        require_same_shape(image, out);
+        nb::gil_scoped_release release;
+        equalize_parallel(image.data(), out.data(), image.size(), threads);
+    }, nb::arg("image"), nb::arg("out").noconvert(), nb::arg("threads") = 0,
+    "equalize_hist into a preallocated array");
+
+    nb::class_<Clahe>(m, "Clahe",
+        "Contrast-limited adaptive histogram equalization; same parameters as cv2.createCLAHE")
+        .def(nb::init<double, std::pair<int, int>, int>(), nb::arg("clip_limit") = 40.0, nb::arg("tile_grid") = std::pair<int, int>{8, 8}, nb::arg("threads") = 0)
+        .def("apply", [](const Clahe& clahe, PlaneInput gray) -> nb::ndarray<nb::numpy, uint8_t> {
+            auto [out, dst] = new_image({gray.shape(0), gray.shape(1)});
+            {
+                nb::gil_scoped_release release;
+                clahe.apply(gray.data(), dst, gray.shape(0), gray.shape(1));
+            }
+            return out;
+        }, nb::arg("gray"), "CLAHE on an (H, W) uint8 image")
+        .def("apply_into", [](const Clahe& clahe, PlaneInput gray, ByteOutput out) {
+            if (out.ndim() != 2 || out.shape(0) != gray.shape(0) || out.shape(1) != gray.shape(1)) {
+                throw std::invalid_argument("out must be a C-contiguous uint8 array of shape (H, W)");
+            }
+            nb::gil_scoped_release release;
+            clahe.apply(gray.data(), out.data(), gray.shape(0), gray.shape(1));
+        }, nb::arg("gray"), nb::arg("out").noconvert(), "apply into a preallocated (H, W) array")
+        .def_prop_ro("clip_limit", &Clahe::clip_limit)
+        .def_prop_ro("tile_grid", &Clahe::tile_grid)
+        .def_prop_ro("threads", &Clahe::threads);
+
+    m.def("simd_level", &simd_level, "Vector path the SIMD kernels were compiled with");
+    m.def("benchmark_lut_kernels", &benchmark_lut_kernels,
+          nb::arg("width") = 3840, nb::arg("height") = 2160, nb::arg("iterations") = 20,
+          "Best-of-N microseconds per frame for grayscale_lut, grayscale_simd, gamma_lut and lut_simd");
 }
@@ -1,15 +1,240 @@
 #include <nanobind/nanobind.h>
+#include <nanobind/ndarray.h>
 #include <nanobind/stl/optional.h>
 #include <nanobind/stl/string.h>
 #include <nanobind/stl/tuple.h>
+#include <algorithm>
+#include <array>
+#include <cerrno>
 #include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <optional>
+#include <span>
+#include <stdexcept>
 #include <string>
 #include <tuple>
+#include <utility>
 #include <variant>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace nb = nanobind;
 
+// ===========================================================================
+// Event log: compact binary records of every update, for deterministic replay
+// ===========================================================================
+//
+// When a track flips to lost or search in production, the inputs that led
+// there are gone. A machine attached to an EventLog (record_to) appends one
+// 32-byte record per update: frame index, track, event, detection box and
+// the state it moved to. The log is a preallocated ring, in memory or in an
+// mmap'd file that outlives the process, so an append is a few stores and
+// never allocates. replay() runs a log back through any implementation below
+// and reports where its states differ from the recorded ones.
+
+enum TrackerEvent : uint8_t { kEventDetect = 0, kEventMiss = 1 };
+
+// State codes shared by every tracker machine in this file
+constexpr const char* kTrackerStateNames[] = {"idle", "tracking", "lost", "search"};
+
+struct EventRecord {
+    uint32_t frame;        // updates since record_to()
+    uint32_t track;
+    uint8_t event;         // TrackerEvent
+    uint8_t state;         // state after the update (index into kTrackerStateNames)
+    uint16_t reserved;
+    int32_t lost_frames;   // after the update
+    float x, y, w, h;      // detection box, zeros on a miss
+};
+static_assert(sizeof(EventRecord) == 32);
+
+// File layout: this header, then `capacity` records. `total` is rewritten on
+// every append, so a log left behind by a crashed process still reads back.
+struct EventLogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t capacity;
+    uint64_t total;        // records ever appended; the ring keeps the last min(total, capacity)
+    uint8_t reserved[32];
+};
+static_assert(sizeof(EventLogHeader) == 64);
+
+constexpr char kEventLogMagic[8] = {'S', 'M', 'E', 'V', 'L', 'O', 'G', '\0'};
+constexpr uint32_t kEventLogVersion = 1;
+constexpr size_t kMaxLogRecords = size_t{1} << 32;
+
+class EventLog {
+public:
+    // In-memory ring, or a file at `path` (created or truncated) that keeps
+    // the records after the process exits
+    explicit EventLog(size_t capacity, std::optional<std::string> path = std::nullopt) {
+        if (capacity == 0 || capacity > kMaxLogRecords) {
+            throw std::invalid_argument("capacity must be in [1, 2^32]");
+        }
+        bytes_ = sizeof(EventLogHeader) + capacity * sizeof(EventRecord);
+        void* base;
+        if (path) {
+            int fd = ::open(path->c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0) throw std::runtime_error("open(" + *path + ") failed: " + std::strerror(errno));
+            if (::ftruncate(fd, static_cast<off_t>(bytes_)) != 0) {
+                int err = errno;
+                ::close(fd);
+                throw std::runtime_error("ftruncate(" + *path + ") failed: " + std::strerror(err));
+            }
+            base = ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+        } else {
+            base = ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        }
+        if (base == MAP_FAILED) throw std::bad_alloc();
+        attach(base, true, std::move(path));
+        header_->version = kEventLogVersion;
+        header_->record_size = sizeof(EventRecord);
+        header_->capacity = capacity;
+        header_->total = 0;
+        std::memcpy(header_->magic, kEventLogMagic, sizeof(kEventLogMagic));  // valid from here on
+    }
+
+    // Map a log file written by another process, read-only, for replay
+    static EventLog open(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw std::runtime_error("open(" + path + ") failed: " + std::strerror(errno));
+        struct stat st {};
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(EventLogHeader)) {
+            ::close(fd);
+            throw std::runtime_error(path + " is not an event log (too small)");
+        }
+        const size_t bytes = static_cast<size_t>(st.st_size);
+        void* base = ::mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) throw std::runtime_error("mmap(" + path + ") failed: " + std::strerror(errno));
+
+        EventLog log;
+        log.bytes_ = bytes;
+        log.attach(base, false, path);
+        const EventLogHeader& h = *log.header_;
+        if (std::memcmp(h.magic, kEventLogMagic, sizeof(kEventLogMagic)) != 0) {
+            throw std::runtime_error(path + " is not an event log (bad magic)");
+        }
+        if (h.version != kEventLogVersion || h.record_size != sizeof(EventRecord)) {
+            throw std::runtime_error(path + ": unsupported event log version " + std::to_string(h.version));
+        }
+        if (h.capacity == 0 || h.capacity > (bytes - sizeof(EventLogHeader)) / sizeof(EventRecord)) {
+            throw std::runtime_error(path + " is truncated");
+        }
+        log.capacity_ = h.capacity;
+        log.next_ = h.total % h.capacity;
+        return log;
+    }
+
+    EventLog(EventLog&& other) noexcept { *this = std::move(other); }
+    EventLog& operator=(EventLog&& other) noexcept {
+        std::swap(base_, other.base_);
+        std::swap(bytes_, other.bytes_);
+        std::swap(header_, other.header_);
+        std::swap(records_, other.records_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(next_, other.next_);
+        std::swap(writable_, other.writable_);
+        std::swap(path_, other.path_);
+        return *this;
+    }
+    EventLog(const EventLog&) = delete;
+    EventLog& operator=(const EventLog&) = delete;
+
+    ~EventLog() {
+        if (base_) ::munmap(base_, bytes_);
+    }
+
+    // Hot path: one 32-byte store and a counter bump. Callers check
+    // writable() once, when they attach, not per record
+    void append(const EventRecord& r) {
+        records_[next_] = r;
+        next_ = next_ + 1 == capacity_ ? 0 : next_ + 1;
+        ++header_->total;
+    }
+
+    // Records from oldest to newest, as (up to) two contiguous runs of the ring
+    [[nodiscard]] std::array<std::span<const EventRecord>, 2> runs() const {
+        if (header_->total <= capacity_) return {{{records_, header_->total}, {}}};
+        return {{{records_ + next_, capacity_ - next_}, {records_, next_}}};
+    }
+
+    void clear() {
+        require_writable();
+        header_->total = 0;
+        next_ = 0;
+    }
+
+    // Push a file-backed log to disk (msync); no-op for an in-memory log
+    void flush() const {
+        if (path_ && writable_ && ::msync(base_, bytes_, MS_SYNC) != 0) {
+            throw std::runtime_error("msync(" + *path_ + ") failed: " + std::strerror(errno));
+        }
+    }
+
+    void require_writable() const {
+        if (!writable_) throw std::invalid_argument("event log is read-only (opened with EventLog.open)");
+    }
+
+    [[nodiscard]] size_t size() const { return std::min<uint64_t>(header_->total, capacity_); }
+    [[nodiscard]] uint64_t total() const { return header_->total; }
+    [[nodiscard]] uint64_t dropped() const { return header_->total - size(); }
+    [[nodiscard]] size_t capacity() const { return capacity_; }
+    [[nodiscard]] bool writable() const { return writable_; }
+    [[nodiscard]] std::optional<std::string> path() const { return path_; }
+
+private:
+    EventLog() = default;
+
+    void attach(void* base, bool writable, std::optional<std::string> path) {
+        base_ = base;
+        header_ = static_cast<EventLogHeader*>(base);
+        records_ = reinterpret_cast<EventRecord*>(static_cast<uint8_t*>(base) + sizeof(EventLogHeader));
+        capacity_ = (bytes_ - sizeof(EventLogHeader)) / sizeof(EventRecord);
+        writable_ = writable;
+        path_ = std::move(path);
+    }
+
+    void* base_ = nullptr;
+    size_t bytes_ = 0;
+    EventLogHeader* header_ = nullptr;
+    EventRecord* records_ = nullptr;
+    size_t capacity_ = 0;
+    size_t next_ = 0;  // ring slot of the next append
+    bool writable_ = false;
+    std::optional<std::string> path_;
+};
+
+// Attachment point shared by the machines below: record_to() validates the
+// log once, so each update only tests one pointer before appending
+struct EventRecorder {
+    EventLog* log = nullptr;
+    uint32_t track = 0;
+    uint32_t frame = 0;
+
+    void attach(EventLog* target, uint32_t track_id) {
+        if (target) target->require_writable();
+        log = target;
+        track = track_id;
+        frame = 0;
+    }
+
+    void record(bool has_detection, uint8_t state, int32_t lost_frames,
+                float x, float y, float w, float h) {
+        if (!log) return;
+        const bool det = has_detection;
+        log->append(EventRecord{frame++, track, det ? kEventDetect : kEventMiss, state, 0, lost_frames,
+                                det ? x : 0.0f, det ? y : 0.0f, det ? w : 0.0f, det ? h : 0.0f});
+    }
+};
+
 // ===========================================================================
 // "BEFORE": String-based state machine (mirrors tracker_engine pattern)
 // ===========================================================================
@@ -51,13 +276,26 @@ public:
             }
             // else: stay in search
         }
+        recorder_.record(has_detection, state_code(), lost_frames_, det_x, det_y, det_w, det_h);
     }
 
     [[nodiscard]] std::string state() const { return state_; }
     [[nodiscard]] int lost_frames() const { return lost_frames_; }
     [[nodiscard]] std::tuple<float, float, float, float> target() const { return target_; }
 
+    // Index into kTrackerStateNames (one more string compare chain)
+    [[nodiscard]] uint8_t state_code() const {
+        if (state_ == "idle") return 0;
+        if (state_ == "tracking") return 1;
+        if (state_ == "lost") return 2;
+        return 3;
+    }
+
+    // Append every update to `log` (nullptr stops recording)
+    void record_to(EventLog* log, uint32_t track) { recorder_.attach(log, track); }
+
 private:
+    EventRecorder recorder_;
     std::string state_;
     int lost_frames_;
     std::tuple<float, float, float, float> target_{0, 0, 0, 0};
@@ -114,6 +352,7 @@ public:
                 return Search{s.last_known};
             }
         }, state_);
+        recorder_.record(has_detection, state_code(), lost_frames(), det_x, det_y, det_w, det_h);
     }
 
     [[nodiscard]] std::string state() const {
@@ -149,10 +388,616 @@ public:
         }, state_);
     }
 
+    // The variant's alternatives are declared in kTrackerStateNames order
+    [[nodiscard]] uint8_t state_code() const { return static_cast<uint8_t>(state_.index()); }
+
+    void record_to(EventLog* log, uint32_t track) { recorder_.attach(log, track); }
+
 private:
     TrackerState state_;
+    EventRecorder recorder_;
 };
 
+// ===========================================================================
+// "BATCHED": one StateMachineBank call advances every track (SoA)
+// ===========================================================================
+//
+// With 1,000+ tracks, one VariantStateMachine per track means 1,000+ Python
+// calls per frame, and each call costs far more than the transition itself.
+// The bank keeps each field as its own column: state codes as uint8, lost
+// counters as int32, and the last box as four float columns. One update()
+// call advances every track. The transition is written as selects instead
+// of branches, so the compiler vectorizes the loop. It follows the same
+// rules as VariantStateMachine, with the lost -> search threshold as a
+// runtime parameter.
+
+enum BankState : uint8_t { kIdle = 0, kTracking = 1, kLost = 2, kSearch = 3 };
+enum BankEvent : uint8_t { kNoEvent = 0, kAcquired = 1, kReacquired = 2, kLostEvent = 3, kSearchEvent = 4 };
+
+constexpr const char* kBankStateNames[] = {"idle", "tracking", "lost", "search"};
+
+// Advance tracks [0, n) by one frame. has_detection holds one 0/1 byte per
+// track (numpy bool), boxes is (n, 4) row-major, and events[i] receives the
+// BankEvent for track i (kNoEvent if its state did not change).
+//
+// Every loop vectorizes at -O3. Two things matter for that: the detection
+// flags are read as bytes, not bool (GCC will not vectorize a select on a
+// bool load), and the boxes are updated in their own loops, apart from the
+// state update.
+static void bank_step(size_t n, const uint8_t* __restrict has_detection, const float* __restrict boxes,
+                      int32_t lost_to_search, uint8_t* __restrict state, int32_t* __restrict lost_frames,
+                      float* __restrict bx, float* __restrict by, float* __restrict bw, float* __restrict bh,
+                      uint8_t* __restrict events) {
+    // The state codes are ordered so that each step is arithmetic:
+    // tracking + 1 = lost and lost + 1 = search, and the event code of a
+    // transition into lost/search/tracking is the new state + 1
+    static_assert(kTracking + 1 == kLost && kLost + 1 == kSearch);
+    static_assert(kLost + 1 == kLostEvent && kSearch + 1 == kSearchEvent && kTracking + 1 == kReacquired);
+
+    // Pass 1 (int32): which tracks have been lost long enough to search.
+    // events is scratch space until pass 2 overwrites it
+    for (size_t i = 0; i < n; ++i) {
+        events[i] = uint8_t(lost_frames[i] >= lost_to_search);
+    }
+    // Pass 2 (uint8): the transition. All math stays byte-wide, with masks
+    // instead of ?:, so one SSE2 step covers 16 tracks; mixing in the int32
+    // counter here makes GCC widen everything to 4 tracks per step
+    for (size_t i = 0; i < n; ++i) {
+        const uint8_t s = state[i];
+        const uint8_t det = has_detection[i] != 0;
+        const uint8_t miss = uint8_t(s + uint8_t(s == kTracking) + (uint8_t(s == kLost) & events[i]));
+        // det ? kTracking : miss (det - 1 is 0x00 or 0xff)
+        const uint8_t next = uint8_t((miss & uint8_t(det - 1)) | det);
+        // idle -> tracking is "acquired", one below the generic next + 1
+        const uint8_t ev = uint8_t(next + 1 - (det & uint8_t(s == kIdle)));
+        events[i] = uint8_t(ev & uint8_t(-uint8_t(next != s)));
+        state[i] = next;
+    }
+    // Pass 3 (int32): frames spent in lost
+    for (size_t i = 0; i < n; ++i) {
+        lost_frames[i] = state[i] == kLost ? lost_frames[i] + 1 : 0;
+    }
+    // One pass per box column: a single loop writing all four columns does
+    // not vectorize with GCC 12, four strided passes do
+    float* const columns[4] = {bx, by, bw, bh};
+    for (size_t c = 0; c < 4; ++c) {
+        float* __restrict col = columns[c];
+        for (size_t i = 0; i < n; ++i) {
+            // Load both sides first so the select is a blend, not a masked load
+            const float fresh = boxes[4 * i + c];
+            const float kept = col[i];
+            col[i] = has_detection[i] != 0 ? fresh : kept;
+        }
+    }
+}
+
+class StateMachineBank {
+public:
+    explicit StateMachineBank(size_t n_tracks, int32_t lost_to_search = 30)
+        : lost_to_search_(lost_to_search),
+          state_(n_tracks, kIdle), lost_frames_(n_tracks, 0),
+          x_(n_tracks, 0.0f), y_(n_tracks, 0.0f), w_(n_tracks, 0.0f), h_(n_tracks, 0.0f),
+          events_(n_tracks, kNoEvent) {
+        if (n_tracks == 0) throw std::invalid_argument("n_tracks must be > 0");
+        if (lost_to_search < 1) throw std::invalid_argument("lost_to_search must be >= 1");
+    }
+
+    // Advance every track by one frame. Returns the tracks that changed state,
+    // as int64 index arrays keyed by event: "acquired" (idle -> tracking),
+    // "reacquired" (lost/search -> tracking), "lost" and "search".
+    nb::dict update(nb::ndarray<const bool, nb::ndim<1>, nb::c_contig, nb::device::cpu> has_detection,
+                    nb::ndarray<const float, nb::shape<-1, 4>, nb::c_contig, nb::device::cpu> boxes) {
+        const size_t n = state_.size();
+        if (has_detection.shape(0) != n || boxes.shape(0) != n) {
+            throw std::invalid_argument("has_detection and boxes must have one row per track (" +
+                                        std::to_string(n) + ")");
+        }
+        bank_step(n, reinterpret_cast<const uint8_t*>(has_detection.data()), boxes.data(), lost_to_search_,
+                  state_.data(), lost_frames_.data(), x_.data(), y_.data(), w_.data(), h_.data(),
+                  events_.data());
+        if (recorder_.log) record_frame(reinterpret_cast<const uint8_t*>(has_detection.data()), boxes.data());
+
+        // Transitions are rare next to "no change", so a scalar compaction pass is cheap
+        std::vector<int64_t> by_event[5];
+        for (size_t i = 0; i < n; ++i) {
+            if (events_[i] != kNoEvent) by_event[events_[i]].push_back(static_cast<int64_t>(i));
+        }
+        nb::dict out;
+        out["acquired"] = index_array(std::move(by_event[kAcquired]));
+        out["reacquired"] = index_array(std::move(by_event[kReacquired]));
+        out["lost"] = index_array(std::move(by_event[kLostEvent]));
+        out["search"] = index_array(std::move(by_event[kSearchEvent]));
+        return out;
+    }
+
+    // Return the given tracks to idle (e.g. when a track slot is reused for a new target)
+    void reset(nb::ndarray<const int64_t, nb::ndim<1>, nb::c_contig, nb::device::cpu> indices) {
+        const int64_t* idx = indices.data();
+        for (size_t k = 0; k < indices.shape(0); ++k) {
+            if (idx[k] < 0 || static_cast<size_t>(idx[k]) >= state_.size()) {
+                throw std::out_of_range("track index out of range");
+            }
+        }
+        for (size_t k = 0; k < indices.shape(0); ++k) {
+            size_t i = static_cast<size_t>(idx[k]);
+            state_[i] = kIdle;
+            lost_frames_[i] = 0;
+            x_[i] = y_[i] = w_[i] = h_[i] = 0.0f;
+        }
+    }
+
+    [[nodiscard]] nb::ndarray<nb::numpy, uint8_t, nb::ndim<1>> states() const { return copy_column(state_); }
+    [[nodiscard]] nb::ndarray<nb::numpy, int32_t, nb::ndim<1>> lost_frames() const { return copy_column(lost_frames_); }
+
+    // Last known box per track as (n, 4) float32: the current target while
+    // tracking, the last detection while lost or searching, zeros while idle
+    [[nodiscard]] nb::ndarray<nb::numpy, float, nb::ndim<2>> boxes() const {
+        const size_t n = state_.size();
+        float* out = new float[n * 4];
+        for (size_t i = 0; i < n; ++i) {
+            out[4 * i + 0] = x_[i];
+            out[4 * i + 1] = y_[i];
+            out[4 * i + 2] = w_[i];
+            out[4 * i + 3] = h_[i];
+        }
+        nb::capsule owner(out, [](void* p) noexcept { delete[] static_cast<float*>(p); });
+        size_t shape[2] = {n, 4};
+        return nb::ndarray<nb::numpy, float, nb::ndim<2>>(out, 2, shape, owner);
+    }
+
+    [[nodiscard]] std::string state(size_t index) const {
+        if (index >= state_.size()) throw std::out_of_range("track index out of range");
+        return kBankStateNames[state_[index]];
+    }
+
+    // Number of tracks in each state: (idle, tracking, lost, search)
+    [[nodiscard]] std::tuple<size_t, size_t, size_t, size_t> counts() const {
+        size_t c[4] = {0, 0, 0, 0};
+        for (uint8_t s : state_) ++c[s];
+        return {c[0], c[1], c[2], c[3]};
+    }
+
+    [[nodiscard]] size_t size() const { return state_.size(); }
+    [[nodiscard]] int32_t lost_to_search() const { return lost_to_search_; }
+
+    // For the C++ benchmark: advance one frame without building the event arrays
+    void step(const uint8_t* has_detection, const float* boxes) {
+        bank_step(state_.size(), has_detection, boxes, lost_to_search_,
+                  state_.data(), lost_frames_.data(), x_.data(), y_.data(), w_.data(), h_.data(),
+                  events_.data());
+    }
+
+    // Append one record per track on every update, with track = index
+    void record_to(EventLog* log) { recorder_.attach(log, 0); }
+
+private:
+    void record_frame(const uint8_t* has_detection, const float* boxes) {
+        const uint32_t frame = recorder_.frame++;
+        for (size_t i = 0; i < state_.size(); ++i) {
+            const bool det = has_detection[i] != 0;
+            const float* b = boxes + 4 * i;
+            recorder_.log->append(EventRecord{frame, static_cast<uint32_t>(i), det ? kEventDetect : kEventMiss,
+                                              state_[i], 0, lost_frames_[i],
+                                              det ? b[0] : 0.0f, det ? b[1] : 0.0f, det ? b[2] : 0.0f,
+                                              det ? b[3] : 0.0f});
+        }
+    }
+
+    template <typename T>
+    static nb::ndarray<nb::numpy, T, nb::ndim<1>> copy_column(const std::vector<T>& column) {
+        T* out = new T[column.size()];
+        std::copy(column.begin(), column.end(), out);
+        nb::capsule owner(out, [](void* p) noexcept { delete[] static_cast<T*>(p); });
+        size_t shape[1] = {column.size()};
+        return nb::ndarray<nb::numpy, T, nb::ndim<1>>(out, 1, shape, owner);
+    }
+
+    static nb::ndarray<nb::numpy, int64_t, nb::ndim<1>> index_array(std::vector<int64_t>&& indices) {
+        auto* owned = new std::vector<int64_t>(std::move(indices));
+        nb::capsule owner(owned, [](void* p) noexcept { delete static_cast<std::vector<int64_t>*>(p); });
+        size_t shape[1] = {owned->size()};
+        return nb::ndarray<nb::numpy, int64_t, nb::ndim<1>>(owned->data(), 1, shape, owner);
+    }
+
+    int32_t lost_to_search_;
+    std::vector<uint8_t> state_;
+    std::vector<int32_t> lost_frames_;
+    std::vector<float> x_, y_, w_, h_;
+    std::vector<uint8_t> events_;  // scratch: per-track event of the last update
+    EventRecorder recorder_;
+};
+
+// ===========================================================================
+// "DECLARATIVE": transition tables checked and compiled at compile time
+// ===========================================================================
+//
+// StringStateMachine, VariantStateMachine and the capstone StateMachine
+// each hand-code their transitions, with thresholds (30, 10) written into
+// the code. Here a machine is declared as data instead: a Spec lists its
+// states, events and rules, and TableMachine<Spec> compiles the rules into
+// a dense [state][event] table in a consteval function. A missing or
+// ambiguous (state, event) cell is a compile error, not a silent
+// fall-through.
+//
+// A rule may have a guard, "counter >= threshold[slot]". Thresholds are
+// runtime values, and checking one is a single compare in the cells that
+// have a guard: the table is expanded into a switch at compile time, so
+// each case knows its outcomes as constants, just like a hand-written
+// transition.
+
+// What a transition does to the per-machine counter (frames lost, frames in
+// state). Encoded as counter = counter * keep + add, so applying it needs no branch.
+enum class CounterOp : uint8_t { kKeep, kZero, kOne, kIncrement };
+
+inline constexpr uint8_t kUnguarded = 0xff;
+
+struct Rule {
+    uint8_t from;
+    uint8_t event;
+    uint8_t to;
+    CounterOp counter = CounterOp::kKeep;
+    bool store_box = false;          // take the event's box as the target
+    uint8_t guard = kUnguarded;      // threshold slot: only if counter >= threshold[guard]
+};
+
+struct TableOutcome {
+    uint8_t to;
+    uint8_t keep;       // 0 or 1
+    uint8_t add;        // 0 or 1
+    uint8_t store_box;  // 0 or 1
+};
+
+struct TableCell {
+    uint8_t slot;               // threshold compared against, or kUnguarded
+    TableOutcome outcome[2];    // [guard failed, guard passed]
+};
+
+// Build the dense [state][event] table from Spec::rules. Runs only at
+// compile time; every throw below turns into a compile error naming the
+// failed check.
+template <typename Spec>
+consteval std::array<TableCell, Spec::kStateCount * Spec::kEventCount> compile_table() {
+    constexpr size_t kStates = Spec::kStateCount;
+    constexpr size_t kEvents = Spec::kEventCount;
+    std::array<int, kStates * kEvents> fallback{};
+    std::array<int, kStates * kEvents> guarded{};
+    fallback.fill(-1);
+    guarded.fill(-1);
+
+    for (size_t r = 0; r < Spec::rules.size(); ++r) {
+        const Rule& rule = Spec::rules[r];
+        if (rule.from >= kStates || rule.to >= kStates) throw "rule names an unknown state";
+        if (rule.event >= kEvents) throw "rule names an unknown event";
+        const size_t cell = rule.from * kEvents + rule.event;
+        if (rule.guard == kUnguarded) {
+            if (fallback[cell] != -1) throw "two unguarded rules for one (state, event)";
+            fallback[cell] = static_cast<int>(r);
+        } else {
+            if (rule.guard >= Spec::kThresholdCount) throw "guard names an unknown threshold";
+            if (guarded[cell] != -1) throw "two guarded rules for one (state, event)";
+            guarded[cell] = static_cast<int>(r);
+        }
+    }
+
+    auto outcome = [](const Rule& rule) {
+        constexpr uint8_t kKeep[] = {1, 0, 0, 1};
+        constexpr uint8_t kAdd[] = {0, 0, 1, 1};
+        const auto op = static_cast<uint8_t>(rule.counter);
+        return TableOutcome{rule.to, kKeep[op], kAdd[op], static_cast<uint8_t>(rule.store_box)};
+    };
+
+    std::array<TableCell, kStates * kEvents> table{};
+    for (size_t cell = 0; cell < table.size(); ++cell) {
+        // Completeness: every (state, event) needs an unguarded rule, even if
+        // it only says "stay". The guarded rule, if any, is the exception to it
+        if (fallback[cell] == -1) throw "(state, event) pair without an unguarded rule";
+        const TableOutcome otherwise = outcome(Spec::rules[fallback[cell]]);
+        if (guarded[cell] == -1) {
+            table[cell] = TableCell{kUnguarded, {otherwise, otherwise}};
+        } else {
+            const Rule& g = Spec::rules[guarded[cell]];
+            table[cell] = TableCell{g.guard, {otherwise, outcome(g)}};
+        }
+    }
+    return table;
+}
+
+template <typename Spec>
+class TableMachine {
+public:
+    static constexpr size_t kEvents = Spec::kEventCount;
+    static constexpr auto kTable = compile_table<Spec>();
+
+    explicit TableMachine(const std::array<int32_t, Spec::kThresholdCount>& thresholds)
+        : thresholds_(thresholds) {}
+
+    uint8_t fire(uint8_t event, const BBox& box = {0, 0, 0, 0}) {
+        dispatch(state_ * kEvents + event, box, std::make_index_sequence<kTable.size()>{});
+        return state_;
+    }
+
+    [[nodiscard]] uint8_t state() const { return state_; }
+    [[nodiscard]] int32_t counter() const { return counter_; }
+    [[nodiscard]] const BBox& target() const { return target_; }
+    [[nodiscard]] int32_t threshold(size_t slot) const { return thresholds_[slot]; }
+
+    void reset() {
+        state_ = 0;
+        counter_ = 0;
+        target_ = {0, 0, 0, 0};
+    }
+
+private:
+    // The fold expands to one comparison per cell, which GCC and Clang turn
+    // into a jump table. Each case sees its cell as a constant, so the
+    // outcome folds into plain stores and unguarded cells compare nothing
+    template <size_t... Cells>
+    void dispatch(size_t cell, const BBox& box, std::index_sequence<Cells...>) {
+        static_cast<void>(((cell == Cells && (apply<Cells>(box), true)) || ...));
+    }
+
+    template <size_t Cell>
+    void apply(const BBox& box) {
+        constexpr TableCell c = kTable[Cell];
+        if constexpr (c.slot == kUnguarded) {
+            apply(c.outcome[0], box);
+        } else {
+            apply(c.outcome[counter_ >= thresholds_[c.slot]], box);
+        }
+    }
+
+    void apply(const TableOutcome& o, const BBox& box) {
+        state_ = o.to;
+        counter_ = counter_ * o.keep + o.add;
+        if (o.store_box) target_ = box;
+    }
+
+    std::array<int32_t, Spec::kThresholdCount> thresholds_;
+    uint8_t state_ = 0;  // state 0 is the initial state
+    int32_t counter_ = 0;
+    BBox target_{0, 0, 0, 0};
+};
+
+// The lesson's tracker: same behavior as VariantStateMachine, with the
+// lost -> search threshold as threshold 0. The counter is frames lost.
+struct TrackerSpec {
+    enum State : uint8_t { kIdle, kTracking, kLost, kSearch, kStateCount };
+    enum Event : uint8_t { kDetect, kMiss, kEventCount };
+    static constexpr size_t kThresholdCount = 1;  // 0: lost_to_search
+    static constexpr const char* kStateNames[] = {"idle", "tracking", "lost", "search"};
+
+    static constexpr auto rules = std::to_array<Rule>({
+        {.from = kIdle, .event = kDetect, .to = kTracking, .store_box = true},
+        {.from = kIdle, .event = kMiss, .to = kIdle},
+        {.from = kTracking, .event = kDetect, .to = kTracking, .store_box = true},
+        {.from = kTracking, .event = kMiss, .to = kLost, .counter = CounterOp::kOne},
+        {.from = kLost, .event = kDetect, .to = kTracking, .counter = CounterOp::kZero, .store_box = true},
+        {.from = kLost, .event = kMiss, .to = kLost, .counter = CounterOp::kIncrement},
+        {.from = kLost, .event = kMiss, .to = kSearch, .counter = CounterOp::kZero, .guard = 0},
+        {.from = kSearch, .event = kDetect, .to = kTracking, .store_box = true},
+        {.from = kSearch, .event = kMiss, .to = kSearch},
+    });
+};
+
+// The capstone tracker lifecycle (capstone/baseline StateMachine): string
+// events, an "expired" state that only "reset" leaves, and frames_in_state
+// counting every event since the last transition. Threshold 0 is the
+// number of frames after which a miss in lost expires the track.
+struct LifecycleSpec {
+    enum State : uint8_t { kIdle, kTracking, kLost, kExpired, kStateCount };
+    enum Event : uint8_t { kDetect, kMiss, kReset, kEventCount };
+    static constexpr size_t kThresholdCount = 1;  // 0: expire_after
+    static constexpr const char* kStateNames[] = {"idle", "tracking", "lost", "expired"};
+    static constexpr const char* kEventNames[] = {"detect", "miss", "reset"};
+
+    static constexpr auto rules = std::to_array<Rule>({
+        {.from = kIdle, .event = kDetect, .to = kTracking, .counter = CounterOp::kZero},
+        {.from = kIdle, .event = kMiss, .to = kIdle, .counter = CounterOp::kIncrement},
+        {.from = kIdle, .event = kReset, .to = kIdle, .counter = CounterOp::kIncrement},
+        {.from = kTracking, .event = kDetect, .to = kTracking, .counter = CounterOp::kZero},
+        {.from = kTracking, .event = kMiss, .to = kLost, .counter = CounterOp::kZero},
+        {.from = kTracking, .event = kReset, .to = kTracking, .counter = CounterOp::kIncrement},
+        {.from = kLost, .event = kDetect, .to = kTracking, .counter = CounterOp::kZero},
+        {.from = kLost, .event = kMiss, .to = kLost, .counter = CounterOp::kIncrement},
+        {.from = kLost, .event = kMiss, .to = kExpired, .counter = CounterOp::kZero, .guard = 0},
+        {.from = kLost, .event = kReset, .to = kLost, .counter = CounterOp::kIncrement},
+        {.from = kExpired, .event = kDetect, .to = kExpired, .counter = CounterOp::kIncrement},
+        {.from = kExpired, .event = kMiss, .to = kExpired, .counter = CounterOp::kIncrement},
+        {.from = kExpired, .event = kReset, .to = kIdle, .counter = CounterOp::kZero},
+    });
+};
+
+// Same interface as VariantStateMachine, driven by TrackerSpec's table
+class TableStateMachine {
+public:
+    explicit TableStateMachine(int32_t lost_to_search = 30) : machine_({lost_to_search}) {
+        if (lost_to_search < 1) throw std::invalid_argument("lost_to_search must be >= 1");
+    }
+
+    void update(bool has_detection, float det_x = 0, float det_y = 0,
+                float det_w = 0, float det_h = 0) {
+        machine_.fire(has_detection ? TrackerSpec::kDetect : TrackerSpec::kMiss,
+                      BBox{det_x, det_y, det_w, det_h});
+        recorder_.record(has_detection, machine_.state(), machine_.counter(), det_x, det_y, det_w, det_h);
+    }
+
+    [[nodiscard]] std::string state() const { return TrackerSpec::kStateNames[machine_.state()]; }
+    [[nodiscard]] int lost_frames() const { return machine_.counter(); }
+    [[nodiscard]] std::tuple<float, float, float, float> target() const {
+        const BBox& t = machine_.target();
+        return {t.x, t.y, t.w, t.h};
+    }
+    [[nodiscard]] int32_t lost_to_search() const { return machine_.threshold(0); }
+    [[nodiscard]] uint8_t state_code() const { return machine_.state(); }
+
+    void record_to(EventLog* log, uint32_t track) { recorder_.attach(log, track); }
+
+private:
+    TableMachine<TrackerSpec> machine_;
+    EventRecorder recorder_;
+};
+
+// The capstone StateMachine on LifecycleSpec's table: on_event("detect")
+// etc. returns the new state, as in capstone/baseline/tracker_baseline.py
+class LifecycleStateMachine {
+public:
+    explicit LifecycleStateMachine(int32_t expire_after = 10) : machine_({expire_after}) {
+        if (expire_after < 0) throw std::invalid_argument("expire_after must be >= 0");
+    }
+
+    std::string on_event(const std::string& event) {
+        for (uint8_t e = 0; e < LifecycleSpec::kEventCount; ++e) {
+            if (event == LifecycleSpec::kEventNames[e]) {
+                return LifecycleSpec::kStateNames[machine_.fire(e)];
+            }
+        }
+        throw std::invalid_argument("unknown event '" + event + "' (expected detect, miss or reset)");
+    }
+
+    [[nodiscard]] std::string state() const { return LifecycleSpec::kStateNames[machine_.state()]; }
+    [[nodiscard]] int frames_in_state() const { return machine_.counter(); }
+    [[nodiscard]] int32_t expire_after() const { return machine_.threshold(0); }
+
+private:
+    TableMachine<LifecycleSpec> machine_;
+};
+
+// ===========================================================================
+// Replay: run a recorded log through an implementation and diff the states
+// ===========================================================================
+
+// Records as numpy columns, oldest first
+static nb::dict log_records(const EventLog& log) {
+    const size_t n = log.size();
+    std::vector<uint32_t> frame(n), track(n);
+    std::vector<uint8_t> event(n), state(n);
+    std::vector<int32_t> lost(n);
+    std::vector<float> boxes(n * 4);
+    size_t i = 0;
+    for (std::span<const EventRecord> run : log.runs()) {
+        for (const EventRecord& r : run) {
+            frame[i] = r.frame;
+            track[i] = r.track;
+            event[i] = r.event;
+            state[i] = r.state;
+            lost[i] = r.lost_frames;
+            float* b = &boxes[4 * i];
+            b[0] = r.x; b[1] = r.y; b[2] = r.w; b[3] = r.h;
+            ++i;
+        }
+    }
+    auto to_numpy = []<typename T>(std::vector<T>&& column, std::initializer_list<size_t> shape) {
+        auto* owned = new std::vector<T>(std::move(column));
+        nb::capsule owner(owned, [](void* p) noexcept { delete static_cast<std::vector<T>*>(p); });
+        return nb::ndarray<nb::numpy, T>(owned->data(), shape.size(), shape.begin(), owner);
+    };
+    nb::dict out;
+    out["frame"] = to_numpy(std::move(frame), {n});
+    out["track"] = to_numpy(std::move(track), {n});
+    out["event"] = to_numpy(std::move(event), {n});
+    out["state"] = to_numpy(std::move(state), {n});
+    out["lost_frames"] = to_numpy(std::move(lost), {n});
+    out["boxes"] = to_numpy(std::move(boxes), {n, 4});
+    return out;
+}
+
+struct ReplayDiff {
+    size_t index;          // position in the log, oldest record = 0
+    uint32_t frame;
+    uint32_t track;
+    std::string recorded;
+    std::string replayed;
+};
+
+struct ReplayResult {
+    size_t records = 0;
+    size_t tracks = 0;
+    size_t mismatches = 0;
+    double elapsed_ns = 0;
+    std::vector<ReplayDiff> diffs;  // the first max_diffs mismatches
+};
+
+// One fresh machine per track, fed the log's events in order. Only the
+// compare against the recorded state sits on the hot path; a mismatch is
+// rare and takes the slow branch
+template <typename Machine, typename MakeMachine>
+static ReplayResult replay_with(const EventLog& log, MakeMachine make, size_t max_diffs) {
+    const auto runs = log.runs();
+    uint32_t max_track = 0;
+    for (std::span<const EventRecord> run : runs) {
+        for (const EventRecord& r : run) max_track = std::max(max_track, r.track);
+    }
+    ReplayResult result;
+    result.records = log.size();
+    result.tracks = result.records ? size_t{max_track} + 1 : 0;
+    std::vector<Machine> machines;
+    machines.reserve(result.tracks);
+    for (size_t t = 0; t < result.tracks; ++t) machines.push_back(make());
+
+    size_t index = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (std::span<const EventRecord> run : runs) {
+        for (const EventRecord& r : run) {
+            Machine& sm = machines[r.track];
+            if (r.event == kEventDetect) {
+                sm.update(true, r.x, r.y, r.w, r.h);
+            } else {
+                sm.update(false);
+            }
+            const uint8_t replayed = sm.state_code();
+            if (replayed != r.state) [[unlikely]] {
+                if (result.mismatches++ < max_diffs) {
+                    result.diffs.push_back({index, r.frame, r.track, kTrackerStateNames[r.state & 3],
+                                            kTrackerStateNames[replayed]});
+                }
+            }
+            ++index;
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    result.elapsed_ns = std::chrono::duration<double, std::nano>(end - start).count();
+    return result;
+}
+
+// Replay `log` through machine = "string", "variant" or "table". The string
+// and variant machines have lost_to_search = 30 compiled in; "table" takes it
+// as a parameter, so a log can be replayed under a different threshold
+static nb::dict replay(const EventLog& log, const std::string& machine, int32_t lost_to_search, size_t max_diffs) {
+    ReplayResult r;
+    {
+        nb::gil_scoped_release release;
+        if (machine == "table") {
+            if (lost_to_search < 1) throw std::invalid_argument("lost_to_search must be >= 1");
+            r = replay_with<TableStateMachine>(log, [&] { return TableStateMachine(lost_to_search); }, max_diffs);
+        } else if (machine == "string" || machine == "variant") {
+            if (lost_to_search != 30) {
+                throw std::invalid_argument("the " + machine + " machine has lost_to_search = 30 built in; "
+                                            "use machine=\"table\" to replay with another threshold");
+            }
+            r = machine == "string"
+                    ? replay_with<StringStateMachine>(log, [] { return StringStateMachine(); }, max_diffs)
+                    : replay_with<VariantStateMachine>(log, [] { return VariantStateMachine(); }, max_diffs);
+        } else {
+            throw std::invalid_argument("unknown machine '" + machine + "' (expected string, variant or table)");
+        }
+    }
+    nb::list diffs;
+    for (const ReplayDiff& d : r.diffs) {
+        diffs.append(nb::make_tuple(d.index, d.frame, d.track, d.recorded, d.replayed));
+    }
+    nb::dict out;
+    out["records"] = r.records;
+    out["tracks"] = r.tracks;
+    out["mismatches"] = r.mismatches;
+    out["diffs"] = diffs;
+    // A wrapped ring starts mid-stream while replay starts every track at
+    // idle, so the first records of each track may legitimately differ
+    out["wrapped"] = log.dropped() > 0;
+    out["elapsed_ns"] = r.elapsed_ns;
+    out["ns_per_record"] = r.records ? r.elapsed_ns / static_cast<double>(r.records) : 0.0;
+    return out;
+}
+
 // ===========================================================================
 // Benchmark helpers (run N iterations of state transitions)
 // ===========================================================================
@@ -198,11 +1043,136 @@ double benchmark_variant_sm(int iterations) {
     return std::chrono::duration<double, std::micro>(end - start).count();
 }
 
+// benchmark_variant_sm with every update appended to an in-memory event
+// log; the difference between the two is the recording cost
+double benchmark_variant_sm_logged(int iterations) {
+    EventLog log(size_t{1} << 16);
+    VariantStateMachine sm;
+    sm.record_to(&log, 0);
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < iterations; ++i) {
+        sm.update(true, 100.0f, 200.0f, 50.0f, 50.0f);
+        sm.update(true, 105.0f, 205.0f, 50.0f, 50.0f);
+        sm.update(false);
+        for (int j = 0; j < 31; ++j) {
+            sm.update(false);
+        }
+        sm.update(true, 110.0f, 210.0f, 50.0f, 50.0f);
+        sm.update(false);
+        sm.update(true, 115.0f, 215.0f, 50.0f, 50.0f);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+// Same scenario as benchmark_variant_sm. The lost -> search threshold is a
+// runtime argument here, where the variant machine has 30 compiled in
+double benchmark_table_sm(int iterations, int32_t lost_to_search) {
+    TableStateMachine sm(lost_to_search);
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < iterations; ++i) {
+        sm.update(true, 100.0f, 200.0f, 50.0f, 50.0f);
+        sm.update(true, 105.0f, 205.0f, 50.0f, 50.0f);
+        sm.update(false);
+        for (int j = 0; j < 31; ++j) {
+            sm.update(false);
+        }
+        sm.update(true, 110.0f, 210.0f, 50.0f, 50.0f);
+        sm.update(false);
+        sm.update(true, 115.0f, 215.0f, 50.0f, 50.0f);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+// Per-frame cost for n_tracks targets: one VariantStateMachine per track
+// versus one StateMachineBank step. Detections follow the same pattern in
+// both, staggered per track so every state is populated each frame.
+static bool bench_detection(size_t track, int frame) { return (frame + static_cast<int>(track * 7)) % 40 < 25; }
+
+double benchmark_variant_tracks(size_t n_tracks, int frames) {
+    std::vector<VariantStateMachine> sms(n_tracks);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int f = 0; f < frames; ++f) {
+        for (size_t i = 0; i < n_tracks; ++i) {
+            if (bench_detection(i, f)) {
+                sms[i].update(true, 100.0f + f, 200.0f, 50.0f, 50.0f);
+            } else {
+                sms[i].update(false);
+            }
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+double benchmark_bank_tracks(size_t n_tracks, int frames) {
+    StateMachineBank bank(n_tracks);
+    // The detection pattern repeats every 40 frames: precompute one period so
+    // only the state update is timed, from cache, as with the loop above
+    constexpr int kPeriod = 40;
+    std::vector<std::vector<uint8_t>> det(kPeriod, std::vector<uint8_t>(n_tracks));
+    std::vector<std::vector<float>> boxes(kPeriod, std::vector<float>(n_tracks * 4));
+    for (int f = 0; f < kPeriod; ++f) {
+        for (size_t i = 0; i < n_tracks; ++i) {
+            det[f][i] = bench_detection(i, f);
+            float* b = &boxes[f][4 * i];
+            b[0] = 100.0f + f; b[1] = 200.0f; b[2] = 50.0f; b[3] = 50.0f;
+        }
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int f = 0; f < frames; ++f) {
+        bank.step(det[f % kPeriod].data(), boxes[f % kPeriod].data());
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
 // ===========================================================================
 // Nanobind bindings
 // ===========================================================================
 NB_MODULE(state_machine, m) {
-    m.doc() = "String-based vs variant-based state machine comparison";
+    m.doc() = "String-based vs variant-based vs table-driven vs batched state machines, with event log replay";
+
+    // --- Event log and replay ---
+    nb::class_<EventLog>(m, "EventLog")
+        .def(nb::init<size_t, std::optional<std::string>>(), nb::arg("capacity"), nb::arg("path") = nb::none(),
+             "Preallocated ring of 32-byte event records, in memory or in an mmap'd file at `path`")
+        .def_static("open", &EventLog::open, nb::arg("path"),
+                    "Map a log file written by another process, read-only")
+        .def("append",
+             [](EventLog& log, uint32_t frame, uint32_t track, bool has_detection, uint8_t state,
+                int32_t lost_frames, std::tuple<float, float, float, float> box) {
+                 log.require_writable();
+                 if (state >= std::size(kTrackerStateNames)) throw std::invalid_argument("state must be in [0, 4)");
+                 auto [x, y, w, h] = box;
+                 log.append(EventRecord{frame, track, has_detection ? kEventDetect : kEventMiss, state, 0,
+                                        lost_frames, x, y, w, h});
+             },
+             nb::arg("frame"), nb::arg("track"), nb::arg("has_detection"), nb::arg("state"),
+             nb::arg("lost_frames") = 0, nb::arg("box") = std::make_tuple(0.0f, 0.0f, 0.0f, 0.0f),
+             "Append one record by hand (state is an index into TRACKER_STATES)")
+        .def("records", &log_records,
+             "Records oldest first as a dict of numpy columns: frame, track, event (0 detect, 1 miss), "
+             "state, lost_frames, boxes")
+        .def("clear", &EventLog::clear)
+        .def("flush", &EventLog::flush, "msync a file-backed log")
+        .def("total", &EventLog::total, "Records ever appended")
+        .def("dropped", &EventLog::dropped, "Records overwritten after the ring wrapped")
+        .def("capacity", &EventLog::capacity)
+        .def("writable", &EventLog::writable)
+        .def("path", &EventLog::path)
+        .def("__len__", &EventLog::size);
+    m.attr("TRACKER_STATES") = nb::make_tuple("idle", "tracking", "lost", "search");
+    m.def("replay", &replay, nb::arg("log"), nb::arg("machine") = "variant", nb::arg("lost_to_search") = 30,
+          nb::arg("max_diffs") = 10,
+          "Re-run a log through machine = 'string', 'variant' or 'table' (one machine per track) and diff "
+          "the states. Returns records, tracks, mismatches, diffs [(index, frame, track, recorded, replayed)], "
+          "wrapped, elapsed_ns and ns_per_record");
 
     // --- String state machine ("before") ---
     nb::class_<StringStateMachine>(m, "StringStateMachine")
@@ -213,7 +1183,9 @@ NB_MODULE(state_machine, m) {
              nb::arg("det_w") = 0.0f, nb::arg("det_h") = 0.0f)
         .def("state", &StringStateMachine::state)
         .def("lost_frames", &StringStateMachine::lost_frames)
-        .def("target", &StringStateMachine::target);
+        .def("target", &StringStateMachine::target)
+        .def("record_to", &StringStateMachine::record_to, nb::arg("log").none(), nb::arg("track") = 0,
+             nb::keep_alive<1, 2>(), "Append every update to an EventLog (None stops recording)");
 
     // --- Variant state machine ("after") ---
     nb::class_<VariantStateMachine>(m, "VariantStateMachine")
@@ -224,11 +1196,68 @@ NB_MODULE(state_machine, m) {
              nb::arg("det_w") = 0.0f, nb::arg("det_h") = 0.0f)
         .def("state", &VariantStateMachine::state)
         .def("lost_frames", &VariantStateMachine::lost_frames)
-        .def("target", &VariantStateMachine::target);
+        .def("target", &VariantStateMachine::target)
+        .def("record_to", &VariantStateMachine::record_to, nb::arg("log").none(), nb::arg("track") = 0,
+             nb::keep_alive<1, 2>(), "Append every update to an EventLog (None stops recording)");
+
+    // --- Batched SoA state machine ---
+    nb::class_<StateMachineBank>(m, "StateMachineBank")
+        .def(nb::init<size_t, int32_t>(), nb::arg("n_tracks"), nb::arg("lost_to_search") = 30,
+             "Tracker state machines for n_tracks targets, advanced together by update()")
+        .def("update", &StateMachineBank::update, nb::arg("has_detection"), nb::arg("boxes"),
+             "Advance every track one frame (bool[n], float32[n, 4]); returns a dict of index "
+             "arrays: acquired, reacquired, lost, search")
+        .def("reset", &StateMachineBank::reset, nb::arg("indices"),
+             "Return the given tracks to idle")
+        .def("states", &StateMachineBank::states,
+             "State codes as uint8 (index into BANK_STATES)")
+        .def("lost_frames", &StateMachineBank::lost_frames)
+        .def("boxes", &StateMachineBank::boxes,
+             "Last known box per track as float32 (n, 4)")
+        .def("state", &StateMachineBank::state, nb::arg("index"))
+        .def("counts", &StateMachineBank::counts,
+             "Number of tracks per state: (idle, tracking, lost, search)")
+        .def("lost_to_search", &StateMachineBank::lost_to_search)
+        .def("record_to", &StateMachineBank::record_to, nb::arg("log").none(), nb::keep_alive<1, 2>(),
+             "Append one record per track on every update (None stops recording)")
+        .def("__len__", &StateMachineBank::size);
+    m.attr("BANK_STATES") = nb::make_tuple("idle", "tracking", "lost", "search");
+
+    // --- Table-driven state machines ---
+    nb::class_<TableStateMachine>(m, "TableStateMachine")
+        .def(nb::init<int32_t>(), nb::arg("lost_to_search") = 30,
+             "VariantStateMachine's rules as a compile-time transition table")
+        .def("update", &TableStateMachine::update,
+             nb::arg("has_detection"),
+             nb::arg("det_x") = 0.0f, nb::arg("det_y") = 0.0f,
+             nb::arg("det_w") = 0.0f, nb::arg("det_h") = 0.0f)
+        .def("state", &TableStateMachine::state)
+        .def("lost_frames", &TableStateMachine::lost_frames)
+        .def("target", &TableStateMachine::target)
+        .def("lost_to_search", &TableStateMachine::lost_to_search)
+        .def("record_to", &TableStateMachine::record_to, nb::arg("log").none(), nb::arg("track") = 0,
+             nb::keep_alive<1, 2>(), "Append every update to an EventLog (None stops recording)");
+
+    nb::class_<LifecycleStateMachine>(m, "LifecycleStateMachine")
+        .def(nb::init<int32_t>(), nb::arg("expire_after") = 10,
+             "The capstone tracker lifecycle (idle/tracking/lost/expired) as a transition table")
+        .def("on_event", &LifecycleStateMachine::on_event, nb::arg("event"),
+             "Process 'detect', 'miss' or 'reset' and return the new state")
+        .def("state", &LifecycleStateMachine::state)
+        .def("frames_in_state", &LifecycleStateMachine::frames_in_state)
+        .def("expire_after", &LifecycleStateMachine::expire_after);
 
     // --- Benchmarks ---
     m.def("benchmark_string_sm", &benchmark_string_sm, nb::arg("iterations"),
           "Benchmark string-based state machine (returns microseconds)");
     m.def("benchmark_variant_sm", &benchmark_variant_sm, nb::arg("iterations"),
           "Benchmark variant-based state machine (returns microseconds)");
+    m.def("benchmark_variant_sm_logged", &benchmark_variant_sm_logged, nb::arg("iterations"),
+          "benchmark_variant_sm with every update recorded to an EventLog (returns microseconds)");
+    m.def("benchmark_table_sm", &benchmark_table_sm, nb::arg("iterations"), nb::arg("lost_to_search") = 30,
+          "Benchmark table-driven state machine (returns microseconds)");
+    m.def("benchmark_variant_tracks", &benchmark_variant_tracks, nb::arg("n_tracks"), nb::arg("frames"),
+          "n_tracks VariantStateMachine objects over `frames` frames (returns microseconds)");
+    m.def("benchmark_bank_tracks", &benchmark_bank_tracks, nb::arg("n_tracks"), nb::arg("frames"),
+          "One StateMachineBank of n_tracks over `frames` frames (returns microseconds)");
 }
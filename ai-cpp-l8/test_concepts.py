@@ -4,7 +4,12 @@ Unit tests for Lesson 8: Compile-Time Concepts for Performance.
 Tests:
   - FlatType concept: which types satisfy it and which don't
   - Compile-time LUTs: grayscale and gamma correctness
+  - SIMD kernels: bit-exact against scalar models; runtime gamma LUT cache
+  - LUT composition: chains of point ops equal the ops applied one by one
+  - Histogram, equalization and CLAHE: match numpy models of OpenCV's algorithms
   - State machine: all transitions produce correct states
+  - Batched state machine: matches the per-track state machine
+  - Transition tables and event log replay: match the hand-coded machines
   - Image template: correct compile-time sizes and data access
 """
 
@@ -299,6 +304,376 @@ class TestGammaLUT:
         assert val == 58
 
 
+# =========================================================================
+# SIMD kernel tests
+# =========================================================================
+def _gray_fixed(bgr):
+    """numpy model of the Q16 fixed-point BT.601 weights used by apply_grayscale_simd."""
+    b, g, r = (bgr[..., c].astype(np.int64) for c in range(3))
+    return (((b * 7471 >> 8) + (g * 38470 >> 8) + (r * 19595 >> 8) + 128) >> 8).astype(np.uint8)
+
+
+class TestSimdKernels:
+    """SIMD grayscale / LUT kernels and the runtime gamma LUT cache."""
+
+    def test_simd_level_reported(self):
+        assert compile_time_lut.simd_level() in ("avx512vbmi", "avx2", "scalar")
+
+    @pytest.mark.parametrize("shape", [(1, 1, 3), (7, 13, 3), (480, 640, 3), (3, 37, 3)])
+    def test_grayscale_simd_matches_fixed_point_model(self, shape):
+        """Odd widths exercise the scalar tail after the 32-pixel vector loop."""
+        bgr = np.random.default_rng(0).integers(0, 256, shape, dtype=np.uint8)
+        gray = compile_time_lut.apply_grayscale_simd(bgr)
+        assert gray.shape == shape[:2]
+        np.testing.assert_array_equal(gray, _gray_fixed(bgr))
+
+    def test_grayscale_simd_close_to_lut(self):
+        bgr = np.random.default_rng(1).integers(0, 256, (64, 64, 3), dtype=np.uint8)
+        simd = compile_time_lut.apply_grayscale_simd(bgr).astype(int)
+        lut = compile_time_lut.apply_grayscale_lut(bgr).astype(int)
+        assert np.max(np.abs(simd - lut)) <= 2
+
+    def test_grayscale_simd_white_stays_white(self):
+        bgr = np.full((4, 40, 3), 255, dtype=np.uint8)
+        assert np.all(compile_time_lut.apply_grayscale_simd(bgr) == 255)
+
+    def test_grayscale_simd_into(self):
+        bgr = np.random.default_rng(2).integers(0, 256, (30, 50, 3), dtype=np.uint8)
+        out = np.empty((30, 50), dtype=np.uint8)
+        compile_time_lut.apply_grayscale_simd_into(bgr, out)
+        np.testing.assert_array_equal(out, _gray_fixed(bgr))
+        with pytest.raises(ValueError):
+            compile_time_lut.apply_grayscale_simd_into(bgr, np.empty((30, 49), dtype=np.uint8))
+
+    @pytest.mark.parametrize("shape", [(1,), (63,), (65,), (129, 3), (480, 640)])
+    def test_apply_lut_matches_numpy_indexing(self, shape):
+        rng = np.random.default_rng(3)
+        image = rng.integers(0, 256, shape, dtype=np.uint8)
+        lut = rng.integers(0, 256, 256, dtype=np.uint8)
+        np.testing.assert_array_equal(compile_time_lut.apply_lut(image, lut), lut[image])
+
+    def test_apply_lut_into_and_shape_errors(self):
+        image = np.arange(256, dtype=np.uint8).reshape(16, 16)
+        lut = (255 - np.arange(256)).astype(np.uint8)
+        out = np.empty_like(image)
+        compile_time_lut.apply_lut_into(image, lut, out)
+        np.testing.assert_array_equal(out, 255 - image)
+        with pytest.raises(ValueError):
+            compile_time_lut.apply_lut_into(image, lut, np.empty((16, 15), dtype=np.uint8))
+        with pytest.raises(TypeError):
+            compile_time_lut.apply_lut(image, np.zeros(255, dtype=np.uint8))
+
+    @pytest.mark.parametrize("gamma", [0.45, 1.7, 2.2, 3.14159])
+    def test_gamma_simd_matches_runtime_pow(self, gamma):
+        """The cached table is built with std::pow, so it is exact for any gamma."""
+        gray = np.random.default_rng(4).integers(0, 256, (33, 97), dtype=np.uint8)
+        np.testing.assert_array_equal(
+            compile_time_lut.apply_gamma_simd(gray, gamma),
+            compile_time_lut.apply_gamma_runtime(gray, gamma),
+        )
+
+    def test_gamma_simd_into(self):
+        gray = np.arange(256, dtype=np.uint8).reshape(1, 256)
+        out = np.empty_like(gray)
+        compile_time_lut.apply_gamma_simd_into(gray, 1.7, out)
+        np.testing.assert_array_equal(out, compile_time_lut.apply_gamma_runtime(gray, 1.7))
+
+    def test_gamma_lut_table(self):
+        table = compile_time_lut.gamma_lut(1.0)
+        np.testing.assert_array_equal(table, np.arange(256, dtype=np.uint8))
+
+    def test_cache_counts_hits_and_misses(self):
+        compile_time_lut.clear_lut_cache()
+        gray = np.zeros((4, 4), dtype=np.uint8)
+        compile_time_lut.apply_gamma_simd(gray, 1.23)
+        compile_time_lut.apply_gamma_simd(gray, 1.23)
+        compile_time_lut.apply_gamma_simd(gray, 0.77)
+        info = compile_time_lut.lut_cache_info()
+        assert (info["size"], info["hits"], info["misses"]) == (2, 1, 2)
+        compile_time_lut.clear_lut_cache()
+        assert compile_time_lut.lut_cache_info()["size"] == 0
+
+    @pytest.mark.parametrize("gamma", [0.0, -1.0, float("nan"), float("inf")])
+    def test_invalid_gamma_rejected(self, gamma):
+        with pytest.raises(ValueError):
+            compile_time_lut.apply_gamma_simd(np.zeros((2, 2), dtype=np.uint8), gamma)
+
+    def test_cache_is_thread_safe(self):
+        """Concurrent callers (GIL released in the kernel) all see correct tables."""
+        from concurrent.futures import ThreadPoolExecutor
+
+        compile_time_lut.clear_lut_cache()
+        gray = np.random.default_rng(5).integers(0, 256, (64, 64), dtype=np.uint8)
+        gammas = [0.5 + 0.1 * (i % 16) for i in range(256)]
+        with ThreadPoolExecutor(max_workers=8) as pool:
+            results = list(pool.map(lambda g: compile_time_lut.apply_gamma_simd(gray, g), gammas))
+        for g, result in zip(gammas, results):
+            np.testing.assert_array_equal(result, compile_time_lut.apply_gamma_runtime(gray, g))
+        info = compile_time_lut.lut_cache_info()
+        assert info["size"] == 16
+        assert info["hits"] + info["misses"] == len(gammas)
+
+
+# =========================================================================
+# LUT composition tests
+# =========================================================================
+def _contrast_stretch(x, lo, hi):
+    """numpy model of contrast_stretch_lut: [lo, hi] -> [0, 255], rounded."""
+    x = np.clip(x.astype(np.int64), lo, hi) - lo
+    return ((x * 255 + (hi - lo) // 2) // (hi - lo)).astype(np.uint8)
+
+
+def _brightness(x, delta):
+    return np.clip(x.astype(np.int64) + delta, 0, 255).astype(np.uint8)
+
+
+class TestLutComposition:
+    """Chains of point ops folded into one table."""
+
+    def test_photometric_lut_is_the_composed_chain(self):
+        """The static chain equals the four ops applied one after another."""
+        x = np.array([compile_time_lut.get_gamma_lut_value(i, 0.45) for i in range(256)], dtype=np.uint8)
+        expected = 255 - _brightness(_contrast_stretch(x, 16, 235), 10)
+        np.testing.assert_array_equal(compile_time_lut.photometric_lut(), expected)
+
+    def test_apply_photometric(self):
+        image = np.random.default_rng(6).integers(0, 256, (37, 41), dtype=np.uint8)
+        table = compile_time_lut.photometric_lut()
+        np.testing.assert_array_equal(compile_time_lut.apply_photometric(image), table[image])
+        out = np.empty_like(image)
+        compile_time_lut.apply_photometric_into(image, out)
+        np.testing.assert_array_equal(out, table[image])
+
+    def test_chain_matches_sequential_passes(self):
+        image = np.random.default_rng(7).integers(0, 256, (65, 129), dtype=np.uint8)
+        chain = compile_time_lut.LutChain().gamma(1.7).contrast_stretch(20, 220).brightness(-15).invert()
+        assert len(chain) == 4
+        step = compile_time_lut.apply_gamma_runtime(image, 1.7)
+        step = 255 - _brightness(_contrast_stretch(step, 20, 220), -15)
+        np.testing.assert_array_equal(chain.apply(image), step)
+
+    def test_builder_returns_same_chain(self):
+        chain = compile_time_lut.LutChain()
+        assert chain.invert() is chain
+        np.testing.assert_array_equal(chain.table, 255 - np.arange(256))
+
+    def test_empty_chain_is_identity(self):
+        chain = compile_time_lut.LutChain()
+        np.testing.assert_array_equal(chain.table, np.arange(256, dtype=np.uint8))
+        assert len(chain) == 0
+
+    def test_double_inversion_cancels(self):
+        chain = compile_time_lut.LutChain().invert().invert()
+        np.testing.assert_array_equal(chain.table, np.arange(256, dtype=np.uint8))
+
+    def test_custom_lut_and_then(self):
+        lut = np.random.default_rng(8).integers(0, 256, 256, dtype=np.uint8)
+        first = compile_time_lut.LutChain().brightness(30)
+        second = compile_time_lut.LutChain().lut(lut).invert()
+        first.then(second)
+        assert len(first) == 3
+        np.testing.assert_array_equal(first.table, 255 - lut[_brightness(np.arange(256), 30)])
+
+    @pytest.mark.parametrize("shape", [(1, 1, 3), (5, 21, 3), (64, 64, 3), (1, 65, 3)])
+    def test_per_channel_chain(self, shape):
+        """Sizes around 64 pixels cover the 192-byte vector step and the tail."""
+        bgr = np.random.default_rng(9).integers(0, 256, shape, dtype=np.uint8)
+        chain = compile_time_lut.LutChain(channels=3).gamma(2.2).invert(channel=0).brightness(40, channel=2)
+        assert chain.table.shape == (3, 256)
+        out = chain.apply(bgr)
+        gamma = compile_time_lut.apply_gamma_runtime(bgr.reshape(-1, 3), 2.2).reshape(shape)
+        np.testing.assert_array_equal(out[..., 0], 255 - gamma[..., 0])
+        np.testing.assert_array_equal(out[..., 1], gamma[..., 1])
+        np.testing.assert_array_equal(out[..., 2], _brightness(gamma[..., 2], 40))
+        into = np.empty_like(bgr)
+        chain.apply_into(bgr, into)
+        np.testing.assert_array_equal(into, out)
+
+    def test_invalid_ops_rejected(self):
+        chain = compile_time_lut.LutChain()
+        with pytest.raises(ValueError):
+            chain.contrast_stretch(200, 100)
+        with pytest.raises(ValueError):
+            chain.brightness(300)
+        with pytest.raises(ValueError):
+            chain.invert(channel=1)
+        with pytest.raises(ValueError):
+            compile_time_lut.LutChain(channels=2)
+        with pytest.raises(ValueError):
+            compile_time_lut.LutChain().then(compile_time_lut.LutChain(channels=3))
+        assert len(chain) == 0
+
+    def test_per_channel_chain_needs_three_channels(self):
+        chain = compile_time_lut.LutChain(channels=3).invert()
+        with pytest.raises(ValueError):
+            chain.apply(np.zeros((4, 4), dtype=np.uint8))
+
+
+# =========================================================================
+# Histogram / equalization / CLAHE tests
+# =========================================================================
+def _equalize_reference(image):
+    """numpy model of cv2.equalizeHist's table (float32 math, round half to even)."""
+    hist = np.bincount(image.ravel(), minlength=256).astype(np.int64)
+    first = int(np.argmax(hist > 0))
+    if hist[first] == image.size:
+        return np.full(256, first, dtype=np.uint8)
+    scale = np.float32(255) / np.float32(image.size - hist[first])
+    lut = np.zeros(256, dtype=np.uint8)
+    lut[first + 1:] = np.rint(np.cumsum(hist[first + 1:]).astype(np.float32) * scale)
+    return lut
+
+
+def _clahe_reference(image, clip_limit, tiles_x, tiles_y):
+    """numpy model of cv2.createCLAHE(clip_limit, (tiles_x, tiles_y)).apply."""
+    h, w = image.shape
+    padded = image
+    if h % tiles_y or w % tiles_x:
+        # OpenCV pads both dimensions as soon as either does not divide
+        padded = np.pad(image, ((0, tiles_y - h % tiles_y), (0, tiles_x - w % tiles_x)), mode="reflect")
+    th, tw = padded.shape[0] // tiles_y, padded.shape[1] // tiles_x
+    area = th * tw
+    limit = max(int(clip_limit * area / 256), 1) if clip_limit > 0 else 0
+    luts = np.zeros((tiles_y, tiles_x, 256), dtype=np.float32)
+    for ty in range(tiles_y):
+        for tx in range(tiles_x):
+            tile = padded[ty * th:(ty + 1) * th, tx * tw:(tx + 1) * tw]
+            hist = np.bincount(tile.ravel(), minlength=256).astype(np.int64)
+            if limit > 0:
+                clipped = int(np.sum(np.maximum(hist - limit, 0)))
+                hist = np.minimum(hist, limit) + clipped // 256
+                residual = clipped % 256
+                if residual:
+                    hist[::max(256 // residual, 1)][:residual] += 1
+            luts[ty, tx] = np.rint(np.cumsum(hist).astype(np.float32) * (np.float32(255) / np.float32(area)))
+
+    def axis(n, tile, tiles):
+        f = np.arange(n, dtype=np.float32) * (np.float32(1) / np.float32(tile)) - np.float32(0.5)
+        lo = np.floor(f).astype(int)
+        return np.maximum(lo, 0), np.minimum(lo + 1, tiles - 1), (f - lo).astype(np.float32)
+
+    x1, x2, wx = axis(w, tw, tiles_x)
+    y1, y2, wy = axis(h, th, tiles_y)
+    v = image.astype(int)
+    y1, y2, wy = y1[:, None], y2[:, None], wy[:, None]
+    one = np.float32(1)
+    top = luts[y1, x1, v] * (one - wx) + luts[y1, x2, v] * wx
+    bottom = luts[y2, x1, v] * (one - wx) + luts[y2, x2, v] * wx
+    return np.rint(top * (one - wy) + bottom * wy).astype(np.uint8)
+
+
+def _textured(shape, seed=0):
+    """Low-contrast image with local structure, where CLAHE has work to do."""
+    rng = np.random.default_rng(seed)
+    y, x = np.indices(shape)
+    base = 90 + 30 * np.sin(x * 0.05) + 20 * np.cos(y * 0.07) + rng.integers(0, 20, shape)
+    return np.clip(base, 0, 255).astype(np.uint8)
+
+
+class TestHistogramEqualization:
+    """Parallel histogram, global equalization and CLAHE."""
+
+    @pytest.mark.parametrize("shape", [(0,), (1,), (7, 13), (480, 640), (3, 5, 3)])
+    @pytest.mark.parametrize("threads", [1, 3])
+    def test_histogram_matches_bincount(self, shape, threads):
+        image = np.random.default_rng(10).integers(0, 256, shape, dtype=np.uint8)
+        hist = compile_time_lut.histogram(image, threads=threads)
+        assert hist.dtype == np.uint64 and hist.shape == (256,)
+        np.testing.assert_array_equal(hist, np.bincount(image.ravel(), minlength=256))
+
+    def test_histogram_of_flat_image(self):
+        """A run of one value is the case the sub-histograms exist for."""
+        hist = compile_time_lut.histogram(np.full((1000, 1000), 42, dtype=np.uint8))
+        assert hist[42] == 1_000_000 and hist.sum() == 1_000_000
+
+    def test_equalization_lut_matches_model(self):
+        image = _textured((120, 160))
+        np.testing.assert_array_equal(compile_time_lut.equalization_lut(image), _equalize_reference(image))
+
+    @pytest.mark.parametrize("threads", [1, 4])
+    def test_equalize_hist(self, threads):
+        image = _textured((97, 131), seed=1)
+        expected = _equalize_reference(image)[image]
+        np.testing.assert_array_equal(compile_time_lut.equalize_hist(image, threads=threads), expected)
+        out = np.empty_like(image)
+        compile_time_lut.equalize_hist_into(image, out, threads=threads)
+        np.testing.assert_array_equal(out, expected)
+
+    def test_equalize_stretches_to_full_range(self):
+        image = _textured((64, 64))
+        result = compile_time_lut.equalize_hist(image)
+        assert result.min() == 0 and result.max() == 255
+
+    def test_equalize_flat_image_unchanged(self):
+        image = np.full((10, 10), 77, dtype=np.uint8)
+        np.testing.assert_array_equal(compile_time_lut.equalize_hist(image), image)
+
+    def test_equalization_lut_composes_with_chain(self):
+        image = _textured((50, 70))
+        chain = compile_time_lut.LutChain().lut(compile_time_lut.equalization_lut(image)).invert()
+        np.testing.assert_array_equal(chain.apply(image), 255 - compile_time_lut.equalize_hist(image))
+
+    @pytest.mark.parametrize("shape,clip_limit,grid", [
+        ((64, 64), 40.0, (8, 8)),
+        ((67, 101), 2.0, (8, 8)),    # not a whole number of tiles: reflect-101 padding
+        ((100, 128), 2.0, (8, 8)),   # width divides, height does not: both are padded
+        ((100, 37), 0.0, (4, 3)),    # no clipping
+        ((8, 8), 3.0, (8, 8)),       # one pixel per tile
+        ((240, 320), 2.0, (8, 8)),
+    ])
+    def test_clahe_matches_model(self, shape, clip_limit, grid):
+        image = _textured(shape, seed=2)
+        result = compile_time_lut.Clahe(clip_limit, grid).apply(image)
+        expected = _clahe_reference(image, clip_limit, *grid)
+        # Built with -ffp-contract=off: the vector path, the scalar tail and
+        # numpy round every product and sum the same way
+        np.testing.assert_array_equal(result, expected)
+
+    def test_clahe_pads_both_dimensions_like_opencv(self):
+        # 1080 rows do not divide into 16 tiles, so OpenCV also pads the 1920
+        # columns by a whole tile: 121-pixel tiles, not 120. The right-most
+        # tile then covers fewer real columns, which changes its table.
+        image = _textured((1080, 1920), seed=5)
+        result = compile_time_lut.Clahe(2.0, (16, 16)).apply(image)
+        expected = _clahe_reference(image, 2.0, 16, 16)
+        np.testing.assert_array_equal(result, expected)
+
+    def test_clahe_same_result_for_any_thread_count(self):
+        image = _textured((181, 257), seed=3)
+        results = [compile_time_lut.Clahe(2.0, (8, 8), threads=t).apply(image) for t in (1, 2, 5)]
+        np.testing.assert_array_equal(results[0], results[1])
+        np.testing.assert_array_equal(results[0], results[2])
+
+    def test_clahe_into_and_properties(self):
+        clahe = compile_time_lut.Clahe(clip_limit=2.5, tile_grid=(4, 6), threads=2)
+        assert (clahe.clip_limit, clahe.tile_grid, clahe.threads) == (2.5, (4, 6), 2)
+        image = _textured((60, 80))
+        out = np.empty_like(image)
+        clahe.apply_into(image, out)
+        np.testing.assert_array_equal(out, clahe.apply(image))
+        with pytest.raises(ValueError):
+            clahe.apply_into(image, np.empty((60, 79), dtype=np.uint8))
+
+    def test_clahe_rejects_bad_arguments(self):
+        with pytest.raises(ValueError):
+            compile_time_lut.Clahe(2.0, (0, 8))
+        with pytest.raises(ValueError):
+            compile_time_lut.Clahe(float("nan"))
+        with pytest.raises(ValueError):
+            compile_time_lut.Clahe(2.0, (8, 8)).apply(np.zeros((4, 100), dtype=np.uint8))
+        with pytest.raises(TypeError):
+            compile_time_lut.Clahe().apply(np.zeros((16, 16, 3), dtype=np.uint8))
+
+    def test_matches_opencv(self):
+        cv2 = pytest.importorskip("cv2")
+        image = _textured((270, 480), seed=4)
+        np.testing.assert_array_equal(compile_time_lut.equalize_hist(image), cv2.equalizeHist(image))
+        ours = compile_time_lut.Clahe(2.0, (8, 8)).apply(image)
+        theirs = cv2.createCLAHE(clipLimit=2.0, tileGridSize=(8, 8)).apply(image)
+        # Same formulas, but OpenCV's own build may fuse its multiply-adds
+        assert np.max(np.abs(ours.astype(int) - theirs.astype(int))) <= 1
+
+
 # =========================================================================
 # State machine tests
 # =========================================================================
@@ -442,3 +817,242 @@ class TestVariantStateMachine:
         assert sm.lost_frames() == 2
         sm.update(True, 50.0, 60.0, 70.0, 80.0)
         assert sm.lost_frames() == 0
+
+
+class TestStateMachineBank:
+    """Test the batched SoA state machine against the per-track variant one."""
+
+    def test_initial_state(self):
+        bank = state_machine.StateMachineBank(8)
+        assert len(bank) == 8
+        assert bank.counts() == (8, 0, 0, 0)
+        assert all(bank.state(i) == "idle" for i in range(8))
+        assert bank.states().dtype == np.uint8
+
+    def test_events(self):
+        bank = state_machine.StateMachineBank(4, lost_to_search=2)
+        boxes = np.zeros((4, 4), dtype=np.float32)
+        ev = bank.update(np.array([True, True, False, False]), boxes)
+        assert ev["acquired"].tolist() == [0, 1]
+        assert ev["lost"].size == 0 and ev["reacquired"].size == 0
+        ev = bank.update(np.array([True, False, False, False]), boxes)
+        assert ev["lost"].tolist() == [1]
+        bank.update(np.array([True, False, False, False]), boxes)  # lost_frames 2
+        ev = bank.update(np.array([True, False, False, False]), boxes)
+        assert ev["search"].tolist() == [1]
+        ev = bank.update(np.array([True, True, False, False]), boxes)
+        assert ev["reacquired"].tolist() == [1]
+        assert bank.counts() == (2, 2, 0, 0)
+
+    def test_matches_variant_state_machine(self):
+        rng = np.random.default_rng(0)
+        n = 37
+        bank = state_machine.StateMachineBank(n)
+        sms = [state_machine.VariantStateMachine() for _ in range(n)]
+        for _ in range(120):
+            det = rng.random(n) < 0.3
+            boxes = rng.random((n, 4), dtype=np.float32) * 100
+            bank.update(det, boxes)
+            for i, sm in enumerate(sms):
+                if det[i]:
+                    sm.update(True, *boxes[i].tolist())
+                else:
+                    sm.update(False)
+        assert [bank.state(i) for i in range(n)] == [sm.state() for sm in sms]
+        assert bank.lost_frames().tolist() == [sm.lost_frames() for sm in sms]
+        np.testing.assert_array_equal(bank.boxes(), np.array([sm.target() for sm in sms], dtype=np.float32))
+
+    def test_boxes_kept_while_lost(self):
+        bank = state_machine.StateMachineBank(2)
+        bank.update(np.array([True, True]), np.array([[1, 2, 3, 4], [5, 6, 7, 8]], dtype=np.float32))
+        bank.update(np.array([False, True]), np.full((2, 4), 9, dtype=np.float32))
+        assert bank.state(0) == "lost"
+        assert bank.boxes()[0].tolist() == [1, 2, 3, 4]
+        assert bank.boxes()[1].tolist() == [9, 9, 9, 9]
+
+    def test_reset(self):
+        bank = state_machine.StateMachineBank(3)
+        bank.update(np.ones(3, dtype=bool), np.ones((3, 4), dtype=np.float32))
+        bank.reset(np.array([0, 2], dtype=np.int64))
+        assert [bank.state(i) for i in range(3)] == ["idle", "tracking", "idle"]
+        assert bank.boxes()[0].tolist() == [0, 0, 0, 0]
+        with pytest.raises(IndexError):
+            bank.reset(np.array([3], dtype=np.int64))
+
+    def test_invalid_arguments(self):
+        with pytest.raises(ValueError):
+            state_machine.StateMachineBank(0)
+        with pytest.raises(ValueError):
+            state_machine.StateMachineBank(4, lost_to_search=0)
+        bank = state_machine.StateMachineBank(4)
+        with pytest.raises(ValueError):
+            bank.update(np.ones(3, dtype=bool), np.zeros((4, 4), dtype=np.float32))
+        with pytest.raises(IndexError):
+            bank.state(4)
+
+
+class TestTableStateMachine:
+    """Test the compile-time transition tables against the hand-coded machines."""
+
+    def test_matches_variant_state_machine(self):
+        rng = np.random.default_rng(1)
+        for p_detect in (0.05, 0.3, 0.8):
+            table = state_machine.TableStateMachine()
+            variant = state_machine.VariantStateMachine()
+            for _ in range(300):
+                box = rng.random(4).tolist()
+                det = bool(rng.random() < p_detect)
+                table.update(det, *box)
+                variant.update(det, *box)
+                assert table.state() == variant.state()
+                assert table.lost_frames() == variant.lost_frames()
+                assert table.target() == variant.target()
+
+    def test_runtime_threshold(self):
+        sm = state_machine.TableStateMachine(lost_to_search=3)
+        assert sm.lost_to_search() == 3
+        sm.update(True, 1.0, 2.0, 3.0, 4.0)
+        for _ in range(3):
+            sm.update(False)
+        assert sm.state() == "lost"
+        sm.update(False)
+        assert sm.state() == "search"
+        assert sm.target() == (1.0, 2.0, 3.0, 4.0)
+
+    def test_invalid_threshold(self):
+        with pytest.raises(ValueError):
+            state_machine.TableStateMachine(lost_to_search=0)
+        with pytest.raises(ValueError):
+            state_machine.LifecycleStateMachine(expire_after=-1)
+
+    def test_lifecycle_matches_capstone_baseline(self):
+        sys.path.insert(0, str(Path(__file__).parent.parent / "capstone" / "baseline"))
+        baseline = pytest.importorskip("tracker_baseline")
+        rng = np.random.default_rng(2)
+        events = rng.choice(["detect", "miss", "reset"], size=2000, p=[0.2, 0.75, 0.05])
+        table = state_machine.LifecycleStateMachine()
+        reference = baseline.StateMachine()
+        for event in events:
+            assert table.on_event(str(event)) == reference.on_event(str(event))
+            assert table.frames_in_state() == reference.frames_in_state
+
+    def test_lifecycle_expire_and_reset(self):
+        sm = state_machine.LifecycleStateMachine(expire_after=2)
+        assert sm.on_event("detect") == "tracking"
+        assert sm.on_event("miss") == "lost"
+        assert sm.on_event("miss") == "lost"
+        assert sm.on_event("miss") == "lost"
+        assert sm.on_event("miss") == "expired"
+        assert sm.on_event("detect") == "expired"
+        assert sm.on_event("reset") == "idle"
+
+    def test_lifecycle_unknown_event(self):
+        sm = state_machine.LifecycleStateMachine()
+        with pytest.raises(ValueError):
+            sm.on_event("teleport")
+
+
+class TestEventLog:
+    """Test event recording and deterministic replay."""
+
+    @staticmethod
+    def _record_variant(log, n_tracks=20, frames=300, seed=3):
+        rng = np.random.default_rng(seed)
+        sms = [state_machine.VariantStateMachine() for _ in range(n_tracks)]
+        for track, sm in enumerate(sms):
+            sm.record_to(log, track)
+        for _ in range(frames):
+            for sm, det in zip(sms, rng.random(n_tracks) < 0.4):
+                if det:
+                    sm.update(True, *rng.random(4).tolist())
+                else:
+                    sm.update(False)
+        return sms
+
+    def test_records(self):
+        log = state_machine.EventLog(64)
+        sm = state_machine.VariantStateMachine()
+        sm.record_to(log, track=5)
+        sm.update(True, 1.0, 2.0, 3.0, 4.0)
+        sm.update(False)
+        rec = log.records()
+        assert len(log) == 2
+        assert rec["frame"].tolist() == [0, 1]
+        assert rec["track"].tolist() == [5, 5]
+        assert rec["event"].tolist() == [0, 1]
+        assert [state_machine.TRACKER_STATES[s] for s in rec["state"]] == ["tracking", "lost"]
+        assert rec["lost_frames"].tolist() == [0, 1]
+        assert rec["boxes"].tolist() == [[1, 2, 3, 4], [0, 0, 0, 0]]
+
+    def test_replay_matches_every_implementation(self):
+        log = state_machine.EventLog(10_000)
+        self._record_variant(log)
+        for machine in ("string", "variant", "table"):
+            result = state_machine.replay(log, machine)
+            assert result["records"] == 6000
+            assert result["tracks"] == 20
+            assert result["mismatches"] == 0, (machine, result["diffs"])
+
+    def test_replay_reports_diffs(self):
+        log = state_machine.EventLog(10_000)
+        self._record_variant(log, frames=200, seed=4)
+        result = state_machine.replay(log, "table", lost_to_search=5, max_diffs=3)
+        assert result["mismatches"] > 0
+        assert len(result["diffs"]) == 3
+        _, _, _, recorded, replayed = result["diffs"][0]
+        assert (recorded, replayed) == ("lost", "search")
+
+    def test_ring_wraps(self):
+        log = state_machine.EventLog(8)
+        sm = state_machine.TableStateMachine()
+        sm.record_to(log)
+        for _ in range(20):
+            sm.update(True, 1.0, 1.0, 1.0, 1.0)
+        assert len(log) == 8 and log.total() == 20 and log.dropped() == 12
+        assert log.records()["frame"].tolist() == list(range(12, 20))
+        assert state_machine.replay(log)["wrapped"]
+
+    def test_file_log_roundtrip(self, tmp_path):
+        path = str(tmp_path / "tracks.smlog")
+        log = state_machine.EventLog(1000, path)
+        sm = state_machine.StringStateMachine()
+        sm.record_to(log, track=2)
+        for i in range(100):
+            sm.update(i % 7 != 0, float(i), 0.0, 1.0, 1.0)
+        log.flush()
+        sm.record_to(None)
+        del sm, log
+
+        reopened = state_machine.EventLog.open(path)
+        assert len(reopened) == 100 and not reopened.writable()
+        assert reopened.path() == path
+        assert state_machine.replay(reopened, "variant")["mismatches"] == 0
+        with pytest.raises(ValueError):
+            state_machine.VariantStateMachine().record_to(reopened)
+
+    def test_open_rejects_other_files(self, tmp_path):
+        path = tmp_path / "not_a_log.bin"
+        path.write_bytes(b"\0" * 256)
+        with pytest.raises(RuntimeError):
+            state_machine.EventLog.open(str(path))
+
+    def test_bank_recording_replays_per_track(self):
+        n = 16
+        log = state_machine.EventLog(n * 100)
+        bank = state_machine.StateMachineBank(n)
+        bank.record_to(log)
+        rng = np.random.default_rng(5)
+        for _ in range(100):
+            bank.update(rng.random(n) < 0.3, rng.random((n, 4), dtype=np.float32))
+        result = state_machine.replay(log, "table")
+        assert result["records"] == n * 100 and result["tracks"] == n
+        assert result["mismatches"] == 0
+
+    def test_invalid_arguments(self):
+        with pytest.raises(ValueError):
+            state_machine.EventLog(0)
+        log = state_machine.EventLog(4)
+        with pytest.raises(ValueError):
+            state_machine.replay(log, "quantum")
+        with pytest.raises(ValueError):
+            state_machine.replay(log, "variant", lost_to_search=10)
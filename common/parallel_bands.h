@@ -0,0 +1,52 @@
+/**
+ * Thread-count and band-splitting helpers shared by the lesson modules.
+ *
+ * Lesson 2 (crop_and_resize), Lesson 7 (CPU preprocess kernels) and
+ * Lesson 8 (histogram, equalization, CLAHE) split work the same way: cut
+ * [0, n) into contiguous bands, one thread per band, with the calling thread
+ * taking the first band. Each lesson's CMakeLists.txt adds this directory to
+ * the include path.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include <sched.h>
+
+namespace ai_cpp {
+
+/** CPUs this process may run on (its affinity mask), not the machine total. */
+inline int allowed_cpu_count() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return 1;
+    return std::max(1, CPU_COUNT(&set));
+}
+
+/**
+ * Split [0, n) into contiguous bands of at least `grain` items and run
+ * fn(begin, end) on each, one thread per band (threads <= 0: one per
+ * allowed CPU). Band b covers [n * b / bands, n * (b + 1) / bands), so the
+ * split depends only on n and the band count.
+ */
+template <typename Fn>
+void parallel_bands(size_t n, size_t grain, int threads, Fn&& fn) {
+    if (threads <= 0) threads = allowed_cpu_count();
+    const size_t bands = std::clamp<size_t>(n / std::max<size_t>(grain, 1), 1, static_cast<size_t>(threads));
+    if (bands == 1) {
+        fn(size_t{0}, n);
+        return;
+    }
+    std::vector<std::thread> workers;
+    workers.reserve(bands - 1);
+    for (size_t b = 1; b < bands; ++b) {
+        workers.emplace_back([&fn, begin = n * b / bands, end = n * (b + 1) / bands] { fn(begin, end); });
+    }
+    fn(size_t{0}, n / bands);
+    for (auto& w : workers) w.join();
+}
+
+}  // namespace ai_cpp
@@ -0,0 +1,117 @@
+/**
+ * Reading the tuning profile cache shared by the lesson modules.
+ *
+ * Lesson 6's cache_benchmark.load_tuning_profile() probes the machine and
+ * writes plain key=value lines to tuning_profile_path(). Lesson 2 and
+ * Lesson 7 read the same file. A file is only trusted if its version and
+ * machine fingerprint match this process, and a missing or malformed value
+ * means "no profile": callers keep their defaults rather than throw.
+ */
+#pragma once
+
+#include <charconv>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+#include "parallel_bands.h"
+
+namespace ai_cpp {
+
+constexpr int kTuningProfileVersion = 1;
+
+/** Number in `text`, or nullopt unless the whole string parses. Never throws. */
+template <typename T>
+std::optional<T> parse_number(std::string_view text) {
+    T value{};
+    const char* end = text.data() + text.size();
+    auto [ptr, ec] = std::from_chars(text.data(), end, value);
+    if (text.empty() || ec != std::errc() || ptr != end) return std::nullopt;
+    return value;
+}
+
+/** The "model name" line of /proc/cpuinfo ("Model" on ARM), or "unknown". */
+inline std::string cpu_model_name() {
+    std::ifstream in("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.rfind("model name", 0) == 0 || line.rfind("Model", 0) == 0) {
+            auto colon = line.find(':');
+            auto start = line.find_first_not_of(" \t", colon == std::string::npos ? colon : colon + 1);
+            if (start != std::string::npos) return line.substr(start);
+        }
+    }
+    return "unknown";
+}
+
+/**
+ * "<cpu model>|<allowed cpus>": the machine and the CPU budget a profile was
+ * derived for. A process pinned to fewer CPUs does not reuse the profile.
+ */
+inline std::string machine_fingerprint() {
+    return cpu_model_name() + "|" + std::to_string(allowed_cpu_count());
+}
+
+/** $AI_CPP_TUNING_PROFILE, else <cache dir>/ai-cpp-course/tuning_profile.txt. */
+inline std::string tuning_profile_path() {
+    if (const char* explicit_path = std::getenv("AI_CPP_TUNING_PROFILE")) return explicit_path;
+    std::string dir;
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        dir = xdg;
+    } else if (const char* home = std::getenv("HOME"); home && *home) {
+        dir = std::string(home) + "/.cache";
+    } else {
+        dir = "/tmp";
+    }
+    return dir + "/ai-cpp-course/tuning_profile.txt";
+}
+
+/** The key=value pairs of a profile file that belongs to this machine. */
+class TuningProfileFile {
+public:
+    /** Read `path`; nullopt if it is missing, another version or from another machine. */
+    static std::optional<TuningProfileFile> read(const std::string& path) {
+        std::ifstream in(path);
+        if (!in) return std::nullopt;
+        TuningProfileFile file;
+        std::string line;
+        while (std::getline(in, line)) {
+            auto eq = line.find('=');
+            if (line.empty() || line[0] == '#' || eq == std::string::npos) continue;
+            file.values_[line.substr(0, eq)] = line.substr(eq + 1);
+        }
+        int version = 0;
+        std::string fingerprint;
+        if (!file.get("version", version) || version != kTuningProfileVersion ||
+            !file.get("fingerprint", fingerprint) || fingerprint != machine_fingerprint()) {
+            return std::nullopt;
+        }
+        return file;
+    }
+
+    /** Store the value of `key` in `out`; false (and `out` untouched) if missing or malformed. */
+    template <typename T>
+    bool get(const std::string& key, T& out) const {
+        auto it = values_.find(key);
+        if (it == values_.end()) return false;
+        if constexpr (std::is_same_v<T, std::string>) {
+            out = it->second;
+            return true;
+        } else {
+            std::optional<T> value = parse_number<T>(it->second);
+            if (!value) return false;
+            out = *value;
+            return true;
+        }
+    }
+
+private:
+    std::map<std::string, std::string> values_;
+};
+
+}  // namespace ai_cpp